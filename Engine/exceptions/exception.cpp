@@ -58,6 +58,8 @@ std::string GraphicsErrCategory::message(int ev) const {
       return "Frame buffer is not set, before drawcall";
     case GraphicsErrc::ComputeCallInRenderPass:
       return "Dispatch compute is not allowed in render pass";
+    case GraphicsErrc::StaleCommandBuffer:
+      return "Command buffer draws vertex or index buffer, relocated by Device::defragment after recording";
     }
   return "(unrecognized error)";
   }
@@ -83,6 +83,11 @@ uint8_t* PixmapCodecDDS::load(PixmapCodec::Context &c, uint32_t &ow, uint32_t &o
   return ddsv;
   }
 
+bool PixmapCodecDDS::decode(PixmapCodec::Context&, Sink&) const {
+  // block-compressed with baked mips: goes through loadImg
+  return false;
+  }
+
 bool PixmapCodecDDS::save(ODevice &, const char* /*ext*/, const uint8_t *data, size_t dataSz,
                           uint32_t w, uint32_t h, Pixmap::Format frm) const {
   return false;
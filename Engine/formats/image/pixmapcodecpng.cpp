@@ -26,6 +26,46 @@ struct PixmapCodecPng::Impl {
       // png exception
       return false;
       }
+    if(!readHeader(png_ptr,info_ptr,frm,outW,outH,outBpp))
+      return false;
+    out = reinterpret_cast<uint8_t*>(malloc(outW*outH*outBpp));
+    readRows(png_ptr,info_ptr,out,outH,outW*outBpp);
+    return true;
+    }
+
+  bool decode(png_structp png_ptr, png_infop info_ptr, Sink& sink) {
+    if(setjmp(png_jmpbuf(png_ptr))) {
+      // png exception
+      return false;
+      }
+    Pixmap::Format frm = Pixmap::Format::RGBA;
+    uint32_t       w = 0, h = 0, bpp = 0;
+    if(!readHeader(png_ptr,info_ptr,frm,w,h,bpp))
+      return false;
+
+    Pixmap::Format dfrm   = frm;
+    size_t         stride = 0;
+    uint8_t*       dst    = sink.begin(w,h,dfrm,stride);
+    if(dfrm!=frm) {
+      const bool rgb16 = (frm==Pixmap::Format::RGB16 && dfrm==Pixmap::Format::RGBA16);
+      if((frm==Pixmap::Format::RGB && dfrm==Pixmap::Format::RGBA) || rgb16) {
+        // alpha is added by libpng, while rows are decoded
+        png_set_filler(png_ptr, rgb16 ? 0xFFFF : 0xFF, PNG_FILLER_AFTER);
+        } else {
+        out = reinterpret_cast<uint8_t*>(malloc(w*h*bpp));
+        readRows(png_ptr,info_ptr,out,h,w*bpp);
+        for(uint32_t y=0; y<h; ++y)
+          convertRow(dst+y*stride,dfrm,out+y*w*bpp,frm,w);
+        return true;
+        }
+      }
+    // NOTE: interlaced images are combined in place, so dst is read back on each pass
+    readRows(png_ptr,info_ptr,dst,h,stride);
+    return true;
+    }
+
+  bool readHeader(png_structp png_ptr, png_infop info_ptr,
+                  Pixmap::Format& frm, uint32_t& outW, uint32_t& outH, uint32_t& outBpp) {
     //png_init_io(png_ptr, data);
     png_set_read_fn  (png_ptr, this, &Impl::read );
     png_set_sig_bytes(png_ptr, 8);
@@ -71,22 +111,23 @@ struct PixmapCodecPng::Impl {
       outBpp*=2;
       frm = Pixmap::Format(uint8_t(Pixmap::Format::R16)+uint8_t(frm)-uint8_t(Pixmap::Format::R));
       }
+    return true;
+    }
 
-    out = reinterpret_cast<uint8_t*>(malloc(outW*outH*outBpp));
+  void readRows(png_structp png_ptr, png_infop info_ptr, uint8_t* dst, uint32_t h, size_t stride) {
     png_set_interlace_handling(png_ptr);
     png_read_update_info(png_ptr, info_ptr);
 
     // Based on png_read_image(png_ptr,imgRows)
     int pass =  png_set_interlace_handling(png_ptr);
     for(int j = 0; j < pass; j++) {
-      for(uint32_t y=0; y<outH; y++) {
-        png_bytep rp = &out[y*outW*outBpp];
+      for(uint32_t y=0; y<h; y++) {
+        png_bytep rp = &dst[y*stride];
         png_read_row(png_ptr, rp, nullptr);
         }
       }
 
     png_read_end(png_ptr, info_ptr);
-    return true;
     }
 
   static void read( png_structp png_ptr,
@@ -157,6 +198,38 @@ uint8_t* PixmapCodecPng::load(PixmapCodec::Context& c, uint32_t& w, uint32_t& h,
   return out;
   }
 
+bool PixmapCodecPng::decode(PixmapCodec::Context& c, Sink& out) const {
+  auto& f = c.device;
+  png_byte head[8];
+  if(f.read(head,8)!=8 || png_sig_cmp(head, 0, 8)!=0)
+    return false;
+
+  png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  if(png_ptr==nullptr)
+    return false;
+
+  png_infop info_ptr = png_create_info_struct(png_ptr);
+  if(info_ptr==nullptr) {
+    png_destroy_read_struct(&png_ptr, nullptr, nullptr);
+    return false;
+    }
+
+  Impl r(&f);
+  bool readed = false;
+  try {
+    readed = r.decode(png_ptr,info_ptr,out);
+    }
+  catch(...) {
+    png_destroy_info_struct(png_ptr, &info_ptr);
+    png_destroy_read_struct(&png_ptr, nullptr, nullptr);
+    throw;
+    }
+
+  png_destroy_info_struct(png_ptr, &info_ptr);
+  png_destroy_read_struct(&png_ptr, nullptr, nullptr);
+  return readed;
+  }
+
 bool PixmapCodecPng::save(ODevice& f, const char* ext, const uint8_t* data,
                           size_t /*dataSz*/, uint32_t w, uint32_t h, Pixmap::Format frm) const {
   if(ext!=nullptr && std::strcmp("png",ext)!=0)
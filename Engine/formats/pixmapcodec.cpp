@@ -8,6 +8,7 @@
 #include <Tempest/IDevice>
 #include <Tempest/Except>
 
+#include <algorithm>
 #include <cstring>
 #include <squish.h>
 
@@ -51,6 +52,17 @@ struct PixmapCodec::Impl {
     throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
     }
 
+  bool decode(IDevice& f, Sink& out) {
+    Context ctx(f);
+
+    for(auto& i:codec)
+      if(i->testFormat(ctx)) {
+        if(i->decode(ctx,out))
+          return true;
+        }
+    return false;
+    }
+
   void implSave(ODevice &f, char *ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm) {
     if(ext!=nullptr) {
       for(size_t i=0;ext[i];++i)
@@ -105,6 +117,65 @@ void PixmapCodec::saveImg(ODevice &f, const char *ext, const uint8_t *data, size
   instance().save(f,ext,data,dataSz,w,h,frm);
   }
 
+bool PixmapCodec::decodeImg(IDevice& f, Sink& out) {
+  return instance().decode(f,out);
+  }
+
+bool PixmapCodec::decode(Context& c, Sink& out) const {
+  uint32_t       w=0, h=0, mipCnt=0, bpp=0;
+  size_t         dataSz=0;
+  Pixmap::Format frm=Pixmap::Format::RGBA;
+
+  std::unique_ptr<uint8_t,void(*)(uint8_t*)> data(load(c,w,h,frm,mipCnt,dataSz,bpp),freeImg);
+  if(data==nullptr)
+    return false;
+  if(mipCnt>1 || bpp==0 || Pixmap::bppForFormat(frm)==0)
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset);
+
+  Pixmap::Format dfrm   = frm;
+  size_t         stride = 0;
+  uint8_t*       dst    = out.begin(w,h,dfrm,stride);
+  const size_t   row    = size_t(w)*bpp;
+  for(uint32_t y=0; y<h; ++y)
+    convertRow(dst+y*stride,dfrm,data.get()+y*row,frm,w);
+  return true;
+  }
+
+void PixmapCodec::convertRow(uint8_t* dst, Pixmap::Format dfrm, const uint8_t* src, Pixmap::Format sfrm, uint32_t w) {
+  const size_t sbpp = Pixmap::bppForFormat(sfrm);
+  if(dfrm==sfrm) {
+    std::memcpy(dst,src,w*sbpp);
+    return;
+    }
+
+  const uint8_t scomp = Pixmap::componentCount(sfrm);
+  const uint8_t dcomp = Pixmap::componentCount(dfrm);
+  const size_t  bpc   = sbpp/scomp;
+  if(Pixmap::bppForFormat(dfrm)!=dcomp*bpc)
+    throw std::system_error(Tempest::SystemErrc::UnableToLoadAsset); // no conversion between component sizes
+
+  // missing color components are zero, alpha is one
+  uint8_t one[4] = {};
+  if(bpc==sizeof(float)) {
+    const float v = 1.f;
+    std::memcpy(one,&v,sizeof(v));
+    } else {
+    std::memset(one,0xFF,bpc);
+    }
+
+  const uint8_t copy = std::min(scomp,dcomp);
+  for(uint32_t x=0; x<w; ++x) {
+    uint8_t*       d = dst+x*dcomp*bpc;
+    const uint8_t* s = src+x*scomp*bpc;
+    std::memcpy(d,s,copy*bpc);
+    for(uint8_t i=copy; i<dcomp; ++i) {
+      if(i==3)
+        std::memcpy(d+i*bpc,one,bpc); else
+        std::memset(d+i*bpc,0,bpc);
+      }
+    }
+  }
+
 void PixmapCodec::freeImg(uint8_t *px) {
   std::free(px);
   }
@@ -27,8 +27,20 @@ class PixmapCodec {
         uint8_t buf[128];
       };
 
+    // Caller-provided destination of decodeImg, such as mapped staging memory
+    class Sink {
+      public:
+        virtual ~Sink()=default;
+        // Called once image size is known. frm can be replaced with format of same channel type and other
+        // component count (RGB -> RGBA); returned memory holds h rows, placed stride bytes apart.
+        virtual uint8_t* begin(uint32_t w, uint32_t h, Pixmap::Format& frm, size_t& stride) = 0;
+      };
+
     static uint8_t*  loadImg (IDevice& f, uint32_t& w, uint32_t& h, Pixmap::Format& frm, uint32_t& mipCnt, uint32_t &bpp, size_t& dataSz);
     static void      saveImg (ODevice& f, const char* ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm);
+    // Decodes scanlines straight into sink. Returns false for images, that have to go through loadImg
+    // (block-compressed or with mips); such are detected before any data is consumed from f.
+    static bool      decodeImg(IDevice& f, Sink& out);
 
     static void      freeImg (uint8_t* px);
 
@@ -36,6 +48,10 @@ class PixmapCodec {
     virtual bool     testFormat(const Context& c) const = 0;
     virtual uint8_t* load(PixmapCodec::Context &c,uint32_t& w,uint32_t& h,Pixmap::Format& frm,uint32_t& mipCnt,size_t& dataSz,uint32_t& bpp) const = 0;
     virtual bool     save(ODevice& f,const char* ext, const uint8_t *data, size_t dataSz, uint32_t w, uint32_t h, Pixmap::Format frm) const = 0;
+    // default implementation decodes with load() and converts rows into sink
+    virtual bool     decode(PixmapCodec::Context &c, Sink& out) const;
+
+    static void      convertRow(uint8_t* dst, Pixmap::Format dfrm, const uint8_t* src, Pixmap::Format sfrm, uint32_t w);
 
   private:
     struct Impl;
@@ -3,8 +3,10 @@
 #include <Tempest/SystemApi>
 
 #include <initializer_list>
+#include <functional>
 #include <memory>
 #include <atomic>
+#include <cstring>
 #include <vector>
 
 #include "../utility/dptr.h"
@@ -195,6 +197,55 @@ namespace Tempest {
       }
     };
 
+  //! Values of specialization constants (layout(constant_id = N) in glsl), applied at pipeline creation.
+  //! Value is converted to type of constant, declared in shader; constants, not used by shaders, are ignored.
+  class SpecializationConstants final {
+    public:
+      enum Type : uint8_t {
+        Bool,
+        Int,
+        UInt,
+        Float,
+        };
+
+      struct Value {
+        uint32_t id   = 0;
+        Type     type = UInt;
+        uint32_t bits = 0;
+        };
+
+      SpecializationConstants& set(uint32_t id, bool     v) { return implSet(id,Bool,v ? 1u : 0u); }
+      SpecializationConstants& set(uint32_t id, int32_t  v) { return implSet(id,Int, uint32_t(v));  }
+      SpecializationConstants& set(uint32_t id, uint32_t v) { return implSet(id,UInt,v);            }
+      SpecializationConstants& set(uint32_t id, float    v) {
+        uint32_t bits = 0;
+        std::memcpy(&bits,&v,sizeof(bits));
+        return implSet(id,Float,bits);
+        }
+
+      bool         isEmpty() const { return values.empty(); }
+      size_t       size()    const { return values.size();  }
+      const Value* data()    const { return values.data();  }
+
+    private:
+      std::vector<Value> values;
+
+      SpecializationConstants& implSet(uint32_t id, Type t, uint32_t bits) {
+        for(auto& i:values)
+          if(i.id==id) {
+            i.type = t;
+            i.bits = bits;
+            return *this;
+            }
+        Value v;
+        v.id   = id;
+        v.type = t;
+        v.bits = bits;
+        values.push_back(v);
+        return *this;
+        }
+    };
+
   namespace Detail {
     enum class IndexClass:uint8_t {
       i16=0,
@@ -294,6 +345,29 @@ namespace Tempest {
           uint64_t storFormat=0;
         };
 
+      struct MemoryStats {
+        struct Heap {
+          uint64_t reserved      = 0; // device memory, allocated by engine
+          uint64_t used          = 0; // part of reserved, occupied by resources
+          uint32_t pages         = 0;
+          uint64_t largestFree   = 0;
+          uint64_t cached        = 0; // freed pages, kept for reuse; not part of reserved
+          float    fragmentation = 0; // 1 - largestFree/(reserved-used)
+          uint64_t budget        = 0; // driver budget, or heap size, if budget is not known
+          uint64_t usage         = 0; // driver reported usage, or reserved
+          bool     deviceLocal   = false;
+          };
+        std::vector<Heap> heaps;
+        uint64_t          pendingRelease = 0; // destroyed resources, waiting for frames in flight to complete; part of used
+        uint32_t          pendingObjects = 0;
+        };
+      using MemoryBudgetCallback = std::function<void(const MemoryStats&)>;
+
+      struct PipelineCacheStats {
+        bool   pipelinesLoaded = false; // driver pipeline cache was seeded from file of setPipelineCacheDir
+        size_t shaderHits      = 0;     // shader modules, that took reflection (or HLSL/MSL translation) from cache
+        };
+
       struct NoCopy {
         NoCopy()=default;
         virtual ~NoCopy() = default;
@@ -305,6 +379,8 @@ namespace Tempest {
 
       struct Shared:NoCopy {
         mutable std::atomic_uint_fast32_t counter{0};
+        // last upload, that writes into resource: see UploadEngine
+        mutable std::atomic<uint64_t>     lastTransfer{0};
         };
 
       struct Device:NoCopy {
@@ -317,6 +393,12 @@ namespace Tempest {
         virtual bool wait(uint64_t time) = 0;
         virtual void reset() = 0;
         };
+      struct Readback:NoCopy {
+        virtual ~Readback()=default;
+        virtual bool isReady() = 0;
+        virtual void wait() = 0;
+        virtual void read(void* out) = 0;
+        };
       struct Swapchain:NoCopy {
         virtual ~Swapchain()=default;
         virtual void          reset()=0;
@@ -355,6 +437,14 @@ namespace Tempest {
         virtual ~Buffer()=default;
         virtual void  update  (const void* data,size_t off,size_t count,size_t sz,size_t alignedSz)=0;
         virtual void  read    (      void* data,size_t off,size_t size)=0;
+        virtual Readback* readAsync(size_t off,size_t size)=0;
+        virtual void* map     ()=0;
+        virtual void  unmap   ()=0;
+        };
+      struct Transient {
+        Buffer* buf    = nullptr;
+        size_t  offset = 0;
+        void*   data   = nullptr;
         };
       struct Desc:NoCopy   {
         virtual ~Desc()=default;
@@ -397,6 +487,9 @@ namespace Tempest {
         virtual void drawIndexed (const Buffer& vbo, const Buffer& ibo, Detail::IndexClass cls,
                                   size_t ioffset, size_t isize, size_t voffset, size_t firstInstance, size_t instanceCount)=0;
         virtual void dispatch    (size_t x, size_t y, size_t z)=0;
+
+        // host-visible slice, valid until command buffer is recorded again
+        virtual bool allocTransient(size_t size, size_t align, Transient& out)=0;
         };
 
       using PBuffer       = Detail::DSharedPtr<Buffer*>;
@@ -430,11 +523,13 @@ namespace Tempest {
 
       virtual PPipeline  createPipeline(Device* d, const RenderState &st, size_t stride, Topology tp,
                                         const PipelineLay &ulayImpl,
-                                        const Shader* vs, const Shader* tc, const Shader* te, const Shader* gs, const Shader* fs)=0;
+                                        const Shader* vs, const Shader* tc, const Shader* te, const Shader* gs, const Shader* fs,
+                                        const SpecializationConstants& spec)=0;
 
       virtual PCompPipeline createComputePipeline(Device* d,
                                                   const PipelineLay &ulayImpl,
-                                                  Shader* shader)=0;
+                                                  Shader* shader,
+                                                  const SpecializationConstants& spec)=0;
 
       virtual PShader    createShader(Device *d,const void* source,size_t src_size)=0;
 
@@ -449,10 +544,30 @@ namespace Tempest {
       virtual PTexture   createTexture(Device* d,const Pixmap& p,TextureFormat frm,uint32_t mips)=0;
       virtual PTexture   createTexture(Device* d,const uint32_t w,const uint32_t h,uint32_t mips, TextureFormat frm)=0;
       virtual PTexture   createStorage(Device* d,const uint32_t w,const uint32_t h,uint32_t mips, TextureFormat frm)=0;
+      virtual void       updateTexture(Device* d,const PTexture t,const Pixmap& p,TextureFormat frm,
+                                       uint32_t x, uint32_t y, uint32_t mip) = 0;
+      // host-visible buffer, to be filled by caller through map(), with image rows placed stride bytes apart
+      virtual PBuffer    createStaging(Device* d,const uint32_t w,const uint32_t h,TextureFormat frm,size_t& stride)=0;
+      virtual PTexture   createTexture(Device* d,const PBuffer& stage,size_t stride,const uint32_t w,const uint32_t h,uint32_t mips,TextureFormat frm)=0;
       virtual void       readPixels   (Device* d, Pixmap &out,const PTexture t,
                                        TextureLayout lay, TextureFormat frm,
                                        const uint32_t w, const uint32_t h, uint32_t mip) = 0;
       virtual void       readBytes    (Device* d, Buffer* buf, void* out, size_t size) = 0;
+      virtual Readback*  readPixelsAsync(Device* d, const PTexture t,
+                                         TextureLayout lay, TextureFormat frm,
+                                         const uint32_t w, const uint32_t h, uint32_t mip) = 0;
+
+      virtual size_t     defragment   (Device* d, size_t byteBudget, size_t moveBudget) = 0;
+      virtual void       memoryStats  (Device* d, MemoryStats& out) = 0;
+      virtual void       setMemoryBudgetCallback(Device* d, float fraction, MemoryBudgetCallback fn) = 0;
+      virtual void       setPageCacheSize(Device* d, size_t bytes) = 0;
+      virtual void       trimPageCache   (Device* d, size_t keepBytes) = 0;
+      virtual void       setPipelineCacheDir(Device* d, const char* dir) = 0;
+      virtual void       savePipelineCache  (Device* d) = 0;
+      virtual void       pipelineCacheStats (Device* d, PipelineCacheStats& out) = 0;
+      // compiles pipeline variants for given layouts ahead of first use
+      virtual void       prewarm(Device* d, Pipeline* p, FboLayout** lay, size_t count) = 0;
+      virtual void       setAsyncPipelines(Device* d, bool async) = 0;
 
       virtual void       present  (Device *d, Swapchain* sw)=0;
 
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// Graphics-queue parts of uploads (queue ownership acquire), that nothing uses yet: ordered by upload serial.
+// Device postpones them, until submission, that reads uploaded resources. Postponed batch can't complete,
+// so staging memory it holds is bounded: oldest entries go to queue, once MAX_BYTES is exceeded.
+// Entries are submitted by fn(Cmd&) under lock of the queue, so queue order follows serial order.
+template<class Cmd>
+class AcquireQueue final {
+  public:
+    enum : size_t {
+      MAX_BYTES = 32*1024*1024,
+      };
+
+    // cmd is postponed, if it may be and fits into MAX_BYTES; otherwise it's submitted after all postponed before.
+    // Returns true, if cmd was postponed
+    template<class Fn>
+    bool push(Cmd& cmd, uint64_t serial, size_t bytes, bool mayPostpone, Fn&& fn) {
+      std::lock_guard<std::mutex> guard(sync);
+      if(mayPostpone && serial!=0 && bytes<=MAX_BYTES) {
+        size_t n = 0;
+        for(; n<pending.size() && held+bytes>MAX_BYTES; ++n) {
+          fn(*pending[n].cmd);
+          held -= pending[n].bytes;
+          }
+        pending.erase(pending.begin(),pending.begin()+ptrdiff_t(n));
+        pending.push_back(Entry{&cmd,serial,bytes});
+        held += bytes;
+        return true;
+        }
+      // cmd may use resources of earlier uploads
+      for(auto& i:pending)
+        fn(*i.cmd);
+      pending.clear();
+      held = 0;
+      fn(cmd);
+      return false;
+      }
+
+    // submits postponed entries with serial<=given one; uint64_t(-1) submits all of them
+    template<class Fn>
+    void submit(uint64_t serial, Fn&& fn) {
+      std::lock_guard<std::mutex> guard(sync);
+      size_t n = 0;
+      for(; n<pending.size() && pending[n].serial<=serial; ++n) {
+        fn(*pending[n].cmd);
+        held -= pending[n].bytes;
+        }
+      pending.erase(pending.begin(),pending.begin()+ptrdiff_t(n));
+      }
+
+    size_t size() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return pending.size();
+      }
+
+    size_t heldBytes() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return held;
+      }
+
+  private:
+    struct Entry {
+      Cmd*     cmd    = nullptr;
+      uint64_t serial = 0;
+      size_t   bytes  = 0;
+      };
+
+    mutable std::mutex sync;
+    std::vector<Entry> pending;
+    size_t             held = 0;
+  };
+
+}}
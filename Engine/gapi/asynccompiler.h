@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// Worker threads for background pipeline compilation.
+// Threads are started on first push, so devices that never pre-warm don't pay for them.
+class AsyncCompiler {
+  public:
+    using Task = std::function<void()>;
+
+    explicit AsyncCompiler(uint32_t threads=2):maxThreads(threads==0 ? 1 : threads) {}
+    AsyncCompiler(const AsyncCompiler&)=delete;
+
+    // tasks, that are not started yet, are dropped; running ones are completed
+    ~AsyncCompiler() {
+      std::deque<Task> drop;
+      {
+      std::lock_guard<std::mutex> guard(sync);
+      stop = true;
+      std::swap(drop,queue);
+      }
+      cv.notify_all();
+      for(auto& i:workers)
+        i.join();
+      }
+
+    // thread-safe; fn must not throw
+    void push(Task&& fn) {
+      {
+      std::lock_guard<std::mutex> guard(sync);
+      queue.emplace_back(std::move(fn));
+      if(workers.size()<maxThreads && workers.size()<queue.size()+running)
+        workers.emplace_back(&AsyncCompiler::workerFunc,this);
+      }
+      cv.notify_one();
+      }
+
+    // waits, until all pushed tasks are complete
+    void wait() {
+      std::unique_lock<std::mutex> guard(sync);
+      idle.wait(guard,[this](){ return queue.empty() && running==0; });
+      }
+
+    size_t pending() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return queue.size()+running;
+      }
+
+  private:
+    void workerFunc() {
+      std::unique_lock<std::mutex> guard(sync);
+      while(true) {
+        cv.wait(guard,[this](){ return stop || !queue.empty(); });
+        if(stop)
+          return;
+        Task fn = std::move(queue.front());
+        queue.pop_front();
+        ++running;
+        guard.unlock();
+        fn();
+        // release captures outside of lock
+        fn = nullptr;
+        guard.lock();
+        --running;
+        if(queue.empty() && running==0)
+          idle.notify_all();
+        }
+      }
+
+    const size_t               maxThreads;
+    mutable std::mutex         sync;
+    std::condition_variable    cv, idle;
+    std::deque<Task>           queue;
+    size_t                     running = 0;
+    bool                       stop    = false;
+    std::vector<std::thread>   workers;
+  };
+
+}}
@@ -0,0 +1,62 @@
+#include "cachefile.h"
+
+#include <Tempest/File>
+#include <Tempest/Platform>
+#include <Tempest/TextCodec>
+#include <cstdio>
+#include <system_error>
+
+#ifdef __WINDOWS__
+#include <windows.h>
+#endif
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+// rename over existing file: reader sees either old or new cache, never a gap between remove and rename
+static bool replace(const std::string& from, const std::string& to) {
+#ifdef __WINDOWS__
+  const std::u16string f = TextCodec::toUtf16(from);
+  const std::u16string t = TextCodec::toUtf16(to);
+  return MoveFileExW(reinterpret_cast<const wchar_t*>(f.c_str()),reinterpret_cast<const wchar_t*>(t.c_str()),
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)!=FALSE;
+#else
+  return std::rename(from.c_str(),to.c_str())==0;
+#endif
+  }
+
+std::string CacheFile::directory(const char* dir) {
+  std::string ret = (dir!=nullptr ? dir : "");
+  if(!ret.empty() && ret.back()!='/' && ret.back()!='\\')
+    ret += '/';
+  return ret;
+  }
+
+bool CacheFile::read(const std::string& path, std::vector<uint8_t>& out) {
+  try {
+    RFile f(path);
+    out.resize(f.size());
+    return f.read(out.data(),out.size())==out.size();
+    }
+  catch(const std::system_error&) {
+    // no cache yet
+    return false;
+    }
+  }
+
+bool CacheFile::write(const std::string& path, const std::vector<uint8_t>& data) {
+  const std::string tmp = path+".tmp";
+  bool              ok  = false;
+  try {
+    WFile f(tmp);
+    ok = f.write(data.data(),data.size())==data.size() && f.flush();
+    }
+  catch(const std::system_error&) {
+    ok = false;
+    }
+  if(!ok || !replace(tmp,path)) {
+    std::remove(tmp.c_str());
+    return false;
+    }
+  return true;
+  }
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// Files of on-disk caches, see Device::setPipelineCacheDir
+class CacheFile final {
+  public:
+    // dir with trailing separator, or empty string
+    static std::string directory(const char* dir);
+
+    // false, if there is no cache yet
+    static bool        read (const std::string& path, std::vector<uint8_t>& out);
+    // file is written aside and replaced: crash in the middle must not leave half-written cache
+    static bool        write(const std::string& path, const std::vector<uint8_t>& data);
+  };
+
+}}
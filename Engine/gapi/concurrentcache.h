@@ -0,0 +1,189 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// Insert-only hash table for per-layout / per-state object caches.
+// Lookups are wait-free: open addressing over atomic slots, no locks.
+// Inserts are serialized; growth is read-copy-update: bigger table is filled and published atomically,
+// while previous tables stay alive until destruction, since readers may still walk them.
+// Values are never moved: references, returned by find/get, stay valid for cache lifetime.
+// Lookup counters write to shared cache line on every find: collected only if CountStats is set (tests, benchmarks).
+template<class K, class V, class Hash=std::hash<K>, class Eq=std::equal_to<K>, bool CountStats=false>
+class ConcurrentCache {
+  public:
+    // lookups, hits and probes stay zero without CountStats
+    struct Stats {
+      uint64_t lookups = 0;
+      uint64_t hits    = 0; // lookups, that found existing value
+      uint64_t probes  = 0; // slots visited by all lookups: probes/lookups is average lookup cost
+      uint64_t size    = 0;
+      };
+
+    ConcurrentCache(Hash h=Hash(), Eq e=Eq()):hash(h), eq(e) {
+      tables.emplace_back(new Table(INITIAL_SIZE));
+      current.store(tables.back().get(),std::memory_order_release);
+      }
+    ConcurrentCache(const ConcurrentCache&)=delete;
+
+    // wait-free
+    V* find(const K& k) const {
+      return implFind(k,mix(hash(k)));
+      }
+
+    // returns existing value, or default-constructs new one and calls init(key,value) on it under writer lock;
+    // if init throws, nothing is inserted
+    template<class Init>
+    V& get(const K& k, Init&& init) {
+      const size_t h = mix(hash(k));
+      if(V* v = implFind(k,h))
+        return *v;
+
+      std::lock_guard<std::mutex> guard(sync);
+      // could be inserted by other writer, since lock-free attempt
+      if(V* v = lookup(*current.load(std::memory_order_acquire),k,h,nullptr))
+        return *v;
+
+      nodes.emplace_back(h,k);
+      Node& n = nodes.back();
+      try {
+        init(n.key,n.value);
+        }
+      catch(...) {
+        nodes.pop_back();
+        throw;
+        }
+      publish(n);
+      return n.value;
+      }
+
+    // not thread-safe: intended for destruction of cached objects
+    template<class Fn>
+    void forEach(Fn fn) {
+      for(auto& i:nodes)
+        fn(i.key,i.value);
+      }
+
+    size_t size() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return nodes.size();
+      }
+
+    Stats stats() const {
+      Stats s;
+      s.lookups = lookups.load(std::memory_order_relaxed);
+      s.hits    = hits   .load(std::memory_order_relaxed);
+      s.probes  = probes .load(std::memory_order_relaxed);
+      s.size    = size();
+      return s;
+      }
+
+  private:
+    enum : size_t {
+      INITIAL_SIZE = 8,
+      };
+
+    struct Node {
+      Node(size_t h, const K& k):hash(h), key(k) {}
+      const size_t hash;
+      const K      key;
+      V            value{};
+      };
+
+    struct Table {
+      explicit Table(size_t size):mask(size-1), slot(new std::atomic<Node*>[size]) {
+        for(size_t i=0; i<size; ++i)
+          slot[i].store(nullptr,std::memory_order_relaxed);
+        }
+      const size_t                         mask;
+      size_t                               used = 0;
+      std::unique_ptr<std::atomic<Node*>[]> slot;
+      };
+
+    // std::hash is identity for integers and pointers on common implementations: spread bits before masking
+    static size_t mix(size_t h) {
+      h ^= h >> 16;
+      h *= size_t(0x85ebca6b);
+      h ^= h >> 13;
+      h *= size_t(0xc2b2ae35);
+      h ^= h >> 16;
+      return h;
+      }
+
+    V* implFind(const K& k, size_t h) const {
+      size_t probe = 0;
+      V*     ret   = lookup(*current.load(std::memory_order_acquire),k,h,CountStats ? &probe : nullptr);
+      if(CountStats) {
+        // statistics only: plain load/store instead of atomic increment, concurrent updates may be lost
+        count(lookups,1);
+        count(probes, probe);
+        if(ret!=nullptr)
+          count(hits,1);
+        }
+      return ret;
+      }
+
+    static void count(std::atomic<uint64_t>& c, uint64_t v) {
+      c.store(c.load(std::memory_order_relaxed)+v,std::memory_order_relaxed);
+      }
+
+    V* lookup(const Table& t, const K& k, size_t h, size_t* probe) const {
+      for(size_t i=h&t.mask, n=0; n<=t.mask; i=(i+1)&t.mask, ++n) {
+        Node* node = t.slot[i].load(std::memory_order_acquire);
+        if(probe!=nullptr)
+          ++(*probe);
+        if(node==nullptr)
+          return nullptr;
+        if(node->hash==h && eq(node->key,k))
+          return &node->value;
+        }
+      return nullptr;
+      }
+
+    static void insert(Table& t, Node& n) {
+      for(size_t i=n.hash&t.mask;; i=(i+1)&t.mask) {
+        if(t.slot[i].load(std::memory_order_relaxed)==nullptr) {
+          // release: value is initialized, before node becomes visible
+          t.slot[i].store(&n,std::memory_order_release);
+          ++t.used;
+          return;
+          }
+        }
+      }
+
+    void publish(Node& n) {
+      Table* t = current.load(std::memory_order_relaxed);
+      // load factor 1/2: probe sequences stay short, and there is always a free slot to end search
+      if((t->used+1)*2 > t->mask+1) {
+        tables.emplace_back(new Table((t->mask+1)*2));
+        Table* next = tables.back().get();
+        for(auto& i:nodes)
+          insert(*next,i);
+        current.store(next,std::memory_order_release);
+        return;
+        }
+      insert(*t,n);
+      }
+
+    Hash                                hash;
+    Eq                                  eq;
+    std::atomic<Table*>                 current{nullptr};
+
+    mutable std::mutex                  sync;
+    std::deque<Node>                    nodes;
+    std::vector<std::unique_ptr<Table>> tables;
+
+    mutable std::atomic<uint64_t>       lookups{0};
+    mutable std::atomic<uint64_t>       hits{0};
+    mutable std::atomic<uint64_t>       probes{0};
+  };
+
+}}
@@ -1,145 +1,431 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <forward_list>
+#include <memory>
 #include <mutex>
+#include <vector>
 #include <algorithm>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace Tempest {
 namespace Detail {
 
+inline uint32_t bitScanForward(uint32_t v) noexcept {
+#if defined(_MSC_VER)
+  unsigned long ret = 0;
+  _BitScanForward(&ret,v);
+  return uint32_t(ret);
+#else
+  return uint32_t(__builtin_ctz(v));
+#endif
+  }
+
+inline uint32_t bitScanReverse(uint32_t v) noexcept {
+#if defined(_MSC_VER)
+  unsigned long ret = 0;
+  _BitScanReverse(&ret,v);
+  return uint32_t(ret);
+#else
+  return uint32_t(31-__builtin_clz(v));
+#endif
+  }
+
+// Two-level segregated fit (TLSF) sub-allocator over device memory pages.
+// First level splits free blocks by power of two, second level splits each power into SL_COUNT linear ranges;
+// both levels are tracked by bitmasks, so lookup, split and merge are constant time.
+// Pages live in shards with own lock: every heap has HEAP_SHARDS of them, and a thread allocates from its own one first,
+// so threads, allocating from the same heap (device-local buffers and textures share it), don't contend either.
+// Other shards of the heap are searched, if not locked, before new page is allocated. Page remembers its shard, for free.
 template<class MemoryProvider>
 class DeviceAllocator {
   struct Page;
   struct Block;
+  struct BlockPool;
+  struct Shard;
   public:
     enum {
-      DEFAULT_PAGE_SIZE=128*1024*1024
+      DEFAULT_PAGE_SIZE=128*1024*1024,
+      SHARD_COUNT      =16,
+      HEAP_SHARDS      =4,
       };
     using Memory=typename MemoryProvider::DeviceMemory;
     static const constexpr Memory null=Memory{};
 
-    explicit DeviceAllocator(MemoryProvider& device):device(device){}
+    explicit DeviceAllocator(MemoryProvider& device, size_t pageSize=DEFAULT_PAGE_SIZE):device(device),pageSize(pageSize){}
 
     DeviceAllocator(const DeviceAllocator&)=delete;
 
     ~DeviceAllocator(){
-      for(auto& i:pages)
-        device.free(i.memory,i.size,i.type);
+      for(auto& s:shards)
+        for(auto& i:s.pages)
+          release(i);
       }
 
     struct Allocation {
       Page*  page  =nullptr;
+      Block* block =nullptr;
       size_t offset=0,size=0;
       };
 
+    struct Stats {
+      uint64_t reserved   =0;
+      uint64_t used       =0;
+      uint64_t largestFree=0;
+      uint32_t pages      =0;
+      };
+
+    struct Movable {
+      void*      owner=nullptr;
+      Allocation src;
+      };
+
     Allocation alloc(size_t size, size_t align, uint32_t heapId, uint32_t typeId, bool hostVisible) {
-      std::lock_guard<std::mutex> guard(sync);
-      for(auto& i:pages){
-        if(i.type==heapId && i.allocated+size<=i.allSize){
-          auto ret=i.alloc(size,align,device);
-          if(ret.page!=nullptr)
-            return ret;
+      const uint32_t slot = threadSlot();
+      for(uint32_t sh=0; sh<HEAP_SHARDS; ++sh) {
+        auto& s = shard(heapId,slot+sh);
+        // shards of other threads are not waited for: own page is cheaper, than contention on every allocation
+        std::unique_lock<std::mutex> guard(s.sync,std::defer_lock);
+        if(sh==0)
+          guard.lock();
+        else if(!guard.try_lock())
+          continue;
+        for(auto& i:s.pages){
+          if(i.type==heapId && i.allocated+size<=i.allSize){
+            auto ret=i.alloc(size,align);
+            if(ret.page!=nullptr)
+              return ret;
+            }
           }
         }
-      return rawAlloc(size,align,heapId,typeId,hostVisible,false);
+      auto& s = shard(heapId,slot);
+      std::lock_guard<std::mutex> guard(s.sync);
+      return rawAlloc(s,size,align,heapId,typeId,hostVisible,false);
       }
 
     void free(const Allocation& a){
-      std::lock_guard<std::mutex> guard(sync);
+      auto& s = *a.page->shard;
+      std::lock_guard<std::mutex> guard(s.sync);
       a.page->free(a);
       if(a.page->allocated==0){
-        device.free(a.page->memory,a.page->size,a.page->type);
-        pages.remove(*a.page);
+        release(*a.page);
+        s.pages.remove(*a.page);
         }
       }
 
     Allocation dedicatedAlloc(size_t size, size_t align, uint32_t heapId, uint32_t typeId, bool hostVisible) {
-      std::lock_guard<std::mutex> guard(sync);
-      return rawAlloc(size,align,heapId,typeId,hostVisible,true);
+      auto& s = shard(heapId,threadSlot());
+      std::lock_guard<std::mutex> guard(s.sync);
+      return rawAlloc(s,size,align,heapId,typeId,hostVisible,true);
+      }
+
+    // owner!=nullptr marks allocation as relocatable by defragment
+    void setOwner(const Allocation& a, void* owner) {
+      std::lock_guard<std::mutex> guard(a.page->shard->sync);
+      a.block->owner  = owner;
+      a.block->moving = false;
+      }
+
+    // Picks the most sparse page, which has only relocatable allocations and fits into free space of denser pages.
+    // Returns up to byteBudget bytes in up to moveBudget of its allocations; those stay marked as moving until setOwner or free.
+    // Allocations, which lost their owner in the meantime (setOwner(a,nullptr)), are skipped.
+    size_t defragment(size_t byteBudget, size_t moveBudget, std::vector<Movable>& out) {
+      // shard with the most sparse candidate
+      Shard*   best      = nullptr;
+      uint32_t heapId    = 0;
+      uint64_t bestUsed  = 0, bestSize = 1;
+      for(auto& s:shards) {
+        std::lock_guard<std::mutex> guard(s.sync);
+        Page* src = sparsest(s,nullptr);
+        if(src!=nullptr && (best==nullptr || uint64_t(src->allocated)*bestSize<bestUsed*src->allSize)) {
+          best     = &s;
+          heapId   = src->type;
+          bestUsed = src->allocated;
+          bestSize = src->allSize;
+          }
+        }
+      if(best==nullptr)
+        return 0;
+
+      // free space of denser pages in other shards of the heap: shards are locked one at a time, so it's an estimate
+      uint64_t space = 0;
+      for(uint32_t sh=0; sh<HEAP_SHARDS; ++sh) {
+        auto& s = shard(heapId,sh);
+        if(&s==best)
+          continue;
+        std::lock_guard<std::mutex> guard(s.sync);
+        for(auto& i:s.pages) {
+          if(i.type==heapId && !i.dedicated && isDenser(i,bestUsed,bestSize))
+            space += i.allSize-i.allocated;
+          }
+        }
+
+      std::lock_guard<std::mutex> guard(best->sync);
+      uint32_t live = 0;
+      Page*    src  = sparsest(*best,&live);
+      if(src==nullptr || src->type!=heapId)
+        return 0;
+
+      for(auto& i:best->pages) {
+        if(&i!=src && i.type==src->type && !i.dedicated && isDenser(i,src->allocated,src->allSize))
+          space += i.allSize-i.allocated;
+        }
+      if(live>space)
+        return 0;
+
+      size_t total = 0, moves = 0;
+      for(Block* b=src->first; b!=nullptr && total<byteBudget && moves<moveBudget; b=b->nextPhys) {
+        if(b->isFree || b->moving || b->owner==nullptr)
+          continue;
+        Movable m;
+        m.owner      = b->owner;
+        m.src.page   = src;
+        m.src.block  = b;
+        m.src.offset = b->offset;
+        m.src.size   = b->size;
+        out.push_back(m);
+        b->moving = true;
+        total    += b->size;
+        moves    += 1;
+        }
+      return total;
+      }
+
+    // new place for src, from a denser page of the same heap
+    Allocation relocate(const Allocation& src, size_t size, size_t align) {
+      uint32_t heapId = 0, used = 0, allSize = 0;
+      bool     hostVisible = false;
+      {
+      std::lock_guard<std::mutex> guard(src.page->shard->sync);
+      heapId      = src.page->type;
+      hostVisible = src.page->hostVisible;
+      used        = src.page->allocated;
+      allSize     = src.page->allSize;
+      }
+
+      for(uint32_t sh=0; sh<HEAP_SHARDS; ++sh) {
+        auto& s = shard(heapId,sh);
+        std::lock_guard<std::mutex> guard(s.sync);
+        for(auto& i:s.pages){
+          if(&i==src.page || i.type!=heapId || i.hostVisible!=hostVisible ||
+             i.dedicated || !isDenser(i,used,allSize))
+            continue;
+          if(i.allocated+size<=i.allSize){
+            auto ret=i.alloc(size,align);
+            if(ret.page!=nullptr)
+              return ret;
+            }
+          }
+        }
+      return Allocation();
+      }
+
+    // accumulates statistics of pages into perType[typeId]
+    void stats(Stats* perType, size_t typeCount) {
+      for(auto& s:shards) {
+        std::lock_guard<std::mutex> guard(s.sync);
+        for(auto& i:s.pages) {
+          if(i.typeId>=typeCount)
+            continue;
+          auto& st = perType[i.typeId];
+          st.reserved   += i.allSize;
+          st.used       += i.allocated;
+          st.largestFree = std::max<uint64_t>(st.largestFree,i.largestFree());
+          st.pages      += 1;
+          }
+        }
       }
 
   private:
-    Allocation rawAlloc(size_t size, size_t align, uint32_t heapId, uint32_t typeId, bool hostVisible, bool dedicated){
-      const uint32_t pgSize = (dedicated ? uint32_t(size) : std::max<uint32_t>(DEFAULT_PAGE_SIZE,uint32_t(size)));
-      Page pg(pgSize);
-      pg.memory      = device.alloc(pg.allSize,typeId);
+    Shard& shard(uint32_t heapId, uint32_t slot) { return shards[(heapId*HEAP_SHARDS + slot%HEAP_SHARDS)%SHARD_COUNT]; }
+
+    // small sequential id of calling thread
+    static uint32_t threadSlot() {
+      static std::atomic<uint32_t> next{0};
+      thread_local uint32_t        slot = next.fetch_add(1);
+      return slot;
+      }
+
+    static Page* sparsest(Shard& s, uint32_t* liveSize) {
+      Page*    src  = nullptr;
+      uint32_t live = 0;
+      for(auto& i:s.pages) {
+        uint32_t sz = 0;
+        if(i.dedicated || i.hostVisible || !i.movableSize(sz) || sz==0)
+          continue;
+        if(src==nullptr || uint64_t(i.allocated)*src->allSize<uint64_t(src->allocated)*i.allSize) {
+          src  = &i;
+          live = sz;
+          }
+        }
+      if(liveSize!=nullptr)
+        *liveSize = live;
+      return src;
+      }
+
+    static bool isDenser(const Page& a, uint64_t used, uint64_t allSize) {
+      return uint64_t(a.allocated)*allSize>=used*a.allSize;
+      }
+
+    void release(Page& pg) {
+      if(pg.mapped!=nullptr)
+        device.unmap(pg.memory);
+      device.free(pg.memory,pg.allSize,pg.typeId,pg.dedicated);
+      }
+
+    Allocation rawAlloc(Shard& s, size_t size, size_t align, uint32_t heapId, uint32_t typeId, bool hostVisible, bool dedicated){
+      auto&          pages  = s.pages;
+      const uint32_t pgSize = (dedicated ? uint32_t(size) : std::max<uint32_t>(uint32_t(pageSize),uint32_t(size)));
+      Page pg(pgSize,s.blocks);
+      pg.memory      = device.alloc(pg.allSize,typeId,dedicated);
       pg.type        = heapId;
+      pg.typeId      = typeId;
       pg.hostVisible = hostVisible;
+      pg.dedicated   = dedicated;
+      pg.shard       = &s;
       if(pg.memory==null)
         return Allocation();
+      if(hostVisible) {
+        // host-visible pages stay mapped for entire lifetime
+        pg.mapped = device.map(pg.memory,pg.allSize);
+        if(pg.mapped==nullptr) {
+          device.free(pg.memory,pg.allSize,pg.typeId,pg.dedicated);
+          return Allocation();
+          }
+        }
       try {
-        pages.push_front(Page(0));
+        pages.push_front(Page(0,s.blocks));
         }
       catch(...){
-        device.free(pg.memory,pg.size,pg.type);
+        release(pg);
         throw;
         }
       pages.front() = std::move(pg);
-      return pages.front().alloc(size,align,device);
-      }
-
-    void       freeDevMemory(Memory mem){
-      return device.free(mem);
+      if(!pages.front().init()) {
+        release(pages.front());
+        pages.pop_front();
+        return Allocation();
+        }
+      return pages.front().alloc(size,align);
       }
 
     MemoryProvider&         device;
-    std::mutex              sync;
-    std::forward_list<Page> pages;
+    const size_t            pageSize;
+    Shard                   shards[SHARD_COUNT];
   };
 
 template<class MemoryProvider>
 struct DeviceAllocator<MemoryProvider>::Block {
-  Block*   next  =nullptr;
-  uint32_t size  =0;
-  uint32_t offset=0;
+  Block*   prevPhys=nullptr;
+  Block*   nextPhys=nullptr;
+  Block*   prevFree=nullptr;
+  Block*   nextFree=nullptr;
+  void*    owner   =nullptr;
+  uint32_t offset  =0;
+  uint32_t size    =0;
+  bool     isFree  =false;
+  bool     moving  =false;
   };
 
+// Block headers are kept out of device memory and recycled through a chunked arena,
+// so split and merge never reach the system heap on the hot path.
 template<class MemoryProvider>
-struct DeviceAllocator<MemoryProvider>::Page : Block {
-  using    Block::next;
-  using    Block::size;
-  using    Block::offset;
+struct DeviceAllocator<MemoryProvider>::BlockPool {
+  enum {
+    CHUNK_SIZE=256
+    };
+  std::vector<std::unique_ptr<Block[]>> chunks;
+  Block*                                freeList=nullptr;
+
+  Block* alloc() noexcept {
+    if(freeList==nullptr) {
+      Block* chunk=new(std::nothrow) Block[CHUNK_SIZE];
+      if(chunk==nullptr)
+        return nullptr;
+      try {
+        chunks.emplace_back(chunk);
+        }
+      catch(...) {
+        delete[] chunk;
+        return nullptr;
+        }
+      for(size_t i=0; i<CHUNK_SIZE; ++i) {
+        chunk[i].nextFree = freeList;
+        freeList          = &chunk[i];
+        }
+      }
+    Block* b=freeList;
+    freeList=b->nextFree;
+    *b = Block();
+    return b;
+    }
+
+  void free(Block* b) noexcept {
+    b->nextFree = freeList;
+    freeList    = b;
+    }
+  };
+
+template<class MemoryProvider>
+struct DeviceAllocator<MemoryProvider>::Page {
+  enum : uint32_t {
+    SL_LOG2  = 4,
+    SL_COUNT = 1u<<SL_LOG2,
+    FL_COUNT = 32-SL_LOG2+1,
+    };
 
   Memory     memory = null;
+  void*      mapped = nullptr;
   std::mutex mmapSync;
   uint32_t   type        = 0;
+  uint32_t   typeId      = 0;
   uint32_t   allSize     = 0;
   uint32_t   allocated   = 0;
   bool       hostVisible = false;
+  bool       dedicated   = false;
 
-  Page(uint32_t sz) noexcept {
-    size   =sz;
-    allSize=sz;
+  Shard*     shard       = nullptr;
+  BlockPool* pool        = nullptr;
+  Block*     first       = nullptr;
+  uint32_t   flMask      = 0;
+  uint32_t   slMask[FL_COUNT]={};
+  Block*     heads [FL_COUNT][SL_COUNT]={};
+
+  Page(uint32_t sz, BlockPool& pool) noexcept :allSize(sz), pool(&pool) {
     }
 
   Page(Page&& p) noexcept {
-    std::swap(next,p.next);
-    size  =p.size;
-    offset=p.offset;
-    std::swap(memory,p.memory);
-    type        = p.type;
-    allSize     = p.allSize;
-    hostVisible = p.hostVisible;
+    *this = std::move(p);
     }
 
   ~Page(){
-    Block* b=next;
+    Block* b=first;
     while(b!=nullptr){
-      Block* p=b->next;
-      delete b;
+      Block* p=b->nextPhys;
+      pool->free(b);
       b=p;
       }
     }
 
   Page& operator=(Page&& p) noexcept {
-    std::swap(next,p.next);
-    size  =p.size;
-    offset=p.offset;
     std::swap(memory,p.memory);
+    std::swap(mapped,p.mapped);
+    std::swap(first, p.first);
+    std::swap(pool,  p.pool);
+    std::swap(flMask,p.flMask);
+    std::swap(slMask,p.slMask);
+    std::swap(heads, p.heads);
     type        = p.type;
+    typeId      = p.typeId;
     allSize     = p.allSize;
+    allocated   = p.allocated;
     hostVisible = p.hostVisible;
+    dedicated   = p.dedicated;
+    shard       = p.shard;
     return *this;
     }
 
@@ -147,101 +433,219 @@ struct DeviceAllocator<MemoryProvider>::Page : Block {
     return memory==other.memory;
     }
 
-  Allocation alloc(size_t size,size_t align,MemoryProvider& /*prov*/) noexcept {
-    Block*   b=this;
-    while(b!=nullptr) {
-      if(size<=b->size) {
-        size_t padding=b->offset%align;
-        if(padding==0)
-          return alloc(*b,size);
-
-        padding=align-padding;
-        if(size+padding==b->size) {
-          return alloc(*b,size,padding);
-          } else
-        if(size+padding<b->size){
-          Block* bp=new(std::nothrow) Block();
-          if(bp!=nullptr){
-            bp->next=b->next;
-            b->next =bp;
-
-            bp->size  =uint32_t(b->size-padding);
-            bp->offset=uint32_t(b->offset+padding);
-            b->size   =uint32_t(padding);
-
-            return alloc(*bp,size);
-            }
-          }
-        }
-      b=b->next;
+  bool init() noexcept {
+    first = pool->alloc();
+    if(first==nullptr)
+      return false;
+    first->offset = 0;
+    first->size   = allSize;
+    insertFree(first);
+    return true;
+    }
+
+  uint32_t largestFree() const noexcept {
+    if(flMask==0)
+      return 0;
+    const uint32_t fl  = bitScanReverse(flMask);
+    const uint32_t sl  = bitScanReverse(slMask[fl]);
+    uint32_t       ret = 0;
+    for(Block* b=heads[fl][sl]; b!=nullptr; b=b->nextFree)
+      ret = std::max(ret,b->size);
+    return ret;
+    }
+
+  // size of allocations, which are not moved yet; false, if page has pinned allocations
+  bool movableSize(uint32_t& sz) const noexcept {
+    for(Block* b=first; b!=nullptr; b=b->nextPhys) {
+      if(b->isFree || b->moving)
+        continue;
+      if(b->owner==nullptr)
+        return false;
+      sz += b->size;
       }
-    return Allocation{};
+    return true;
     }
 
-  Allocation alloc(Block& b,size_t size) noexcept {
-    Allocation a;
-    a.offset=b.offset;
-    a.page  =this;
-    a.size  =size;
+  static void mapping(uint32_t size, uint32_t& fl, uint32_t& sl) noexcept {
+    if(size<SL_COUNT) {
+      fl = 0;
+      sl = size;
+      return;
+      }
+    const uint32_t msb = bitScanReverse(size);
+    fl = msb-SL_LOG2+1;
+    sl = (size >> (msb-SL_LOG2)) ^ SL_COUNT;
+    }
 
-    b.offset +=uint32_t(size);
-    b.size   -=uint32_t(size);
-    allocated+=uint32_t(size);
-    return a;
+  // rounds size up to the next list, so every block found by search is large enough
+  static bool mappingSearch(uint64_t size, uint32_t& fl, uint32_t& sl) noexcept {
+    if(size>=SL_COUNT)
+      size += (uint64_t(1) << (bitScanReverse(uint32_t(std::min<uint64_t>(size,0xFFFFFFFF)))-SL_LOG2)) - 1;
+    if(size>0xFFFFFFFF)
+      return false;
+    mapping(uint32_t(size),fl,sl);
+    return true;
     }
 
-  Allocation alloc(Block& b,size_t size,size_t padding) noexcept {
-    Allocation a;
-    a.offset=b.offset+padding;
-    a.page  =this;
-    a.size  =size;
-
-    uint32_t sz=uint32_t(size+padding);
-    b.offset +=sz;
-    b.size   -=sz;
-    allocated+=uint32_t(size);
-    return a;
+  Block* findSuitable(uint32_t fl, uint32_t sl) const noexcept {
+    uint32_t slMap = slMask[fl] & (~0u << sl);
+    if(slMap==0) {
+      if(fl+1>=FL_COUNT)
+        return nullptr;
+      const uint32_t flMap = flMask & (~0u << (fl+1));
+      if(flMap==0)
+        return nullptr;
+      fl    = bitScanForward(flMap);
+      slMap = slMask[fl];
+      }
+    sl = bitScanForward(slMap);
+    return heads[fl][sl];
     }
 
-  void free(const Allocation& a) noexcept {
-    allocated -= uint32_t(a.size);
+  void insertFree(Block* b) noexcept {
+    uint32_t fl=0, sl=0;
+    mapping(b->size,fl,sl);
+    b->isFree   = true;
+    b->prevFree = nullptr;
+    b->nextFree = heads[fl][sl];
+    if(b->nextFree!=nullptr)
+      b->nextFree->prevFree = b;
+    heads[fl][sl] = b;
+    flMask     |= (1u << fl);
+    slMask[fl] |= (1u << sl);
+    }
 
-    Block* b=this;
-    while(b!=nullptr && (b->offset+b->size)<a.offset)
-      b=b->next;
+  void removeFree(Block* b) noexcept {
+    uint32_t fl=0, sl=0;
+    mapping(b->size,fl,sl);
+    if(b->prevFree!=nullptr)
+      b->prevFree->nextFree = b->nextFree;
+    if(b->nextFree!=nullptr)
+      b->nextFree->prevFree = b->prevFree;
+    if(heads[fl][sl]==b) {
+      heads[fl][sl] = b->nextFree;
+      if(heads[fl][sl]==nullptr) {
+        slMask[fl] &= ~(1u << sl);
+        if(slMask[fl]==0)
+          flMask &= ~(1u << fl);
+        }
+      }
+    b->isFree   = false;
+    b->prevFree = nullptr;
+    b->nextFree = nullptr;
+    }
 
-    if(b->offset+b->size==a.offset){
-      b->size+=uint32_t(a.size);
-      mergeWithNext(b);
-      return;
+  static uint32_t padding(const Block& b, size_t align) noexcept {
+    const size_t pad = b.offset%align;
+    return pad==0 ? 0 : uint32_t(align-pad);
+    }
+
+  Block* find(size_t size, size_t align) const noexcept {
+    uint32_t fl=0, sl=0;
+    // worst-case padding is align-1, so the first block of a suitable list always fits
+    if(mappingSearch(uint64_t(size)+align-1,fl,sl)) {
+      if(Block* b=findSuitable(fl,sl))
+        return b;
       }
-    if(b->offset==a.offset+a.size){
-      b->offset=uint32_t(a.offset);
-      b->size +=uint32_t(a.size);
-      return;
+    // blocks in the exact size class may still fit, once real padding is known
+    if(size>0xFFFFFFFF)
+      return nullptr;
+    mapping(uint32_t(size),fl,sl);
+    for(Block* b=heads[fl][sl]; b!=nullptr; b=b->nextFree)
+      if(size_t(b->size)>=size+padding(*b,align))
+        return b;
+    return nullptr;
+    }
+
+  // cut [b.offset, b.offset+size) out of b; the rest goes to r, as a new free block
+  void split(Block* b, uint32_t size, Block* r) noexcept {
+    r->offset   = b->offset+size;
+    r->size     = b->size-size;
+    r->prevPhys = b;
+    r->nextPhys = b->nextPhys;
+    if(b->nextPhys!=nullptr)
+      b->nextPhys->prevPhys = r;
+    b->nextPhys = r;
+    b->size     = size;
+    insertFree(r);
+    }
+
+  Allocation alloc(size_t size, size_t align) noexcept {
+    if(align==0)
+      align = 1;
+    Block* b=find(size,align);
+    if(b==nullptr)
+      return Allocation{};
+
+    const uint32_t pad  = padding(*b,align);
+    const uint32_t tail = uint32_t(b->size-pad-size);
+
+    Block* rPad  = nullptr;
+    Block* rTail = nullptr;
+    if(pad>0 && (rPad=pool->alloc())==nullptr)
+      return Allocation{};
+    if(tail>0 && (rTail=pool->alloc())==nullptr) {
+      if(rPad!=nullptr)
+        pool->free(rPad);
+      return Allocation{};
+      }
+
+    removeFree(b);
+    if(rPad!=nullptr) {
+      // head padding stays behind as separate free block
+      split(b,pad,rPad);
+      removeFree(rPad);
+      insertFree(b);
+      b = rPad;
       }
+    if(rTail!=nullptr)
+      split(b,uint32_t(size),rTail);
 
-    Block* r=new(std::nothrow) Block();
-    if(r==nullptr)
-      return; // no error, but sort of leak in Page
-    *r=*b;
-    b->next  =r;
-    b->size  =uint32_t(a.size);
-    b->offset=uint32_t(a.offset);
+    Allocation a;
+    a.page   = this;
+    a.block  = b;
+    a.offset = b->offset;
+    a.size   = size;
+    allocated += uint32_t(size);
+    return a;
     }
 
-  void mergeWithNext(Block* b) noexcept {
-    while(b->next!=nullptr){
-      if(b->offset+b->size==b->next->offset){
-        auto rm=b->next;
-        b->size+=b->next->size;
-        b->next=b->next->next;
-        delete rm;
-        } else {
-        return;
+  void free(const Allocation& a) noexcept {
+    allocated -= uint32_t(a.size);
+
+    Block* b=a.block;
+    b->owner  = nullptr;
+    b->moving = false;
+    if(Block* n=b->nextPhys) {
+      if(n->isFree) {
+        removeFree(n);
+        b->size    += n->size;
+        b->nextPhys = n->nextPhys;
+        if(n->nextPhys!=nullptr)
+          n->nextPhys->prevPhys = b;
+        pool->free(n);
         }
       }
+    if(Block* p=b->prevPhys) {
+      if(p->isFree) {
+        removeFree(p);
+        p->size    += b->size;
+        p->nextPhys = b->nextPhys;
+        if(b->nextPhys!=nullptr)
+          b->nextPhys->prevPhys = p;
+        pool->free(b);
+        b = p;
+        }
+      }
+    insertFree(b);
     }
   };
-}}
 
+template<class MemoryProvider>
+struct DeviceAllocator<MemoryProvider>::Shard {
+  std::mutex              sync;
+  BlockPool               blocks;
+  std::forward_list<Page> pages;
+  };
+
+}}
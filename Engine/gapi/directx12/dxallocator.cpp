@@ -81,14 +81,14 @@ DxBuffer DxAllocator::alloc(const void* mem, size_t count, size_t size, size_t a
   return DxBuffer(owner,std::move(ret),UINT(resDesc.Width));
   }
 
-DxTexture DxAllocator::alloc(const Pixmap& pm, uint32_t mip, DXGI_FORMAT format) {
+DxTexture DxAllocator::alloc(const uint32_t w, const uint32_t h, uint32_t mip, DXGI_FORMAT format) {
   ComPtr<ID3D12Resource> ret;
 
   D3D12_RESOURCE_DESC resDesc = {};
   resDesc.MipLevels          = mip;
   resDesc.Format             = format;
-  resDesc.Width              = pm.w();
-  resDesc.Height             = pm.h();
+  resDesc.Width              = w;
+  resDesc.Height             = h;
   resDesc.Flags              = D3D12_RESOURCE_FLAG_NONE;
   resDesc.DepthOrArraySize   = 1;
   resDesc.SampleDesc.Count   = 1;
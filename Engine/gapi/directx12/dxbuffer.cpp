@@ -59,6 +59,35 @@ void DxBuffer::read(void* data, size_t off, size_t size) {
   readFromMapped(stage,data,0,size);
   }
 
+AbstractGraphicsApi::Readback* DxBuffer::readAsync(size_t off, size_t size) {
+  auto& dx = *dev;
+
+  std::unique_ptr<DxDevice::Readback> ret(new DxDevice::Readback(dx,size,size,1,16));
+  Detail::DSharedPtr<Buffer*> pbuf(this);
+  auto& cmd = ret->commands();
+  cmd.hold(pbuf);
+  cmd.copy(ret->staging(),ret->offset(), *this,off,size);
+  ret->submit();
+  return ret.release();
+  }
+
+void* DxBuffer::map() {
+  D3D12_HEAP_PROPERTIES prop = {};
+  impl->GetHeapProperties(&prop,nullptr);
+  if(prop.Type!=D3D12_HEAP_TYPE_UPLOAD)
+    return nullptr;
+
+  dev->dataMgr().waitFor(this); // write-after-write case
+  D3D12_RANGE rgn    = {0,0};
+  void*       mapped = nullptr;
+  dxAssert(impl->Map(0,&rgn,&mapped));
+  return mapped;
+  }
+
+void DxBuffer::unmap() {
+  impl->Unmap(0,nullptr);
+  }
+
 void DxBuffer::uploadS3TC(const uint8_t* d, uint32_t w, uint32_t h, uint32_t mipCnt, UINT blockSize) {
   ID3D12Resource& ret = *impl;
 
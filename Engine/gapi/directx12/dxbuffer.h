@@ -17,6 +17,10 @@ class DxBuffer : public AbstractGraphicsApi::Buffer {
 
     void  update(const void* data,size_t off,size_t count,size_t sz,size_t alignedSz) override;
     void  read  (void* data, size_t off, size_t sz) override;
+    auto  readAsync(size_t off, size_t sz) -> AbstractGraphicsApi::Readback* override;
+
+    void* map   () override;
+    void  unmap () override;
 
     void  uploadS3TC(const uint8_t* d, uint32_t w, uint32_t h, uint32_t mip, UINT blockSize);
 
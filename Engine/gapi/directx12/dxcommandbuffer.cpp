@@ -218,6 +218,7 @@ void DxCommandBuffer::reset() {
   if(resetDone)
     return;
   clearStage();
+  transient.reset();
   dxAssert(pool->Reset());
   dxAssert(impl->Reset(pool.get(),nullptr));
   resetDone = true;
@@ -481,6 +482,19 @@ void DxCommandBuffer::drawIndexed(const AbstractGraphicsApi::Buffer& ivbo, const
   impl->DrawIndexedInstanced(UINT(isize),UINT(instanceCount),UINT(ioffset),INT(voffset),UINT(firstInstance));
   }
 
+bool DxCommandBuffer::allocTransient(size_t size, size_t align, AbstractGraphicsApi::Transient& out) {
+  return transient.alloc(size,align,out,[this](TransientHeap<DxBuffer>::Chunk& c){
+    auto usage = MemUsage::VertexBuffer|MemUsage::IndexBuffer|MemUsage::UniformBuffer;
+    c.buf.reset(new DxBuffer(dev.allocator.alloc(nullptr,c.size,1,1,usage,BufferHeap::Upload)));
+    // upload heap can stay mapped for entire lifetime of resource
+    D3D12_RANGE rgn    = {0,0};
+    void*       mapped = nullptr;
+    dxAssert(c.buf->impl->Map(0,&rgn,&mapped));
+    c.mapped = reinterpret_cast<uint8_t*>(mapped);
+    return true;
+    });
+  }
+
 void DxCommandBuffer::dispatch(size_t x, size_t y, size_t z) {
   if(T_UNLIKELY(ssboBarriers)) {
     curUniforms->ssboBarriers(resState);
@@ -497,6 +511,11 @@ void DxCommandBuffer::copy(AbstractGraphicsApi::Buffer& dstBuf, size_t offsetDes
 
 void DxCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t width, size_t height, size_t mip,
                            const AbstractGraphicsApi::Buffer& srcBuf, size_t offset) {
+  copy(dstTex,0,0,width,height,mip,srcBuf,offset,0);
+  }
+
+void DxCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t x, size_t y, size_t width, size_t height, size_t mip,
+                           const AbstractGraphicsApi::Buffer& srcBuf, size_t offset, size_t rowPitch) {
   auto& dst = reinterpret_cast<DxTexture&>(dstTex);
   auto& src = reinterpret_cast<const DxBuffer&>(srcBuf);
 
@@ -517,6 +536,8 @@ void DxCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t width, s
     foot.Footprint.RowPitch = UINT((width*bpp+D3D12_TEXTURE_DATA_PITCH_ALIGNMENT-1)
                                    /D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)*D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
     }
+  if(rowPitch!=0)
+    foot.Footprint.RowPitch = UINT(rowPitch);
 
   D3D12_TEXTURE_COPY_LOCATION dstLoc = {};
   dstLoc.pResource        = dst.impl.get();
@@ -528,7 +549,7 @@ void DxCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t width, s
   srcLoc.Type             = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
   srcLoc.PlacedFootprint  = foot;
 
-  impl->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, nullptr);
+  impl->CopyTextureRegion(&dstLoc, UINT(x), UINT(y), 0, &srcLoc, nullptr);
   }
 
 void DxCommandBuffer::implCopy(AbstractGraphicsApi::Buffer& dstBuf, size_t width, size_t height, size_t mip,
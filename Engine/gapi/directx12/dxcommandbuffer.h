@@ -6,6 +6,7 @@
 
 #include "comptr.h"
 #include "gapi/resourcestate.h"
+#include "gapi/transientheap.h"
 #include "dxframebuffer.h"
 #include "dxpipelinelay.h"
 
@@ -53,6 +54,8 @@ class DxCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
                       size_t ioffset, size_t isize, size_t voffset, size_t firstInstance, size_t instanceCount) override;
     void dispatch    (size_t x, size_t y, size_t z) override;
 
+    bool allocTransient(size_t size, size_t align, AbstractGraphicsApi::Transient& out) override;
+
     void changeLayout(AbstractGraphicsApi::Buffer&  buf, BufferLayout  prev, BufferLayout  next) override;
     void changeLayout(AbstractGraphicsApi::Attach&  img, TextureLayout prev, TextureLayout next, bool byRegion) override;
     void changeLayout(AbstractGraphicsApi::Texture& tex, TextureLayout prev, TextureLayout next, uint32_t mipId);
@@ -62,6 +65,8 @@ class DxCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
 
     void copy(AbstractGraphicsApi::Buffer&  dest, size_t offsetDest, const AbstractGraphicsApi::Buffer& src, size_t offsetSrc, size_t size);
     void copy(AbstractGraphicsApi::Texture& dest, size_t width, size_t height, size_t mip, const AbstractGraphicsApi::Buffer&  src, size_t offset);
+    // rowPitch: in bytes, 0 - width is aligned to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+    void copy(AbstractGraphicsApi::Texture& dest, size_t x, size_t y, size_t width, size_t height, size_t mip, const AbstractGraphicsApi::Buffer&  src, size_t offset, size_t rowPitch);
 
     ID3D12GraphicsCommandList* get() { return impl.get(); }
 
@@ -80,6 +85,7 @@ class DxCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     UINT                              vboStride=0;
 
     ResourceState                     resState;
+    TransientHeap<DxBuffer>           transient;
     bool                              ssboBarriers = false;
     bool                              isInCompute  = false;
 
@@ -9,6 +9,7 @@
 #include "dxtexture.h"
 #include "dxshader.h"
 #include "dxpipeline.h"
+#include "gapi/cachefile.h"
 #include "builtin_shader.h"
 
 using namespace Tempest;
@@ -61,8 +62,8 @@ DxDevice::DxDevice(IDXGIAdapter1& adapter, const ApiEntry& dllApi)
   st.setZTestMode   (RenderState::ZTestMode::Always);
   st.setCullFaceMode(RenderState::CullMode::NoCull);
 
-  auto blitVs = DSharedPtr<DxShader*>(new DxShader(blit_vert_sprv,sizeof(blit_vert_sprv)));
-  auto blitFs = DSharedPtr<DxShader*>(new DxShader(blit_frag_sprv,sizeof(blit_frag_sprv)));
+  auto blitVs = DSharedPtr<DxShader*>(new DxShader(*this,blit_vert_sprv,sizeof(blit_vert_sprv)));
+  auto blitFs = DSharedPtr<DxShader*>(new DxShader(*this,blit_frag_sprv,sizeof(blit_frag_sprv)));
 
   blitLayout  = DSharedPtr<DxPipelineLay*>(new DxPipelineLay(*this,blitFs.handler->lay));
   blit        = DSharedPtr<DxPipeline*>   (new DxPipeline   (*this,st,0,Triangles,*blitLayout.handler,
@@ -70,15 +71,36 @@ DxDevice::DxDevice(IDXGIAdapter1& adapter, const ApiEntry& dllApi)
   }
 
   data.reset(new DataMgr(*this));
+  readback.reset(new ReadbackMgr(*this));
   }
 
 DxDevice::~DxDevice() {
+  savePipelineCache();
   blit       = DSharedPtr<DxPipeline*>();
   blitLayout = DSharedPtr<DxPipelineLay*>();
+  readback.reset();
   data.reset();
   CloseHandle(idleEvent);
   }
 
+void DxDevice::setPipelineCacheDir(const char* dir) {
+  std::lock_guard<std::mutex> guard(pipelineCacheSync);
+  cacheDir = CacheFile::directory(dir);
+
+  std::vector<uint8_t> file;
+  if(CacheFile::read(cacheDir+translation.fileName(),file) && !translation.deserialize(file))
+    Log::d("DirectX12Api: shader cache is outdated or damaged - ignored");
+  }
+
+void DxDevice::savePipelineCache() {
+  std::lock_guard<std::mutex> guard(pipelineCacheSync);
+  if(cacheDir.empty() || !translation.isDirty())
+    return;
+  const std::string path = cacheDir+translation.fileName();
+  if(!CacheFile::write(path,translation.serialize()))
+    Log::e("DirectX12Api: unable to write ",path);
+  }
+
 void DxDevice::getProp(IDXGIAdapter1& adapter, AbstractGraphicsApi::Props& prop) {
   DXGI_ADAPTER_DESC1 desc={};
   adapter.GetDesc1(&desc);
@@ -175,7 +197,7 @@ void DxDevice::waitData() {
   }
 
 void Detail::DxDevice::waitIdle() {
-  std::lock_guard<SpinLock> guard(syncCmdQueue);
+  std::lock_guard<std::mutex> guard(syncCmdQueue);
   dxAssert(cmdQueue->Signal(idleFence.get(),DxFence::Ready));
   dxAssert(idleFence->SetEventOnCompletion(DxFence::Ready,idleEvent));
   WaitForSingleObjectEx(idleEvent, INFINITE, FALSE);
@@ -185,7 +207,7 @@ void Detail::DxDevice::waitIdle() {
 void DxDevice::submit(DxCommandBuffer& cmdBuffer, DxFence& sync) {
   sync.reset();
 
-  std::lock_guard<SpinLock> guard(syncCmdQueue);
+  std::lock_guard<std::mutex> guard(syncCmdQueue);
   ID3D12CommandList* cmd[] = {cmdBuffer.get()};
   cmdQueue->ExecuteCommandLists(1, cmd);
   sync.signal(*cmdQueue);
@@ -15,6 +15,8 @@
 #include "dxallocator.h"
 #include "dxfence.h"
 #include "gapi/uploadengine.h"
+#include "gapi/readbackring.h"
+#include "gapi/translationcache.h"
 
 namespace Tempest {
 
@@ -166,7 +168,9 @@ class DxDevice : public AbstractGraphicsApi::Device {
     DxDevice(IDXGIAdapter1& adapter, const ApiEntry& dllApi);
     ~DxDevice() override;
 
-    using DataMgr = UploadEngine<DxDevice,DxCommandBuffer,DxFence,DxBuffer>;
+    using DataMgr     = UploadEngine<DxDevice,DxCommandBuffer,DxFence,DxBuffer>;
+    using ReadbackMgr = ReadbackRing<DxDevice,DxBuffer>;
+    using Readback    = AsyncReadback<DxDevice,DxBuffer>;
 
     void         waitData();
     void         waitIdle() override;
@@ -176,12 +180,13 @@ class DxDevice : public AbstractGraphicsApi::Device {
     void         submit(DxCommandBuffer& cmd,DxFence& sync);
 
     DataMgr&     dataMgr() { return *data; }
+    ReadbackMgr& readbackMgr() { return *readback; }
 
     ApiEntry                    dllApi;
 
     AbstractGraphicsApi::Props  props;
     ComPtr<ID3D12Device>        device;
-    SpinLock                    syncCmdQueue;
+    std::mutex                  syncCmdQueue;
     ComPtr<ID3D12CommandQueue>  cmdQueue;
 
     DxAllocator                 allocator;
@@ -189,11 +194,21 @@ class DxDevice : public AbstractGraphicsApi::Device {
     DSharedPtr<DxPipelineLay*>  blitLayout;
     DSharedPtr<DxPipeline*>     blit;
 
+    // seeds hlsl translations from file in dir: D3DCompile is still done on every run
+    void              setPipelineCacheDir(const char* dir);
+    void              savePipelineCache();
+    TranslationCache& translationCache() { return translation; }
+
   private:
     ComPtr<ID3D12Fence>         idleFence;
     HANDLE                      idleEvent=nullptr;
 
     std::unique_ptr<DataMgr>    data;
+    std::unique_ptr<ReadbackMgr> readback;
+
+    std::string                 cacheDir;
+    std::mutex                  pipelineCacheSync;
+    TranslationCache            translation{ShaderTranslator::hlsl()};
   };
 
 }}
@@ -13,7 +13,8 @@ using namespace Tempest::Detail;
 
 DxPipeline::DxPipeline(DxDevice& device,
                        const RenderState& st, size_t stride, Topology tp, const DxPipelineLay& ulay,
-                       const DxShader* vert, const DxShader* ctrl, const DxShader* tess, const DxShader* geom, const DxShader* frag)
+                       const DxShader* vert, const DxShader* ctrl, const DxShader* tess, const DxShader* geom, const DxShader* frag,
+                       const SpecializationConstants& sc)
   : sign(ulay.impl.get()), stride(UINT(stride)),
     device(device),
     vsShader(vert), tcShader(ctrl), teShader(tess), gsShader(geom), fsShader(frag), rState(st) {
@@ -27,6 +28,21 @@ DxPipeline::DxPipeline(DxDevice& device,
   pushConstantId = ulay.pushConstantId;
   ssboBarriers   = ulay.hasSsbo;
 
+  if(!sc.isEmpty()) {
+    const DxShader* sh[] = {vert,ctrl,tess,geom,frag};
+    const std::vector<ShaderReflection::SpecConstant>* decl[5] = {};
+    for(size_t i=0; i<5; ++i)
+      if(sh[i]!=nullptr)
+        decl[i] = &sh[i]->spec;
+    std::vector<ShaderReflection::SpecValue> spec;
+    ShaderReflection::specialize(spec,decl,5,sc);
+    specialize(vsShader,spec);
+    specialize(tcShader,spec);
+    specialize(teShader,spec);
+    specialize(gsShader,spec);
+    specialize(fsShader,spec);
+    }
+
   if(vert!=nullptr) {
     declSize = UINT(vert->vdecl.size());
     vsInput.reset(new D3D12_INPUT_ELEMENT_DESC[declSize]);
@@ -188,16 +204,30 @@ ComPtr<ID3D12PipelineState> DxPipeline::initGraphicsPipeline(const DxFboLayout&
   return ret;
   }
 
-DxCompPipeline::DxCompPipeline(DxDevice& device, const DxPipelineLay& ulay, DxShader& comp)
+void DxPipeline::specialize(DSharedPtr<const DxShader*>& sh, const std::vector<ShaderReflection::SpecValue>& spec) {
+  if(sh.handler==nullptr || sh.handler->spec.empty() || spec.empty())
+    return;
+  sh = DSharedPtr<const DxShader*>(new DxShader(*sh.handler,spec));
+  }
+
+DxCompPipeline::DxCompPipeline(DxDevice& device, const DxPipelineLay& ulay, DxShader& comp, const SpecializationConstants& sc)
   : sign(ulay.impl.get()) {
   sign.get()->AddRef();
 
   pushConstantId = ulay.pushConstantId;
   ssboBarriers   = ulay.hasSsbo;
 
+  DSharedPtr<const DxShader*> sh(&comp);
+  if(!sc.isEmpty()) {
+    const std::vector<ShaderReflection::SpecConstant>* decl[1] = {&comp.spec};
+    std::vector<ShaderReflection::SpecValue> spec;
+    ShaderReflection::specialize(spec,decl,1,sc);
+    DxPipeline::specialize(sh,spec);
+    }
+
   D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
   psoDesc.pRootSignature = sign.get();
-  psoDesc.CS             = comp.bytecode();
+  psoDesc.CS             = sh.handler->bytecode();
 
   dxAssert(device.device->CreateComputePipelineState(&psoDesc, uuid<ID3D12PipelineState>(), reinterpret_cast<void**>(&impl)));
   }
@@ -6,6 +6,7 @@
 #include <d3d12.h>
 #include "gapi/directx12/comptr.h"
 #include "utility/spinlock.h"
+#include "gapi/shaderreflection.h"
 
 #include "dxfbolayout.h"
 #include "dxpipelinelay.h"
@@ -20,7 +21,8 @@ class DxPipeline : public AbstractGraphicsApi::Pipeline {
   public:
     DxPipeline(DxDevice &device,
                const RenderState &st, size_t stride, Topology tp, const DxPipelineLay& ulay,
-               const DxShader* vert, const DxShader* ctrl, const DxShader* tess, const DxShader* geom,  const DxShader* frag);
+               const DxShader* vert, const DxShader* ctrl, const DxShader* tess, const DxShader* geom,  const DxShader* frag,
+               const SpecializationConstants& spec);
 
     struct Inst final {
       Inst() = default;
@@ -58,6 +60,10 @@ class DxPipeline : public AbstractGraphicsApi::Pipeline {
     D3D12_BLEND_DESC            getBlend(const RenderState &st) const;
     D3D12_RASTERIZER_DESC       getRaster(const RenderState &st) const;
     ComPtr<ID3D12PipelineState> initGraphicsPipeline(const DxFboLayout& frm);
+
+    static void                 specialize(DSharedPtr<const DxShader*>& sh, const std::vector<ShaderReflection::SpecValue>& spec);
+
+  friend class DxCompPipeline;
   };
 
 class DxCompPipeline : public AbstractGraphicsApi::CompPipeline {
@@ -65,7 +71,8 @@ class DxCompPipeline : public AbstractGraphicsApi::CompPipeline {
     DxCompPipeline()=default;
     DxCompPipeline(DxDevice &device,
                    const DxPipelineLay& ulay,
-                   DxShader& comp);
+                   DxShader& comp,
+                   const SpecializationConstants& spec);
 
     ComPtr<ID3D12RootSignature> sign;
     ComPtr<ID3D12PipelineState> impl;
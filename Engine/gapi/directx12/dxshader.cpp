@@ -6,74 +6,57 @@
 #include <Tempest/Log>
 #include <d3dcompiler.h>
 
-#include "gapi/shaderreflection.h"
-#include "thirdparty/spirv_cross/spirv_hlsl.hpp"
+#include "gapi/shadertranslator.h"
+#include "gapi/translationcache.h"
 
 using namespace Tempest;
 using namespace Tempest::Detail;
 
-DxShader::DxShader(const void *source, size_t src_size) {
-  if(src_size%4!=0)
-    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
-
-  spirv_cross::CompilerHLSL::Options optHLSL;
-  optHLSL.shader_model = 50;
-
-  spirv_cross::CompilerGLSL::Options optGLSL;
-  optGLSL.vertex.flip_vert_y = true;
-
-  std::string hlsl;
-  spv::ExecutionModel exec = spv::ExecutionModelMax;
-
-  try {
-    spirv_cross::CompilerHLSL comp(reinterpret_cast<const uint32_t*>(source),src_size/4);
-    comp.set_hlsl_options  (optHLSL);
-    comp.set_common_options(optGLSL);
-    // comp.remap_num_workgroups_builtin();
-    hlsl = comp.compile();
-    exec = comp.get_execution_model();
-
-    ShaderReflection::getVertexDecl(vdecl,comp);
-    ShaderReflection::getBindings(lay,comp);
-    }
-  catch(const std::bad_alloc&) {
-    throw;
-    }
-  catch(const spirv_cross::CompilerError& err) {
-#if !defined(NDEBUG)
-    Log::d("cross-compile error: \"",err.what(),"\"");
-#else
-    (void)err;
-#endif
-    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
-    }
-  catch(...) {
-    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+DxShader::DxShader(DxDevice& dev, const void *source, size_t src_size) {
+  ShaderTranslator::Result hlsl;
+  dev.translationCache().translate(hlsl,source,src_size);
+  vdecl = std::move(hlsl.vdecl);
+  lay   = std::move(hlsl.lay);
+  spec  = std::move(hlsl.spec);
+  compile(hlsl.source,hlsl.stage);
+
+  if(!spec.empty()) {
+    auto* code = reinterpret_cast<const uint32_t*>(source);
+    spirv.assign(code,code+src_size/4);
     }
+  }
+
+DxShader::DxShader(const DxShader& base, const std::vector<ShaderReflection::SpecValue>& values)
+  :vdecl(base.vdecl), lay(base.lay), spec(base.spec) {
+  ShaderTranslator::Result hlsl;
+  ShaderTranslator::translate(hlsl,ShaderTranslator::hlsl(),base.spirv.data(),base.spirv.size(),&values);
+  compile(hlsl.source,hlsl.stage);
+  }
 
-  static const char* target = nullptr;
-  switch(exec) {
-    case spv::ExecutionModelGLCompute:
+void DxShader::compile(const std::string& hlsl, ShaderReflection::Stage stage) {
+  const char* target = nullptr;
+  switch(stage) {
+    case ShaderReflection::Compute:
       target = "cs_5_0";
       break;
-    case spv::ExecutionModelVertex:
+    case ShaderReflection::Vertex:
       target = "vs_5_0";
       break;
-    case spv::ExecutionModelTessellationControl:
+    case ShaderReflection::Control:
       target = "hs_5_0";
       break;
-    case spv::ExecutionModelTessellationEvaluation:
+    case ShaderReflection::Evaluate:
       target = "ds_5_0";
       break;
-    case spv::ExecutionModelGeometry:
+    case ShaderReflection::Geometry:
       target = "gs_5_0";
       break;
-    case spv::ExecutionModelFragment:
+    case ShaderReflection::Fragment:
       target = "ps_5_0";
       break;
-    default: // unimplemented
-      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
     }
+  if(target==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
   //Log::d(hlsl);
 
   ComPtr<ID3DBlob> err;
@@ -14,7 +14,9 @@ class DxDevice;
 
 class DxShader:public AbstractGraphicsApi::Shader {
   public:
-    DxShader(const void* source, size_t src_size);
+    DxShader(DxDevice& dev, const void* source, size_t src_size);
+    // variant of base shader, with specialization constants baked in
+    DxShader(const DxShader& base, const std::vector<ShaderReflection::SpecValue>& values);
     ~DxShader();
 
     using Binding = ShaderReflection::Binding;
@@ -22,11 +24,16 @@ class DxShader:public AbstractGraphicsApi::Shader {
     D3D12_SHADER_BYTECODE    bytecode() const;
     void                     disasm() const;
 
-    std::vector<Decl::ComponentType> vdecl;
-    std::vector<Binding>             lay;
+    std::vector<Decl::ComponentType>            vdecl;
+    std::vector<Binding>                        lay;
+    std::vector<ShaderReflection::SpecConstant> spec;
 
   private:
     mutable ComPtr<ID3DBlob>         shader;
+    // kept only for shaders with specialization constants: hlsl has no specialization, variants are compiled from it
+    std::vector<uint32_t>            spirv;
+
+    void compile(const std::string& hlsl, ShaderReflection::Stage stage);
   };
 
 }}
@@ -107,7 +107,7 @@ struct DirectX12Api::Impl {
     Detail::DxDevice& dx   = *reinterpret_cast<Detail::DxDevice*>(d);
     Detail::DxFence&  fcpu = *reinterpret_cast<Detail::DxFence*>(doneCpu);
 
-    std::lock_guard<SpinLock> guard(dx.syncCmdQueue);
+    std::lock_guard<std::mutex> guard(dx.syncCmdQueue);
     fcpu.reset();
     dx.cmdQueue->ExecuteCommandLists(UINT(count), cmd);
     fcpu.signal(*dx.cmdQueue);
@@ -189,7 +189,8 @@ AbstractGraphicsApi::PFboLayout DirectX12Api::createFboLayout(AbstractGraphicsAp
 AbstractGraphicsApi::PPipeline DirectX12Api::createPipeline(AbstractGraphicsApi::Device* d, const RenderState& st, size_t stride,
                                                             Topology tp,
                                                             const PipelineLay& ulayImpl,
-                                                            const Shader* vs, const Shader* tc, const Shader* te, const Shader* gs, const Shader* fs) {
+                                                            const Shader* vs, const Shader* tc, const Shader* te, const Shader* gs, const Shader* fs,
+                                                            const SpecializationConstants& spec) {
   auto* dx   = reinterpret_cast<Detail::DxDevice*>(d);
   auto* vert = reinterpret_cast<const Detail::DxShader*>(vs);
   auto* ctrl = reinterpret_cast<const Detail::DxShader*>(tc);
@@ -198,21 +199,23 @@ AbstractGraphicsApi::PPipeline DirectX12Api::createPipeline(AbstractGraphicsApi:
   auto* frag = reinterpret_cast<const Detail::DxShader*>(fs);
   auto& ul   = reinterpret_cast<const Detail::DxPipelineLay&>(ulayImpl);
 
-  return PPipeline(new Detail::DxPipeline(*dx,st,stride,tp,ul,vert,ctrl,tess,geom,frag));
+  return PPipeline(new Detail::DxPipeline(*dx,st,stride,tp,ul,vert,ctrl,tess,geom,frag,spec));
   }
 
 AbstractGraphicsApi::PCompPipeline DirectX12Api::createComputePipeline(AbstractGraphicsApi::Device* d,
                                                                        const AbstractGraphicsApi::PipelineLay& ulayImpl,
-                                                                       AbstractGraphicsApi::Shader* shader) {
+                                                                       AbstractGraphicsApi::Shader* shader,
+                                                                       const SpecializationConstants& spec) {
   auto*   dx = reinterpret_cast<Detail::DxDevice*>(d);
   auto&   ul = reinterpret_cast<const Detail::DxPipelineLay&>(ulayImpl);
 
-  return PCompPipeline(new Detail::DxCompPipeline(*dx,ul,*reinterpret_cast<Detail::DxShader*>(shader)));
+  return PCompPipeline(new Detail::DxCompPipeline(*dx,ul,*reinterpret_cast<Detail::DxShader*>(shader),spec));
   }
 
-AbstractGraphicsApi::PShader DirectX12Api::createShader(AbstractGraphicsApi::Device*,
+AbstractGraphicsApi::PShader DirectX12Api::createShader(AbstractGraphicsApi::Device* d,
                                                         const void* source, size_t src_size) {
-  return PShader(new Detail::DxShader(source,src_size));
+  auto* dx = reinterpret_cast<Detail::DxDevice*>(d);
+  return PShader(new Detail::DxShader(*dx,source,src_size));
   }
 
 AbstractGraphicsApi::Fence* DirectX12Api::createFence(AbstractGraphicsApi::Device* d) {
@@ -285,7 +288,7 @@ AbstractGraphicsApi::PTexture DirectX12Api::createTexture(Device* d, const Pixma
   uint32_t          row    = p.w()*p.bpp();
   const uint32_t    pith   = ((row+D3D12_TEXTURE_DATA_PITCH_ALIGNMENT-1)/D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)*D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
   Detail::DxBuffer  stage  = dx.allocator.alloc(p.data(),p.h(),row,pith,MemUsage::TransferSrc,BufferHeap::Upload);
-  Detail::DxTexture buf    = dx.allocator.alloc(p,mipCnt,format);
+  Detail::DxTexture buf    = dx.allocator.alloc(p.w(),p.h(),mipCnt,format);
 
   Detail::DSharedPtr<Buffer*>  pstage(new Detail::DxBuffer (std::move(stage)));
   Detail::DSharedPtr<Texture*> pbuf  (new Detail::DxTexture(std::move(buf)));
@@ -329,7 +332,7 @@ AbstractGraphicsApi::PTexture DirectX12Api::createCompressedTexture(Device* d, c
     }
 
   Detail::DxBuffer  stage  = dx.allocator.alloc(nullptr,stageBufferSize,1,1,MemUsage::TransferSrc,BufferHeap::Upload);
-  Detail::DxTexture buf    = dx.allocator.alloc(p,mipCnt,format);
+  Detail::DxTexture buf    = dx.allocator.alloc(p.w(),p.h(),mipCnt,format);
   Detail::DSharedPtr<Buffer*>  pstage(new Detail::DxBuffer (std::move(stage)));
   Detail::DSharedPtr<Texture*> pbuf  (new Detail::DxTexture(std::move(buf)));
 
@@ -365,6 +368,41 @@ AbstractGraphicsApi::PTexture DirectX12Api::createCompressedTexture(Device* d, c
   return PTexture(pbuf.handler);
   }
 
+AbstractGraphicsApi::PBuffer DirectX12Api::createStaging(Device* d, const uint32_t w, const uint32_t h, TextureFormat frm, size_t& stride) {
+  Detail::DxDevice& dx  = *reinterpret_cast<Detail::DxDevice*>(d);
+  const uint32_t    bpp = uint32_t(Pixmap::bppForFormat(Pixmap::toPixmapFormat(frm)));
+  if(bpp==0 || isCompressedFormat(frm))
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
+
+  const uint32_t   row   = w*bpp;
+  const uint32_t   pith  = ((row+D3D12_TEXTURE_DATA_PITCH_ALIGNMENT-1)/D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)*D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+  Detail::DxBuffer stage = dx.allocator.alloc(nullptr,h,row,pith,MemUsage::TransferSrc,BufferHeap::Upload);
+  stride = pith;
+  return PBuffer(new Detail::DxBuffer(std::move(stage)));
+  }
+
+AbstractGraphicsApi::PTexture DirectX12Api::createTexture(Device* d, const PBuffer& stage, size_t stride, const uint32_t w, const uint32_t h,
+                                                          uint32_t mipCnt, TextureFormat frm) {
+  Detail::DxDevice& dx  = *reinterpret_cast<Detail::DxDevice*>(d);
+  Detail::DxTexture buf = dx.allocator.alloc(w,h,mipCnt,Detail::nativeFormat(frm));
+
+  Detail::DSharedPtr<Buffer*>  pstage = stage;
+  Detail::DSharedPtr<Texture*> pbuf(new Detail::DxTexture(std::move(buf)));
+
+  auto cmd = dx.dataMgr().get();
+  cmd->begin();
+  cmd->hold(pbuf);
+  cmd->hold(pstage); // preserve stage buffer, until gpu side copy is finished
+
+  cmd->copy(*pbuf.handler,0,0,w,h,0,*pstage.handler,0,stride);
+  if(mipCnt>1)
+    cmd->generateMipmap(*pbuf.handler, TextureLayout::TransferDest, w, h, mipCnt); else
+    cmd->changeLayout(*pbuf.handler, TextureLayout::TransferDest, TextureLayout::Sampler, uint32_t(-1));
+  cmd->end();
+  dx.dataMgr().submit(std::move(cmd));
+  return PTexture(pbuf.handler);
+  }
+
 AbstractGraphicsApi::PTexture DirectX12Api::createTexture(Device* d, const uint32_t w, const uint32_t h, uint32_t mipCnt, TextureFormat frm) {
   Detail::DxDevice& dx = *reinterpret_cast<Detail::DxDevice*>(d);
 
@@ -383,6 +421,28 @@ AbstractGraphicsApi::PTexture DirectX12Api::createStorage(AbstractGraphicsApi::D
   return PTexture(pbuf.handler);
   }
 
+void DirectX12Api::updateTexture(Device* d, const PTexture t, const Pixmap& p, TextureFormat /*frm*/,
+                                 uint32_t x, uint32_t y, uint32_t mip) {
+  Detail::DxDevice& dx    = *reinterpret_cast<Detail::DxDevice*>(d);
+  uint32_t          row   = p.w()*p.bpp();
+  const uint32_t    pith  = ((row+D3D12_TEXTURE_DATA_PITCH_ALIGNMENT-1)/D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)*D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+  Detail::DxBuffer  stage = dx.allocator.alloc(p.data(),p.h(),row,pith,MemUsage::TransferSrc,BufferHeap::Upload);
+
+  Detail::DSharedPtr<Buffer*>  pstage(new Detail::DxBuffer(std::move(stage)));
+  Detail::DSharedPtr<Texture*> ptex = t;
+
+  auto cmd = dx.dataMgr().get();
+  cmd->begin();
+  cmd->hold(ptex);
+  cmd->hold(pstage); // preserve stage buffer, until gpu side copy is finished
+
+  cmd->changeLayout(*ptex.handler, TextureLayout::Sampler, TextureLayout::TransferDest, mip);
+  cmd->copy(*ptex.handler,x,y,p.w(),p.h(),mip,*pstage.handler,0,0);
+  cmd->changeLayout(*ptex.handler, TextureLayout::TransferDest, TextureLayout::Sampler, mip);
+  cmd->end();
+  dx.dataMgr().submit(std::move(cmd));
+  }
+
 void DirectX12Api::readPixels(Device* d, Pixmap& out, const PTexture t, TextureLayout lay,
                               TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip) {
   Detail::DxDevice&  dx = *reinterpret_cast<Detail::DxDevice*>(d);
@@ -409,6 +469,28 @@ void DirectX12Api::readPixels(Device* d, Pixmap& out, const PTexture t, TextureL
     }
   }
 
+AbstractGraphicsApi::Readback* DirectX12Api::readPixelsAsync(Device* d, const PTexture t, TextureLayout lay,
+                                                            TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip) {
+  Detail::DxDevice&  dx = *reinterpret_cast<Detail::DxDevice*>(d);
+  Detail::DxTexture& tx = *reinterpret_cast<Detail::DxTexture*>(t.handler);
+
+  Pixmap::Format  pfrm  = Pixmap::toPixmapFormat(frm);
+  size_t          bpp   = Pixmap::bppForFormat(pfrm);
+  if(bpp==0)
+    throw std::runtime_error("not implemented");
+
+  const size_t row  = w*bpp;
+  const size_t pith = ((row+D3D12_TEXTURE_DATA_PITCH_ALIGNMENT-1)/D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)*D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+  std::unique_ptr<Detail::DxDevice::Readback> ret(new Detail::DxDevice::Readback(dx,row,pith,h,D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+
+  PTexture pt  = t;
+  auto&    cmd = ret->commands();
+  cmd.hold(pt);
+  cmd.copy(ret->staging(),lay,w,h,mip,tx,ret->offset());
+  ret->submit();
+  return ret.release();
+  }
+
 void DirectX12Api::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buffer* buf, void* out, size_t size) {
   buf->read(out,0,size);
   }
@@ -422,7 +504,7 @@ void DirectX12Api::present(AbstractGraphicsApi::Device* d, AbstractGraphicsApi::
   Detail::DxDevice&    dx = *reinterpret_cast<Detail::DxDevice*>(d);
   Detail::DxSwapchain* sx = reinterpret_cast<Detail::DxSwapchain*>(sw);
 
-  std::lock_guard<SpinLock> guard(dx.syncCmdQueue);
+  std::lock_guard<std::mutex> guard(dx.syncCmdQueue);
   sx->queuePresent();
   }
 
@@ -452,6 +534,51 @@ void DirectX12Api::submit(AbstractGraphicsApi::Device* d, AbstractGraphicsApi::C
   impl->submit(d,cmdList,count,doneCpu);
   }
 
+size_t DirectX12Api::defragment(AbstractGraphicsApi::Device*, size_t, size_t) {
+  // committed resources only, nothing to compact
+  return 0;
+  }
+
+void DirectX12Api::memoryStats(AbstractGraphicsApi::Device*, MemoryStats& out) {
+  out.heaps.clear();
+  }
+
+void DirectX12Api::setMemoryBudgetCallback(AbstractGraphicsApi::Device*, float, MemoryBudgetCallback) {
+  }
+
+void DirectX12Api::setPageCacheSize(AbstractGraphicsApi::Device*, size_t) {
+  }
+
+void DirectX12Api::trimPageCache(AbstractGraphicsApi::Device*, size_t) {
+  }
+
+void DirectX12Api::setPipelineCacheDir(AbstractGraphicsApi::Device* d, const char* dir) {
+  // driver keeps own on-disk cache of compiled pso; here only spirv->hlsl translation is cached
+  auto* dx = reinterpret_cast<Detail::DxDevice*>(d);
+  dx->setPipelineCacheDir(dir);
+  }
+
+void DirectX12Api::savePipelineCache(AbstractGraphicsApi::Device* d) {
+  auto* dx = reinterpret_cast<Detail::DxDevice*>(d);
+  dx->savePipelineCache();
+  }
+
+void DirectX12Api::pipelineCacheStats(AbstractGraphicsApi::Device* d, PipelineCacheStats& out) {
+  auto* dx = reinterpret_cast<Detail::DxDevice*>(d);
+  out = PipelineCacheStats();
+  out.shaderHits = dx->translationCache().hits();
+  }
+
+void DirectX12Api::prewarm(AbstractGraphicsApi::Device*, Pipeline* p, FboLayout** lay, size_t count) {
+  // no background compilation yet: variants are compiled on calling thread
+  auto& px = *reinterpret_cast<Detail::DxPipeline*>(p);
+  for(size_t i=0; i<count; ++i)
+    px.instance(*reinterpret_cast<Detail::DxFboLayout*>(lay[i]));
+  }
+
+void DirectX12Api::setAsyncPipelines(AbstractGraphicsApi::Device*, bool) {
+  }
+
 void DirectX12Api::getCaps(AbstractGraphicsApi::Device* d, AbstractGraphicsApi::Props& caps) {
   Detail::DxDevice& dx = *reinterpret_cast<Detail::DxDevice*>(d);
   caps = dx.props;
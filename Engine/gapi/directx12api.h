@@ -30,10 +30,12 @@ class DirectX12Api : public AbstractGraphicsApi {
 
     PPipeline      createPipeline(Device* d, const RenderState &st, size_t stride,
                                   Topology tp, const PipelineLay& ulayImpl,
-                                  const Shader* vs, const Shader* tc, const Shader* te, const Shader* gs, const Shader* fs) override;
+                                  const Shader* vs, const Shader* tc, const Shader* te, const Shader* gs, const Shader* fs,
+                                  const SpecializationConstants& spec) override;
     PCompPipeline  createComputePipeline(Device* d,
                                          const PipelineLay &ulayImpl,
-                                         Shader* sh) override;
+                                         Shader* sh,
+                                         const SpecializationConstants& spec) override;
 
     PShader        createShader(Device *d, const void* source, size_t src_size) override;
 
@@ -44,11 +46,29 @@ class DirectX12Api : public AbstractGraphicsApi {
     PTexture       createTexture(Device* d,const Pixmap& p,TextureFormat frm,uint32_t mips) override;
     PTexture       createTexture(Device* d,const uint32_t w,const uint32_t h,uint32_t mips, TextureFormat frm) override;
     PTexture       createStorage(Device* d,const uint32_t w,const uint32_t h,uint32_t mips, TextureFormat frm) override;
+    void           updateTexture(Device* d,const PTexture t,const Pixmap& p,TextureFormat frm,
+                                 uint32_t x, uint32_t y, uint32_t mip) override;
+    PBuffer        createStaging(Device* d,const uint32_t w,const uint32_t h,TextureFormat frm,size_t& stride) override;
+    PTexture       createTexture(Device* d,const PBuffer& stage,size_t stride,const uint32_t w,const uint32_t h,uint32_t mips,TextureFormat frm) override;
 
     void           readPixels(Device *d, Pixmap &out, const PTexture t,
                               TextureLayout lay, TextureFormat frm,
                               const uint32_t w, const uint32_t h, uint32_t mip) override;
     void           readBytes(Device* d, Buffer* buf, void* out, size_t size) override;
+    Readback*      readPixelsAsync(Device *d, const PTexture t,
+                                   TextureLayout lay, TextureFormat frm,
+                                   const uint32_t w, const uint32_t h, uint32_t mip) override;
+
+    size_t         defragment(Device* d, size_t byteBudget, size_t moveBudget) override;
+    void           memoryStats(Device* d, MemoryStats& out) override;
+    void           setMemoryBudgetCallback(Device* d, float fraction, MemoryBudgetCallback fn) override;
+    void           setPageCacheSize(Device* d, size_t bytes) override;
+    void           trimPageCache   (Device* d, size_t keepBytes) override;
+    void           setPipelineCacheDir(Device* d, const char* dir) override;
+    void           savePipelineCache  (Device* d) override;
+    void           pipelineCacheStats (Device* d, PipelineCacheStats& out) override;
+    void           prewarm(Device* d, Pipeline* p, FboLayout** lay, size_t count) override;
+    void           setAsyncPipelines(Device* d, bool async) override;
 
     Desc*          createDescriptors(Device* d, PipelineLay& layP) override;
 
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include <Tempest/RenderState>
+
+#include <cstdint>
+
+namespace Tempest {
+namespace Detail {
+
+// Part of fixed-function state, that can be set by commands instead of being baked into pipeline.
+// Pipelines, that differ only in dynamic part, share one native pipeline object.
+class DynamicState final {
+  public:
+    enum Flags : uint8_t {
+      None     = 0,
+      Topology = 1,
+      Blend    = 2, // blend enable, blend equation and z-write: Painter blend modes differ in all of them
+      };
+
+    DynamicState()=default;
+    DynamicState(const RenderState& st, Tempest::Topology tp)
+      :tp(tp), blend(st.hasBlend()), zWrite(st.isZWriteEnabled()),
+       src(st.blendSource()), dst(st.blendDest()), op(st.blendOperation()) {}
+
+    // state of shared pipeline: dynamic part is reset to defaults
+    static RenderState baseState(const RenderState& st, uint8_t flags) {
+      RenderState ret = st;
+      if(flags & Blend) {
+        ret.setBlendSource  (RenderState::BlendMode::one);
+        ret.setBlendDest    (RenderState::BlendMode::zero);
+        ret.setBlendOp      (RenderState::BlendOp::Add);
+        ret.setZWriteEnabled(true);
+        }
+      return ret;
+      }
+
+    static Tempest::Topology baseTopology(Tempest::Topology tp, uint8_t flags) {
+      return (flags & Topology) ? Triangles : tp;
+      }
+
+    // parts, that differ
+    uint8_t diff(const DynamicState& s) const {
+      uint8_t ret = None;
+      if(tp!=s.tp)
+        ret |= Topology;
+      if(blend!=s.blend || zWrite!=s.zWrite || src!=s.src || dst!=s.dst || op!=s.op)
+        ret |= Blend;
+      return ret;
+      }
+
+    Tempest::Topology      tp     = Triangles;
+    bool                   blend  = false;
+    bool                   zWrite = true;
+    RenderState::BlendMode src    = RenderState::BlendMode::one;
+    RenderState::BlendMode dst    = RenderState::BlendMode::zero;
+    RenderState::BlendOp   op     = RenderState::BlendOp::Add;
+  };
+
+// Native pipeline and dynamic state, bound to command buffer: tells, which commands have to be recorded
+class DynamicStateTracker final {
+  public:
+    struct Cmd {
+      bool    bindPipeline = false;
+      uint8_t setState     = DynamicState::None;
+      };
+
+    // dynamic: parts of state, that are dynamic in pipeline
+    Cmd bind(uint64_t pipeline, uint8_t dynamic, const DynamicState& st) {
+      Cmd ret;
+      if(pipeline!=cur) {
+        ret.bindPipeline = true;
+        cur              = pipeline;
+        // pipeline with static state invalidates previously set dynamic state
+        valid           &= dynamic;
+        }
+      ret.setState = uint8_t(dynamic & (~valid | state.diff(st)));
+      if(ret.setState!=DynamicState::None) {
+        valid |= ret.setState;
+        if(ret.setState & DynamicState::Topology)
+          state.tp = st.tp;
+        if(ret.setState & DynamicState::Blend) {
+          state.blend  = st.blend;
+          state.zWrite = st.zWrite;
+          state.src    = st.src;
+          state.dst    = st.dst;
+          state.op     = st.op;
+          }
+        }
+      return ret;
+      }
+
+    void reset() {
+      cur   = 0;
+      valid = DynamicState::None;
+      }
+
+  private:
+    uint64_t     cur   = 0;
+    uint8_t      valid = DynamicState::None;
+    DynamicState state;
+  };
+
+}}
@@ -15,6 +15,10 @@ class MtBuffer : public Tempest::AbstractGraphicsApi::Buffer {
 
     void  update  (const void* data, size_t off, size_t count, size_t sz, size_t alignedSz) override;
     void  read    (      void* data, size_t off, size_t size) override;
+    auto  readAsync(size_t off, size_t size) -> AbstractGraphicsApi::Readback* override;
+
+    void* map     () override;
+    void  unmap   () override;
 
     MtDevice&     dev;
     id<MTLBuffer> impl;
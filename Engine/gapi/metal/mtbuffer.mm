@@ -1,5 +1,6 @@
 #include "mtbuffer.h"
 #include "mtdevice.h"
+#include "mtreadback.h"
 
 #include "utility/compiller_hints.h"
 #include "gapi/graphicsmemutils.h"
@@ -87,6 +88,40 @@ void MtBuffer::read(void *data, size_t off, size_t size) {
     }
   }
 
+Tempest::AbstractGraphicsApi::Readback* MtBuffer::readAsync(size_t off, size_t size) {
+  @autoreleasepool {
+    MTLResourceOptions opt   = MTLResourceStorageModeShared | MTLResourceCPUCacheModeDefaultCache | MTLResourceHazardTrackingModeTracked;
+    id<MTLDevice>      dx    = dev.impl;
+    id<MTLBuffer>      stage = [dx newBufferWithLength:size options:opt];
+    if(stage==nil)
+      throw std::system_error(GraphicsErrc::OutOfVideoMemory);
+
+    id<MTLCommandBuffer>      cmd = [dev.queue commandBuffer];
+    id<MTLBlitCommandEncoder> enc = [cmd blitCommandEncoder];
+    [enc copyFromBuffer:impl
+                        sourceOffset:off
+                        toBuffer:stage
+                        destinationOffset:0
+                        size:size];
+    [enc endEncoding];
+    [cmd commit];
+
+    return new MtReadback(cmd,stage,size);
+    }
+  }
+
+void* MtBuffer::map() {
+  if(impl.storageMode==MTLStorageModePrivate)
+    return nullptr;
+  return [impl contents];
+  }
+
+void MtBuffer::unmap() {
+  if(impl.storageMode!=MTLStorageModeManaged)
+    return;
+  [impl didModifyRange: NSMakeRange(0,impl.length)];
+  }
+
 void MtBuffer::implUpdate(const void *data, size_t off, size_t count, size_t sz, size_t alignedSz) {
   id<MTLBuffer> buf = impl;
   auto ptr = reinterpret_cast<uint8_t*>([buf contents]);
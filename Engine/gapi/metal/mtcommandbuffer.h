@@ -6,6 +6,7 @@
 #import  <Metal/MTLRenderCommandEncoder.h>
 
 #include "gapi/shaderreflection.h"
+#include "gapi/transientheap.h"
 
 #include "mtpipelinelay.h"
 
@@ -55,6 +56,8 @@ class MtCommandBuffer : public AbstractGraphicsApi::CommandBuffer {
                       size_t ioffset, size_t isize, size_t voffset, size_t firstInstance, size_t instanceCount) override;
     void dispatch    (size_t x, size_t y, size_t z) override;
 
+    bool allocTransient(size_t size, size_t align, AbstractGraphicsApi::Transient& out) override;
+
     void copy        (AbstractGraphicsApi::Buffer& dest, TextureLayout defLayout, uint32_t width, uint32_t height, uint32_t mip, AbstractGraphicsApi::Texture& src, size_t offset) override;
 
   private:
@@ -80,6 +83,8 @@ class MtCommandBuffer : public AbstractGraphicsApi::CommandBuffer {
     id<MTLComputeCommandEncoder> encComp = nil;
     id<MTLBlitCommandEncoder>    encBlit = nil;
 
+    TransientHeap<MtBuffer> transient;
+
     uint32_t             curVboId = 0;
     MtFramebuffer*       curFbo   = nullptr;
     const MtPipelineLay* curLay   = nullptr;
@@ -37,6 +37,8 @@ void MtCommandBuffer::end() {
   }
 
 void MtCommandBuffer::reset() {
+  transient.reset();
+
   MTLCommandBufferDescriptor* desc = [MTLCommandBufferDescriptor new];
   desc.retainedReferences = NO;
 
@@ -159,6 +161,15 @@ void MtCommandBuffer::setViewport(const Rect &r) {
   [encDraw setViewport:v];
   }
 
+bool MtCommandBuffer::allocTransient(size_t size, size_t align, AbstractGraphicsApi::Transient& out) {
+  return transient.alloc(size,align,out,[this](TransientHeap<MtBuffer>::Chunk& c){
+    const MTLResourceOptions opt = MTLResourceStorageModeShared | MTLResourceCPUCacheModeWriteCombined;
+    c.buf.reset(new MtBuffer(device,nullptr,c.size,1,1,opt));
+    c.mapped = reinterpret_cast<uint8_t*>([c.buf->impl contents]);
+    return true;
+    });
+  }
+
 void MtCommandBuffer::draw(const AbstractGraphicsApi::Buffer& ivbo, size_t offset, size_t vertexCount, size_t firstInstance, size_t instanceCount) {
   auto& vbo = reinterpret_cast<const MtBuffer&>(ivbo);
   [encDraw setVertexBuffer:vbo.impl
@@ -5,6 +5,7 @@
 #include <Tempest/Except>
 
 #include "../utility/compiller_hints.h"
+#include "gapi/translationcache.h"
 #include "mtsamplercache.h"
 #import  <Metal/MTLPixelFormat.h>
 #import  <Metal/MTLVertexDescriptor.h>
@@ -208,7 +209,17 @@ class MtDevice : public AbstractGraphicsApi::Device {
     autoDevice     dev;
     MtSamplerCache samplers;
 
+    // seeds msl translations from file in dir: metal library is still compiled on every run
+    void              setPipelineCacheDir(const char* dir);
+    void              savePipelineCache();
+    TranslationCache& translationCache() { return translation; }
+
     static void deductProps(AbstractGraphicsApi::Props& prop, id<MTLDevice> dev);
+
+  private:
+    std::string      cacheDir;
+    std::mutex       pipelineCacheSync;
+    TranslationCache translation{ShaderTranslator::msl()};
   };
 
 inline void mtAssert(id obj, NSError* err) {
@@ -2,6 +2,8 @@
 
 #include <Tempest/Log>
 
+#include "gapi/cachefile.h"
+
 #include <Metal/MTLDevice.h>
 #include <Metal/MTLCommandQueue.h>
 
@@ -44,6 +46,25 @@ MtDevice::MtDevice(const char* name) : dev(name), samplers(dev.impl) {
   }
 
 MtDevice::~MtDevice() {
+  savePipelineCache();
+  }
+
+void MtDevice::setPipelineCacheDir(const char* dir) {
+  std::lock_guard<std::mutex> guard(pipelineCacheSync);
+  cacheDir = CacheFile::directory(dir);
+
+  std::vector<uint8_t> file;
+  if(CacheFile::read(cacheDir+translation.fileName(),file) && !translation.deserialize(file))
+    Log::d("MetalApi: shader cache is outdated or damaged - ignored");
+  }
+
+void MtDevice::savePipelineCache() {
+  std::lock_guard<std::mutex> guard(pipelineCacheSync);
+  if(cacheDir.empty() || !translation.isDirty())
+    return;
+  const std::string path = cacheDir+translation.fileName();
+  if(!CacheFile::write(path,translation.serialize()))
+    Log::e("MetalApi: unable to write ",path);
   }
 
 void MtDevice::waitIdle() {
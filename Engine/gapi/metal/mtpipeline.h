@@ -28,7 +28,8 @@ class MtPipeline : public AbstractGraphicsApi::Pipeline {
                size_t stride,
                const MtPipelineLay& lay,
                const MtShader &vert,
-               const MtShader &frag);
+               const MtShader &frag,
+               const SpecializationConstants& spec);
     ~MtPipeline();
 
     struct Inst {
@@ -54,6 +55,8 @@ class MtPipeline : public AbstractGraphicsApi::Pipeline {
 
     const MtShader* vert = nullptr;
     const MtShader* frag = nullptr;
+    id<MTLFunction> vsFn = nil;
+    id<MTLFunction> fsFn = nil;
 
     SpinLock        sync;
     std::list<Inst> instance;
@@ -61,7 +64,7 @@ class MtPipeline : public AbstractGraphicsApi::Pipeline {
 
 class MtCompPipeline : public AbstractGraphicsApi::CompPipeline {
   public:
-    MtCompPipeline(MtDevice &d, const MtPipelineLay& lay, const MtShader& sh);
+    MtCompPipeline(MtDevice &d, const MtPipelineLay& lay, const MtShader& sh, const SpecializationConstants& spec);
 
     id<MTLComputePipelineState>      impl;
     DSharedPtr<const MtPipelineLay*> lay;
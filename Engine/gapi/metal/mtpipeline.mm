@@ -12,8 +12,15 @@ using namespace Tempest::Detail;
 MtPipeline::MtPipeline(MtDevice &d, Topology tp,
                        const RenderState &rs, size_t stride,
                        const MtPipelineLay& lay,
-                       const MtShader &vert, const MtShader &frag)
+                       const MtShader &vert, const MtShader &frag,
+                       const SpecializationConstants& sc)
   :lay(&lay), device(d), rs(rs), vert(&vert), frag(&frag) {
+  const std::vector<ShaderReflection::SpecConstant>* decl[] = {&vert.spec,&frag.spec};
+  std::vector<ShaderReflection::SpecValue> spec;
+  ShaderReflection::specialize(spec,decl,2,sc);
+  vsFn = vert.function(spec);
+  fsFn = frag.function(spec);
+
   cullMode = nativeFormat(rs.cullFaceMode());
   topology = nativeFormat(tp);
 
@@ -43,8 +50,8 @@ MtPipeline::MtPipeline(MtDevice &d, Topology tp,
 
   pdesc = [MTLRenderPipelineDescriptor new];
   pdesc.sampleCount          = 1;
-  pdesc.vertexFunction       = vert.impl;
-  pdesc.fragmentFunction     = frag.impl;
+  pdesc.vertexFunction       = vsFn;
+  pdesc.fragmentFunction     = fsFn;
   pdesc.vertexDescriptor     = vdesc;
   pdesc.rasterizationEnabled = rs.isRasterDiscardEnabled() ? NO : YES; // TODO: test it
 
@@ -70,6 +77,8 @@ MtPipeline::~MtPipeline() {
       [i.pso release];
   [vdesc release];
   [pdesc release];
+  [vsFn  release];
+  [fsFn  release];
   }
 
 MtPipeline::Inst& MtPipeline::inst(const MtFboLayout& lay) {
@@ -103,12 +112,18 @@ MtPipeline::Inst& MtPipeline::inst(const MtFboLayout& lay) {
   }
 
 
-MtCompPipeline::MtCompPipeline(MtDevice &device, const MtPipelineLay& lay, const MtShader &sh)
+MtCompPipeline::MtCompPipeline(MtDevice &device, const MtPipelineLay& lay, const MtShader &sh,
+                               const SpecializationConstants& sc)
   :lay(&lay) {
   id dev = device.impl;
 
+  const std::vector<ShaderReflection::SpecConstant>* decl[] = {&sh.spec};
+  std::vector<ShaderReflection::SpecValue> spec;
+  ShaderReflection::specialize(spec,decl,1,sc);
+  id<MTLFunction> fn = sh.function(spec);
+
   MTLComputePipelineDescriptor* pdesc = [MTLComputePipelineDescriptor new];
-  pdesc.computeFunction                                 = sh.impl;
+  pdesc.computeFunction                                 = fn;
   // pdesc.threadGroupSizeIsMultipleOfThreadExecutionWidth = YES;
 
   for(size_t i=0; i<lay.lay.size(); ++i) {
@@ -129,6 +144,7 @@ MtCompPipeline::MtCompPipeline(MtDevice &device, const MtPipelineLay& lay, const
               reflection:nil
               error:&error];
   [pdesc release];
+  [fn    release];
 
   mtAssert(impl,error);
   }
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+
+#import  <Metal/MTLBuffer.h>
+#import  <Metal/MTLCommandBuffer.h>
+
+namespace Tempest {
+namespace Detail {
+
+class MtReadback : public AbstractGraphicsApi::Readback {
+  public:
+    MtReadback(id<MTLCommandBuffer> cmd, id<MTLBuffer> stage, size_t size);
+    ~MtReadback();
+
+    bool isReady() override;
+    void wait() override;
+    void read(void* out) override;
+
+  private:
+    id<MTLCommandBuffer> cmd;
+    id<MTLBuffer>        stage;
+    size_t               size = 0;
+  };
+
+}
+}
@@ -0,0 +1,33 @@
+#include "mtreadback.h"
+
+#include <Tempest/Except>
+#include <cstring>
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+MtReadback::MtReadback(id<MTLCommandBuffer> cmd, id<MTLBuffer> stage, size_t size)
+  :cmd([cmd retain]), stage(stage), size(size) {
+  }
+
+MtReadback::~MtReadback() {
+  [cmd waitUntilCompleted];
+  [cmd release];
+  [stage release];
+  }
+
+bool MtReadback::isReady() {
+  const MTLCommandBufferStatus st = cmd.status;
+  return st==MTLCommandBufferStatusCompleted || st==MTLCommandBufferStatusError;
+  }
+
+void MtReadback::wait() {
+  [cmd waitUntilCompleted];
+  if(cmd.status==MTLCommandBufferStatusError)
+    throw DeviceLostException();
+  }
+
+void MtReadback::read(void* out) {
+  wait();
+  std::memcpy(out,stage.contents,size);
+  }
@@ -19,11 +19,15 @@ class MtShader : public AbstractGraphicsApi::Shader {
 
     using Binding = ShaderReflection::Binding;
 
+    // retained function: impl, or variant with function constants, if any of values is used by shader
+    id<MTLFunction> function(const std::vector<ShaderReflection::SpecValue>& values) const;
+
     id<MTLLibrary>  library;
     id<MTLFunction> impl;
 
-    std::vector<Decl::ComponentType> vdecl;
-    std::vector<Binding>             lay;
+    std::vector<Decl::ComponentType>            vdecl;
+    std::vector<Binding>                        lay;
+    std::vector<ShaderReflection::SpecConstant> spec;
   };
 
 }
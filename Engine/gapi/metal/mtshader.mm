@@ -5,8 +5,8 @@
 #include <Tempest/Log>
 #include <Tempest/Except>
 
-#include "gapi/shaderreflection.h"
-#include "thirdparty/spirv_cross/spirv_msl.hpp"
+#include "gapi/shadertranslator.h"
+#include "gapi/translationcache.h"
 
 #include <Metal/MTLLibrary.h>
 
@@ -14,55 +14,17 @@ using namespace Tempest;
 using namespace Tempest::Detail;
 
 MtShader::MtShader(MtDevice& dev, const void* source, size_t srcSize) {
-  if(srcSize%4!=0)
-    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
-
-  spirv_cross::CompilerMSL::Options optMSL;
-#if defined(__OSX__)
-  optMSL.platform = spirv_cross::CompilerMSL::Options::macOS;
-#else
-  optMSL.platform = spirv_cross::CompilerMSL::Options::iOS;
-#endif
-
-  spirv_cross::CompilerGLSL::Options optGLSL;
-  optGLSL.vertex.flip_vert_y = true;
-
-  std::string msl;
-  try {
-    spirv_cross::CompilerMSL comp(reinterpret_cast<const uint32_t*>(source),srcSize/4);
-    comp.set_msl_options   (optMSL );
-    comp.set_common_options(optGLSL);
-
-    msl = comp.compile();
-
-    ShaderReflection::getVertexDecl(vdecl,comp);
-    ShaderReflection::getBindings(lay,comp);
-    for(auto& i:lay) {
-      i.mslBinding = comp.get_automatic_msl_resource_binding(i.spvId);
-      if(i.cls==ShaderReflection::Texture)
-        i.mslBinding2 = comp.get_automatic_msl_resource_binding_secondary(i.spvId);
-      }
-    }
-  catch(const std::bad_alloc&) {
-    throw;
-    }
-  catch(const spirv_cross::CompilerError& err) {
-#if !defined(NDEBUG)
-    Log::d("cross-compile error: \"",err.what(),"\"");
-#else
-    (void)err;
-#endif
-    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
-    }
-  catch(...) {
-    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
-    }
+  ShaderTranslator::Result msl;
+  dev.translationCache().translate(msl,source,srcSize);
+  vdecl = std::move(msl.vdecl);
+  lay   = std::move(msl.lay);
+  spec  = std::move(msl.spec);
 
-  //Log::d(msl);
+  //Log::d(msl.source);
 
   auto     opt = [MTLCompileOptions new];
   NSError* err = nil;
-  auto     str = [NSString stringWithCString:msl.c_str() encoding:[NSString defaultCStringEncoding]];
+  auto     str = [NSString stringWithCString:msl.source.c_str() encoding:[NSString defaultCStringEncoding]];
 
   library = [dev.impl newLibraryWithSource:str options:opt error:&err];
   [opt release];
@@ -82,3 +44,47 @@ MtShader::~MtShader() {
   [impl    release];
   [library release];
   }
+
+id<MTLFunction> MtShader::function(const std::vector<ShaderReflection::SpecValue>& values) const {
+  // spirv_cross emits specialization constants as function constants, with same index
+  MTLFunctionConstantValues* cv   = nil;
+  for(auto& v:values) {
+    bool used = false;
+    for(auto& c:spec)
+      used |= (c.id==v.id);
+    if(!used)
+      continue;
+    if(cv==nil)
+      cv = [MTLFunctionConstantValues new];
+    switch(v.type) {
+      case SpecializationConstants::Bool: {
+        bool b = (v.bits!=0);
+        [cv setConstantValue:&b type:MTLDataTypeBool atIndex:v.id];
+        break;
+        }
+      case SpecializationConstants::Int:
+        [cv setConstantValue:&v.bits type:MTLDataTypeInt atIndex:v.id];
+        break;
+      case SpecializationConstants::UInt:
+        [cv setConstantValue:&v.bits type:MTLDataTypeUInt atIndex:v.id];
+        break;
+      case SpecializationConstants::Float:
+        [cv setConstantValue:&v.bits type:MTLDataTypeFloat atIndex:v.id];
+        break;
+      }
+    }
+  if(cv==nil)
+    return [impl retain];
+
+  NSError*        err = nil;
+  id<MTLFunction> ret = [library newFunctionWithName:@"main0" constantValues:cv error:&err];
+  [cv release];
+  if(ret==nil) {
+#if !defined(NDEBUG)
+    const char* e = [[err domain] UTF8String];
+    Log::d("function constants error: \"",e,"\"");
+#endif
+    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+    }
+  return ret;
+  }
@@ -7,17 +7,21 @@ namespace Tempest {
 namespace Detail {
 
 class MtDevice;
+class MtBuffer;
 
 class MtTexture : public Tempest::AbstractGraphicsApi::Texture {
   public:
     MtTexture(MtDevice &d,
               const uint32_t w, const uint32_t h, uint32_t mips, TextureFormat frm, bool storageTex);
     MtTexture(MtDevice &d, const Pixmap& pm, uint32_t mips, TextureFormat frm);
+    MtTexture(MtDevice &d, MtBuffer& stage, size_t stride, const uint32_t w, const uint32_t h, uint32_t mips, TextureFormat frm);
     ~MtTexture();
 
     uint32_t mipCount() const override;
+    void     update(const Pixmap& p, uint32_t x, uint32_t y, uint32_t mip);
     void     readPixels(Pixmap& out, TextureFormat frm,
                         const uint32_t w, const uint32_t h, uint32_t mip);
+    auto     readPixelsAsync(TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip) -> AbstractGraphicsApi::Readback*;
 
     uint32_t bitCount() const;
 
@@ -3,6 +3,8 @@
 #include <Tempest/Pixmap>
 #include <Tempest/Except>
 #include "mtdevice.h"
+#include "mtbuffer.h"
+#include "mtreadback.h"
 
 #include <Tempest/AbstractGraphicsApi>
 
@@ -71,6 +73,30 @@ MtTexture::MtTexture(MtDevice& dev, const Pixmap& pm, uint32_t mips, TextureForm
   [stage release];
   }
 
+MtTexture::MtTexture(MtDevice& dev, MtBuffer& stage, size_t stride, const uint32_t w, const uint32_t h, uint32_t mips, TextureFormat frm)
+  :dev(dev), mips(mips) {
+  const size_t row = stride;
+  impl = alloc(frm,w,h,mips,MTLStorageModePrivate,MTLTextureUsageShaderRead);
+
+  @autoreleasepool {
+    id<MTLCommandBuffer>      cmd = [dev.queue commandBuffer];
+    id<MTLBlitCommandEncoder> enc = [cmd blitCommandEncoder];
+    [enc copyFromBuffer:stage.impl
+           sourceOffset:0
+      sourceBytesPerRow:row
+    sourceBytesPerImage:row*h
+             sourceSize:MTLSizeMake(w,h,1)
+              toTexture:impl
+       destinationSlice:0
+       destinationLevel:0
+      destinationOrigin:MTLOriginMake(0,0,0)];
+    if(mips>1)
+      [enc generateMipmapsForTexture:impl];
+    [enc endEncoding];
+    [cmd commit];
+    }
+  }
+
 MtTexture::~MtTexture() {
   [impl release];
   }
@@ -143,6 +169,32 @@ uint32_t MtTexture::mipCount() const {
   return mips;
   }
 
+void MtTexture::update(const Pixmap& p, uint32_t x, uint32_t y, uint32_t mip) {
+  const size_t  row   = p.w()*Pixmap::bppForFormat(p.format());
+  id<MTLBuffer> stage = [dev.impl newBufferWithBytes:p.data() length:p.dataSize() options:MTLResourceStorageModeShared];
+  if(stage==nil)
+    throw std::system_error(GraphicsErrc::OutOfVideoMemory);
+
+  @autoreleasepool {
+    // blit is ordered after frames committed before, so texture is not overwritten while sampled
+    id<MTLCommandBuffer>      cmd = [dev.queue commandBuffer];
+    id<MTLBlitCommandEncoder> enc = [cmd blitCommandEncoder];
+    [enc copyFromBuffer:stage
+           sourceOffset:0
+      sourceBytesPerRow:row
+    sourceBytesPerImage:row*p.h()
+             sourceSize:MTLSizeMake(p.w(),p.h(),1)
+              toTexture:impl
+       destinationSlice:0
+       destinationLevel:mip
+      destinationOrigin:MTLOriginMake(x,y,0)];
+    [enc endEncoding];
+    [cmd commit];
+    }
+  // command buffer retains stage, until copy is done
+  [stage release];
+  }
+
 void MtTexture::readPixels(Pixmap& out, TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip) {
   Pixmap::Format  pfrm = Pixmap::toPixmapFormat(frm);
   size_t          bpp  = Pixmap::bppForFormat(pfrm);
@@ -176,6 +228,35 @@ void MtTexture::readPixels(Pixmap& out, TextureFormat frm, const uint32_t w, con
   [stage release];
   }
 
+AbstractGraphicsApi::Readback* MtTexture::readPixelsAsync(TextureFormat frm, const uint32_t w, const uint32_t h, uint32_t mip) {
+  Pixmap::Format  pfrm = Pixmap::toPixmapFormat(frm);
+  size_t          bpp  = Pixmap::bppForFormat(pfrm);
+  if(bpp==0)
+    throw std::runtime_error("not implemented");
+
+  const size_t  row   = w*bpp;
+  id<MTLBuffer> stage = [dev.impl newBufferWithLength:row*h options:MTLResourceStorageModeShared];
+  if(stage==nil)
+    throw std::system_error(GraphicsErrc::OutOfVideoMemory);
+
+  @autoreleasepool {
+    id<MTLCommandBuffer>      cmd = [dev.queue commandBuffer];
+    id<MTLBlitCommandEncoder> enc = [cmd blitCommandEncoder];
+    [enc copyFromTexture:impl
+                         sourceSlice:0
+                         sourceLevel:mip
+                         sourceOrigin:MTLOriginMake(0,0,0)
+                         sourceSize:MTLSizeMake(w,h,1)
+                         toBuffer:stage
+                         destinationOffset:0
+                         destinationBytesPerRow:row
+                         destinationBytesPerImage:row*h];
+    [enc endEncoding];
+    [cmd commit];
+    return new MtReadback(cmd,stage,row*h);
+    }
+  }
+
 uint32_t MtTexture::bitCount() const {
   MTLPixelFormat frm = impl.pixelFormat;
   switch(frm) {
@@ -108,7 +108,8 @@ AbstractGraphicsApi::PPipeline MetalApi::createPipeline(AbstractGraphicsApi::Dev
                                                         const AbstractGraphicsApi::Shader *tc,
                                                         const AbstractGraphicsApi::Shader *te,
                                                         const AbstractGraphicsApi::Shader *gs,
-                                                        const AbstractGraphicsApi::Shader *fs) {
+                                                        const AbstractGraphicsApi::Shader *fs,
+                                                        const SpecializationConstants& spec) {
   auto& dx  = *reinterpret_cast<MtDevice*>(d);
 
   auto& lay = reinterpret_cast<const MtPipelineLay&>(ulayImpl);
@@ -116,16 +117,17 @@ AbstractGraphicsApi::PPipeline MetalApi::createPipeline(AbstractGraphicsApi::Dev
   auto& vx  = *reinterpret_cast<const MtShader*>(vs);
   auto& fx  = *reinterpret_cast<const MtShader*>(fs);
 
-  return PPipeline(new MtPipeline(dx,tp,st,stride,lay,vx,fx));
+  return PPipeline(new MtPipeline(dx,tp,st,stride,lay,vx,fx,spec));
   }
 
 AbstractGraphicsApi::PCompPipeline MetalApi::createComputePipeline(AbstractGraphicsApi::Device *d,
                                                                    const AbstractGraphicsApi::PipelineLay& ulayImpl,
-                                                                   AbstractGraphicsApi::Shader *cs) {
+                                                                   AbstractGraphicsApi::Shader *cs,
+                                                                   const SpecializationConstants& spec) {
   auto& dx = *reinterpret_cast<MtDevice*>(d);
   auto& cx = *reinterpret_cast<const MtShader*>(cs);
   auto& lay = reinterpret_cast<const MtPipelineLay&>(ulayImpl);
-  return PCompPipeline(new MtCompPipeline(dx,lay,cx));
+  return PCompPipeline(new MtCompPipeline(dx,lay,cx,spec));
   }
 
 AbstractGraphicsApi::PShader MetalApi::createShader(AbstractGraphicsApi::Device *d, const void *source, size_t src_size) {
@@ -175,6 +177,25 @@ AbstractGraphicsApi::PTexture MetalApi::createTexture(AbstractGraphicsApi::Devic
     }
   }
 
+AbstractGraphicsApi::PBuffer MetalApi::createStaging(AbstractGraphicsApi::Device* d,
+                                                    const uint32_t w, const uint32_t h, TextureFormat frm, size_t& stride) {
+  auto&        dx  = *reinterpret_cast<MtDevice*>(d);
+  const size_t bpp = Pixmap::bppForFormat(Pixmap::toPixmapFormat(frm));
+  if(bpp==0 || isCompressedFormat(frm))
+    throw std::system_error(GraphicsErrc::UnsupportedTextureFormat);
+  stride = w*bpp;
+  return PBuffer(new MtBuffer(dx,nullptr,h,stride,stride,MTLResourceStorageModeShared|MTLResourceCPUCacheModeWriteCombined));
+  }
+
+AbstractGraphicsApi::PTexture MetalApi::createTexture(AbstractGraphicsApi::Device* d, const PBuffer& stage, size_t stride,
+                                                      const uint32_t w, const uint32_t h, uint32_t mips, TextureFormat frm) {
+  @autoreleasepool {
+    auto& dev = *reinterpret_cast<MtDevice*>(d);
+    auto& buf = *reinterpret_cast<MtBuffer*>(stage.handler);
+    return PTexture(new MtTexture(dev,buf,stride,w,h,mips,frm));
+    }
+  }
+
 AbstractGraphicsApi::PTexture MetalApi::createTexture(AbstractGraphicsApi::Device *d,
                                                       const uint32_t w, const uint32_t h, uint32_t mips, TextureFormat frm) {
   @autoreleasepool {
@@ -191,6 +212,15 @@ AbstractGraphicsApi::PTexture MetalApi::createStorage(AbstractGraphicsApi::Devic
     }
   }
 
+void MetalApi::updateTexture(AbstractGraphicsApi::Device*, const AbstractGraphicsApi::PTexture t,
+                             const Pixmap& p, TextureFormat /*frm*/,
+                             uint32_t x, uint32_t y, uint32_t mip) {
+  @autoreleasepool {
+    auto& tx = *reinterpret_cast<MtTexture*>(t.handler);
+    tx.update(p,x,y,mip);
+    }
+  }
+
 void MetalApi::readPixels(AbstractGraphicsApi::Device*,
                           Pixmap& out, const AbstractGraphicsApi::PTexture t,
                           TextureLayout /*lay*/, TextureFormat frm,
@@ -199,6 +229,14 @@ void MetalApi::readPixels(AbstractGraphicsApi::Device*,
   tx.readPixels(out,frm,w,h,mip);
   }
 
+AbstractGraphicsApi::Readback* MetalApi::readPixelsAsync(AbstractGraphicsApi::Device*,
+                                                        const AbstractGraphicsApi::PTexture t,
+                                                        TextureLayout /*lay*/, TextureFormat frm,
+                                                        const uint32_t w, const uint32_t h, uint32_t mip) {
+  auto& tx = *reinterpret_cast<MtTexture*>(t.handler);
+  return tx.readPixelsAsync(frm,w,h,mip);
+  }
+
 void MetalApi::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buffer *buf,
                          void *out, size_t size) {
   buf->read(out,0,size);
@@ -270,6 +308,50 @@ void MetalApi::submit(AbstractGraphicsApi::Device*,
     }
   }
 
+size_t MetalApi::defragment(AbstractGraphicsApi::Device*, size_t, size_t) {
+  return 0;
+  }
+
+void MetalApi::memoryStats(AbstractGraphicsApi::Device*, MemoryStats& out) {
+  out.heaps.clear();
+  }
+
+void MetalApi::setMemoryBudgetCallback(AbstractGraphicsApi::Device*, float, MemoryBudgetCallback) {
+  }
+
+void MetalApi::setPageCacheSize(AbstractGraphicsApi::Device*, size_t) {
+  }
+
+void MetalApi::trimPageCache(AbstractGraphicsApi::Device*, size_t) {
+  }
+
+void MetalApi::setPipelineCacheDir(AbstractGraphicsApi::Device* d, const char* dir) {
+  // driver keeps own on-disk shader cache; here only spirv->msl translation is cached
+  auto& dx = *reinterpret_cast<MtDevice*>(d);
+  dx.setPipelineCacheDir(dir);
+  }
+
+void MetalApi::savePipelineCache(AbstractGraphicsApi::Device* d) {
+  auto& dx = *reinterpret_cast<MtDevice*>(d);
+  dx.savePipelineCache();
+  }
+
+void MetalApi::pipelineCacheStats(AbstractGraphicsApi::Device* d, PipelineCacheStats& out) {
+  auto& dx = *reinterpret_cast<MtDevice*>(d);
+  out = PipelineCacheStats();
+  out.shaderHits = dx.translationCache().hits();
+  }
+
+void MetalApi::prewarm(AbstractGraphicsApi::Device*, Pipeline* p, FboLayout** lay, size_t count) {
+  // no background compilation yet: variants are compiled on calling thread
+  auto& px = *reinterpret_cast<MtPipeline*>(p);
+  for(size_t i=0; i<count; ++i)
+    px.inst(*reinterpret_cast<const MtFboLayout*>(lay[i]));
+  }
+
+void MetalApi::setAsyncPipelines(AbstractGraphicsApi::Device*, bool) {
+  }
+
 void MetalApi::getCaps(AbstractGraphicsApi::Device *d, AbstractGraphicsApi::Props &caps) {
   auto& dx = *reinterpret_cast<MtDevice*>(d);
   caps = dx.prop;
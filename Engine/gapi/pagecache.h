@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// Bounded LRU cache of freed device memory pages, keyed by memory type and size class.
+// Not thread-safe: owner is expected to serialize access.
+template<class Memory>
+class PageCache {
+  public:
+    enum {
+      MAX_ENTRIES=64,
+      CLASS_STEPS=8, // size classes per power of two: at most 12.5% of slack
+      };
+
+    explicit PageCache(size_t capacity=0):cap(capacity){}
+
+    // page size, as it should be allocated from device, so freed page can be found by take()
+    static size_t sizeClass(size_t size) {
+      if(size<=CLASS_STEPS)
+        return size;
+      size_t pow = 1;
+      while(pow*2<=size)
+        pow *= 2;
+      const size_t step = pow/CLASS_STEPS;
+      return ((size+step-1)/step)*step;
+      }
+
+    size_t capacity() const { return cap;   }
+    size_t size()     const { return bytes; }
+
+    uint64_t cachedBytes(uint32_t typeId) const {
+      uint64_t ret = 0;
+      for(auto& i:entries)
+        if(i.typeId==typeId)
+          ret += i.size;
+      return ret;
+      }
+
+    // most recently cached page of given type and size, if any
+    bool take(size_t size, uint32_t typeId, Memory& out) {
+      size_t id = entries.size();
+      for(size_t i=0; i<entries.size(); ++i) {
+        auto& e = entries[i];
+        if(e.size==size && e.typeId==typeId && (id==entries.size() || e.tick>entries[id].tick))
+          id = i;
+        }
+      if(id==entries.size())
+        return false;
+      out    = entries[id].memory;
+      bytes -= entries[id].size;
+      entries[id] = entries.back();
+      entries.pop_back();
+      return true;
+      }
+
+    // release(Memory,size,typeId) is called for pages, which didn't fit into capacity
+    template<class Fn>
+    void put(Memory m, size_t size, uint32_t typeId, Fn&& release) {
+      if(size>cap) {
+        release(m,size,typeId);
+        return;
+        }
+      Entry e;
+      e.memory = m;
+      e.size   = size;
+      e.typeId = typeId;
+      e.tick   = ++tick;
+      entries.push_back(e);
+      bytes += size;
+      shrink(cap,release);
+      }
+
+    template<class Fn>
+    void setCapacity(size_t capacity, Fn&& release) {
+      cap = capacity;
+      shrink(cap,release);
+      }
+
+    // evicts least recently used pages, until at most keepBytes are cached
+    template<class Fn>
+    void trim(size_t keepBytes, Fn&& release) {
+      shrink(keepBytes,release);
+      }
+
+  private:
+    struct Entry {
+      Memory   memory{};
+      size_t   size  =0;
+      uint32_t typeId=0;
+      uint64_t tick  =0;
+      };
+
+    template<class Fn>
+    void shrink(size_t keepBytes, Fn& release) {
+      while(!entries.empty() && (bytes>keepBytes || entries.size()>MAX_ENTRIES)) {
+        size_t lru = 0;
+        for(size_t i=1; i<entries.size(); ++i)
+          if(entries[i].tick<entries[lru].tick)
+            lru = i;
+        Entry e = entries[lru];
+        entries[lru] = entries.back();
+        entries.pop_back();
+        bytes -= e.size;
+        release(e.memory,e.size,e.typeId);
+        }
+      }
+
+    std::vector<Entry> entries;
+    size_t             cap  =0;
+    size_t             bytes=0;
+    uint64_t           tick =0;
+  };
+
+}}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// On-disk pipeline cache: driver blob, wrapped into header with gpu identity and checksum.
+// Drivers are not required to validate cache data well, so damaged, truncated or foreign files
+// are rejected here, before driver ever sees them.
+class PipelineCacheFile {
+  public:
+    enum : uint32_t {
+      VERSION = 1,
+      };
+
+    struct Key {
+      uint32_t vendor = 0;
+      uint32_t device = 0;
+      uint32_t driver = 0;
+      uint8_t  uuid[16] = {};
+      };
+
+    // file name depends on gpu and cache uuid, so different gpu's don't overwrite each other
+    static std::string fileName(const Key& k) {
+      static const char hex[] = "0123456789abcdef";
+      std::string ret = "pipeline-cache-";
+      ret += toHex(k.vendor);
+      ret += '-';
+      ret += toHex(k.device);
+      ret += '-';
+      for(auto i:k.uuid) {
+        ret += hex[i>>4];
+        ret += hex[i&0xF];
+        }
+      ret += ".bin";
+      return ret;
+      }
+
+    static std::vector<uint8_t> pack(const Key& k, const void* data, size_t size) {
+      Header h;
+      std::memcpy(h.magic,"TPSO",sizeof(h.magic));
+      h.version = VERSION;
+      h.key     = k;
+      h.size    = size;
+      h.hash    = hash(data,size);
+
+      std::vector<uint8_t> ret(sizeof(Header)+size);
+      std::memcpy(ret.data(),&h,sizeof(h));
+      if(size>0)
+        std::memcpy(ret.data()+sizeof(Header),data,size);
+      return ret;
+      }
+
+    // returns driver blob of file, or nullptr if file is not usable for gpu k
+    static const uint8_t* unpack(const Key& k, const std::vector<uint8_t>& file, size_t& size) {
+      size = 0;
+      if(file.size()<sizeof(Header))
+        return nullptr;
+      Header h;
+      std::memcpy(&h,file.data(),sizeof(h));
+      if(std::memcmp(h.magic,"TPSO",sizeof(h.magic))!=0 || h.version!=VERSION)
+        return nullptr;
+      if(h.key.vendor!=k.vendor || h.key.device!=k.device || h.key.driver!=k.driver ||
+         std::memcmp(h.key.uuid,k.uuid,sizeof(k.uuid))!=0)
+        return nullptr;
+      if(h.size!=file.size()-sizeof(Header))
+        return nullptr;
+      const uint8_t* data = file.data()+sizeof(Header);
+      if(h.hash!=hash(data,size_t(h.size)))
+        return nullptr;
+      size = size_t(h.size);
+      return data;
+      }
+
+    // FNV-1a
+    static uint64_t hash(const void* data, size_t size) {
+      auto*    b = reinterpret_cast<const uint8_t*>(data);
+      uint64_t h = 0xcbf29ce484222325ull;
+      for(size_t i=0; i<size; ++i) {
+        h ^= b[i];
+        h *= 0x100000001b3ull;
+        }
+      return h;
+      }
+
+  private:
+    struct Header {
+      char     magic[4] = {};
+      uint32_t version  = 0;
+      Key      key;
+      uint64_t size     = 0;
+      uint64_t hash     = 0;
+      };
+
+    static std::string toHex(uint32_t v) {
+      static const char hex[] = "0123456789abcdef";
+      char buf[8];
+      for(int i=7; i>=0; --i) {
+        buf[i] = hex[v&0xF];
+        v >>= 4;
+        }
+      return std::string(buf,8);
+      }
+  };
+
+}}
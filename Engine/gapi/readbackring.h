@@ -0,0 +1,197 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace Tempest {
+namespace Detail {
+
+// Ring sub-allocator: blocks can be freed in any order, but space is reclaimed in allocation order.
+// Not thread-safe: owner is expected to serialize access.
+class RingAllocator {
+  public:
+    enum : size_t {
+      npos = size_t(-1),
+      };
+
+    explicit RingAllocator(size_t capacity=0):cap(capacity){}
+
+    size_t capacity() const { return cap; }
+    bool   isEmpty()  const { return blocks.empty(); }
+
+    size_t alloc(size_t size, size_t align) {
+      if(size==0)
+        size = 1;
+      if(align==0)
+        align = 1;
+      if(blocks.empty())
+        head = 0;
+
+      size_t at = ((head+align-1)/align)*align;
+      if(blocks.empty() || head>blocks.front().offset) {
+        if(at+size>cap) {
+          // wrap around; gap at the end is reclaimed together with front block
+          at = 0;
+          if(!blocks.empty() && at+size>=blocks.front().offset)
+            return npos;
+          if(size>cap)
+            return npos;
+          }
+        } else {
+        // strict: head==tail means, that ring is empty
+        if(at+size>=blocks.front().offset)
+          return npos;
+        }
+
+      Block b;
+      b.offset = at;
+      b.size   = size;
+      blocks.push_back(b);
+      head = at+size;
+      return at;
+      }
+
+    void free(size_t offset) {
+      for(auto& i:blocks)
+        if(i.offset==offset && i.used) {
+          i.used = false;
+          break;
+          }
+      while(!blocks.empty() && !blocks.front().used)
+        blocks.pop_front();
+      }
+
+  private:
+    struct Block {
+      size_t offset = 0;
+      size_t size   = 0;
+      bool   used   = true;
+      };
+
+    std::deque<Block> blocks;
+    size_t            cap  = 0;
+    size_t            head = 0;
+  };
+
+// Persistent Readback-heap buffer, shared by asynchronous readbacks.
+// Requests, that don't fit into the ring, get dedicated staging buffer.
+template<class Device, class Buffer>
+class ReadbackRing {
+  public:
+    enum {
+      RING_SIZE = 4*1024*1024,
+      };
+
+    struct Span {
+      Buffer*                 buf    = nullptr;
+      size_t                  offset = 0;
+      std::unique_ptr<Buffer> own;
+      };
+
+    explicit ReadbackRing(Device& dev):device(dev), ring(RING_SIZE) {}
+
+    Span alloc(size_t size, size_t align) {
+      Span ret;
+      if(size<=RING_SIZE/2) {
+        std::lock_guard<std::mutex> guard(sync);
+        if(buf==nullptr)
+          buf.reset(new Buffer(device.dataMgr().allocStagingMemory(nullptr,RING_SIZE,1,1,MemUsage::TransferDst,BufferHeap::Readback)));
+        const size_t at = ring.alloc(size,align);
+        if(at!=RingAllocator::npos) {
+          ret.buf    = buf.get();
+          ret.offset = at;
+          return ret;
+          }
+        }
+      ret.own.reset(new Buffer(device.dataMgr().allocStagingMemory(nullptr,size,1,1,MemUsage::TransferDst,BufferHeap::Readback)));
+      ret.buf = ret.own.get();
+      return ret;
+      }
+
+    void free(Span& s) {
+      if(s.own!=nullptr) {
+        s.own.reset();
+        } else {
+        std::lock_guard<std::mutex> guard(sync);
+        ring.free(s.offset);
+        }
+      s.buf = nullptr;
+      }
+
+  private:
+    Device&                 device;
+    std::mutex              sync;
+    std::unique_ptr<Buffer> buf;
+    RingAllocator           ring;
+  };
+
+// GPU->CPU copy in flight: rowCount rows of rowSize bytes, placed pitch bytes apart in staging memory.
+// Owns its command buffer, so completion can be polled without touching other uploads.
+template<class Device, class Buffer>
+class AsyncReadback : public AbstractGraphicsApi::Readback {
+  public:
+    using Commands = typename Device::DataMgr::Commands;
+
+    AsyncReadback(Device& dev, size_t rowSize, size_t pitch, size_t rowCount, size_t align)
+      :device(dev), rowSize(rowSize), pitch(pitch), rowCount(rowCount) {
+      span = device.readbackMgr().alloc(pitch*rowCount,align);
+      cmd  = device.dataMgr().get();
+      cmd->begin();
+      }
+
+    ~AsyncReadback() override {
+      if(submitted)
+        cmd->wait();
+      cmd->reset();
+      device.dataMgr().recycle(std::move(cmd));
+      device.readbackMgr().free(span);
+      }
+
+    Commands& commands()      { return *cmd;        }
+    Buffer&   staging()       { return *span.buf;   }
+    size_t    offset() const  { return span.offset; }
+
+    void submit() {
+      cmd->end();
+      // pending uploads are submitted first, device orders the copy after them on GPU
+      // (Vulkan puts postponed queue ownership acquires of uploads into graphics queue before): no need to wait on CPU
+      device.dataMgr().flush();
+      device.dataMgr().submitDetached(*cmd);
+      submitted = true;
+      }
+
+    bool isReady() override {
+      return cmd->wait(0);
+      }
+
+    void wait() override {
+      cmd->wait();
+      }
+
+    void read(void* out) override {
+      cmd->wait();
+      auto* dst = reinterpret_cast<uint8_t*>(out);
+      if(rowSize==pitch) {
+        span.buf->read(dst,span.offset,rowSize*rowCount);
+        return;
+        }
+      for(size_t i=0; i<rowCount; ++i)
+        span.buf->read(dst+i*rowSize,span.offset+i*pitch,rowSize);
+      }
+
+  private:
+    Device&                                device;
+    typename ReadbackRing<Device,Buffer>::Span span;
+    std::unique_ptr<Commands>              cmd;
+    size_t                                 rowSize   = 0;
+    size_t                                 pitch     = 0;
+    size_t                                 rowCount  = 0;
+    bool                                   submitted = false;
+  };
+
+}}
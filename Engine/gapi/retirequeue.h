@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// Resources, destroyed by user, can still be referenced by frames in flight.
+// Instead of being released on the spot, they are retired: grouped by frame and released in bulk,
+// once fence of that frame is signaled.
+template<class Device, class Fence>
+class RetireQueue {
+  public:
+    using Release = std::function<void()>;
+
+    enum : uint64_t {
+      // no frame is submitted, but that much memory waits: close batch early, so next frame() can release it
+      MAX_OPEN_BYTES = 64*1024*1024,
+      };
+
+    struct Stats {
+      uint64_t bytes   = 0;
+      uint32_t objects = 0;
+      };
+
+    explicit RetireQueue(Device& dev):device(dev) {}
+    RetireQueue(const RetireQueue&)=delete;
+    ~RetireQueue() { flush(); }
+
+    // thread-safe; fn is called later, by frame() or flush().
+    // Nothing is released here: retire is called from destructors, possibly under locks of allocator
+    void retire(size_t bytes, Release&& fn) {
+      std::lock_guard<std::mutex> guard(sync);
+      open.fn.emplace_back(std::move(fn));
+      open.bytes += bytes;
+      st.bytes   += bytes;
+      st.objects += 1;
+      if(open.bytes>=MAX_OPEN_BYTES) {
+        // fence covers all work submitted before, so it's valid at any point, not only at frame boundary
+        close();
+        }
+      }
+
+    // frame boundary, called after submission:
+    // objects, retired so far, are closed with fence, that signals after all work submitted to this point
+    void frame() {
+      std::vector<Release> done;
+      {
+      std::lock_guard<std::mutex> guard(sync);
+      collect(done);
+      close();
+      }
+      for(auto& i:done)
+        i();
+      }
+
+    // device must be idle
+    void flush() {
+      std::vector<Release> done;
+      {
+      std::lock_guard<std::mutex> guard(sync);
+      pending.push_back(std::move(open));
+      open = Frame();
+      for(auto& i:pending)
+        release(i,done);
+      pending.clear();
+      }
+      for(auto& i:done)
+        i();
+      }
+
+    Stats stats() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return st;
+      }
+
+  private:
+    struct Frame {
+      std::unique_ptr<Fence> fence;
+      std::vector<Release>   fn;
+      uint64_t               bytes = 0;
+      };
+
+    void close() {
+      if(open.fn.empty())
+        return;
+      std::unique_ptr<Fence> f;
+      if(fences.empty()) {
+        f.reset(new Fence(device));
+        } else {
+        f = std::move(fences.back());
+        fences.pop_back();
+        }
+      device.signal(*f);
+      open.fence = std::move(f);
+      pending.push_back(std::move(open));
+      open = Frame();
+      }
+
+    void collect(std::vector<Release>& done) {
+      // fences of one queue are signaled in submission order
+      while(!pending.empty() && pending.front().fence->wait(0)) {
+        release(pending.front(),done);
+        pending.pop_front();
+        }
+      }
+
+    void release(Frame& f, std::vector<Release>& done) {
+      st.bytes   -= f.bytes;
+      st.objects -= uint32_t(f.fn.size());
+      for(auto& i:f.fn)
+        done.emplace_back(std::move(i));
+      f.fn.clear();
+      if(f.fence!=nullptr)
+        fences.emplace_back(std::move(f.fence));
+      }
+
+    Device&                             device;
+    mutable std::mutex                  sync;
+    Frame                               open;
+    std::deque<Frame>                   pending;
+    std::vector<std::unique_ptr<Fence>> fences;
+    Stats                               st;
+  };
+
+}}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "shaderreflection.h"
+
+namespace Tempest {
+namespace Detail {
+
+// Reflection of SPIR-V modules, keyed by content hash.
+// Can be stored on disk, so next start doesn't have to parse modules with spirv_cross.
+// Binding::spvId is not stored: cache is only for backends, that consume SPIR-V directly.
+class ShaderCache final {
+  public:
+    enum : uint32_t {
+      VERSION = 2,
+      };
+
+    struct Key {
+      uint64_t hash = 0;
+      uint64_t size = 0;
+
+      bool operator == (const Key& k) const { return hash==k.hash && size==k.size; }
+      };
+
+    struct Reflection {
+      std::vector<Decl::ComponentType>            vdecl;
+      std::vector<ShaderReflection::Binding>      lay;
+      std::vector<ShaderReflection::SpecConstant> spec;
+      };
+
+    // FNV-1a
+    static Key key(const void* spirv, size_t size) {
+      auto* b = reinterpret_cast<const uint8_t*>(spirv);
+      Key   k;
+      k.hash = 0xcbf29ce484222325ull;
+      k.size = size;
+      for(size_t i=0; i<size; ++i) {
+        k.hash ^= b[i];
+        k.hash *= 0x100000001b3ull;
+        }
+      return k;
+      }
+
+    // thread-safe
+    bool find(const Key& k, Reflection& out) const {
+      std::lock_guard<std::mutex> guard(sync);
+      auto it = entries.find(k.hash);
+      if(it==entries.end() || it->second.size!=k.size)
+        return false;
+      out = it->second.ref;
+      ++hitCount;
+      return true;
+      }
+
+    void insert(const Key& k, const Reflection& r) {
+      std::lock_guard<std::mutex> guard(sync);
+      auto& e = entries[k.hash];
+      e.size  = k.size;
+      e.ref   = r;
+      dirty   = true;
+      }
+
+    size_t size() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return entries.size();
+      }
+
+    // successful find calls
+    size_t hits() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return hitCount;
+      }
+
+    // entries were added, since last load or serialize
+    bool isDirty() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return dirty;
+      }
+
+    std::vector<uint8_t> serialize() {
+      std::lock_guard<std::mutex> guard(sync);
+      std::vector<uint8_t> ret;
+      put(ret,uint32_t(MAGIC));
+      put(ret,uint32_t(VERSION));
+      put(ret,uint32_t(entries.size()));
+      for(auto& i:entries) {
+        auto& r = i.second.ref;
+        put(ret,i.first);
+        put(ret,i.second.size);
+        put(ret,uint32_t(r.vdecl.size()));
+        for(auto d:r.vdecl)
+          put(ret,uint8_t(d));
+        put(ret,uint32_t(r.lay.size()));
+        for(auto& b:r.lay) {
+          put(ret,b.layout);
+          put(ret,uint8_t(b.cls));
+          put(ret,uint8_t(b.stage));
+          put(ret,b.size);
+          }
+        put(ret,uint32_t(r.spec.size()));
+        for(auto& c:r.spec) {
+          put(ret,c.id);
+          put(ret,uint8_t(c.type));
+          put(ret,uint8_t(c.stage));
+          }
+        }
+      put(ret,key(ret.data(),ret.size()).hash);
+      dirty = false;
+      return ret;
+      }
+
+    // merges entries of file; damaged, truncated or outdated file is ignored as a whole
+    bool deserialize(const std::vector<uint8_t>& file) {
+      if(file.size()<sizeof(uint64_t))
+        return false;
+      const size_t payload = file.size()-sizeof(uint64_t);
+      uint64_t     hash    = 0;
+      std::memcpy(&hash,file.data()+payload,sizeof(hash));
+      if(hash!=key(file.data(),payload).hash)
+        return false;
+
+      Reader   rd{file.data(),payload};
+      uint32_t magic=0, version=0, count=0;
+      if(!rd.get(magic) || magic!=MAGIC || !rd.get(version) || version!=VERSION || !rd.get(count))
+        return false;
+
+      std::unordered_map<uint64_t,Entry> ld;
+      for(uint32_t i=0; i<count; ++i) {
+        uint64_t h = 0;
+        Entry    e;
+        uint32_t n = 0;
+        if(!rd.get(h) || !rd.get(e.size) || !rd.get(n) || n>rd.left())
+          return false;
+        e.ref.vdecl.resize(n);
+        for(auto& d:e.ref.vdecl) {
+          uint8_t v = 0;
+          if(!rd.get(v) || v>=Decl::count)
+            return false;
+          d = Decl::ComponentType(v);
+          }
+        if(!rd.get(n) || n>rd.left())
+          return false;
+        e.ref.lay.resize(n);
+        for(auto& b:e.ref.lay) {
+          uint8_t cls=0, stage=0;
+          if(!rd.get(b.layout) || !rd.get(cls) || !rd.get(stage) || !rd.get(b.size))
+            return false;
+          if(cls>ShaderReflection::Push)
+            return false;
+          b.cls   = ShaderReflection::Class(cls);
+          b.stage = ShaderReflection::Stage(stage);
+          }
+        if(!rd.get(n) || n>rd.left())
+          return false;
+        e.ref.spec.resize(n);
+        for(auto& c:e.ref.spec) {
+          uint8_t type=0, stage=0;
+          if(!rd.get(c.id) || !rd.get(type) || !rd.get(stage))
+            return false;
+          if(type>SpecializationConstants::Float)
+            return false;
+          c.type  = ShaderReflection::SpecType(type);
+          c.stage = ShaderReflection::Stage(stage);
+          }
+        ld[h] = std::move(e);
+        }
+      if(rd.left()!=0)
+        return false;
+
+      std::lock_guard<std::mutex> guard(sync);
+      for(auto& i:ld)
+        entries.insert(std::move(i));
+      return true;
+      }
+
+    // binary helpers, also used by TranslationCache
+    struct Reader {
+      const uint8_t* at;
+      size_t         size;
+
+      size_t left() const { return size; }
+
+      template<class T>
+      bool get(T& v) {
+        if(size<sizeof(T))
+          return false;
+        std::memcpy(&v,at,sizeof(T));
+        at   += sizeof(T);
+        size -= sizeof(T);
+        return true;
+        }
+
+      // n raw bytes, or nullptr if file is truncated
+      const uint8_t* take(size_t n) {
+        if(size<n)
+          return nullptr;
+        auto* ret = at;
+        at   += n;
+        size -= n;
+        return ret;
+        }
+      };
+
+    template<class T>
+    static void put(std::vector<uint8_t>& out, const T& v) {
+      const size_t at = out.size();
+      out.resize(at+sizeof(T));
+      std::memcpy(out.data()+at,&v,sizeof(T));
+      }
+
+  private:
+    enum : uint32_t {
+      MAGIC = 0x43525354, // "TSRC"
+      };
+
+    struct Entry {
+      uint64_t   size = 0;
+      Reflection ref;
+      };
+
+    mutable std::mutex                 sync;
+    std::unordered_map<uint64_t,Entry> entries;
+    bool                               dirty    = false;
+    mutable size_t                     hitCount = 0;
+  };
+
+}}
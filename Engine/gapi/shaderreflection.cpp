@@ -2,6 +2,9 @@
 
 #include <Tempest/Except>
 
+#include <algorithm>
+#include <cstring>
+
 #include "thirdparty/spirv_cross/spirv_common.hpp"
 
 using namespace Tempest;
@@ -40,29 +43,7 @@ void ShaderReflection::getVertexDecl(std::vector<Decl::ComponentType>& data, spi
 
 void ShaderReflection::getBindings(std::vector<Binding>&  lay,
                                    spirv_cross::Compiler& comp) {
-  Stage s = Stage::Compute;
-  switch(comp.get_execution_model()) {
-    case spv::ExecutionModelGLCompute:
-      s = Stage::Compute;
-      break;
-    case spv::ExecutionModelVertex:
-      s = Stage::Vertex;
-      break;
-    case spv::ExecutionModelTessellationControl:
-      s = Stage::Control;
-      break;
-    case spv::ExecutionModelTessellationEvaluation:
-      s = Stage::Evaluate;
-      break;
-    case spv::ExecutionModelGeometry:
-      s = Stage::Geometry;
-      break;
-    case spv::ExecutionModelFragment:
-      s = Stage::Fragment;
-      break;
-    default: // unimplemented
-      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
-    }
+  const Stage s = stage(comp);
 
   spirv_cross::ShaderResources resources = comp.get_shader_resources();
   for(auto &resource : resources.sampled_images) {
@@ -122,6 +103,35 @@ void ShaderReflection::getBindings(std::vector<Binding>&  lay,
     }
   }
 
+void ShaderReflection::getSpecConstants(std::vector<SpecConstant>& ret, spirv_cross::Compiler& comp) {
+  const Stage s = stage(comp);
+  for(auto& i:comp.get_specialization_constants()) {
+    auto& c = comp.get_constant(i.id);
+    auto& t = comp.get_type(c.constant_type);
+    SpecConstant sc;
+    sc.id    = i.constant_id;
+    sc.stage = s;
+    switch(t.basetype) {
+      case spirv_cross::SPIRType::Boolean:
+        sc.type = SpecializationConstants::Bool;
+        break;
+      case spirv_cross::SPIRType::Int:
+        sc.type = SpecializationConstants::Int;
+        break;
+      case spirv_cross::SPIRType::UInt:
+        sc.type = SpecializationConstants::UInt;
+        break;
+      case spirv_cross::SPIRType::Float:
+        sc.type = SpecializationConstants::Float;
+        break;
+      default:
+        // 64-bit and 8/16-bit constants are not supported: shader keeps default value
+        continue;
+      }
+    ret.push_back(sc);
+    }
+  }
+
 void ShaderReflection::merge(std::vector<ShaderReflection::Binding>& ret,
                              ShaderReflection::PushBlock& pb,
                              const std::vector<ShaderReflection::Binding>& comp) {
@@ -181,6 +191,91 @@ void ShaderReflection::merge(std::vector<Binding>& ret,
   finalize(ret);
   }
 
+void ShaderReflection::specialize(std::vector<SpecValue>& ret,
+                                  const std::vector<SpecConstant>* sh[],
+                                  size_t count,
+                                  const SpecializationConstants& values) {
+  for(size_t shId=0; shId<count; ++shId) {
+    if(sh[shId]==nullptr)
+      continue;
+    for(auto& c:*sh[shId]) {
+      const SpecializationConstants::Value* v = nullptr;
+      for(size_t i=0; i<values.size(); ++i)
+        if(values.data()[i].id==c.id)
+          v = &values.data()[i];
+      if(v==nullptr)
+        continue;
+
+      bool ins = false;
+      for(auto& r:ret)
+        if(r.id==c.id) {
+          r.stage = Stage(r.stage | c.stage);
+          ins     = true;
+          break;
+          }
+      if(ins)
+        continue;
+
+      SpecValue sv;
+      sv.id    = c.id;
+      sv.type  = c.type;
+      sv.stage = c.stage;
+      sv.bits  = convert(*v,c.type);
+      ret.push_back(sv);
+      }
+    }
+  std::sort(ret.begin(),ret.end(),[](const SpecValue& a, const SpecValue& b){
+    return a.id<b.id;
+    });
+  }
+
+uint32_t ShaderReflection::convert(const SpecializationConstants::Value& v, SpecType dst) {
+  if(v.type==dst)
+    return v.bits;
+
+  float f = 0;
+  std::memcpy(&f,&v.bits,sizeof(f));
+  switch(dst) {
+    case SpecializationConstants::Bool:
+      if(v.type==SpecializationConstants::Float)
+        return f!=0.f ? 1 : 0;
+      return v.bits!=0 ? 1 : 0;
+    case SpecializationConstants::Int:
+    case SpecializationConstants::UInt:
+      if(v.type==SpecializationConstants::Float)
+        return dst==SpecializationConstants::Int ? uint32_t(int32_t(f)) : uint32_t(f);
+      return v.bits;
+    case SpecializationConstants::Float: {
+      if(v.type==SpecializationConstants::Int)
+        f = float(int32_t(v.bits)); else
+        f = float(v.bits);
+      uint32_t bits = 0;
+      std::memcpy(&bits,&f,sizeof(bits));
+      return bits;
+      }
+    }
+  return v.bits;
+  }
+
+ShaderReflection::Stage ShaderReflection::stage(spirv_cross::Compiler& comp) {
+  switch(comp.get_execution_model()) {
+    case spv::ExecutionModelGLCompute:
+      return Stage::Compute;
+    case spv::ExecutionModelVertex:
+      return Stage::Vertex;
+    case spv::ExecutionModelTessellationControl:
+      return Stage::Control;
+    case spv::ExecutionModelTessellationEvaluation:
+      return Stage::Evaluate;
+    case spv::ExecutionModelGeometry:
+      return Stage::Geometry;
+    case spv::ExecutionModelFragment:
+      return Stage::Fragment;
+    default: // unimplemented
+      throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+    }
+  }
+
 void ShaderReflection::finalize(std::vector<Binding>& ret) {
   std::sort(ret.begin(),ret.end(),[](const Binding& a, const Binding& b){
     return a.layout<b.layout;
@@ -45,8 +45,26 @@ class ShaderReflection final {
       size_t   size  = 0;
       };
 
+    using SpecType = SpecializationConstants::Type;
+
+    struct SpecConstant {
+      uint32_t id    = 0;
+      SpecType type  = SpecializationConstants::UInt;
+      Stage    stage = Fragment;
+      };
+
+    // value of specialization constant, converted to declared type; stage is mask of stages, that use it
+    struct SpecValue {
+      uint32_t id    = 0;
+      SpecType type  = SpecializationConstants::UInt;
+      Stage    stage = Fragment;
+      uint32_t bits  = 0;
+      };
+
     static void getVertexDecl(std::vector<Decl::ComponentType>& data, spirv_cross::Compiler& comp);
     static void getBindings(std::vector<Binding>& b, spirv_cross::Compiler& comp);
+    static void getSpecConstants(std::vector<SpecConstant>& c, spirv_cross::Compiler& comp);
+    static Stage stage(spirv_cross::Compiler& comp);
 
     static void merge(std::vector<Binding>& ret,
                       PushBlock& pb,
@@ -56,8 +74,14 @@ class ShaderReflection final {
                       const std::vector<Binding>* sh[],
                       size_t count);
 
+    static void specialize(std::vector<SpecValue>& ret,
+                           const std::vector<SpecConstant>* sh[],
+                           size_t count,
+                           const SpecializationConstants& values);
+
   private:
-    static void finalize(std::vector<Binding>& p);
+    static void     finalize(std::vector<Binding>& p);
+    static uint32_t convert(const SpecializationConstants::Value& v, SpecType dst);
   };
 
 }
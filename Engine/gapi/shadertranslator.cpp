@@ -0,0 +1,112 @@
+#include "shadertranslator.h"
+
+#include <Tempest/Except>
+#include <Tempest/Platform>
+
+#include "thirdparty/spirv_cross/spirv_hlsl.hpp"
+#include "thirdparty/spirv_cross/spirv_msl.hpp"
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+std::string ShaderTranslator::Profile::name() const {
+  switch(target) {
+    case Hlsl:
+      return "hlsl"+std::to_string(version);
+    case MslMacOS:
+      return "msl-macos"+std::to_string(version);
+    case MslIOS:
+      return "msl-ios"+std::to_string(version);
+    }
+  return "unknown";
+  }
+
+ShaderTranslator::Profile ShaderTranslator::hlsl() {
+  Profile p;
+  p.target  = Hlsl;
+  p.version = 50;
+  return p;
+  }
+
+ShaderTranslator::Profile ShaderTranslator::msl() {
+  Profile p;
+#if defined(__OSX__)
+  p.target  = MslMacOS;
+#else
+  p.target  = MslIOS;
+#endif
+  p.version = spirv_cross::CompilerMSL::Options::make_msl_version(1,2);
+  return p;
+  }
+
+static void bakeSpecConstants(spirv_cross::Compiler& comp, const std::vector<ShaderReflection::SpecValue>& values) {
+  for(auto& c:comp.get_specialization_constants())
+    for(auto& v:values)
+      if(v.id==c.constant_id)
+        comp.get_constant(c.id).m.c[0].r[0].u32 = v.bits;
+  }
+
+static void reflect(ShaderTranslator::Result& out, spirv_cross::Compiler& comp) {
+  ShaderReflection::getVertexDecl(out.vdecl,comp);
+  ShaderReflection::getBindings(out.lay,comp);
+  ShaderReflection::getSpecConstants(out.spec,comp);
+  }
+
+void ShaderTranslator::translate(Result& out, const Profile& p, const uint32_t* spirv, size_t words,
+                                 const std::vector<ShaderReflection::SpecValue>* values) {
+  out = Result();
+
+  spirv_cross::CompilerGLSL::Options optGLSL;
+  optGLSL.vertex.flip_vert_y = true;
+
+  try {
+    if(p.target==Hlsl) {
+      spirv_cross::CompilerHLSL::Options optHLSL;
+      optHLSL.shader_model = p.version;
+
+      spirv_cross::CompilerHLSL comp(spirv,words);
+      comp.set_hlsl_options  (optHLSL);
+      comp.set_common_options(optGLSL);
+      // comp.remap_num_workgroups_builtin();
+      if(values!=nullptr)
+        bakeSpecConstants(comp,*values);
+      out.source = comp.compile();
+      out.stage  = ShaderReflection::stage(comp);
+      if(values==nullptr)
+        reflect(out,comp);
+      } else {
+      spirv_cross::CompilerMSL::Options optMSL;
+      optMSL.platform    = (p.target==MslMacOS) ? spirv_cross::CompilerMSL::Options::macOS
+                                                : spirv_cross::CompilerMSL::Options::iOS;
+      optMSL.msl_version = p.version;
+
+      spirv_cross::CompilerMSL comp(spirv,words);
+      comp.set_msl_options   (optMSL );
+      comp.set_common_options(optGLSL);
+      if(values!=nullptr)
+        bakeSpecConstants(comp,*values);
+      out.source = comp.compile();
+      out.stage  = ShaderReflection::stage(comp);
+      if(values==nullptr) {
+        reflect(out,comp);
+        for(auto& i:out.lay) {
+          i.mslBinding = comp.get_automatic_msl_resource_binding(i.spvId);
+          if(i.cls==ShaderReflection::Texture)
+            i.mslBinding2 = comp.get_automatic_msl_resource_binding_secondary(i.spvId);
+          }
+        }
+      }
+    }
+  catch(const std::bad_alloc&) {
+    throw;
+    }
+  catch(const std::system_error&) {
+    throw;
+    }
+  catch(const spirv_cross::CompilerError& err) {
+    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule,err.what());
+    }
+  catch(...) {
+    throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+    }
+  }
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include <string>
+#include <vector>
+
+#include "shaderreflection.h"
+
+namespace Tempest {
+namespace Detail {
+
+// SPIR-V to HLSL/MSL cross-compilation, as done by DirectX12 and Metal backends.
+// Needs only spirv_cross, so it's also used by offline tools.
+class ShaderTranslator final {
+  public:
+    enum Target : uint8_t {
+      Hlsl     = 0,
+      MslMacOS = 1,
+      MslIOS   = 2,
+      };
+
+    struct Profile {
+      Target   target  = Hlsl;
+      uint32_t version = 50; // shader model for hlsl, msl version for metal
+
+      bool operator == (const Profile& p) const { return target==p.target && version==p.version; }
+      bool operator != (const Profile& p) const { return !(*this==p); }
+
+      // short name, usable as part of file name: "hlsl50", "msl-macos10200"
+      std::string name() const;
+      };
+
+    static Profile hlsl();
+    static Profile msl();
+
+    struct Result {
+      std::string                                 source;
+      ShaderReflection::Stage                     stage = ShaderReflection::Fragment;
+      std::vector<Decl::ComponentType>            vdecl;
+      std::vector<ShaderReflection::Binding>      lay;   // mslBinding's are filled for msl targets
+      std::vector<ShaderReflection::SpecConstant> spec;
+      };
+
+    // values: specialization constants to bake into source; reflection is not filled in that case.
+    // Throws std::system_error(InvalidShaderModule), with spirv_cross message, if any
+    static void translate(Result& out, const Profile& p, const uint32_t* spirv, size_t words,
+                          const std::vector<ShaderReflection::SpecValue>* values = nullptr);
+  };
+
+}
+}
@@ -0,0 +1,504 @@
+#include "spirvreflection.h"
+
+#include <Tempest/Except>
+
+#include <algorithm>
+#include <cstring>
+
+#include "thirdparty/spirv_cross/spirv.hpp"
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+[[noreturn]] static void invalidModule() {
+  throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+  }
+
+// minimal word count of type declaration: every operand, that reflection reads, is present
+static uint32_t typeLength(uint32_t op) {
+  switch(op) {
+    case spv::OpTypeInt:          return 4;
+    case spv::OpTypeFloat:        return 3;
+    case spv::OpTypeVector:       return 4;
+    case spv::OpTypeMatrix:       return 4;
+    case spv::OpTypeImage:        return 9;
+    case spv::OpTypeSampledImage: return 3;
+    case spv::OpTypeArray:        return 4;
+    case spv::OpTypeRuntimeArray: return 3;
+    case spv::OpTypePointer:      return 4;
+    case spv::OpTypeFunction:     return 3;
+    default:                      return 2;
+    }
+  }
+
+SpirvReflection::SpirvReflection(const uint32_t* spirv, size_t words)
+  :code(spirv), words(words) {
+  parse();
+  }
+
+void SpirvReflection::parse() {
+  if(words<5 || code[0]!=spv::MagicNumber)
+    invalidModule();
+  version = code[1];
+  // universal limit of SPIR-V id bound
+  if(code[3]==0 || code[3]>0x400000)
+    invalidModule();
+  ids.resize(code[3]);
+
+  bool entry = false;
+  for(size_t i=5; i<words;) {
+    const uint32_t  len  = code[i] >> 16;
+    const uint32_t  op   = code[i] & 0xFFFF;
+    const uint32_t* arg  = code+i+1;
+    const size_t    argc = len-1;
+    if(len==0 || i+len>words)
+      invalidModule();
+
+    switch(op) {
+      case spv::OpEntryPoint:
+        // first entry point is the one used, same as in spirv_cross
+        if(!entry)
+          entryPoint(arg,argc);
+        entry = true;
+        break;
+      case spv::OpDecorate:
+        if(argc<2)
+          invalidModule();
+        decorate(arg[0],arg[1],arg+2,argc-2);
+        break;
+      case spv::OpMemberDecorate:
+        if(argc<3)
+          invalidModule();
+        decorateMember(arg[0],arg[1],arg[2],arg+3,argc-3);
+        break;
+      case spv::OpTypeVoid:
+      case spv::OpTypeBool:
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat:
+      case spv::OpTypeVector:
+      case spv::OpTypeMatrix:
+      case spv::OpTypeImage:
+      case spv::OpTypeSampler:
+      case spv::OpTypeSampledImage:
+      case spv::OpTypeArray:
+      case spv::OpTypeRuntimeArray:
+      case spv::OpTypeStruct:
+      case spv::OpTypePointer:
+      case spv::OpTypeFunction:
+      case spv::OpTypeAccelerationStructureKHR:
+        if(len<typeLength(op))
+          invalidModule();
+        meta(arg[0]).at = uint32_t(i);
+        break;
+      case spv::OpConstant:
+      case spv::OpSpecConstant:
+      case spv::OpSpecConstantTrue:
+      case spv::OpSpecConstantFalse:
+        if(argc<2 || ((op==spv::OpConstant || op==spv::OpSpecConstant) && argc<3))
+          invalidModule();
+        meta(arg[1]).at = uint32_t(i);
+        if(op!=spv::OpConstant && (ids[arg[1]].flags & HasSpecId))
+          specConst.push_back(arg[1]);
+        break;
+      case spv::OpVariable: {
+        if(argc<3)
+          invalidModule();
+        meta(arg[1]).at = uint32_t(i);
+        if(arg[2]!=spv::StorageClassFunction) {
+          Variable v;
+          v.id      = arg[1];
+          v.type    = arg[0];
+          v.storage = arg[2];
+          vars.push_back(v);
+          }
+        break;
+        }
+      case spv::OpFunction:
+        // globals are declared before any function: bodies are not walked
+        i = words;
+        continue;
+      default:
+        break;
+      }
+    i += len;
+    }
+
+  if(!entry)
+    invalidModule();
+  }
+
+void SpirvReflection::entryPoint(const uint32_t* arg, size_t argc) {
+  if(argc<3)
+    invalidModule();
+  switch(arg[0]) {
+    case spv::ExecutionModelGLCompute:
+      stg = ShaderReflection::Compute;
+      break;
+    case spv::ExecutionModelVertex:
+      stg = ShaderReflection::Vertex;
+      break;
+    case spv::ExecutionModelTessellationControl:
+      stg = ShaderReflection::Control;
+      break;
+    case spv::ExecutionModelTessellationEvaluation:
+      stg = ShaderReflection::Evaluate;
+      break;
+    case spv::ExecutionModelGeometry:
+      stg = ShaderReflection::Geometry;
+      break;
+    case spv::ExecutionModelFragment:
+      stg = ShaderReflection::Fragment;
+      break;
+    default: // unimplemented
+      invalidModule();
+    }
+
+  // name: nul-terminated string, padded to words
+  size_t name = 2;
+  while(name<argc) {
+    const uint32_t w = arg[name];
+    ++name;
+    if((w & 0xFF000000u)==0)
+      break;
+    }
+  interface.assign(arg+name,arg+argc);
+  std::sort(interface.begin(),interface.end());
+  }
+
+void SpirvReflection::decorate(uint32_t id, uint32_t dec, const uint32_t* arg, size_t argc) {
+  auto& m = meta(id);
+  switch(dec) {
+    case spv::DecorationBlock:
+      m.flags |= Block;
+      break;
+    case spv::DecorationBufferBlock:
+      m.flags |= BufferBlock;
+      break;
+    case spv::DecorationBuiltIn:
+      m.flags |= BuiltIn;
+      break;
+    case spv::DecorationNonWritable:
+      m.flags |= NonWritable;
+      break;
+    case spv::DecorationBinding:
+      if(argc<1)
+        invalidModule();
+      m.binding = arg[0];
+      break;
+    case spv::DecorationLocation:
+      if(argc<1)
+        invalidModule();
+      m.location = arg[0];
+      break;
+    case spv::DecorationSpecId:
+      if(argc<1)
+        invalidModule();
+      m.flags |= HasSpecId;
+      m.specId = arg[0];
+      break;
+    case spv::DecorationArrayStride:
+      if(argc<1)
+        invalidModule();
+      m.flags      |= HasArrayStride;
+      m.arrayStride = arg[0];
+      break;
+    default:
+      break;
+    }
+  }
+
+void SpirvReflection::decorateMember(uint32_t id, uint32_t mem, uint32_t dec, const uint32_t* arg, size_t argc) {
+  meta(id);
+  auto& mx = members[id];
+  if(mem>=mx.size())
+    mx.resize(mem+1);
+  auto& m = mx[mem];
+  switch(dec) {
+    case spv::DecorationBuiltIn:
+      m.flags |= BuiltIn;
+      break;
+    case spv::DecorationNonWritable:
+      m.flags |= NonWritable;
+      break;
+    case spv::DecorationRowMajor:
+      m.flags |= RowMajor;
+      break;
+    case spv::DecorationColMajor:
+      m.flags |= ColMajor;
+      break;
+    case spv::DecorationOffset:
+      if(argc<1)
+        invalidModule();
+      m.flags |= HasOffset;
+      m.offset = arg[0];
+      break;
+    case spv::DecorationMatrixStride:
+      if(argc<1)
+        invalidModule();
+      m.flags       |= HasMatrixStride;
+      m.matrixStride = arg[0];
+      break;
+    default:
+      break;
+    }
+  }
+
+SpirvReflection::Id& SpirvReflection::meta(uint32_t id) {
+  if(id==0 || id>=ids.size())
+    invalidModule();
+  return ids[id];
+  }
+
+const uint32_t* SpirvReflection::inst(uint32_t id) const {
+  if(id>=ids.size() || ids[id].at==0)
+    invalidModule();
+  return code+ids[id].at;
+  }
+
+uint32_t SpirvReflection::opcode(uint32_t id) const {
+  return inst(id)[0] & 0xFFFF;
+  }
+
+uint32_t SpirvReflection::pointee(uint32_t ptr) const {
+  auto* i = inst(ptr);
+  if((i[0] & 0xFFFF)!=spv::OpTypePointer || (i[0]>>16)<4)
+    invalidModule();
+  return i[3];
+  }
+
+uint32_t SpirvReflection::stripArray(uint32_t type) const {
+  for(uint32_t depth=0; ; ++depth) {
+    if(depth>MAX_TYPE_DEPTH)
+      invalidModule(); // cyclic type
+    auto* i = inst(type);
+    const uint32_t op = i[0] & 0xFFFF;
+    if(op!=spv::OpTypeArray && op!=spv::OpTypeRuntimeArray)
+      return type;
+    type = i[2];
+    }
+  }
+
+uint32_t SpirvReflection::scalar(uint32_t type, uint32_t& vecsize) const {
+  type    = stripArray(type);
+  vecsize = 1;
+  if(opcode(type)==spv::OpTypeMatrix)
+    type = inst(type)[2];
+  if(opcode(type)==spv::OpTypeVector) {
+    vecsize = inst(type)[3];
+    type    = inst(type)[2];
+    }
+  return type;
+  }
+
+bool SpirvReflection::isInterface(uint32_t id) const {
+  return std::binary_search(interface.begin(),interface.end(),id);
+  }
+
+bool SpirvReflection::isBuiltin(const Variable& v) const {
+  if(ids[v.id].flags & BuiltIn)
+    return true;
+  auto it = members.find(stripArray(pointee(v.type)));
+  if(it==members.end())
+    return false;
+  for(auto& m:it->second)
+    if(m.flags & BuiltIn)
+      return true;
+  return false;
+  }
+
+const SpirvReflection::Member* SpirvReflection::member(uint32_t type, uint32_t i) const {
+  auto it = members.find(type);
+  if(it==members.end() || i>=it->second.size())
+    return nullptr;
+  return &it->second[i];
+  }
+
+uint32_t SpirvReflection::constantU32(uint32_t id) const {
+  // specialization constant: default value, as spirv_cross does
+  auto* i = inst(id);
+  const uint32_t op = i[0] & 0xFFFF;
+  if((op!=spv::OpConstant && op!=spv::OpSpecConstant) || (i[0]>>16)<4)
+    invalidModule();
+  return i[3];
+  }
+
+uint64_t SpirvReflection::structSize(uint32_t type, uint32_t depth) const {
+  if(depth>MAX_TYPE_DEPTH)
+    invalidModule(); // cyclic type
+  auto* i = inst(type);
+  const uint32_t len = i[0]>>16;
+  if((i[0] & 0xFFFF)!=spv::OpTypeStruct || len<3)
+    invalidModule(); // declared struct in block cannot be empty
+  const uint32_t last = len-3;
+  auto*          m    = member(type,last);
+  if(m==nullptr || (m->flags & HasOffset)==0)
+    invalidModule();
+  return m->offset + memberSize(type,last,depth);
+  }
+
+uint64_t SpirvReflection::memberSize(uint32_t type, uint32_t id, uint32_t depth) const {
+  const uint32_t mt = inst(type)[2+id];
+
+  uint32_t vecsize = 1;
+  auto*    s       = inst(scalar(mt,vecsize));
+  switch(s[0] & 0xFFFF) {
+    case spv::OpTypeVoid:
+    case spv::OpTypeBool:
+    case spv::OpTypeImage:
+    case spv::OpTypeSampledImage:
+    case spv::OpTypeSampler:
+      // object with opaque size
+      invalidModule();
+    }
+
+  auto* i = inst(mt);
+  switch(i[0] & 0xFFFF) {
+    case spv::OpTypePointer:
+      if(i[2]!=spv::StorageClassPhysicalStorageBuffer)
+        invalidModule();
+      return 8;
+    case spv::OpTypeArray:
+    case spv::OpTypeRuntimeArray: {
+      if((ids[mt].flags & HasArrayStride)==0)
+        invalidModule();
+      const uint32_t count = ((i[0] & 0xFFFF)==spv::OpTypeArray) ? constantU32(i[3]) : 0;
+      return uint64_t(ids[mt].arrayStride)*count;
+      }
+    case spv::OpTypeStruct:
+      return structSize(mt,depth+1);
+    case spv::OpTypeMatrix: {
+      auto* m = member(type,id);
+      if(m==nullptr || (m->flags & HasMatrixStride)==0)
+        invalidModule();
+      if(m->flags & RowMajor)
+        return uint64_t(m->matrixStride)*vecsize;
+      if(m->flags & ColMajor)
+        return uint64_t(m->matrixStride)*i[3];
+      invalidModule();
+      }
+    case spv::OpTypeVector:
+    case spv::OpTypeInt:
+    case spv::OpTypeFloat: {
+      const uint32_t sop = s[0] & 0xFFFF;
+      if(sop!=spv::OpTypeInt && sop!=spv::OpTypeFloat)
+        invalidModule();
+      return vecsize*(s[2]/8);
+      }
+    }
+  invalidModule();
+  }
+
+void SpirvReflection::getVertexDecl(std::vector<Decl::ComponentType>& data) const {
+  if(stg!=ShaderReflection::Vertex)
+    return;
+
+  for(auto& v:vars) {
+    if(v.storage!=spv::StorageClassInput || !isInterface(v.id) || isBuiltin(v))
+      continue;
+    const uint32_t loc     = ids[v.id].location;
+    uint32_t       vecsize = 1;
+    auto*          s       = inst(scalar(pointee(v.type),vecsize));
+    data.resize(std::max<size_t>(loc+1,data.size()));
+
+    const uint32_t op = s[0] & 0xFFFF;
+    if(op==spv::OpTypeFloat && s[2]==32)
+      data[loc] = Decl::ComponentType(Decl::float1+vecsize-1);
+    else if(op==spv::OpTypeInt && s[2]==32 && s[3]!=0)
+      data[loc] = Decl::ComponentType(Decl::int1+vecsize-1);
+    else if(op==spv::OpTypeInt && s[2]==32)
+      data[loc] = Decl::ComponentType(Decl::uint1+vecsize-1);
+    else
+      invalidModule(); // not supported
+    }
+  }
+
+void SpirvReflection::getBindings(std::vector<ShaderReflection::Binding>& lay) const {
+  // same order as ShaderReflection::getBindings: by class, then by declaration
+  std::vector<ShaderReflection::Binding> tex, ubo, ssbo, img, push;
+
+  for(auto& v:vars) {
+    // SPIR-V 1.4 lists all used globals in entry point, earlier versions - only inputs and outputs
+    const bool io = (v.storage==spv::StorageClassInput || v.storage==spv::StorageClassOutput);
+    if((io || version>=0x10400) && !isInterface(v.id))
+      continue;
+    if(io || isBuiltin(v))
+      continue;
+
+    const uint32_t  t = stripArray(pointee(v.type));
+    const uint32_t* i = inst(t);
+    const uint32_t  op = i[0] & 0xFFFF;
+
+    ShaderReflection::Binding b;
+    b.layout = ids[v.id].binding;
+    b.stage  = stg;
+    b.spvId  = v.id;
+
+    if(v.storage==spv::StorageClassUniformConstant && op==spv::OpTypeImage && i[3]==spv::DimSubpassData) {
+      continue;
+      }
+    else if(v.storage==spv::StorageClassUniform && (ids[t].flags & Block)) {
+      b.cls  = ShaderReflection::Ubo;
+      b.size = structSize(t);
+      ubo.push_back(b);
+      }
+    else if((v.storage==spv::StorageClassUniform && (ids[t].flags & BufferBlock)) ||
+            v.storage==spv::StorageClassStorageBuffer) {
+      // readonly, if variable or every member of block is NonWritable
+      bool readonly = (ids[v.id].flags & NonWritable);
+      if(!readonly && op==spv::OpTypeStruct && (i[0]>>16)>2) {
+        readonly = true;
+        for(uint32_t m=0; m+2<(i[0]>>16); ++m) {
+          auto* mx = member(t,m);
+          readonly &= (mx!=nullptr && (mx->flags & NonWritable));
+          }
+        }
+      b.cls  = readonly ? ShaderReflection::SsboR : ShaderReflection::SsboRW;
+      b.size = structSize(t);
+      ssbo.push_back(b);
+      }
+    else if(v.storage==spv::StorageClassPushConstant) {
+      b.cls  = ShaderReflection::Push;
+      b.size = structSize(t);
+      push.push_back(b);
+      }
+    else if(v.storage==spv::StorageClassUniformConstant && op==spv::OpTypeImage && i[7]==2) {
+      b.cls  = ShaderReflection::ImgRW;
+      img.push_back(b);
+      }
+    else if(v.storage==spv::StorageClassUniformConstant && op==spv::OpTypeSampledImage) {
+      b.cls  = ShaderReflection::Texture;
+      tex.push_back(b);
+      }
+    }
+
+  for(auto* l:{&tex,&ubo,&ssbo,&img,&push})
+    lay.insert(lay.end(),l->begin(),l->end());
+  }
+
+void SpirvReflection::getSpecConstants(std::vector<ShaderReflection::SpecConstant>& ret) const {
+  for(auto id:specConst) {
+    auto* t = inst(inst(id)[1]);
+    ShaderReflection::SpecConstant sc;
+    sc.id    = ids[id].specId;
+    sc.stage = stg;
+    switch(t[0] & 0xFFFF) {
+      case spv::OpTypeBool:
+        sc.type = SpecializationConstants::Bool;
+        break;
+      case spv::OpTypeInt:
+        if(t[2]!=32)
+          continue;
+        sc.type = (t[3]!=0) ? SpecializationConstants::Int : SpecializationConstants::UInt;
+        break;
+      case spv::OpTypeFloat:
+        if(t[2]!=32)
+          continue;
+        sc.type = SpecializationConstants::Float;
+        break;
+      default:
+        // 64-bit and 8/16-bit constants are not supported: shader keeps default value
+        continue;
+      }
+    ret.push_back(sc);
+    }
+  }
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include <unordered_map>
+#include <vector>
+
+#include "shaderreflection.h"
+
+namespace Tempest {
+namespace Detail {
+
+// Single-pass walker over SPIR-V decorations, types and global variables.
+// Gives same vertex inputs, bindings and specialization constants as ShaderReflection over spirv_cross::Compiler,
+// without building compiler IR: used by Vulkan backend, that needs no source translation.
+class SpirvReflection final {
+  public:
+    // spirv must outlive reflection; throws std::system_error(InvalidShaderModule) for malformed modules
+    SpirvReflection(const uint32_t* spirv, size_t words);
+
+    ShaderReflection::Stage stage() const { return stg; }
+
+    void getVertexDecl(std::vector<Decl::ComponentType>& data) const;
+    void getBindings(std::vector<ShaderReflection::Binding>& b) const;
+    void getSpecConstants(std::vector<ShaderReflection::SpecConstant>& c) const;
+
+  private:
+    // deepest nesting of arrays and structs; well-formed module has no cyclic types, but malicious one may
+    enum {
+      MAX_TYPE_DEPTH = 256,
+      };
+
+    enum Flags : uint16_t {
+      Block           = 1<<0,
+      BufferBlock     = 1<<1,
+      BuiltIn         = 1<<2,
+      NonWritable     = 1<<3,
+      HasSpecId       = 1<<4,
+      HasArrayStride  = 1<<5,
+      HasOffset       = 1<<6,
+      HasMatrixStride = 1<<7,
+      RowMajor        = 1<<8,
+      ColMajor        = 1<<9,
+      };
+
+    struct Member {
+      uint16_t flags        = 0;
+      uint32_t offset       = 0;
+      uint32_t matrixStride = 0;
+      };
+
+    struct Id {
+      uint32_t at          = 0; // offset of instruction, that defines id
+      uint16_t flags       = 0;
+      uint32_t binding     = 0;
+      uint32_t location    = 0;
+      uint32_t specId      = 0;
+      uint32_t arrayStride = 0;
+      };
+
+    struct Variable {
+      uint32_t id      = 0;
+      uint32_t type    = 0; // pointer type
+      uint32_t storage = 0;
+      };
+
+    const uint32_t*                                  code    = nullptr;
+    size_t                                           words   = 0;
+    uint32_t                                         version = 0;
+    ShaderReflection::Stage                          stg     = ShaderReflection::Vertex;
+    std::vector<Id>                                  ids;
+    std::unordered_map<uint32_t,std::vector<Member>> members;
+    std::vector<uint32_t>                            interface;
+    std::vector<Variable>                            vars;
+    std::vector<uint32_t>                            specConst;
+
+    void            parse();
+    void            entryPoint(const uint32_t* op, size_t argc);
+    void            decorate(uint32_t id, uint32_t dec, const uint32_t* arg, size_t argc);
+    void            decorateMember(uint32_t id, uint32_t mem, uint32_t dec, const uint32_t* arg, size_t argc);
+    Id&             meta(uint32_t id);
+
+    const uint32_t* inst(uint32_t id) const;
+    uint32_t        opcode(uint32_t id) const;
+    uint32_t        pointee(uint32_t ptr) const;
+    uint32_t        stripArray(uint32_t type) const;
+    uint32_t        scalar(uint32_t type, uint32_t& vecsize) const;
+    bool            isInterface(uint32_t id) const;
+    bool            isBuiltin(const Variable& v) const;
+    const Member*   member(uint32_t type, uint32_t i) const;
+    uint32_t        constantU32(uint32_t id) const;
+    uint64_t        structSize(uint32_t type, uint32_t depth=0) const;
+    uint64_t        memberSize(uint32_t type, uint32_t i, uint32_t depth) const;
+  };
+
+}
+}
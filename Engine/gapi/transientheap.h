@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Tempest {
+namespace Detail {
+
+// Linear allocator over persistently mapped host-visible chunks, owned by a command buffer.
+// Slices are recycled, once command buffer is recorded again: at that point previous submission must be completed.
+template<class Buffer>
+class TransientHeap {
+  public:
+    enum {
+      CHUNK_SIZE=256*1024
+      };
+
+    struct Chunk {
+      std::unique_ptr<Buffer> buf;
+      uint8_t*                mapped=nullptr;
+      size_t                  size  =0;
+      size_t                  used  =0;
+      };
+
+    // mkChunk(Chunk&) have to fill Chunk::buf and Chunk::mapped, for Chunk::size bytes
+    template<class MkChunk>
+    bool alloc(size_t size, size_t align, AbstractGraphicsApi::Transient& out, MkChunk&& mkChunk) {
+      if(align==0)
+        align = 1;
+      for(; current<chunks.size(); ++current) {
+        if(bump(chunks[current],size,align,out))
+          return true;
+        }
+
+      Chunk c;
+      c.size = std::max<size_t>(CHUNK_SIZE,size);
+      if(!mkChunk(c) || c.mapped==nullptr)
+        return false;
+      chunks.emplace_back(std::move(c));
+      current = chunks.size()-1;
+      return bump(chunks[current],size,align,out);
+      }
+
+    void reset() {
+      for(auto& i:chunks)
+        i.used = 0;
+      current = 0;
+      }
+
+    template<class Fn>
+    void clear(Fn&& fn) {
+      for(auto& i:chunks)
+        fn(i);
+      chunks.clear();
+      current = 0;
+      }
+
+  private:
+    static bool bump(Chunk& c, size_t size, size_t align, AbstractGraphicsApi::Transient& out) {
+      const size_t at = ((c.used+align-1)/align)*align;
+      if(at+size>c.size)
+        return false;
+      c.used     = at+size;
+      out.buf    = c.buf.get();
+      out.offset = at;
+      out.data   = c.mapped+at;
+      return true;
+      }
+
+    std::vector<Chunk> chunks;
+    size_t             current=0;
+  };
+
+}}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <Tempest/Except>
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shadercache.h"
+#include "shadertranslator.h"
+
+namespace Tempest {
+namespace Detail {
+
+// HLSL/MSL sources and reflection of SPIR-V modules, keyed by content hash; one cache per target profile.
+// Same as ShaderCache, but for backends, that cross-compile SPIR-V: file can be prepared offline by Tools/shadertranslate.
+// Only base shaders are cached: variants with baked specialization constants are translated on demand.
+class TranslationCache final {
+  public:
+    enum : uint32_t {
+      VERSION = 1,
+      };
+
+    using Key     = ShaderCache::Key;
+    using Profile = ShaderTranslator::Profile;
+    using Result  = ShaderTranslator::Result;
+
+    explicit TranslationCache(const Profile& p):prof(p) {}
+
+    const Profile& profile() const { return prof; }
+    std::string    fileName() const { return "shader-"+prof.name()+".bin"; }
+
+    // thread-safe
+    bool find(const Key& k, Result& out) const {
+      std::lock_guard<std::mutex> guard(sync);
+      auto it = entries.find(k.hash);
+      if(it==entries.end() || it->second.size!=k.size)
+        return false;
+      out = it->second.res;
+      ++hitCount;
+      return true;
+      }
+
+    void insert(const Key& k, const Result& r) {
+      std::lock_guard<std::mutex> guard(sync);
+      auto& e = entries[k.hash];
+      e.size  = k.size;
+      e.res   = r;
+      dirty   = true;
+      }
+
+    // cached translation, or new one, that is stored in cache
+    void translate(Result& out, const void* spirv, size_t size) {
+      if(size%4!=0)
+        throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
+      const Key k = ShaderCache::key(spirv,size);
+      if(find(k,out))
+        return;
+      ShaderTranslator::translate(out,prof,reinterpret_cast<const uint32_t*>(spirv),size/4);
+      insert(k,out);
+      }
+
+    size_t size() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return entries.size();
+      }
+
+    // successful find calls
+    size_t hits() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return hitCount;
+      }
+
+    // entries were added, since last load or serialize
+    bool isDirty() const {
+      std::lock_guard<std::mutex> guard(sync);
+      return dirty;
+      }
+
+    std::vector<uint8_t> serialize() {
+      std::lock_guard<std::mutex> guard(sync);
+      std::vector<uint8_t> ret;
+      put(ret,uint32_t(MAGIC));
+      put(ret,uint32_t(VERSION));
+      put(ret,uint8_t(prof.target));
+      put(ret,prof.version);
+      put(ret,uint32_t(entries.size()));
+      for(auto& i:entries) {
+        auto& r = i.second.res;
+        put(ret,i.first);
+        put(ret,i.second.size);
+        put(ret,uint32_t(r.source.size()));
+        ret.insert(ret.end(),r.source.begin(),r.source.end());
+        put(ret,uint8_t(r.stage));
+        put(ret,uint32_t(r.vdecl.size()));
+        for(auto d:r.vdecl)
+          put(ret,uint8_t(d));
+        put(ret,uint32_t(r.lay.size()));
+        for(auto& b:r.lay) {
+          put(ret,b.layout);
+          put(ret,uint8_t(b.cls));
+          put(ret,uint8_t(b.stage));
+          put(ret,b.size);
+          put(ret,b.mslBinding);
+          put(ret,b.mslBinding2);
+          }
+        put(ret,uint32_t(r.spec.size()));
+        for(auto& c:r.spec) {
+          put(ret,c.id);
+          put(ret,uint8_t(c.type));
+          put(ret,uint8_t(c.stage));
+          }
+        }
+      put(ret,ShaderCache::key(ret.data(),ret.size()).hash);
+      dirty = false;
+      return ret;
+      }
+
+    // merges entries of file; damaged, truncated, outdated or other-profile file is ignored as a whole
+    bool deserialize(const std::vector<uint8_t>& file) {
+      if(file.size()<sizeof(uint64_t))
+        return false;
+      const size_t payload = file.size()-sizeof(uint64_t);
+      uint64_t     hash    = 0;
+      std::memcpy(&hash,file.data()+payload,sizeof(hash));
+      if(hash!=ShaderCache::key(file.data(),payload).hash)
+        return false;
+
+      Reader   rd{file.data(),payload};
+      uint32_t magic=0, version=0, count=0, profVersion=0;
+      uint8_t  target=0;
+      if(!rd.get(magic) || magic!=MAGIC || !rd.get(version) || version!=VERSION)
+        return false;
+      if(!rd.get(target) || target!=prof.target || !rd.get(profVersion) || profVersion!=prof.version)
+        return false;
+      if(!rd.get(count))
+        return false;
+
+      std::unordered_map<uint64_t,Entry> ld;
+      for(uint32_t i=0; i<count; ++i) {
+        uint64_t h = 0;
+        Entry    e;
+        uint32_t n = 0;
+        if(!rd.get(h) || !rd.get(e.size) || !rd.get(n))
+          return false;
+        auto* src = rd.take(n);
+        if(src==nullptr)
+          return false;
+        e.res.source.assign(reinterpret_cast<const char*>(src),n);
+
+        uint8_t stage = 0;
+        if(!rd.get(stage))
+          return false;
+        e.res.stage = ShaderReflection::Stage(stage);
+
+        if(!rd.get(n) || n>rd.left())
+          return false;
+        e.res.vdecl.resize(n);
+        for(auto& d:e.res.vdecl) {
+          uint8_t v = 0;
+          if(!rd.get(v) || v>=Decl::count)
+            return false;
+          d = Decl::ComponentType(v);
+          }
+        if(!rd.get(n) || n>rd.left())
+          return false;
+        e.res.lay.resize(n);
+        for(auto& b:e.res.lay) {
+          uint8_t cls=0;
+          if(!rd.get(b.layout) || !rd.get(cls) || !rd.get(stage) || !rd.get(b.size) ||
+             !rd.get(b.mslBinding) || !rd.get(b.mslBinding2))
+            return false;
+          if(cls>ShaderReflection::Push)
+            return false;
+          b.cls   = ShaderReflection::Class(cls);
+          b.stage = ShaderReflection::Stage(stage);
+          }
+        if(!rd.get(n) || n>rd.left())
+          return false;
+        e.res.spec.resize(n);
+        for(auto& c:e.res.spec) {
+          uint8_t type=0;
+          if(!rd.get(c.id) || !rd.get(type) || !rd.get(stage))
+            return false;
+          if(type>SpecializationConstants::Float)
+            return false;
+          c.type  = ShaderReflection::SpecType(type);
+          c.stage = ShaderReflection::Stage(stage);
+          }
+        ld[h] = std::move(e);
+        }
+      if(rd.left()!=0)
+        return false;
+
+      std::lock_guard<std::mutex> guard(sync);
+      for(auto& i:ld)
+        entries.insert(std::move(i));
+      return true;
+      }
+
+  private:
+    enum : uint32_t {
+      MAGIC = 0x43545354, // "TSTC"
+      };
+
+    struct Entry {
+      uint64_t size = 0;
+      Result   res;
+      };
+
+    using Reader = ShaderCache::Reader;
+
+    template<class T>
+    static void put(std::vector<uint8_t>& out, const T& v) {
+      ShaderCache::put(out,v);
+      }
+
+    const Profile                      prof;
+    mutable std::mutex                 sync;
+    std::unordered_map<uint64_t,Entry> entries;
+    bool                               dirty    = false;
+    mutable size_t                     hitCount = 0;
+  };
+
+}}
@@ -1 +1,7 @@
 #include "uploadengine.h"
+
+uint32_t Tempest::Detail::uploadThreadId() {
+  static std::atomic<uint32_t> next{0};
+  static thread_local uint32_t id = next.fetch_add(1);
+  return id;
+  }
@@ -4,18 +4,22 @@
 #include <Tempest/Except>
 #include <Tempest/Log>
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <atomic>
 #include <vector>
 
-#include "utility/spinlock.h"
-
 namespace Tempest {
 
 namespace Detail {
 
+// small sequential id of calling thread
+uint32_t uploadThreadId();
+
 template<class CmdBuffer, class Fence>
 class TransferCmd : public CmdBuffer {
   public:
@@ -23,6 +27,10 @@ class TransferCmd : public CmdBuffer {
     using TexPtr = Detail::DSharedPtr<AbstractGraphicsApi::Texture*>;
     using ResPtr = Detail::DSharedPtr<AbstractGraphicsApi::Shared*>;
 
+    enum : uint64_t {
+      OPEN_BATCH = uint64_t(1)<<63, // tag bit of batch, that is still recorded
+      };
+
     template<class Device>
     TransferCmd(Device& dev):CmdBuffer(dev), fence(dev) {
       holdRes.reserve(4);
@@ -30,10 +38,12 @@ class TransferCmd : public CmdBuffer {
 
     void hold(BufPtr &b) {
       holdRes.emplace_back(ResPtr(b.handler));
+      mark(*b.handler);
       }
 
     void hold(TexPtr &b) {
       holdRes.emplace_back(ResPtr(b.handler));
+      mark(*b.handler);
       }
 
     bool wait(uint64_t t) {
@@ -47,26 +57,54 @@ class TransferCmd : public CmdBuffer {
       holdRes.clear();
       }
 
-    bool waitFor(AbstractGraphicsApi::Shared* s) {
-      for(auto& i:holdRes)
-        if(i.handler==s) {
-          wait();
-          return true;
-          }
-      return false;
+    // true, if resource was written by this batch
+    bool holds(AbstractGraphicsApi::Shared* s) const {
+      return tag!=0 && s->lastTransfer.load()==tag;
       }
 
+    // submission serial, already known in Device::submit; 0 for batch, that is still recorded
+    uint64_t serial() const { return (tag & OPEN_BATCH) ? 0 : tag; }
+    // staging memory of recorded copies, that is held until batch is complete
+    size_t   stagedBytes() const { return staged; }
+
     void reset() {
       holdRes.clear();
+      tag    = 0;
+      staged = 0;
       CmdBuffer::reset();
       }
 
     Fence               fence;
 
   private:
+    void mark(AbstractGraphicsApi::Shared& s) {
+      if(tag!=0)
+        s.lastTransfer.store(tag);
+      }
+
+    void markAll(uint64_t serial) {
+      const uint64_t open = tag;
+      tag = serial;
+      for(auto& i:holdRes) {
+        // other open batch is submitted later: keep it's tag
+        uint64_t cur = i.handler->lastTransfer.load();
+        while((cur==open || (cur & OPEN_BATCH)==0) && !i.handler->lastTransfer.compare_exchange_weak(cur,serial))
+          ;
+        }
+      }
+
+    uint64_t            tag    = 0; // OPEN_BATCH|generation|context while recorded as shared batch, submission serial afterwards
+    size_t              staged = 0;
     std::vector<ResPtr> holdRes;
+
+  template<class D, class C, class F, class B>
+  friend class UploadEngine;
   };
 
+// Every submission gets next serial, that is stored in resources it writes to (Shared::lastTransfer).
+// Fences of one queue are signaled in submission order, so waiting for a resource is one lookup into in-flight list.
+// Uploads from different threads are recorded into separate open batches (contexts), each with own command pool
+// and transient staging memory, so worker threads don't serialize on each other while recording.
 template<class Device, class CommandBuffer, class Fence, class Buffer>
 class UploadEngine final {
   public:
@@ -77,83 +115,211 @@ class UploadEngine final {
 
     using Commands = TransferCmd<CommandBuffer,Fence>;
 
+    enum {
+      FLUSH_THRESHOLD = 8*1024*1024, // staged bytes, after which open batch is submitted without waiting for sync point
+      CONTEXT_COUNT   = 8,           // open batches; threads beyond that share them
+      };
+
     std::unique_ptr<Commands> get();
     void                      submit(std::unique_ptr<Commands>&& cmd);
     void                      submitAndWait(std::unique_ptr<Commands>&& cmd);
+    // cmd stays with caller, who polls cmd.fence and gives it back with recycle(); used by async readbacks
+    void                      submitDetached(Commands& cmd);
+    void                      recycle(std::unique_ptr<Commands>&& cmd);
     void                      wait();
     void                      waitFor(AbstractGraphicsApi::Shared* s);
 
+    // fn(Commands&) records into open batch of calling thread, which is submitted by flush(), wait() or waitFor().
+    // Copies into dst from other batches are waited first (write-after-write); within the batch fn have to order them itself.
+    template<class Fn>
+    void                      record(AbstractGraphicsApi::Shared* dst, size_t bytes, Fn&& fn);
+    void                      flush();
+
     Buffer                    allocStagingMemory(const void* data, size_t count, size_t size, size_t alignedSz, MemUsage usage, BufferHeap heap);
 
   private:
+    struct Context {
+      std::mutex                sync;
+      std::unique_ptr<Commands> open;
+      };
+
+    Context&                  context()             { return ctx[uploadThreadId()%CONTEXT_COUNT]; }
+    Context&                  context(uint64_t tag) { return ctx[(tag & ~uint64_t(Commands::OPEN_BATCH))%CONTEXT_COUNT]; }
+
+    void                      implFlush(Context& c);
+    void                      implWaitFor(AbstractGraphicsApi::Shared* s, const Context* self);
+    uint64_t                  implSubmit(std::unique_ptr<Commands>&& cmd);
+    void                      implWait(uint64_t serial);
+    void                      implReap();
+    void                      retire();
+
     Device&                   device;
 
-    SpinLock                  sync;
-    std::vector<std::unique_ptr<Commands>> cmd;
-    bool                      hasWaits {false};
+    // held over queue submission and fence waits: not a spinlock
+    std::mutex                sync;
+    std::deque<std::unique_ptr<Commands>>  inflight; // ordered by serial, without gaps
+    std::vector<std::unique_ptr<Commands>> idle;
+    uint64_t                  serial = 0;
+    std::atomic<uint64_t>     completed{0};
+
+    Context                   ctx[CONTEXT_COUNT];
+    std::atomic<uint64_t>     openGen{0};
   };
 
 template<class Device, class CommandBuffer, class Fence, class Buffer>
 auto UploadEngine<Device,CommandBuffer,Fence,Buffer>::get() -> std::unique_ptr<Commands> {
   {
-  std::lock_guard<SpinLock> guard(sync);
-  if(!hasWaits && cmd.size()>0) {
-    auto ret = std::move(cmd.back());
-    cmd.pop_back();
-    if(cmd.size()>4)
-      cmd.resize(4);
+  std::lock_guard<std::mutex> guard(sync);
+  implReap();
+  if(idle.size()>0) {
+    auto ret = std::move(idle.back());
+    idle.pop_back();
+    if(idle.size()>CONTEXT_COUNT)
+      idle.resize(CONTEXT_COUNT);
     return ret;
     }
-  for(size_t i=0; i<cmd.size(); ++i) {
-    if(cmd[i]->wait(0)) {
-      std::swap(cmd[i],cmd.back());
-      auto ret = std::move(cmd.back());
-      cmd.pop_back();
-      return ret;
-      }
-    }
   }
   return std::unique_ptr<Commands>{new Commands(device)};
   }
 
 template<class Device, class CommandBuffer, class Fence, class Buffer>
 void UploadEngine<Device,CommandBuffer,Fence,Buffer>::wait() {
-  std::lock_guard<SpinLock> guard(sync);
-  if(!hasWaits)
-    return;
-  for(auto& i:cmd)
-    i->wait();
-  hasWaits = false;
+  flush();
+  std::lock_guard<std::mutex> guard(sync);
+  if(!inflight.empty())
+    implWait(inflight.back()->tag);
   }
 
 template<class Device, class CommandBuffer, class Fence, class Buffer>
 void UploadEngine<Device,CommandBuffer,Fence,Buffer>::waitFor(AbstractGraphicsApi::Shared* s) {
-  std::lock_guard<SpinLock> guard(sync);
-  if(!hasWaits)
+  implWaitFor(s,nullptr);
+  }
+
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+void UploadEngine<Device,CommandBuffer,Fence,Buffer>::implWaitFor(AbstractGraphicsApi::Shared* s, const Context* self) {
+  uint64_t t = s->lastTransfer.load();
+  if(t==0 || ((t & Commands::OPEN_BATCH)==0 && t<=completed.load()))
+    return;
+  if(t & Commands::OPEN_BATCH) {
+    Context& c = context(t);
+    if(&c==self)
+      return;
+    {
+    std::lock_guard<std::mutex> guard(c.sync);
+    if(c.open!=nullptr && c.open->tag==t)
+      implFlush(c);
+    }
+    t = s->lastTransfer.load();
+    if(t & Commands::OPEN_BATCH)
+      return;
+    }
+  std::lock_guard<std::mutex> guard(sync);
+  implWait(t);
+  }
+
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+void UploadEngine<Device,CommandBuffer,Fence,Buffer>::implWait(uint64_t s) {
+  if(s<=completed.load() || inflight.empty())
+    return;
+  const uint64_t first = inflight.front()->tag;
+  if(s<first)
     return;
-  bool waitAll = true;
-  for(auto& i:cmd)
-    waitAll &= i->waitFor(s);
-  hasWaits = !waitAll;
+  const size_t id = std::min(size_t(s-first),inflight.size()-1);
+  inflight[id]->wait();
+  // everything, submitted before, is complete as well
+  for(size_t i=0; i<=id; ++i)
+    retire();
+  }
+
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+void UploadEngine<Device,CommandBuffer,Fence,Buffer>::implReap() {
+  while(!inflight.empty() && inflight.front()->wait(0))
+    retire();
+  }
+
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+void UploadEngine<Device,CommandBuffer,Fence,Buffer>::retire() {
+  auto cmd = std::move(inflight.front());
+  inflight.pop_front();
+  cmd->wait();
+  completed.store(cmd->tag);
+  cmd->reset();
+  idle.push_back(std::move(cmd));
   }
 
 template<class Device, class CommandBuffer, class Fence, class Buffer>
 void UploadEngine<Device,CommandBuffer,Fence,Buffer>::submit(std::unique_ptr<Commands>&& cmd) {
+  implSubmit(std::move(cmd));
+  }
+
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+uint64_t UploadEngine<Device,CommandBuffer,Fence,Buffer>::implSubmit(std::unique_ptr<Commands>&& cmd) {
+  // serial order must match queue order
+  std::lock_guard<std::mutex> guard(sync);
+  // serial is assigned first: device may postpone part of submission, until written resources are used
+  const uint64_t ret = ++serial;
+  cmd->markAll(ret);
   device.submit(*cmd,cmd->fence);
+  // nobody may wait for uploads explicitly: release staging memory of finished batches here
+  implReap();
+  inflight.push_back(std::move(cmd));
+  return ret;
+  }
 
-  std::lock_guard<SpinLock> guard(sync);
-  this->cmd.push_back(std::move(cmd));
-  hasWaits = true;
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+template<class Fn>
+void UploadEngine<Device,CommandBuffer,Fence,Buffer>::record(AbstractGraphicsApi::Shared* dst, size_t bytes, Fn&& fn) {
+  Context& c = context();
+  if(dst!=nullptr) {
+    // write-after-write case: other batch is submitted and waited; own batch is ordered by fn
+    implWaitFor(dst,&c);
+    }
+
+  std::lock_guard<std::mutex> guard(c.sync);
+  if(c.open==nullptr) {
+    c.open = get();
+    c.open->begin();
+    c.open->tag = Commands::OPEN_BATCH | ((++openGen)*CONTEXT_COUNT + uint64_t(&c-ctx));
+    }
+  fn(*c.open);
+  c.open->staged += bytes;
+  if(c.open->staged>=FLUSH_THRESHOLD)
+    implFlush(c);
+  }
+
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+void UploadEngine<Device,CommandBuffer,Fence,Buffer>::flush() {
+  for(auto& c:ctx) {
+    std::lock_guard<std::mutex> guard(c.sync);
+    implFlush(c);
+    }
+  }
+
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+void UploadEngine<Device,CommandBuffer,Fence,Buffer>::implFlush(Context& c) {
+  if(c.open==nullptr)
+    return;
+  auto cmd = std::move(c.open);
+  cmd->end();
+  implSubmit(std::move(cmd));
   }
 
 template<class Device, class CommandBuffer, class Fence, class Buffer>
 void UploadEngine<Device,CommandBuffer,Fence,Buffer>::submitAndWait(std::unique_ptr<Commands>&& cmd) {
-  device.submit(*cmd,cmd->fence);
-  cmd->fence.wait();
-  cmd->reset();
+  const uint64_t s = implSubmit(std::move(cmd));
+  std::lock_guard<std::mutex> guard(sync);
+  implWait(s);
+  }
 
-  std::lock_guard<SpinLock> guard(sync);
-  this->cmd.push_back(std::move(cmd));
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+void UploadEngine<Device,CommandBuffer,Fence,Buffer>::submitDetached(Commands& cmd) {
+  device.submit(cmd,cmd.fence);
+  }
+
+template<class Device, class CommandBuffer, class Fence, class Buffer>
+void UploadEngine<Device,CommandBuffer,Fence,Buffer>::recycle(std::unique_ptr<Commands>&& cmd) {
+  std::lock_guard<std::mutex> guard(sync);
+  idle.push_back(std::move(cmd));
   }
 
 template<class Device, class CommandBuffer, class Fence, class Buffer>
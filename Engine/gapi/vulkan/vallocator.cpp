@@ -18,6 +18,7 @@ using namespace Tempest;
 using namespace Tempest::Detail;
 
 VAllocator::VAllocator() {
+  arenaProvider.owner = this;
   }
 
 VAllocator::~VAllocator() {
@@ -34,20 +35,19 @@ VDevice* VAllocator::device() {
   }
 
 VAllocator::Provider::~Provider() {
-  if(lastFree!=VK_NULL_HANDLE)
-    vkFreeMemory(device->device.impl,lastFree,nullptr);
+  trim(0);
   }
 
-VAllocator::Provider::DeviceMemory VAllocator::Provider::alloc(size_t size,uint32_t typeId) {
-  if(lastFree!=VK_NULL_HANDLE){
-    if(lastType==typeId && lastSize==size){
-      VkDeviceMemory memory=lastFree;
-      lastFree=VK_NULL_HANDLE;
+VAllocator::Provider::DeviceMemory VAllocator::Provider::alloc(size_t size, uint32_t typeId, bool dedicated) {
+  if(!dedicated) {
+    // allocate whole size class, so the page can be reused for any size of the same class
+    size = PageCache<DeviceMemory>::sizeClass(size);
+    std::lock_guard<std::mutex> guard(cacheSync);
+    VkDeviceMemory memory=VK_NULL_HANDLE;
+    if(cache.take(size,typeId,memory))
       return memory;
-      }
-    vkFreeMemory(device->device.impl,lastFree,nullptr);
-    lastFree=VK_NULL_HANDLE;
     }
+
   VkDeviceMemory memory=VK_NULL_HANDLE;
 
   VkMemoryAllocateInfo vk_memoryAllocateInfo;
@@ -57,18 +57,78 @@ VAllocator::Provider::DeviceMemory VAllocator::Provider::alloc(size_t size,uint3
   vk_memoryAllocateInfo.memoryTypeIndex = typeId;
 
   auto code = vkAllocateMemory(device->device.impl,&vk_memoryAllocateInfo,nullptr,&memory);
+  if(code!=VK_SUCCESS) {
+    // out of memory: give cached pages back to driver and try again
+    trim(0);
+    code = vkAllocateMemory(device->device.impl,&vk_memoryAllocateInfo,nullptr,&memory);
+    }
   if(code!=VK_SUCCESS)
     return VK_NULL_HANDLE;
+  grown.store(true);
   return memory;
   }
 
-void VAllocator::Provider::free(VAllocator::Provider::DeviceMemory m, size_t size, uint32_t typeId) {
-  if(lastFree!=VK_NULL_HANDLE)
-    vkFreeMemory(device->device.impl,lastFree,nullptr);
+void VAllocator::Provider::free(VAllocator::Provider::DeviceMemory m, size_t size, uint32_t typeId, bool dedicated) {
+  if(dedicated) {
+    release(m,size,typeId);
+    return;
+    }
+  size = PageCache<DeviceMemory>::sizeClass(size);
+  std::lock_guard<std::mutex> guard(cacheSync);
+  cache.put(m,size,typeId,[this](DeviceMemory m, size_t size, uint32_t typeId){
+    release(m,size,typeId);
+    });
+  }
+
+void VAllocator::Provider::setCacheSize(size_t bytes) {
+  std::lock_guard<std::mutex> guard(cacheSync);
+  cache.setCapacity(bytes,[this](DeviceMemory m, size_t size, uint32_t typeId){
+    release(m,size,typeId);
+    });
+  }
+
+void VAllocator::Provider::trim(size_t keepBytes) {
+  std::lock_guard<std::mutex> guard(cacheSync);
+  cache.trim(keepBytes,[this](DeviceMemory m, size_t size, uint32_t typeId){
+    release(m,size,typeId);
+    });
+  }
 
-  lastFree=m;
-  lastSize=size;
-  lastType=typeId;
+void VAllocator::Provider::release(VAllocator::Provider::DeviceMemory m, size_t, uint32_t) {
+  vkFreeMemory(device->device.impl,m,nullptr);
+  }
+
+void* VAllocator::Provider::map(VAllocator::Provider::DeviceMemory m, size_t size) {
+  void* ret=nullptr;
+  if(vkMapMemory(device->device.impl,m,0,size,0,&ret)!=VK_SUCCESS)
+    return nullptr;
+  return ret;
+  }
+
+void VAllocator::Provider::unmap(VAllocator::Provider::DeviceMemory m) {
+  vkUnmapMemory(device->device.impl,m);
+  }
+
+VAllocator::ArenaProvider::DeviceMemory VAllocator::ArenaProvider::alloc(size_t size, uint32_t typeId, bool) {
+  const BufferHeap heap  = (typeId==1 ? BufferHeap::Upload : BufferHeap::Device);
+  const MemUsage   usage = MemUsage::VertexBuffer | MemUsage::IndexBuffer | MemUsage::TransferDst | MemUsage::TransferSrc;
+  try {
+    return new VBuffer(owner->alloc(nullptr,size,1,1,usage,heap));
+    }
+  catch(...) {
+    return nullptr;
+    }
+  }
+
+void VAllocator::ArenaProvider::free(VAllocator::ArenaProvider::DeviceMemory m, size_t, uint32_t, bool) {
+  delete m;
+  }
+
+void* VAllocator::ArenaProvider::map(VAllocator::ArenaProvider::DeviceMemory m, size_t) {
+  return owner->map(*m);
+  }
+
+void VAllocator::ArenaProvider::unmap(VAllocator::ArenaProvider::DeviceMemory) {
   }
 
 static size_t GCD(size_t n1, size_t n2) {
@@ -116,23 +176,29 @@ VBuffer VAllocator::alloc(const void *mem, size_t count, size_t size, size_t ali
     createInfo.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 
   vkAssert(vkCreateBuffer(dev,&createInfo,nullptr,&ret.impl));
+  ret.size  = createInfo.size;
+  ret.usage = createInfo.usage;
 
   MemRequirements memRq={};
   getMemoryRequirements(memRq,ret.impl);
 
-  uint32_t props[2] = {};
+  // coherent memory first: persistently mapped pages then don't need vkFlushMappedMemoryRanges
+  uint32_t props[3] = {};
   uint8_t  propsCnt = 1;
   if(bufHeap==BufferHeap::Upload && usage==MemUsage::UniformBuffer) {
+    propsCnt = 3;
+    props[0] = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    props[1] = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    props[2] = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    }
+  else if(bufHeap==BufferHeap::Upload || bufHeap==BufferHeap::Readback) {
     propsCnt = 2;
-    props[0] = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    props[0] = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
     props[1] = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-    //props[1]|=(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);// to avoid vkFlushMappedMemoryRanges
     }
-  else if(bufHeap==BufferHeap::Upload)
-    props[0] = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
   else if(bufHeap==BufferHeap::Device)
     props[0] = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-  else if(bufHeap==BufferHeap::Readback)
+  else
     props[0] = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 
   for(uint8_t i=0; i<propsCnt; ++i) {
@@ -144,8 +210,7 @@ VBuffer VAllocator::alloc(const void *mem, size_t count, size_t size, size_t ali
     if(!ret.page.page)
       continue;
 
-    if(!commit(ret.page.page->memory,ret.page.page->mmapSync,ret.impl,ret.page.offset,
-               mem,count,size,alignedSz)) {
+    if(!commit(ret.page,ret.impl,mem,count,size,alignedSz)) {
       throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
       }
     return ret;
@@ -154,15 +219,15 @@ VBuffer VAllocator::alloc(const void *mem, size_t count, size_t size, size_t ali
   throw std::system_error(Tempest::GraphicsErrc::OutOfVideoMemory);
   }
 
-VTexture VAllocator::alloc(const Pixmap& pm,uint32_t mip,VkFormat format) {
+VTexture VAllocator::alloc(const uint32_t w, const uint32_t h, uint32_t mip, VkFormat format) {
   VTexture ret;
   ret.alloc = this;
 
   VkImageCreateInfo imageInfo = {};
   imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageInfo.imageType     = VK_IMAGE_TYPE_2D;
-  imageInfo.extent.width  = pm.w();
-  imageInfo.extent.height = pm.h();
+  imageInfo.extent.width  = w;
+  imageInfo.extent.height = h;
   imageInfo.extent.depth  = 1;
   imageInfo.mipLevels     = mip;
   imageInfo.arrayLayers   = 1;
@@ -243,24 +308,297 @@ VTexture VAllocator::alloc(const uint32_t w, const uint32_t h, const uint32_t mi
   return ret;
   }
 
+VBuffer VAllocator::allocTransient(size_t size) {
+  VBuffer ret;
+  ret.alloc = this;
+
+  VkBufferCreateInfo createInfo={};
+  createInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  createInfo.size        = size;
+  createInfo.usage       = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                           VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                           VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  // chunks are recycled between transfer and graphics queue, without ownership transfer
+  auto&    dx       = *provider.device;
+  uint32_t family[] = {dx.graphicsQueue->family, dx.transferQueue->family};
+  if(dx.hasTransferQueue()) {
+    createInfo.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+    createInfo.queueFamilyIndexCount = 2;
+    createInfo.pQueueFamilyIndices   = family;
+    }
+  vkAssert(vkCreateBuffer(dev,&createInfo,nullptr,&ret.impl));
+  ret.size  = createInfo.size;
+  ret.usage = createInfo.usage;
+
+  MemRequirements memRq={};
+  getMemoryRequirements(memRq,ret.impl);
+
+  // coherent memory is guaranteed by spec, so no flush is required before submit
+  auto props = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  VDevice::MemIndex memId = provider.device->memoryTypeIndex(memRq.memoryTypeBits,VkMemoryPropertyFlagBits(props),VK_IMAGE_TILING_LINEAR);
+  if(memId.typeId==uint32_t(-1))
+    throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
+
+  // not dedicated: exact-size memory would bypass page cache, and chunks come and go with command buffers
+  ret.page = allocator.alloc(memRq.size,memRq.alignment,memId.heapId,memId.typeId,true);
+  if(!ret.page.page)
+    throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
+  if(!commit(ret.page,ret.impl,nullptr,0,0,0))
+    throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
+  return ret;
+  }
+
+VBuffer VAllocator::allocSlice(size_t count, size_t alignedSz, BufferHeap bufHeap) {
+  const size_t   size = count*alignedSz;
+  const uint32_t heap = (bufHeap==BufferHeap::Upload ? 1 : 0);
+  ArenaAllocation a = arena.alloc(size,LCM(alignedSz,4),heap,heap,bufHeap==BufferHeap::Upload);
+  if(a.page==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::OutOfVideoMemory);
+
+  // arena buffers are never relocated, so handle and memory can be shared by slices
+  VBuffer& src = *a.page->memory;
+  VBuffer  ret;
+  ret.alloc       = this;
+  ret.impl        = src.impl;
+  ret.page        = src.page;
+  ret.page.block  = nullptr;
+  ret.page.offset = src.page.offset + a.offset;
+  ret.page.size   = size;
+  ret.size        = size;
+  ret.usage       = src.usage;
+  ret.base        = a.offset;
+  ret.stride      = uint32_t(alignedSz);
+  ret.slice       = a;
+  return ret;
+  }
+
 void VAllocator::free(VBuffer &buf) {
-  if(buf.impl!=VK_NULL_HANDLE)
-    vkDestroyBuffer (dev,buf.impl,nullptr);
+  auto& dx = *provider.device;
+  if(buf.slice.page!=nullptr) {
+    ArenaAllocation slice = buf.slice;
+    dx.retire(slice.size,[this,slice]() {
+      arena.free(slice);
+      });
+    return;
+    }
 
-  if(buf.page.page!=nullptr)
-    allocator.free(buf.page);
+  VkBuffer   impl = buf.impl;
+  Allocation page = buf.page;
+  if(page.page!=nullptr) {
+    std::lock_guard<std::mutex> guard(movableSync);
+    allocator.setOwner(page,nullptr);
+    }
+  dx.retire(page.size,[this,impl,page]() {
+    if(impl!=VK_NULL_HANDLE)
+      vkDestroyBuffer(dev,impl,nullptr);
+    if(page.page!=nullptr)
+      allocator.free(page);
+    });
   }
 
 void VAllocator::free(VTexture &buf) {
+  auto& dx = *provider.device;
+
+  std::vector<VkImageView> views;
   if(buf.view!=VK_NULL_HANDLE) {
-    buf.destroyViews(dev);
-    vkDestroyImage  (dev,buf.impl,nullptr);
+    auto* ext = buf.extViews.load();
+    views.reserve(ext==nullptr ? 1 : ext->size()+1);
+    views.push_back(buf.view);
+    if(ext!=nullptr)
+      ext->forEach([&views](const VTexture::View&, VkImageView v){ views.push_back(v); });
+    }
+
+  VkImage    impl = buf.impl;
+  Allocation page = buf.page;
+  dx.retire(page.size,[this,impl,page,views]() {
+    for(auto v:views)
+      vkDestroyImageView(dev,v,nullptr);
+    if(impl!=VK_NULL_HANDLE)
+      vkDestroyImage(dev,impl,nullptr);
+    if(page.page!=nullptr)
+      allocator.free(page);
+    });
+  }
+
+void VAllocator::setMovable(VBuffer& buf) {
+  std::lock_guard<std::mutex> guard(movableSync);
+  if(buf.page.page==nullptr)
+    return;
+  buf.movable = true;
+  allocator.setOwner(buf.page,&buf);
+  }
+
+size_t VAllocator::defragment(size_t byteBudget, size_t moveBudget) {
+  using BufPtr = Detail::DSharedPtr<AbstractGraphicsApi::Buffer*>;
+
+  // UploadEngine is not used under movableSync: buffers, released by its finished batches, take movableSync in free()
+  auto& dx = *provider.device;
+  // uploads into moved buffers, that are still recorded, are queued before the copies
+  dx.dataMgr().flush();
+  auto cmd = dx.dataMgr().get();
+  cmd->begin();
+
+  size_t              moved = 0;
+  std::vector<BufPtr> keep; // released after movableSync
+  {
+  std::lock_guard<std::mutex> guard(movableSync);
+  std::vector<DeviceAllocator<Provider>::Movable> mv;
+  allocator.defragment(byteBudget,moveBudget,mv);
+  keep.reserve(mv.size());
+
+  for(auto& i:mv) {
+    auto& buf = *reinterpret_cast<VBuffer*>(i.owner);
+    // buf may be already in destructor, waiting for movableSync: then it's memory goes into retire-queue as is
+    auto cnt = buf.counter.load();
+    while(cnt>0 && !buf.counter.compare_exchange_weak(cnt,cnt+1))
+      ;
+    if(cnt==0)
+      continue;
+    keep.emplace_back(&buf);
+    buf.counter.fetch_sub(1);
+
+    VkBuffer   impl = VK_NULL_HANDLE;
+    Allocation page;
+    if(!relocate(buf,impl,page)) {
+      allocator.setOwner(i.src,&buf);
+      continue;
+      }
+
+    BufPtr pOld(new VBuffer());
+    auto&  old = *static_cast<VBuffer*>(pOld.handler);
+    old.alloc = this;
+    old.size  = buf.size;
+    old.usage = buf.usage;
+    old.impl  = impl;
+    old.page  = page;
+
+    // buf is marked as written by this batch: later uploads into it wait for the copy
+    cmd->hold(keep.back());
+    cmd->hold(pOld);
+    cmd->graphics().copy(old,0,buf,0,size_t(buf.size));
+
+    // from now on buf lives in the new place; old memory is released, once copy is done
+    std::swap(buf.impl,old.impl);
+    std::swap(buf.page,old.page);
+    allocator.setOwner(buf.page,&buf);
+    moved += i.src.size;
+    }
+  if(moved>0)
+    relocGen.fetch_add(1);
+  }
+
+  cmd->end();
+  dx.dataMgr().submit(std::move(cmd));
+  return moved;
+  }
+
+bool VAllocator::relocate(const VBuffer& buf, VkBuffer& impl, Allocation& page) {
+  VkBufferCreateInfo createInfo={};
+  createInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  createInfo.size        = buf.size;
+  createInfo.usage       = buf.usage;
+  createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  if(vkCreateBuffer(dev,&createInfo,nullptr,&impl)!=VK_SUCCESS)
+    return false;
+
+  MemRequirements memRq={};
+  getMemoryRequirements(memRq,impl);
+  const size_t align = LCM(memRq.alignment,provider.device->props.nonCoherentAtomSize);
+
+  // no VBuffer on failure: it's destructor would take movableSync
+  page = allocator.relocate(buf.page,memRq.size,align);
+  if(page.page!=nullptr && commit(page,impl,nullptr,0,0,0))
+    return true;
+  if(page.page!=nullptr)
+    allocator.free(page);
+  vkDestroyBuffer(dev,impl,nullptr);
+  return false;
+  }
+
+void VAllocator::setPageCacheSize(size_t bytes) {
+  provider.setCacheSize(bytes);
+  }
+
+void VAllocator::trimPageCache(size_t keepBytes) {
+  provider.trim(keepBytes);
+  }
+
+void VAllocator::stats(AbstractGraphicsApi::MemoryStats& out) {
+  auto& dx  = *provider.device;
+  auto& mem = dx.memoryProps();
+
+  DeviceAllocator<Provider>::Stats st[VK_MAX_MEMORY_TYPES] = {};
+  allocator.stats(st,mem.memoryTypeCount);
+
+  out.heaps.resize(mem.memoryHeapCount);
+  for(uint32_t i=0; i<mem.memoryHeapCount; ++i) {
+    auto& h = out.heaps[i];
+    h             = AbstractGraphicsApi::MemoryStats::Heap();
+    h.budget      = mem.memoryHeaps[i].size;
+    h.deviceLocal = (mem.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)!=0;
     }
-  else if(buf.impl!=VK_NULL_HANDLE) {
-    vkDestroyImage  (dev,buf.impl,nullptr);
+  for(uint32_t i=0; i<mem.memoryTypeCount; ++i) {
+    auto& h = out.heaps[mem.memoryTypes[i].heapIndex];
+    h.reserved   += st[i].reserved;
+    h.used       += st[i].used;
+    h.pages      += st[i].pages;
+    h.largestFree = std::max(h.largestFree,st[i].largestFree);
+    }
+  {
+  std::lock_guard<std::mutex> guard(provider.cacheSync);
+  for(uint32_t i=0; i<mem.memoryTypeCount; ++i)
+    out.heaps[mem.memoryTypes[i].heapIndex].cached += provider.cache.cachedBytes(i);
+  }
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+  const bool hasBudget = dx.memoryBudget(budget);
+  for(uint32_t i=0; i<mem.memoryHeapCount; ++i) {
+    auto&          h    = out.heaps[i];
+    const uint64_t free = h.reserved-h.used;
+    h.fragmentation = free>0 ? 1.f - float(double(h.largestFree)/double(free)) : 0.f;
+    if(hasBudget) {
+      h.budget = budget.heapBudget[i];
+      h.usage  = budget.heapUsage[i];
+      } else {
+      h.usage  = h.reserved+h.cached;
+      }
     }
-  if(buf.page.page!=nullptr)
-    allocator.free(buf.page);
+  }
+
+void VAllocator::setBudgetCallback(float fraction, AbstractGraphicsApi::MemoryBudgetCallback fn) {
+  std::lock_guard<std::mutex> guard(budgetSync);
+  budgetFraction = fraction;
+  budgetFn       = std::move(fn);
+  overBudget     = 0;
+  }
+
+void VAllocator::checkBudget() {
+  std::unique_lock<std::mutex> guard(budgetSync);
+  if(!budgetFn)
+    return;
+  guard.unlock();
+
+  AbstractGraphicsApi::MemoryStats st;
+  stats(st);
+
+  guard.lock();
+  uint32_t over = 0;
+  for(size_t i=0; i<st.heaps.size(); ++i) {
+    auto& h = st.heaps[i];
+    if(h.budget>0 && double(h.usage)>=double(h.budget)*budgetFraction)
+      over |= (1u << i);
+    }
+  // fire only on crossing, not on every allocation above the limit
+  AbstractGraphicsApi::MemoryBudgetCallback fn;
+  if((over & ~overBudget)!=0)
+    fn = budgetFn;
+  overBudget = over;
+  guard.unlock();
+
+  if(fn)
+    fn(st);
   }
 
 void VAllocator::getMemoryRequirements(MemRequirements& out,VkBuffer buf) {
@@ -339,6 +677,9 @@ VAllocator::Allocation VAllocator::allocMemory(const VAllocator::MemRequirements
     } else {
     ret = allocator.alloc(memRq.size,align,heapId,typeId,hostVisible);
     }
+  // called outside of allocator lock, so callback is free to release resources
+  if(provider.grown.exchange(false))
+    checkBudget();
   return ret;
   }
 
@@ -354,103 +695,106 @@ void VAllocator::alignRange(VkMappedMemoryRange& rgn, size_t nonCoherentAtomSize
 bool VAllocator::update(VBuffer &dest, const void *mem,
                         size_t offset, size_t count, size_t size, size_t alignedSz) {
   auto& page = dest.page;
-  void* data = nullptr;
-
-  VkMappedMemoryRange rgn={};
-  rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  rgn.memory = page.page->memory;
-  rgn.offset = page.offset+offset*alignedSz;
-  rgn.size   = count*alignedSz;
-
-  size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
-
-  std::lock_guard<std::mutex> g(page.page->mmapSync);
-  if(vkMapMemory(dev,page.page->memory,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
-    return false;
-
-  data = reinterpret_cast<uint8_t*>(data) + shift + offset*alignedSz;
+  auto  data = reinterpret_cast<uint8_t*>(page.page->mapped) + page.offset + offset*alignedSz;
   copyUpsample(mem,data,count,size,alignedSz);
 
-  vkFlushMappedMemoryRanges(dev,1,&rgn);
-
-  vkUnmapMemory(dev,page.page->memory);
+  if(!isCoherent(page)) {
+    VkMappedMemoryRange rgn={};
+    rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    rgn.memory = page.page->memory;
+    rgn.offset = page.offset+offset*alignedSz;
+    rgn.size   = count*alignedSz;
+    alignRange(rgn,provider.device->props.nonCoherentAtomSize);
+    vkFlushMappedMemoryRanges(dev,1,&rgn);
+    }
   return true;
   }
 
 bool VAllocator::read(VBuffer& src, void* mem, size_t offset, size_t count, size_t size, size_t alignedSz) {
   auto& page = src.page;
-  void* data = nullptr;
-
-  VkMappedMemoryRange rgn={};
-  rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  rgn.memory = page.page->memory;
-  rgn.offset = page.offset+offset;
-  rgn.size   = count*alignedSz;
-  size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
-
-  std::lock_guard<std::mutex> g(page.page->mmapSync);
-  if(vkMapMemory(dev,page.page->memory,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
-    return false;
-  vkInvalidateMappedMemoryRanges(dev,1,&rgn);
+  if(!isCoherent(page)) {
+    VkMappedMemoryRange rgn={};
+    rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    rgn.memory = page.page->memory;
+    rgn.offset = page.offset+offset;
+    rgn.size   = count*alignedSz;
+    alignRange(rgn,provider.device->props.nonCoherentAtomSize);
+    vkInvalidateMappedMemoryRanges(dev,1,&rgn);
+    }
 
-  data = reinterpret_cast<uint8_t*>(data)+shift;
+  auto data = reinterpret_cast<const uint8_t*>(page.page->mapped) + page.offset + offset;
   copyUpsample(data,mem,count,size,alignedSz);
-
-  vkUnmapMemory(dev,page.page->memory);
   return true;
   }
 
 bool VAllocator::read(VBuffer &src, void *mem, size_t offset, size_t size) {
   auto& page = src.page;
-  void* data = nullptr;
+  if(!isCoherent(page)) {
+    VkMappedMemoryRange rgn={};
+    rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    rgn.memory = page.page->memory;
+    rgn.offset = page.offset+offset;
+    rgn.size   = size;
+    alignRange(rgn,provider.device->props.nonCoherentAtomSize);
+    vkInvalidateMappedMemoryRanges(dev,1,&rgn);
+    }
 
+  auto data = reinterpret_cast<const uint8_t*>(page.page->mapped) + page.offset + offset;
+  std::memcpy(mem,data,size);
+  return true;
+  }
+
+void* VAllocator::map(VBuffer& buf) {
+  auto& page = buf.page;
+  if(page.page==nullptr || page.page->mapped==nullptr)
+    return nullptr;
+  return reinterpret_cast<uint8_t*>(page.page->mapped) + page.offset;
+  }
+
+void VAllocator::flush(VBuffer& buf, size_t offset, size_t size) {
+  auto& page = buf.page;
+  if(page.page==nullptr || page.page->mapped==nullptr || isCoherent(page))
+    return;
   VkMappedMemoryRange rgn={};
   rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
   rgn.memory = page.page->memory;
   rgn.offset = page.offset+offset;
   rgn.size   = size;
-  size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
-
-  std::lock_guard<std::mutex> g(page.page->mmapSync);
-  if(vkMapMemory(dev,page.page->memory,rgn.offset,rgn.size,0,&data)!=VK_SUCCESS)
-    return false;
-  vkInvalidateMappedMemoryRanges(dev,1,&rgn);
-
-  data = reinterpret_cast<uint8_t*>(data)+shift;
-  std::memcpy(mem,data,size);
+  alignRange(rgn,provider.device->props.nonCoherentAtomSize);
+  vkFlushMappedMemoryRanges(dev,1,&rgn);
+  }
 
-  vkUnmapMemory(dev,page.page->memory);
-  return true;
+bool VAllocator::isCoherent(const Allocation& a) const {
+  auto& mem = provider.device->memoryProps();
+  return (mem.memoryTypes[a.page->typeId].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)!=0;
   }
 
 VkSampler VAllocator::updateSampler(const Tempest::Sampler2d &s) {
   return samplers.get(s);
   }
 
-bool VAllocator::commit(VkDeviceMemory dmem, std::mutex &mmapSync, VkBuffer dest,
-                        size_t pageOffset, const void* mem,  size_t count, size_t size, size_t alignedSz) {
-  VkMappedMemoryRange rgn={};
-  rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-  rgn.memory = dmem;
-  rgn.offset = pageOffset;
-  rgn.size   = count*alignedSz;
-  size_t shift = 0;
-  alignRange(rgn,provider.device->props.nonCoherentAtomSize,shift);
-
-  std::lock_guard<std::mutex> g(mmapSync); // on practice bind requires external sync
-  if(vkBindBufferMemory(dev,dest,dmem,pageOffset)!=VK_SUCCESS)
+bool VAllocator::commit(const Allocation& page, VkBuffer dest,
+                        const void* mem,  size_t count, size_t size, size_t alignedSz) {
+  {
+  std::lock_guard<std::mutex> g(page.page->mmapSync); // on practice bind requires external sync
+  if(vkBindBufferMemory(dev,dest,page.page->memory,page.offset)!=VK_SUCCESS)
     return false;
+  }
+
   if(mem!=nullptr) {
-    void* data=nullptr;
-    if(vkMapMemory(dev,dmem,pageOffset,rgn.size,0,&data)!=VK_SUCCESS)
+    if(page.page->mapped==nullptr)
       return false;
-    data = reinterpret_cast<uint8_t*>(data)+shift;
+    auto data = reinterpret_cast<uint8_t*>(page.page->mapped) + page.offset;
     copyUpsample(mem,data,count,size,alignedSz);
-    vkFlushMappedMemoryRanges(dev,1,&rgn);
-    vkUnmapMemory(dev,dmem);
+    if(!isCoherent(page)) {
+      VkMappedMemoryRange rgn={};
+      rgn.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+      rgn.memory = page.page->memory;
+      rgn.offset = page.offset;
+      rgn.size   = count*alignedSz;
+      alignRange(rgn,provider.device->props.nonCoherentAtomSize);
+      vkFlushMappedMemoryRanges(dev,1,&rgn);
+      }
     }
 
   return true;
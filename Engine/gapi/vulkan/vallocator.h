@@ -3,6 +3,7 @@
 #include <Tempest/AbstractGraphicsApi>
 #include "vulkan_sdk.h"
 #include "gapi/deviceallocator.h"
+#include "gapi/pagecache.h"
 #include "vsamplercache.h"
 
 namespace Tempest {
@@ -18,14 +19,38 @@ class VAllocator {
       using DeviceMemory=VkDeviceMemory;
       ~Provider();
 
+      enum {
+        DEFAULT_CACHE_SIZE=256*1024*1024
+        };
+
       VDevice*     device=nullptr;
 
-      DeviceMemory lastFree=VK_NULL_HANDLE;
-      uint32_t     lastType=0;
-      size_t       lastSize=0;
+      std::mutex              cacheSync;
+      PageCache<DeviceMemory> cache{DEFAULT_CACHE_SIZE};
+
+      std::atomic_bool grown{false};
+
+      // dedicated memory is allocated at exact size and never goes to page cache
+      DeviceMemory alloc(size_t size, uint32_t typeId, bool dedicated);
+      void         free(DeviceMemory m, size_t size, uint32_t typeId, bool dedicated);
+      void*        map (DeviceMemory m, size_t size);
+      void         unmap(DeviceMemory m);
 
-      DeviceMemory alloc(size_t size, uint32_t typeId);
-      void         free(DeviceMemory m, size_t size, uint32_t typeId);
+      void         setCacheSize(size_t bytes);
+      void         trim(size_t keepBytes);
+      void         release(DeviceMemory m, size_t size, uint32_t typeId);
+      };
+
+    // pages of arena are large shared vertex/index buffers; small buffers are sub-ranges of them
+    struct ArenaProvider {
+      using DeviceMemory=VBuffer*;
+
+      VAllocator*  owner=nullptr;
+
+      DeviceMemory alloc(size_t size, uint32_t typeId, bool dedicated);
+      void         free(DeviceMemory m, size_t size, uint32_t typeId, bool dedicated);
+      void*        map (DeviceMemory m, size_t size);
+      void         unmap(DeviceMemory m);
       };
 
     struct MemRequirements {
@@ -43,18 +68,42 @@ class VAllocator {
     void setDevice(VDevice& device);
     VDevice* device();
 
-    using Allocation=typename Tempest::Detail::DeviceAllocator<Provider>::Allocation;
+    using Allocation     =typename Tempest::Detail::DeviceAllocator<Provider>::Allocation;
+    using ArenaAllocation=typename Tempest::Detail::DeviceAllocator<ArenaProvider>::Allocation;
+
+    enum {
+      ARENA_PAGE_SIZE=4*1024*1024,
+      ARENA_MAX_SIZE =64*1024,
+      };
 
     VBuffer  alloc(const void *mem, size_t count, size_t size, size_t alignedSz, MemUsage usage, BufferHeap bufHeap);
-    VTexture alloc(const Pixmap &pm, uint32_t mip, VkFormat format);
+    VTexture alloc(const uint32_t w, const uint32_t h, uint32_t mip, VkFormat format);
     VTexture alloc(const uint32_t w, const uint32_t h, const uint32_t mip, TextureFormat frm, bool imgStorage);
     void     free(VBuffer&  buf);
     void     free(VTexture& buf);
 
+    VBuffer  allocTransient(size_t size);
+    // sub-range of shared vertex/index buffer; offset is multiple of alignedSz
+    VBuffer  allocSlice(size_t count, size_t alignedSz, BufferHeap bufHeap);
+
+    void     setMovable(VBuffer& buf);
+    size_t   defragment(size_t byteBudget, size_t moveBudget);
+    // incremented by each defragment, that moved something
+    uint64_t relocations() const { return relocGen.load(); }
+
+    void     setPageCacheSize(size_t bytes);
+    void     trimPageCache(size_t keepBytes);
+
+    void     stats(AbstractGraphicsApi::MemoryStats& out);
+    void     setBudgetCallback(float fraction, AbstractGraphicsApi::MemoryBudgetCallback fn);
+
     bool     update(VBuffer& dest, const void *mem, size_t offset, size_t count, size_t size, size_t alignedSz);
     bool     read  (VBuffer& src,        void *mem, size_t offset, size_t count, size_t size, size_t alignedSz);
     bool     read  (VBuffer& src,        void *mem, size_t offset, size_t size);
 
+    void*    map  (VBuffer& buf);
+    void     flush(VBuffer& buf, size_t offset, size_t size);
+
     VkSampler updateSampler(const Sampler2d& s);
 
   private:
@@ -62,14 +111,29 @@ class VAllocator {
     Provider                          provider;
     VSamplerCache                     samplers;
     Detail::DeviceAllocator<Provider> allocator{provider};
+    // free vs defragment: owner of movable buffer is cleared, before VBuffer is gone
+    std::mutex                        movableSync;
+    std::atomic<uint64_t>             relocGen{0};
+
+    ArenaProvider                          arenaProvider;
+    Detail::DeviceAllocator<ArenaProvider> arena{arenaProvider,ARENA_PAGE_SIZE};
+
+    std::mutex                                budgetSync;
+    float                                     budgetFraction=1.f;
+    uint32_t                                  overBudget=0;
+    AbstractGraphicsApi::MemoryBudgetCallback budgetFn;
 
     void getMemoryRequirements   (MemRequirements& out, VkBuffer buf);
     void getImgMemoryRequirements(MemRequirements& out, VkImage  img);
-    void alignRange(VkMappedMemoryRange& rgn, size_t nonCoherentAtomSize, size_t shift);
+    void alignRange(VkMappedMemoryRange& rgn, size_t nonCoherentAtomSize, size_t shift=0);
+    bool isCoherent(const Allocation& a) const;
 
     Allocation allocMemory(const MemRequirements& rq, const uint32_t heapId, const uint32_t typeId, bool hostVisible);
 
-    bool commit(VkDeviceMemory dev, std::mutex& mmapSync, VkBuffer dest, size_t offset,
+    bool relocate(const VBuffer& buf, VkBuffer& impl, Allocation& page);
+    void checkBudget();
+
+    bool commit(const Allocation& page, VkBuffer dest,
                 const void *mem, size_t count, size_t size, size_t alignedSz);
     bool commit(VkDeviceMemory dev, std::mutex& mmapSync, VkImage  dest, size_t offset);
   };
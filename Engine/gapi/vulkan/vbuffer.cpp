@@ -5,6 +5,8 @@
 #include "vdevice.h"
 #include "vallocator.h"
 
+#include "gapi/graphicsmemutils.h"
+
 #include <utility>
 
 using namespace Tempest::Detail;
@@ -13,6 +15,12 @@ VBuffer::VBuffer(VBuffer &&other) {
   std::swap(impl, other.impl);
   std::swap(alloc,other.alloc);
   std::swap(page, other.page);
+  std::swap(size, other.size);
+  std::swap(usage,other.usage);
+  std::swap(base, other.base);
+  std::swap(stride,other.stride);
+  std::swap(slice,other.slice);
+  std::swap(movable,other.movable);
   }
 
 VBuffer::~VBuffer() {
@@ -24,10 +32,24 @@ VBuffer& VBuffer::operator=(VBuffer&& other) {
   std::swap(impl, other.impl);
   std::swap(alloc,other.alloc);
   std::swap(page, other.page);
+  std::swap(size, other.size);
+  std::swap(usage,other.usage);
+  std::swap(base, other.base);
+  std::swap(stride,other.stride);
+  std::swap(slice,other.slice);
+  std::swap(movable,other.movable);
   return *this;
   }
 
 void VBuffer::update(const void *data, size_t off, size_t count, size_t size, size_t alignedSz) {
+  implUpdate(data,off,count,size,alignedSz,false);
+  }
+
+void VBuffer::upload(const void* data, size_t count, size_t size, size_t alignedSz) {
+  implUpdate(data,0,count,size,alignedSz,true);
+  }
+
+void VBuffer::implUpdate(const void* data, size_t off, size_t count, size_t size, size_t alignedSz, bool fresh) {
   auto& dx = *alloc->device();
 
   if(T_LIKELY(page.page->hostVisible)) {
@@ -36,20 +58,40 @@ void VBuffer::update(const void *data, size_t off, size_t count, size_t size, si
     return;
     }
 
-  auto  stage = dx.dataMgr().allocStagingMemory(data,count,size,alignedSz,MemUsage::TransferSrc,BufferHeap::Upload);
+  Detail::DSharedPtr<Buffer*> pBuf(this);
+  Detail::DSharedPtr<Buffer*> pStage;
+  const size_t                bytes = count*alignedSz;
+  // nobody reads fresh buffer yet: copy can go to transfer queue; arena slice shares VkBuffer with live ones
+  const bool                  async = fresh && slice.page==nullptr;
 
-  Detail::DSharedPtr<Buffer*> pStage(new Detail::VBuffer(std::move(stage)));
-  Detail::DSharedPtr<Buffer*> pBuf  (this);
-
-  auto cmd = dx.dataMgr().get();
-  cmd->begin();
-  cmd->hold(pBuf); // NOTE: VBuffer may be deleted, before copy is finished
-  cmd->hold(pStage);
-  cmd->copy(*this, off*alignedSz, *pStage.handler,0, count*alignedSz);
-  cmd->end();
+  if(bytes>TransientHeap<VBuffer>::CHUNK_SIZE) {
+    auto stage = dx.dataMgr().allocStagingMemory(data,count,size,alignedSz,MemUsage::TransferSrc,BufferHeap::Upload);
+    pStage = Detail::DSharedPtr<Buffer*>(new Detail::VBuffer(std::move(stage)));
+    }
 
-  dx.dataMgr().waitFor(this); // write-after-write case
-  dx.dataMgr().submit(std::move(cmd));
+  dx.dataMgr().record(this,bytes,[&](VDevice::DataMgr::Commands& cmd) {
+    AbstractGraphicsApi::Buffer* src    = pStage.handler;
+    size_t                       offset = 0;
+    if(src==nullptr) {
+      // small update: staged in command buffer's ring
+      AbstractGraphicsApi::Transient stage;
+      if(!cmd.allocTransient(bytes,16,stage))
+        throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
+      copyUpsample(data,stage.data,count,size,alignedSz);
+      src    = stage.buf;
+      offset = stage.offset;
+      } else {
+      cmd.hold(pStage);
+      }
+
+    VCommandBuffer& rec = async ? static_cast<VCommandBuffer&>(cmd) : cmd.graphics();
+    if(cmd.holds(this))
+      rec.transferBarrier(); // write-after-write case
+    cmd.hold(pBuf); // NOTE: VBuffer may be deleted, before copy is finished
+    rec.copy(*this, off*alignedSz, *src,offset, bytes);
+    if(async)
+      cmd.release(*this);
+    });
   }
 
 void VBuffer::read(void* out, size_t off, size_t size) {
@@ -65,7 +107,7 @@ void VBuffer::read(void* out, size_t off, size_t size) {
 
   auto cmd = dx.dataMgr().get();
   cmd->begin();
-  cmd->copy(stage,0, *this,off,size);
+  cmd->graphics().copy(stage,0, *this,off,size);
   cmd->end();
 
   dx.dataMgr().waitFor(this); // Buffer::update can be in flight
@@ -74,4 +116,27 @@ void VBuffer::read(void* out, size_t off, size_t size) {
   stage.read(out,0,size);
   }
 
+Tempest::AbstractGraphicsApi::Readback* VBuffer::readAsync(size_t off, size_t size) {
+  auto& dx = *alloc->device();
+
+  std::unique_ptr<VDevice::Readback> ret(new VDevice::Readback(dx,size,size,1,16));
+  Detail::DSharedPtr<Buffer*> pBuf(this);
+  auto& cmd = ret->commands();
+  cmd.hold(pBuf);
+  cmd.graphics().copy(ret->staging(),ret->offset(), *this,off,size);
+  ret->submit();
+  return ret.release();
+  }
+
+void* VBuffer::map() {
+  if(page.page==nullptr || !page.page->hostVisible)
+    return nullptr;
+  alloc->device()->dataMgr().waitFor(this); // Buffer::update can be in flight
+  return alloc->map(*this);
+  }
+
+void VBuffer::unmap() {
+  alloc->flush(*this,0,size);
+  }
+
 #endif
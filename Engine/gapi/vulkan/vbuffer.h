@@ -16,14 +16,32 @@ class VBuffer : public AbstractGraphicsApi::Buffer {
 
     VBuffer& operator=(VBuffer&& other);
 
-    void update  (const void* data, size_t off, size_t count, size_t sz, size_t alignedSz) override;
-    void read    (void* data, size_t off, size_t sz) override;
+    void  update  (const void* data, size_t off, size_t count, size_t sz, size_t alignedSz) override;
+    void  read    (void* data, size_t off, size_t sz) override;
+    auto  readAsync(size_t off, size_t sz) -> AbstractGraphicsApi::Readback* override;
+    // initial content of just created buffer
+    void  upload  (const void* data, size_t count, size_t sz, size_t alignedSz);
+
+    void* map     () override;
+    void  unmap   () override;
+
+    // may be relocated by VAllocator::defragment
+    bool  isMovable() const { return movable; }
 
     VkBuffer               impl=VK_NULL_HANDLE;
+    // sub-range of shared arena buffer: byte offset in impl, and it's element size
+    VkDeviceSize           base  =0;
+    uint32_t               stride=1;
 
   private:
-    VAllocator*            alloc=nullptr;
-    VAllocator::Allocation page={};
+    void  implUpdate(const void* data, size_t off, size_t count, size_t sz, size_t alignedSz, bool fresh);
+
+    VAllocator*                 alloc=nullptr;
+    VAllocator::Allocation      page={};
+    VAllocator::ArenaAllocation slice={};
+    VkDeviceSize                size =0;
+    VkBufferUsageFlags          usage=0;
+    bool                        movable=false;
 
   friend class VAllocator;
   };
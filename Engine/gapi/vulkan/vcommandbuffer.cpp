@@ -13,11 +13,13 @@
 #include "vswapchain.h"
 #include "vtexture.h"
 
+#include <algorithm>
+
 using namespace Tempest;
 using namespace Tempest::Detail;
 
-VCommandBuffer::VCommandBuffer(VDevice& device, VkCommandPoolCreateFlags flags)
-  :device(device), pool(device,flags) {
+VCommandBuffer::VCommandBuffer(VDevice& device, VkCommandPoolCreateFlags flags, uint32_t family)
+  :device(device), pool(device,flags,family) {
   VkCommandBufferAllocateInfo allocInfo = {};
   allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   allocInfo.commandPool        = pool.impl;
@@ -33,6 +35,7 @@ VCommandBuffer::~VCommandBuffer() {
 
 void VCommandBuffer::reset() {
   vkResetCommandBuffer(impl,VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+  transient.reset();
   swapchainSync.reserve(swapchainSync.size());
   swapchainSync.clear();
   }
@@ -46,6 +49,11 @@ void VCommandBuffer::begin(VkCommandBufferUsageFlags flg) {
   swapchainSync.reserve(swapchainSync.size());
   swapchainSync.clear();
   curVbo = VK_NULL_HANDLE;
+  curIbo = VK_NULL_HANDLE;
+  curPipeline.reset();
+  uploadDep = 0;
+  movableBufs = false;
+  transient.reset();
 
   VkCommandBufferBeginInfo beginInfo = {};
   beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -132,8 +140,19 @@ void VCommandBuffer::setPipeline(AbstractGraphicsApi::Pipeline& p) {
     throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
   VPipeline&           px = reinterpret_cast<VPipeline&>(p);
   VFramebufferLayout*  l  = reinterpret_cast<VFramebufferLayout*>(curFbo->rp.handler);
-  auto& v = px.instance(*l);
-  vkCmdBindPipeline(impl,VK_PIPELINE_BIND_POINT_GRAPHICS,v.val);
+  VPipeline::Inst*     v  = nullptr;
+  if(device.asyncPipelines)
+    v = px.tryInstance(*l,device.compiler()); else
+    v = &px.instance(*l);
+  skipDraws = (v==nullptr);
+  if(skipDraws)
+    return;
+  // pipelines, that differ only in dynamic state, share native pipeline: no rebind
+  auto cmd = curPipeline.bind(uint64_t(v->val),px.dynamicFlags,px.dynamic);
+  if(cmd.bindPipeline)
+    vkCmdBindPipeline(impl,VK_PIPELINE_BIND_POINT_GRAPHICS,v->val);
+  if(cmd.setState!=DynamicState::None)
+    device.setDynamicState(impl,px.dynamic,cmd.setState,l->colorCount);
   ssboBarriers = px.ssboBarriers;
   }
 
@@ -146,6 +165,7 @@ void VCommandBuffer::setUniforms(AbstractGraphicsApi::Pipeline &p, AbstractGraph
   VPipeline&        px=reinterpret_cast<VPipeline&>(p);
   VDescriptorArray& ux=reinterpret_cast<VDescriptorArray&>(u);
   curUniforms = &ux;
+  uploadDep   = std::max(uploadDep,ux.uploadDep);
   vkCmdBindDescriptorSets(impl,VK_PIPELINE_BIND_POINT_GRAPHICS,
                           px.pipelineLayout,0,
                           1,&ux.desc,
@@ -173,6 +193,7 @@ void VCommandBuffer::setUniforms(AbstractGraphicsApi::CompPipeline& p, AbstractG
   VCompPipeline&    px=reinterpret_cast<VCompPipeline&>(p);
   VDescriptorArray& ux=reinterpret_cast<VDescriptorArray&>(u);
   curUniforms = &ux;
+  uploadDep   = std::max(uploadDep,ux.uploadDep);
   vkCmdBindDescriptorSets(impl,VK_PIPELINE_BIND_POINT_COMPUTE,
                           px.pipelineLayout,0,
                           1,&ux.desc,
@@ -180,22 +201,30 @@ void VCommandBuffer::setUniforms(AbstractGraphicsApi::CompPipeline& p, AbstractG
   }
 
 void VCommandBuffer::draw(const AbstractGraphicsApi::Buffer& ivbo, size_t offset, size_t size, size_t firstInstance, size_t instanceCount) {
+  if(T_UNLIKELY(skipDraws))
+    return;
   if(T_UNLIKELY(ssboBarriers)) {
     curUniforms->ssboBarriers(resState);
     resState.flushSSBO(*this);
     }
   const VBuffer& vbo=reinterpret_cast<const VBuffer&>(ivbo);
+  uses(vbo);
+  usesMovable(vbo);
   if(curVbo!=vbo.impl) {
     VkBuffer     buffers[1] = {vbo.impl};
     VkDeviceSize offsets[1] = {0};
     vkCmdBindVertexBuffers(impl, 0, 1, buffers, offsets );
     curVbo = vbo.impl;
     }
-  vkCmdDraw(impl, uint32_t(size), uint32_t(instanceCount), uint32_t(offset), uint32_t(firstInstance));
+  // buffers from the same arena share handle: binding stays, only first vertex differs
+  const size_t first = offset + size_t(vbo.base/vbo.stride);
+  vkCmdDraw(impl, uint32_t(size), uint32_t(instanceCount), uint32_t(first), uint32_t(firstInstance));
   }
 
 void VCommandBuffer::drawIndexed(const AbstractGraphicsApi::Buffer& ivbo, const AbstractGraphicsApi::Buffer& iibo, Detail::IndexClass cls,
                                  size_t ioffset, size_t isize, size_t voffset, size_t firstInstance, size_t instanceCount) {
+  if(T_UNLIKELY(skipDraws))
+    return;
   if(T_UNLIKELY(ssboBarriers)) {
     curUniforms->ssboBarriers(resState);
     resState.flushSSBO(*this);
@@ -207,14 +236,32 @@ void VCommandBuffer::drawIndexed(const AbstractGraphicsApi::Buffer& ivbo, const
 
   const VBuffer& vbo = reinterpret_cast<const VBuffer&>(ivbo);
   const VBuffer& ibo = reinterpret_cast<const VBuffer&>(iibo);
+  uses(vbo);
+  uses(ibo);
+  usesMovable(vbo);
+  usesMovable(ibo);
   if(curVbo!=vbo.impl) {
     VkBuffer     buffers[1] = {vbo.impl};
     VkDeviceSize offsets[1] = {0};
     vkCmdBindVertexBuffers(impl, 0, 1, buffers, offsets );
     curVbo = vbo.impl;
     }
-  vkCmdBindIndexBuffer(impl, ibo.impl, 0, type[uint32_t(cls)]);
-  vkCmdDrawIndexed    (impl, uint32_t(isize), uint32_t(instanceCount), uint32_t(ioffset), int32_t(voffset), uint32_t(firstInstance));
+  if(curIbo!=ibo.impl || curIboCls!=cls) {
+    vkCmdBindIndexBuffer(impl, ibo.impl, 0, type[uint32_t(cls)]);
+    curIbo    = ibo.impl;
+    curIboCls = cls;
+    }
+  const size_t first = ioffset + size_t(ibo.base/ibo.stride);
+  const size_t vbase = voffset + size_t(vbo.base/vbo.stride);
+  vkCmdDrawIndexed(impl, uint32_t(isize), uint32_t(instanceCount), uint32_t(first), int32_t(vbase), uint32_t(firstInstance));
+  }
+
+bool VCommandBuffer::allocTransient(size_t size, size_t align, AbstractGraphicsApi::Transient& out) {
+  return transient.alloc(size,align,out,[this](TransientHeap<VBuffer>::Chunk& c){
+    c.buf.reset(new VBuffer(device.allocator.allocTransient(c.size)));
+    c.mapped = reinterpret_cast<uint8_t*>(device.allocator.map(*c.buf));
+    return true;
+    });
   }
 
 void VCommandBuffer::dispatch(size_t x, size_t y, size_t z) {
@@ -240,27 +287,54 @@ void VCommandBuffer::setViewport(const Tempest::Rect &r) {
 void VCommandBuffer::copy(AbstractGraphicsApi::Buffer& dstBuf, size_t offsetDest, const AbstractGraphicsApi::Buffer &srcBuf, size_t offsetSrc, size_t size) {
   auto& src = reinterpret_cast<const VBuffer&>(srcBuf);
   auto& dst = reinterpret_cast<VBuffer&>(dstBuf);
+  uses(src);
+  uses(dst);
+  usesMovable(src);
+  usesMovable(dst);
 
   VkBufferCopy copyRegion = {};
-  copyRegion.dstOffset = offsetDest;
-  copyRegion.srcOffset = offsetSrc;
+  copyRegion.dstOffset = dst.base + offsetDest;
+  copyRegion.srcOffset = src.base + offsetSrc;
   copyRegion.size      = size;
   vkCmdCopyBuffer(impl, src.impl, dst.impl, 1, &copyRegion);
   }
 
+void VCommandBuffer::transferBarrier() {
+  // Write-after-Write between copies in same command buffer
+  VkMemoryBarrier barrier = {};
+  barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+  vkCmdPipelineBarrier(
+        impl,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+  }
+
 void VCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t width, size_t height, size_t mip, const AbstractGraphicsApi::Buffer& srcBuf, size_t offset) {
+  copy(dstTex,0,0,width,height,mip,srcBuf,offset,0);
+  }
+
+void VCommandBuffer::copy(AbstractGraphicsApi::Texture& dstTex, size_t x, size_t y, size_t width, size_t height, size_t mip,
+                          const AbstractGraphicsApi::Buffer& srcBuf, size_t offset, uint32_t rowLength) {
   auto& src = reinterpret_cast<const VBuffer&>(srcBuf);
   auto& dst = reinterpret_cast<VTexture&>(dstTex);
+  uses(src);
+  uses(dst);
 
   VkBufferImageCopy region = {};
   region.bufferOffset      = offset;
-  region.bufferRowLength   = 0;
+  region.bufferRowLength   = rowLength;
   region.bufferImageHeight = 0;
   region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
   region.imageSubresource.mipLevel = uint32_t(mip);
   region.imageSubresource.baseArrayLayer = 0;
   region.imageSubresource.layerCount = 1;
-  region.imageOffset = {0, 0, 0};
+  region.imageOffset = {int32_t(x), int32_t(y), 0};
   region.imageExtent = {
       uint32_t(width),
       uint32_t(height),
@@ -274,6 +348,8 @@ void VCommandBuffer::implCopy(AbstractGraphicsApi::Buffer& dstBuf, size_t width,
                               const AbstractGraphicsApi::Texture& srcTex, size_t offset) {
   auto& src = reinterpret_cast<const VTexture&>(srcTex);
   auto& dst = reinterpret_cast<VBuffer&>(dstBuf);
+  uses(src);
+  uses(dst);
 
   VkBufferImageCopy region={};
   region.bufferOffset      = offset;
@@ -297,6 +373,8 @@ void VCommandBuffer::blit(AbstractGraphicsApi::Texture& srcTex, uint32_t srcW, u
                           AbstractGraphicsApi::Texture& dstTex, uint32_t dstW, uint32_t dstH, uint32_t dstMip) {
   auto& src = reinterpret_cast<VTexture&>(srcTex);
   auto& dst = reinterpret_cast<VTexture&>(dstTex);
+  uses(src);
+  uses(dst);
 
   // Check if image format supports linear blitting
   VkFormatProperties formatProperties;
@@ -342,6 +420,7 @@ void Tempest::Detail::VCommandBuffer::copy(AbstractGraphicsApi::Buffer& dest, Te
   }
 
 void VCommandBuffer::changeLayout(AbstractGraphicsApi::Buffer& buf, BufferLayout prev, BufferLayout next) {
+  uses(buf);
   VkBufferMemoryBarrier barrier = {};
   barrier.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
 
@@ -428,6 +507,7 @@ void VCommandBuffer::changeLayout(AbstractGraphicsApi::Texture& t,
                                   TextureLayout prev, TextureLayout next, uint32_t mipId) {
   auto&    vt       = reinterpret_cast<VTexture&>(t);
   auto     p        = (prev==TextureLayout::Undefined ? TextureLayout::Sampler : prev);
+  uses(vt);
   uint32_t mipBase  = (mipId==uint32_t(-1) ? 0         : mipId);
   uint32_t mipCount = (mipId==uint32_t(-1) ? vt.mipCnt : 1);
 
@@ -442,6 +522,7 @@ void VCommandBuffer::generateMipmap(AbstractGraphicsApi::Texture& img,
   if(curFbo!=nullptr)
     throw std::system_error(Tempest::GraphicsErrc::ComputeCallInRenderPass);
   resState.flushLayout(*this);
+  uses(img);
 
   if(mipLevels==1)
     return;
@@ -618,6 +699,22 @@ void VCommandBuffer::implChangeLayout(VkImage dest, VkFormat imageFormat,
         );
   }
 
+void VCommandBuffer::uses(const AbstractGraphicsApi::Shared& s) {
+  uploadDep = std::max(uploadDep,VDevice::uploadOf(s));
+  }
+
+void VCommandBuffer::usesMovable(const VBuffer& buf) {
+  if(!buf.isMovable() || movableBufs)
+    return;
+  // relocation after any of recorded commands invalidates whole recording
+  relocGen    = device.allocator.relocations();
+  movableBufs = true;
+  }
+
+bool VCommandBuffer::isStale() const {
+  return movableBufs && relocGen!=device.allocator.relocations();
+  }
+
 void VCommandBuffer::addDependency(VSwapchain& s, size_t imgId) {
   VSwapchain::Sync* sc = nullptr;
   for(auto& i:s.sync)
@@ -3,7 +3,9 @@
 #include <Tempest/AbstractGraphicsApi>
 #include "vulkan_sdk.h"
 
+#include "gapi/dynamicstate.h"
 #include "gapi/resourcestate.h"
+#include "gapi/transientheap.h"
 #include "vcommandpool.h"
 #include "vframebuffer.h"
 #include "vswapchain.h"
@@ -33,7 +35,7 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
       };
 
     VCommandBuffer()=delete;
-    VCommandBuffer(VDevice &device, VkCommandPoolCreateFlags flags=VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    VCommandBuffer(VDevice &device, VkCommandPoolCreateFlags flags=VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, uint32_t family=uint32_t(-1));
     ~VCommandBuffer();
 
     VkCommandBuffer                impl=nullptr;
@@ -66,6 +68,8 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
                      size_t ioffset, size_t isize, size_t voffset, size_t firstInstance, size_t instanceCount) override;
     void dispatch   (size_t x, size_t y, size_t z) override;
 
+    bool allocTransient(size_t size, size_t align, AbstractGraphicsApi::Transient& out) override;
+
     void changeLayout(AbstractGraphicsApi::Buffer&  buf, BufferLayout  prev, BufferLayout  next) override;
     void changeLayout(AbstractGraphicsApi::Attach&  img, TextureLayout prev, TextureLayout next, bool byRegion) override;
     void changeLayout(AbstractGraphicsApi::Texture& tex, TextureLayout prev, TextureLayout next, uint32_t mipId);
@@ -74,12 +78,22 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     void generateMipmap(AbstractGraphicsApi::Texture& image, TextureLayout defLayout, uint32_t texWidth, uint32_t texHeight, uint32_t mipLevels) override;
 
     void copy(AbstractGraphicsApi::Texture& dest, size_t width, size_t height, size_t mip, const AbstractGraphicsApi::Buffer&  src, size_t offset);
+    // rowLength: in texels, 0 - rows are tightly packed
+    void copy(AbstractGraphicsApi::Texture& dest, size_t x, size_t y, size_t width, size_t height, size_t mip, const AbstractGraphicsApi::Buffer&  src, size_t offset, uint32_t rowLength);
     void copy(AbstractGraphicsApi::Buffer&  dest, size_t offsetDest, const AbstractGraphicsApi::Buffer& src, size_t offsetSrc, size_t size);
+    void transferBarrier();
 
     void blit(AbstractGraphicsApi::Texture& src, uint32_t srcW, uint32_t srcH, uint32_t srcMip,
               AbstractGraphicsApi::Texture& dst, uint32_t dstW, uint32_t dstH, uint32_t dstMip);
 
+    // newest upload, that recorded commands use: it's postponed acquire is submitted before this command buffer
+    uint64_t uploadDependency() const { return uploadDep; }
+    // draws vertex/index buffer, that Device::defragment relocated after it was recorded
+    bool     isStale() const;
+
   private:
+    void uses(const AbstractGraphicsApi::Shared& s);
+    void usesMovable(const VBuffer& buf);
     void implCopy(AbstractGraphicsApi::Buffer&  dest, size_t width, size_t height, size_t mip,
                   const AbstractGraphicsApi::Texture& src, size_t offset);
     void implChangeLayout(VkImage dest, VkFormat imageFormat,
@@ -92,14 +106,22 @@ class VCommandBuffer:public AbstractGraphicsApi::CommandBuffer {
     VCommandPool                            pool;
 
     ResourceState                           resState;
+    TransientHeap<VBuffer>                  transient;
 
     RpState                                 state        = NoRecording;
     VFramebuffer*                           curFbo       = nullptr;
     VRenderPass*                            curRp        = nullptr;
     VDescriptorArray*                       curUniforms  = nullptr;
     VkBuffer                                curVbo       = VK_NULL_HANDLE;
+    VkBuffer                                curIbo       = VK_NULL_HANDLE;
+    Detail::IndexClass                      curIboCls    = Detail::IndexClass::i16;
+    DynamicStateTracker                     curPipeline;
+    uint64_t                                uploadDep    = 0;
+    uint64_t                                relocGen     = 0;
+    bool                                    movableBufs  = false;
     bool                                    ssboBarriers = false;
     bool                                    isInCompute  = false;
+    bool                                    skipDraws    = false; // pipeline is not compiled yet
   };
 
 }}
@@ -8,11 +8,11 @@
 
 using namespace Tempest::Detail;
 
-VCommandPool::VCommandPool(VDevice& device,VkCommandPoolCreateFlags flags)
+VCommandPool::VCommandPool(VDevice& device, VkCommandPoolCreateFlags flags, uint32_t family)
   :device(device.device.impl) {
   VkCommandPoolCreateInfo poolInfo = {};
   poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-  poolInfo.queueFamilyIndex = device.props.graphicsFamily;
+  poolInfo.queueFamilyIndex = (family==uint32_t(-1) ? device.props.graphicsFamily : family);
   poolInfo.flags            = flags;
 
   vkAssert(vkCreateCommandPool(device.device.impl,&poolInfo,nullptr,&impl));
@@ -10,7 +10,7 @@ class VDevice;
 
 class VCommandPool {
   public:
-    VCommandPool(VDevice &device, VkCommandPoolCreateFlags flags=VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    VCommandPool(VDevice &device, VkCommandPoolCreateFlags flags=VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, uint32_t family=uint32_t(-1));
     VCommandPool(VCommandPool&& other);
     ~VCommandPool();
 
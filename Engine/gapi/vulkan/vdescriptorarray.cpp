@@ -3,6 +3,7 @@
 #include "vbuffer.h"
 
 #include <Tempest/PipelineLayout>
+#include <algorithm>
 
 #include "vdevice.h"
 #include "vdescriptorarray.h"
@@ -11,8 +12,8 @@
 using namespace Tempest;
 using namespace Tempest::Detail;
 
-VDescriptorArray::VDescriptorArray(VkDevice device, VPipelineLay& vlay)
-  :device(device),lay(&vlay) {
+VDescriptorArray::VDescriptorArray(VDevice& dev, VPipelineLay& vlay)
+  :dev(dev),device(dev.device.impl),lay(&vlay) {
   if(lay.handler->hasSSBO)
     ssbo.reset(new SSBO[vlay.lay.size()]);
 
@@ -39,11 +40,16 @@ VDescriptorArray::VDescriptorArray(VkDevice device, VPipelineLay& vlay)
 VDescriptorArray::~VDescriptorArray() {
   if(desc==VK_NULL_HANDLE)
     return;
-  Detail::VPipelineLay* layImpl = lay.handler;
-  std::lock_guard<Detail::SpinLock> guard(layImpl->sync);
-
-  vkFreeDescriptorSets(device,pool->impl,1,&desc);
-  pool->freeCount++;
+  // layout reference keeps pool alive, until set is released
+  VkDevice                  device = this->device;
+  VkDescriptorSet           set    = desc;
+  VPipelineLay::Pool*       pool   = this->pool;
+  DSharedPtr<VPipelineLay*> lay    = this->lay;
+  dev.retire(0,[device,set,pool,lay]() {
+    std::lock_guard<Detail::SpinLock> guard(lay.handler->sync);
+    vkFreeDescriptorSets(device,pool->impl,1,&set);
+    pool->freeCount++;
+    });
   }
 
 VkDescriptorPool VDescriptorArray::allocPool(const VPipelineLay& lay, size_t size) {
@@ -95,6 +101,7 @@ bool VDescriptorArray::allocDescSet(VkDescriptorPool pool, VkDescriptorSetLayout
 
 void VDescriptorArray::set(size_t id, Tempest::AbstractGraphicsApi::Texture* t, const Sampler2d& smp) {
   VTexture* tex=reinterpret_cast<VTexture*>(t);
+  uploadDep = std::max(uploadDep,VDevice::uploadOf(*tex));
 
   VkDescriptorImageInfo imageInfo = {};
   imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -115,6 +122,7 @@ void VDescriptorArray::set(size_t id, Tempest::AbstractGraphicsApi::Texture* t,
 
 void VDescriptorArray::setSsbo(size_t id, AbstractGraphicsApi::Texture* t, uint32_t mipLevel) {
   VTexture* tex=reinterpret_cast<VTexture*>(t);
+  uploadDep = std::max(uploadDep,VDevice::uploadOf(*tex));
 
   VkDescriptorImageInfo imageInfo = {};
   imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
@@ -137,6 +145,7 @@ void VDescriptorArray::setSsbo(size_t id, AbstractGraphicsApi::Texture* t, uint3
 
 void VDescriptorArray::setUbo(size_t id, Tempest::AbstractGraphicsApi::Buffer *buf, size_t offset) {
   VBuffer* memory=reinterpret_cast<VBuffer*>(buf);
+  uploadDep = std::max(uploadDep,VDevice::uploadOf(*memory));
   VkDescriptorBufferInfo bufferInfo = {};
   bufferInfo.buffer = memory->impl;
   bufferInfo.offset = offset;
@@ -156,6 +165,7 @@ void VDescriptorArray::setUbo(size_t id, Tempest::AbstractGraphicsApi::Buffer *b
 
 void VDescriptorArray::setSsbo(size_t id, Tempest::AbstractGraphicsApi::Buffer *buf, size_t offset) {
   VBuffer* memory=reinterpret_cast<VBuffer*>(buf);
+  uploadDep = std::max(uploadDep,VDevice::uploadOf(*memory));
   VkDescriptorBufferInfo bufferInfo = {};
   bufferInfo.buffer = memory->impl;
   bufferInfo.offset = offset;
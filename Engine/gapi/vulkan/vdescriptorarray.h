@@ -8,11 +8,12 @@
 namespace Tempest {
 namespace Detail {
 
+class VDevice;
 class VPipelineLay;
 
 class VDescriptorArray : public AbstractGraphicsApi::Desc {
   public:
-    VDescriptorArray(VkDevice device, VPipelineLay& vlay);
+    VDescriptorArray(VDevice& dev, VPipelineLay& vlay);
     ~VDescriptorArray() override;
 
     void                     set    (size_t id, AbstractGraphicsApi::Texture* tex, const Sampler2d& smp) override;
@@ -22,8 +23,11 @@ class VDescriptorArray : public AbstractGraphicsApi::Desc {
     void                     ssboBarriers(Detail::ResourceState& res) override;
 
     VkDescriptorSet           desc=VK_NULL_HANDLE;
+    // newest upload of bound resources: see VCommandBuffer::uploadDependency
+    uint64_t                  uploadDep=0;
 
   private:
+    VDevice&                  dev;
     VkDevice                  device=nullptr;
     DSharedPtr<VPipelineLay*> lay;
     VPipelineLay::Pool*       pool=nullptr;
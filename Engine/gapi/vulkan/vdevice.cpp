@@ -8,10 +8,15 @@
 #include "vswapchain.h"
 #include "vbuffer.h"
 #include "vtexture.h"
+#include "vshader.h"
+#include "vpipeline.h"
+#include "gapi/cachefile.h"
 #include "system/api/x11api.h"
 
 #include <Tempest/Log>
 #include <Tempest/Platform>
+#include <Tempest/File>
+#include <cstdio>
 #include <thread>
 #include <set>
 #include <cstring>
@@ -61,6 +66,15 @@ VDevice::autoDevice::~autoDevice() {
 
 VDevice::VDevice(VulkanInstance &api, const char* gpuName)
   :instance(api.instance)  {
+  if(api.hasDeviceProps2) {
+    vkGetPhysicalDeviceMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>
+        (vkGetInstanceProcAddr(instance,"vkGetPhysicalDeviceMemoryProperties2KHR"));
+    vkGetPhysicalDeviceFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>
+        (vkGetInstanceProcAddr(instance,"vkGetPhysicalDeviceFeatures2KHR"));
+    vkGetPhysicalDeviceProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>
+        (vkGetInstanceProcAddr(instance,"vkGetPhysicalDeviceProperties2KHR"));
+    }
+
   uint32_t deviceCount = 0;
   vkEnumeratePhysicalDevices(api.instance, &deviceCount, nullptr);
 
@@ -85,8 +99,18 @@ VDevice::VDevice(VulkanInstance &api, const char* gpuName)
   }
 
 VDevice::~VDevice(){
+  // queued compilations are dropped
+  psoCompiler.reset();
+  submitAcquire(uint64_t(-1));
   vkDeviceWaitIdle(device.impl);
+  readback.reset();
   data.reset();
+  // resources, released from here on, are destroyed immediately
+  retired.reset();
+  if(pipelineCache!=VK_NULL_HANDLE) {
+    savePipelineCache();
+    vkDestroyPipelineCache(device.impl,pipelineCache,nullptr);
+    }
   }
 
 void VDevice::implInit(VkPhysicalDevice pdev, VkSurfaceKHR surf) {
@@ -98,7 +122,217 @@ void VDevice::implInit(VkPhysicalDevice pdev, VkSurfaceKHR surf) {
 
   physicalDevice = pdev;
   allocator.setDevice(*this);
+  retired.reset(new RetireMgr(*this));
   data.reset(new DataMgr(*this));
+  readback.reset(new ReadbackMgr(*this));
+  psoCompiler.reset(new AsyncCompiler());
+
+  VkPhysicalDeviceProperties prop = {};
+  vkGetPhysicalDeviceProperties(pdev,&prop);
+  pipelineCacheKey.vendor = prop.vendorID;
+  pipelineCacheKey.device = prop.deviceID;
+  pipelineCacheKey.driver = prop.driverVersion;
+  std::memcpy(pipelineCacheKey.uuid,prop.pipelineCacheUUID,VK_UUID_SIZE);
+
+  VkPipelineCacheCreateInfo cacheInfo = {};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  vkAssert(vkCreatePipelineCache(device.impl,&cacheInfo,nullptr,&pipelineCache));
+  }
+
+static const char* SHADER_CACHE_FILE = "shader-reflection.bin";
+
+static void writeCacheFile(const std::string& path, const std::vector<uint8_t>& data) {
+  if(!CacheFile::write(path,data))
+    Log::e("VulkanApi: unable to write ",path);
+  }
+
+void VDevice::setPipelineCacheDir(const char* dir) {
+  std::lock_guard<std::mutex> guard(pipelineCacheSync);
+  cacheDir = CacheFile::directory(dir);
+
+  std::vector<uint8_t> file;
+  if(CacheFile::read(cacheDir+SHADER_CACHE_FILE,file) && !reflection.deserialize(file))
+    Log::d("VulkanApi: shader cache is outdated or damaged - ignored");
+
+  if(!CacheFile::read(cacheDir+PipelineCacheFile::fileName(pipelineCacheKey),file))
+    return;
+
+  size_t         size = 0;
+  const uint8_t* blob = PipelineCacheFile::unpack(pipelineCacheKey,file,size);
+  if(blob==nullptr) {
+    Log::d("VulkanApi: pipeline cache is outdated or damaged - ignored");
+    return;
+    }
+
+  // driver header, as defined by VkPipelineCacheHeaderVersionOne
+  uint32_t hdr[4] = {};
+  if(size<sizeof(hdr)+VK_UUID_SIZE)
+    return;
+  std::memcpy(hdr,blob,sizeof(hdr));
+  if(hdr[0]<sizeof(hdr)+VK_UUID_SIZE || hdr[1]!=VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+     hdr[2]!=pipelineCacheKey.vendor || hdr[3]!=pipelineCacheKey.device ||
+     std::memcmp(blob+sizeof(hdr),pipelineCacheKey.uuid,VK_UUID_SIZE)!=0)
+    return;
+
+  VkPipelineCacheCreateInfo cacheInfo = {};
+  cacheInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = size;
+  cacheInfo.pInitialData    = blob;
+
+  VkPipelineCache seed = VK_NULL_HANDLE;
+  if(vkCreatePipelineCache(device.impl,&cacheInfo,nullptr,&seed)!=VK_SUCCESS)
+    return;
+  pipelinesLoaded = (vkMergePipelineCaches(device.impl,pipelineCache,1,&seed)==VK_SUCCESS);
+  vkDestroyPipelineCache(device.impl,seed,nullptr);
+  }
+
+void VDevice::savePipelineCache() {
+  std::lock_guard<std::mutex> guard(pipelineCacheSync);
+  if(cacheDir.empty())
+    return;
+
+  if(reflection.isDirty())
+    writeCacheFile(cacheDir+SHADER_CACHE_FILE,reflection.serialize());
+
+  size_t size = 0;
+  if(vkGetPipelineCacheData(device.impl,pipelineCache,&size,nullptr)!=VK_SUCCESS)
+    return;
+  std::vector<uint8_t> blob(size);
+  if(vkGetPipelineCacheData(device.impl,pipelineCache,&size,blob.data())!=VK_SUCCESS)
+    return;
+  writeCacheFile(cacheDir+PipelineCacheFile::fileName(pipelineCacheKey),
+                 PipelineCacheFile::pack(pipelineCacheKey,blob.data(),size));
+  }
+
+void VDevice::pipelineCacheStats(AbstractGraphicsApi::PipelineCacheStats& out) {
+  std::lock_guard<std::mutex> guard(pipelineCacheSync);
+  out.pipelinesLoaded = pipelinesLoaded;
+  out.shaderHits      = reflection.hits();
+  }
+
+AbstractGraphicsApi::PShader VDevice::createShader(const void* source, size_t size) {
+  const auto key = ShaderCache::key(source,size);
+  {
+  std::lock_guard<std::mutex> guard(shaderSync);
+  auto range = shaderModules.equal_range(key.hash);
+  for(auto i=range.first; i!=range.second; ++i) {
+    VShader* sh = i->second;
+    if(!(sh->key==key))
+      continue;
+    // last reference may be gone already, with destructor waiting for shaderSync
+    auto cnt = sh->counter.load();
+    while(cnt>0 && !sh->counter.compare_exchange_weak(cnt,cnt+1))
+      ;
+    if(cnt==0)
+      continue;
+    AbstractGraphicsApi::PShader ret(sh);
+    sh->counter.fetch_sub(1);
+    return ret;
+    }
+  }
+
+  auto* sh = new VShader(*this,source,size,key);
+  AbstractGraphicsApi::PShader ret(sh);
+  std::lock_guard<std::mutex> guard(shaderSync);
+  shaderModules.emplace(key.hash,sh);
+  return ret;
+  }
+
+void VDevice::removeShader(VShader& s) {
+  std::lock_guard<std::mutex> guard(shaderSync);
+  auto range = shaderModules.equal_range(s.key.hash);
+  for(auto i=range.first; i!=range.second; ++i)
+    if(i->second==&s) {
+      shaderModules.erase(i);
+      return;
+      }
+  }
+
+DSharedPtr<VPipeline*> VDevice::sharedPipeline(const VPipeline& src, const VPipelineLay& ulay) {
+  const size_t hash = src.sharedHash();
+  {
+  std::lock_guard<std::mutex> guard(pipelineSync);
+  auto range = sharedPipelines.equal_range(hash);
+  for(auto i=range.first; i!=range.second; ++i) {
+    VPipeline* p = i->second;
+    if(!p->isSharedFor(src))
+      continue;
+    // same as in createShader: destructor may wait for pipelineSync
+    auto cnt = p->counter.load();
+    while(cnt>0 && !p->counter.compare_exchange_weak(cnt,cnt+1))
+      ;
+    if(cnt==0)
+      continue;
+    DSharedPtr<VPipeline*> ret(p);
+    p->counter.fetch_sub(1);
+    return ret;
+    }
+  }
+
+  auto* p = new VPipeline(*this,src,ulay);
+  DSharedPtr<VPipeline*> ret(p);
+  std::lock_guard<std::mutex> guard(pipelineSync);
+  sharedPipelines.emplace(hash,p);
+  return ret;
+  }
+
+void VDevice::removePipeline(VPipeline& p) {
+  std::lock_guard<std::mutex> guard(pipelineSync);
+  auto range = sharedPipelines.equal_range(p.sharedHash());
+  for(auto i=range.first; i!=range.second; ++i)
+    if(i->second==&p) {
+      sharedPipelines.erase(i);
+      return;
+      }
+  }
+
+uint32_t VDevice::dynamicStates(uint8_t flags, VkDynamicState* out) {
+  uint32_t cnt = 0;
+#if defined(VK_EXT_extended_dynamic_state3)
+  if(flags & DynamicState::Topology)
+    out[cnt++] = VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT;
+  if(flags & DynamicState::Blend) {
+    out[cnt++] = VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT;
+    out[cnt++] = VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT;
+    out[cnt++] = VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT;
+    }
+#else
+  // props.dynamicState is None without extension headers
+  (void)flags;
+  (void)out;
+#endif
+  return cnt;
+  }
+
+void VDevice::setDynamicState(VkCommandBuffer impl, const DynamicState& st, uint8_t flags, uint8_t colorCount) const {
+#if defined(VK_EXT_extended_dynamic_state3)
+  if(flags & DynamicState::Topology) {
+    const VkPrimitiveTopology tp = (st.tp==Triangles) ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST : VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+    vkCmdSetPrimitiveTopology(impl,tp);
+    }
+  if(flags & DynamicState::Blend) {
+    vkCmdSetDepthWriteEnable(impl,st.zWrite ? VK_TRUE : VK_FALSE);
+
+    VkBool32                enable = st.blend ? VK_TRUE : VK_FALSE;
+    VkColorBlendEquationEXT eq     = {};
+    eq.srcColorBlendFactor = nativeFormat(st.src);
+    eq.dstColorBlendFactor = nativeFormat(st.dst);
+    eq.colorBlendOp        = nativeFormat(st.op);
+    eq.srcAlphaBlendFactor = eq.srcColorBlendFactor;
+    eq.dstAlphaBlendFactor = eq.dstColorBlendFactor;
+    eq.alphaBlendOp        = eq.colorBlendOp;
+    // same blend for all attachments, as in VPipeline::initGraphicsPipeline
+    for(uint32_t i=0; i<colorCount; ++i) {
+      vkCmdSetColorBlendEnable  (impl,i,1,&enable);
+      vkCmdSetColorBlendEquation(impl,i,1,&eq);
+      }
+    }
+#else
+  (void)impl;
+  (void)st;
+  (void)flags;
+  (void)colorCount;
+#endif
   }
 
 VkSurfaceKHR VDevice::createSurface(void* hwnd) {
@@ -161,6 +395,7 @@ void VDevice::deviceQueueProps(VulkanInstance::VkProp& prop,VkPhysicalDevice dev
   uint32_t graphics  = uint32_t(-1);
   uint32_t present   = uint32_t(-1);
   uint32_t universal = uint32_t(-1);
+  uint32_t transfer  = uint32_t(-1);
 
   for(uint32_t i=0;i<queueFamilyCount;++i) {
     const auto& queueFamily = queueFamilies[i];
@@ -181,6 +416,9 @@ void VDevice::deviceQueueProps(VulkanInstance::VkProp& prop,VkPhysicalDevice dev
       present = i;
     if(presentSupport && graphicsSupport)
       universal = i;
+    // dedicated DMA engine: uploads can overlap with rendering
+    if((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && (queueFamily.queueFlags & rqFlag)==0)
+      transfer = i;
     }
 
   if(universal!=uint32_t(-1)) {
@@ -190,6 +428,7 @@ void VDevice::deviceQueueProps(VulkanInstance::VkProp& prop,VkPhysicalDevice dev
 
   prop.graphicsFamily = graphics;
   prop.presentFamily  = present;
+  prop.transferFamily = transfer;
   }
 
 bool VDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
@@ -256,8 +495,60 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
     props.hasDedicatedAlloc = true;
     rqExt.push_back(VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME);
     }
+  if(vkGetPhysicalDeviceMemoryProperties2!=nullptr && checkForExt(ext,VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+    props.hasMemoryBudget = true;
+    rqExt.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+  void* featuresChain = nullptr;
+#if defined(VK_EXT_extended_dynamic_state3)
+  // blend and topology as dynamic state: Painter pipelines, that differ only in blend mode, collapse into one
+  VkPhysicalDeviceExtendedDynamicStateFeaturesEXT  dynamic1 = {};
+  dynamic1.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+  VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamic3 = {};
+  dynamic3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+  if(vkGetPhysicalDeviceFeatures2!=nullptr && vkGetPhysicalDeviceProperties2!=nullptr &&
+     checkForExt(ext,VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME) &&
+     checkForExt(ext,VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+    dynamic1.pNext = &dynamic3;
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &dynamic1;
+    vkGetPhysicalDeviceFeatures2(pdev,&features);
+
+    VkPhysicalDeviceExtendedDynamicState3PropertiesEXT dynamic3Prop = {};
+    dynamic3Prop.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_PROPERTIES_EXT;
+    VkPhysicalDeviceProperties2 prop = {};
+    prop.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    prop.pNext = &dynamic3Prop;
+    vkGetPhysicalDeviceProperties2(pdev,&prop);
+
+    // lines and triangles are different topology classes: only unrestricted topology can be shared.
+    // Blend alone saves few binds (pen and brush still differ), at price of 3 state commands per switch
+    if(dynamic1.extendedDynamicState!=VK_FALSE &&
+       dynamic3.extendedDynamicState3ColorBlendEnable!=VK_FALSE &&
+       dynamic3.extendedDynamicState3ColorBlendEquation!=VK_FALSE &&
+       dynamic3Prop.dynamicPrimitiveTopologyUnrestricted!=VK_FALSE) {
+      props.dynamicState = DynamicState::Blend | DynamicState::Topology;
+      }
+    }
+  if(props.dynamicState!=DynamicState::None) {
+    // enable only features, that are used
+    dynamic1 = {};
+    dynamic1.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+    dynamic1.pNext = &dynamic3;
+    dynamic1.extendedDynamicState = VK_TRUE;
+    dynamic3 = {};
+    dynamic3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+    dynamic3.extendedDynamicState3ColorBlendEnable   = VK_TRUE;
+    dynamic3.extendedDynamicState3ColorBlendEquation = VK_TRUE;
+    featuresChain = &dynamic1;
+    rqExt.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+    rqExt.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+    }
+#endif
 
-  std::array<uint32_t,2>  uniqueQueueFamilies = {props.graphicsFamily, props.presentFamily};
+  std::array<uint32_t,3>  uniqueQueueFamilies = {props.graphicsFamily, props.presentFamily, props.transferFamily};
   float                   queuePriority       = 1.0f;
   size_t                  queueCnt            = 0;
   VkDeviceQueueCreateInfo qinfo[3]={};
@@ -269,7 +560,7 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
 
     bool nonUnique=false;
     for(size_t r=0;r<queueCnt;++r)
-      if(q.family==family)
+      if(queues[r].family==family)
         nonUnique = true;
     if(nonUnique)
       continue;
@@ -297,8 +588,18 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
   deviceFeatures.vertexPipelineStoresAndAtomics = supportedFeatures.vertexPipelineStoresAndAtomics;
   deviceFeatures.fragmentStoresAndAtomics       = supportedFeatures.fragmentStoresAndAtomics;
 
+  // uploaded buffers and textures are read by copies, vertex fetch and shaders: rasterization and attachments don't wait
+  uploadStages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                 VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  if(deviceFeatures.tessellationShader!=VK_FALSE)
+    uploadStages |= VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT;
+  if(deviceFeatures.geometryShader!=VK_FALSE)
+    uploadStages |= VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
+
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext = featuresChain;
 
   createInfo.queueCreateInfoCount = uint32_t(queueCnt);
   createInfo.pQueueCreateInfos    = &qinfo[0];
@@ -316,7 +617,11 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
       graphicsQueue = &queues[i];
     if(queues[i].family==props.presentFamily)
       presentQueue = &queues[i];
+    if(queues[i].family==props.transferFamily)
+      transferQueue = &queues[i];
     }
+  if(transferQueue==nullptr)
+    transferQueue = graphicsQueue;
 
   if(props.hasMemRq2) {
     vkGetBufferMemoryRequirements2 = reinterpret_cast<PFN_vkGetBufferMemoryRequirements2KHR>
@@ -324,6 +629,18 @@ void VDevice::createLogicalDevice(VkPhysicalDevice pdev) {
     vkGetImageMemoryRequirements2 = reinterpret_cast<PFN_vkGetImageMemoryRequirements2KHR>
         (vkGetDeviceProcAddr(device.impl,"vkGetImageMemoryRequirements2KHR"));
     }
+#if defined(VK_EXT_extended_dynamic_state3)
+  if(props.dynamicState!=DynamicState::None) {
+    vkCmdSetPrimitiveTopology = reinterpret_cast<PFN_vkCmdSetPrimitiveTopologyEXT>
+        (vkGetDeviceProcAddr(device.impl,"vkCmdSetPrimitiveTopologyEXT"));
+    vkCmdSetDepthWriteEnable = reinterpret_cast<PFN_vkCmdSetDepthWriteEnableEXT>
+        (vkGetDeviceProcAddr(device.impl,"vkCmdSetDepthWriteEnableEXT"));
+    vkCmdSetColorBlendEnable = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>
+        (vkGetDeviceProcAddr(device.impl,"vkCmdSetColorBlendEnableEXT"));
+    vkCmdSetColorBlendEquation = reinterpret_cast<PFN_vkCmdSetColorBlendEquationEXT>
+        (vkGetDeviceProcAddr(device.impl,"vkCmdSetColorBlendEquationEXT"));
+    }
+#endif
   }
 
 VDevice::MemIndex VDevice::memoryTypeIndex(uint32_t typeBits, VkMemoryPropertyFlags props, VkImageTiling tiling) const {
@@ -356,8 +673,26 @@ VDevice::MemIndex VDevice::memoryTypeIndex(uint32_t typeBits, VkMemoryPropertyFl
   return ret;
   }
 
+bool VDevice::memoryBudget(VkPhysicalDeviceMemoryBudgetPropertiesEXT& out) const {
+  if(!props.hasMemoryBudget)
+    return false;
+  out       = {};
+  out.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+  VkPhysicalDeviceMemoryProperties2KHR prop = {};
+  prop.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+  prop.pNext = &out;
+  vkGetPhysicalDeviceMemoryProperties2(physicalDevice,&prop);
+  return true;
+  }
+
 void VDevice::waitIdle() {
+  if(data!=nullptr)
+    data->flush();
+  submitAcquire(uint64_t(-1));
   waitIdleSync(queues,sizeof(queues)/sizeof(queues[0]));
+  if(retired!=nullptr)
+    retired->flush();
   }
 
 void VDevice::waitIdleSync(VDevice::Queue* q, size_t n) {
@@ -366,7 +701,7 @@ void VDevice::waitIdleSync(VDevice::Queue* q, size_t n) {
     return;
     }
   if(q->impl!=nullptr) {
-    std::lock_guard<SpinLock> guard(q->sync);
+    std::lock_guard<std::mutex> guard(q->sync);
     waitIdleSync(q+1,n-1);
     } else {
     waitIdleSync(q+1,n-1);
@@ -379,17 +714,73 @@ void VDevice::submit(VCommandBuffer& cmd, VFence& sync) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers    = &cmd.impl;
 
+  // copies on graphics queue may read uploads, which acquire is still postponed
+  if(cmd.uploadDependency()!=0)
+    submitAcquire(cmd.uploadDependency());
   sync.reset();
   graphicsQueue->submit(1,&submitInfo,sync.impl);
   }
 
+void VDevice::submit(TransferCmd<VTransferCmd,VFence>& cmd, VFence& sync) {
+  if(!cmd.isAsync()) {
+    submit(static_cast<VCommandBuffer&>(cmd),sync);
+    return;
+    }
+
+  VkSubmitInfo transfer = {};
+  transfer.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  transfer.commandBufferCount   = 1;
+  transfer.pCommandBuffers      = &cmd.impl;
+  transfer.signalSemaphoreCount = 1;
+  transfer.pSignalSemaphores    = &cmd.semaphore;
+
+  sync.reset();
+  transferQueue->submit(1,&transfer,VK_NULL_HANDLE);
+
+  // part with only ownership acquire: graphics queue waits for copies, once uploaded resources are used.
+  // Nobody waits on fence yet: UploadEngine publishes batch after submit
+  sync.postponed.store(true);
+  postponed.push(cmd,cmd.serial(),cmd.stagedBytes(),!cmd.hasGraphicsWork(),[this](DataMgr::Commands& c){ implSubmitAcquire(c); });
+  }
+
+void VDevice::submitAcquire(uint64_t serial) {
+  postponed.submit(serial,[this](DataMgr::Commands& c){ implSubmitAcquire(c); });
+  }
+
+void VDevice::implSubmitAcquire(DataMgr::Commands& cmd) {
+  VkPipelineStageFlags waitStage = uploadStages;
+  VkSubmitInfo acquire = {};
+  acquire.sType                 = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  acquire.waitSemaphoreCount    = 1;
+  acquire.pWaitSemaphores       = &cmd.semaphore;
+  acquire.pWaitDstStageMask     = &waitStage;
+  acquire.commandBufferCount    = 1;
+  acquire.pCommandBuffers       = &cmd.graphicsImpl();
+
+  graphicsQueue->submit(1,&acquire,cmd.fence.impl);
+  cmd.fence.postponed.store(false);
+  }
+
+void VDevice::signal(VFence& sync) {
+  sync.reset();
+  graphicsQueue->submit(0,nullptr,sync.impl);
+  }
+
+void VDevice::retire(size_t bytes, RetireMgr::Release&& fn) {
+  if(retired==nullptr) {
+    fn();
+    return;
+    }
+  retired->retire(bytes,std::move(fn));
+  }
+
 void VDevice::Queue::submit(uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence) {
-  std::lock_guard<SpinLock> guard(sync);
+  std::lock_guard<std::mutex> guard(sync);
   vkAssert(vkQueueSubmit(impl,submitCount,pSubmits,fence));
   }
 
 VkResult VDevice::Queue::present(VkPresentInfoKHR& presentInfo) {
-  std::lock_guard<SpinLock> guard(sync);
+  std::lock_guard<std::mutex> guard(sync);
   return vkQueuePresentKHR(impl,&presentInfo);
   }
 
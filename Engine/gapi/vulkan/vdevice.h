@@ -1,11 +1,13 @@
 #pragma once
 
 #include <Tempest/AbstractGraphicsApi>
+#include <Tempest/RenderState>
 #include <stdexcept>
 #include "vulkan_sdk.h"
 
 #include "vallocator.h"
 #include "vcommandbuffer.h"
+#include "vtransfercmd.h"
 #include "vcommandpool.h"
 #include "vswapchain.h"
 #include "vfence.h"
@@ -14,6 +16,14 @@
 #include "utility/spinlock.h"
 #include "utility/compiller_hints.h"
 #include "gapi/uploadengine.h"
+#include "gapi/acquirequeue.h"
+#include "gapi/readbackring.h"
+#include "gapi/retirequeue.h"
+#include "gapi/pipelinecachefile.h"
+#include "gapi/asynccompiler.h"
+#include "gapi/shadercache.h"
+
+#include <unordered_map>
 
 namespace Tempest {
 namespace Detail {
@@ -21,6 +31,10 @@ namespace Detail {
 class VFence;
 
 class VTexture;
+class VShader;
+class VPipeline;
+class VPipelineLay;
+class DynamicState;
 
 inline void vkAssert(VkResult code){
   if(T_LIKELY(code==VkResult::VK_SUCCESS))
@@ -117,6 +131,35 @@ inline VkFilter nativeFormat(Filter f){
   return vfrm[int(f)];
   }
 
+inline VkBlendFactor nativeFormat(RenderState::BlendMode m) {
+  static const VkBlendFactor blend[] = {
+    VK_BLEND_FACTOR_ZERO,                 //GL_ZERO,
+    VK_BLEND_FACTOR_ONE,                  //GL_ONE,
+    VK_BLEND_FACTOR_SRC_COLOR,            //GL_SRC_COLOR,
+    VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR,  //GL_ONE_MINUS_SRC_COLOR,
+    VK_BLEND_FACTOR_SRC_ALPHA,            //GL_SRC_ALPHA,
+    VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,  //GL_ONE_MINUS_SRC_ALPHA,
+    VK_BLEND_FACTOR_DST_ALPHA,            //GL_DST_ALPHA,
+    VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA,  //GL_ONE_MINUS_DST_ALPHA,
+    VK_BLEND_FACTOR_DST_COLOR,            //GL_DST_COLOR,
+    VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR,  //GL_ONE_MINUS_DST_COLOR,
+    VK_BLEND_FACTOR_SRC_ALPHA_SATURATE,   //GL_SRC_ALPHA_SATURATE,
+    VK_BLEND_FACTOR_ZERO
+    };
+  return blend[uint8_t(m)];
+  }
+
+inline VkBlendOp nativeFormat(RenderState::BlendOp op) {
+  static const VkBlendOp blendOp[] = {
+    VK_BLEND_OP_ADD,
+    VK_BLEND_OP_SUBTRACT,
+    VK_BLEND_OP_REVERSE_SUBTRACT,
+    VK_BLEND_OP_MIN,
+    VK_BLEND_OP_MAX,
+    };
+  return blendOp[uint8_t(op)];
+  }
+
 inline VkFormat nativeFormat(Decl::ComponentType t) {
   switch(t) {
     case Decl::float0:
@@ -173,7 +216,7 @@ class VDevice : public AbstractGraphicsApi::Device {
       };
 
     struct Queue final {
-      SpinLock   sync;
+      std::mutex sync; // held over vkQueueSubmit, which may block
       VkQueue    impl=nullptr;
       uint32_t   family=0;
 
@@ -193,29 +236,102 @@ class VDevice : public AbstractGraphicsApi::Device {
     Queue                   queues[3];
     Queue*                  graphicsQueue=nullptr;
     Queue*                  presentQueue =nullptr;
+    Queue*                  transferQueue=nullptr; // dedicated transfer queue, or graphicsQueue if there is none
 
-    std::mutex              allocSync;
     VAllocator              allocator;
 
     VkProps                 props={};
 
     PFN_vkGetBufferMemoryRequirements2KHR vkGetBufferMemoryRequirements2 = nullptr;
     PFN_vkGetImageMemoryRequirements2KHR  vkGetImageMemoryRequirements2  = nullptr;
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR vkGetPhysicalDeviceMemoryProperties2 = nullptr;
+    PFN_vkGetPhysicalDeviceFeatures2KHR         vkGetPhysicalDeviceFeatures2         = nullptr;
+    PFN_vkGetPhysicalDeviceProperties2KHR       vkGetPhysicalDeviceProperties2       = nullptr;
+
+#if defined(VK_EXT_extended_dynamic_state3)
+    PFN_vkCmdSetPrimitiveTopologyEXT      vkCmdSetPrimitiveTopology  = nullptr;
+    PFN_vkCmdSetDepthWriteEnableEXT       vkCmdSetDepthWriteEnable   = nullptr;
+    PFN_vkCmdSetColorBlendEnableEXT       vkCmdSetColorBlendEnable   = nullptr;
+    PFN_vkCmdSetColorBlendEquationEXT     vkCmdSetColorBlendEquation = nullptr;
+#endif
 
     void                    waitIdle() override;
 
     void                    submit(VCommandBuffer& cmd,VFence& sync);
+    void                    submit(TransferCmd<VTransferCmd,VFence>& cmd,VFence& sync);
+    // postponed acquire parts of uploads up to given serial are put into graphics queue
+    void                    submitAcquire(uint64_t serial);
+    // stages of graphics queue, that wait for uploads: transfer, vertex input and shaders
+    VkPipelineStageFlags    uploadStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    // empty submission: sync is signaled, once all work submitted to graphics queue is complete
+    void                    signal(VFence& sync);
+    bool                    hasTransferQueue() const { return transferQueue!=graphicsQueue; }
 
     VkSurfaceKHR            createSurface(void* hwnd);
     SwapChainSupport        querySwapChainSupport(VkSurfaceKHR surface) { return querySwapChainSupport(physicalDevice,surface); }
     MemIndex                memoryTypeIndex(uint32_t typeBits, VkMemoryPropertyFlags props, VkImageTiling tiling) const;
+    auto                    memoryProps() const -> const VkPhysicalDeviceMemoryProperties& { return memoryProperties; }
+    bool                    memoryBudget(VkPhysicalDeviceMemoryBudgetPropertiesEXT& out) const;
 
-    using DataMgr = UploadEngine<VDevice,VCommandBuffer,VFence,VBuffer>;
+    using DataMgr = UploadEngine<VDevice,VTransferCmd,VFence,VBuffer>;
     DataMgr&                dataMgr() const { return *data; }
+    // upload serial, that usage of resource depends on: batch, that is still recorded, is newer than any
+    static uint64_t         uploadOf(const AbstractGraphicsApi::Shared& s) {
+      const uint64_t t = s.lastTransfer.load(std::memory_order_relaxed);
+      return (t & DataMgr::Commands::OPEN_BATCH) ? uint64_t(-1) : t;
+      }
+
+    using ReadbackMgr = ReadbackRing<VDevice,VBuffer>;
+    using Readback    = AsyncReadback<VDevice,VBuffer>;
+    ReadbackMgr&            readbackMgr() const { return *readback; }
+
+    using RetireMgr = RetireQueue<VDevice,VFence>;
+    RetireMgr&              retireMgr() const { return *retired; }
+    // release of destroyed resource, postponed until frames in flight are complete
+    void                    retire(size_t bytes, RetireMgr::Release&& fn);
+
+    VkPipelineCache         pipelineCache = VK_NULL_HANDLE;
+    // seeds pipelineCache and shader reflection from files in dir; not synchronized with pipeline creation
+    void                    setPipelineCacheDir(const char* dir);
+    void                    savePipelineCache();
+    void                    pipelineCacheStats(AbstractGraphicsApi::PipelineCacheStats& out);
+
+    ShaderCache&            shaderCache() { return reflection; }
+    // identical SPIR-V modules share one VShader
+    AbstractGraphicsApi::PShader
+                            createShader(const void* source, size_t size);
+    void                    removeShader(VShader& s);
+    // pipelines, that differ only in dynamic state, share one VPipeline with compiled instances
+    DSharedPtr<VPipeline*>  sharedPipeline(const VPipeline& src, const VPipelineLay& ulay);
+    void                    removePipeline(VPipeline& p);
+    // flags: subset of props.dynamicState; out must fit 4 entries
+    static uint32_t         dynamicStates(uint8_t flags, VkDynamicState* out);
+    void                    setDynamicState(VkCommandBuffer impl, const DynamicState& st, uint8_t flags, uint8_t colorCount) const;
+
+    AsyncCompiler&          compiler() { return *psoCompiler; }
+    // setPipeline doesn't wait for compilation: draws are skipped, until pipeline is ready
+    std::atomic_bool        asyncPipelines{false};
 
   private:
     VkPhysicalDeviceMemoryProperties memoryProperties;
     std::unique_ptr<DataMgr>         data;
+    std::unique_ptr<ReadbackMgr>     readback;
+    std::unique_ptr<RetireMgr>       retired;
+    std::unique_ptr<AsyncCompiler>   psoCompiler;
+    PipelineCacheFile::Key           pipelineCacheKey;
+    std::string                      cacheDir;
+    std::mutex                       pipelineCacheSync;
+    bool                             pipelinesLoaded = false;
+    ShaderCache                      reflection;
+    std::mutex                       shaderSync;
+    std::unordered_multimap<uint64_t,VShader*> shaderModules;
+    std::mutex                       pipelineSync;
+    std::unordered_multimap<size_t,VPipeline*> sharedPipelines;
+
+    // acquire parts of uploads, that graphics queue doesn't need yet
+    AcquireQueue<DataMgr::Commands>  postponed;
+    void                    implSubmitAcquire(DataMgr::Commands& cmd);
+
     void                    waitIdleSync(Queue* q, size_t n);
 
     void                    implInit(VkPhysicalDevice pdev, VkSurfaceKHR surf);
@@ -7,7 +7,7 @@
 using namespace Tempest::Detail;
 
 VFence::VFence(VDevice &device)
-  :device(device.device.impl) {
+  :owner(&device), device(device.device.impl) {
   VkFenceCreateInfo fenceInfo = {};
   fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
   fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
@@ -22,10 +22,18 @@ VFence::~VFence() {
   }
 
 void VFence::wait() {
+  if(postponed.load())
+    owner->submitAcquire(uint64_t(-1));
   vkAssert(vkWaitForFences(device,1,&impl,VK_TRUE,std::numeric_limits<uint64_t>::max()));
   }
 
 bool VFence::wait(uint64_t time) {
+  if(postponed.load()) {
+    // not in queue yet: polling doesn't force submission
+    if(time==0)
+      return false;
+    owner->submitAcquire(uint64_t(-1));
+    }
   if(time<std::numeric_limits<uint64_t>::max())
     time/=uint64_t(1000*1000); // nano to millis convertion
   VkResult res = vkWaitForFences(device,1,&impl,VK_TRUE,time);
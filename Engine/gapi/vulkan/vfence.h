@@ -3,6 +3,8 @@
 #include <Tempest/AbstractGraphicsApi>
 #include "vulkan_sdk.h"
 
+#include <atomic>
+
 namespace Tempest {
 namespace Detail {
 
@@ -17,9 +19,12 @@ class VFence : public AbstractGraphicsApi::Fence {
     bool wait(uint64_t time) override;
     void reset() override;
 
-    VkFence impl=VK_NULL_HANDLE;
+    VkFence          impl=VK_NULL_HANDLE;
+    // submission is postponed by VDevice: waiting with timeout submits it first
+    std::atomic_bool postponed{false};
 
   private:
+    VDevice* owner =nullptr;
     VkDevice device=nullptr;
   };
 
@@ -55,8 +55,27 @@ bool VFramebufferLayout::isCompatible(const VFramebufferLayout &other) const {
   return true;
   }
 
+size_t VFramebufferLayout::hash() const {
+  size_t h = attCount;
+  for(size_t i=0;i<attCount;++i) {
+    VkFormat f = frm[i];
+    if(f==VK_FORMAT_UNDEFINED)
+      f = swapchain[i]->format();
+    h = h*31 + size_t(f);
+    }
+  return h;
+  }
+
 bool VFramebufferLayout::equals(const Tempest::AbstractGraphicsApi::FboLayout &other) const {
   return isCompatible(reinterpret_cast<const VFramebufferLayout&>(other));
   }
 
+size_t LayoutHash::operator()(const VFramebufferLayout* l) const {
+  return l->hash();
+  }
+
+bool LayoutEq::operator()(const VFramebufferLayout* a, const VFramebufferLayout* b) const {
+  return a->isCompatible(*b);
+  }
+
 #endif
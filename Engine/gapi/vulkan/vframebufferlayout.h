@@ -25,6 +25,8 @@ class VFramebufferLayout : public AbstractGraphicsApi::FboLayout {
     uint8_t                        colorCount=0;
 
     bool                        isCompatible(const VFramebufferLayout& other) const;
+    // consistent with isCompatible: compatible layouts have same hash
+    size_t                      hash() const;
     bool                        equals(const FboLayout& other) const override;
 
   private:
@@ -8,6 +8,7 @@
 #include "vrenderpass.h"
 #include "vshader.h"
 #include "vpipelinelay.h"
+#include "gapi/asynccompiler.h"
 
 #include <algorithm>
 
@@ -22,8 +23,9 @@ VPipeline::VPipeline(){
 
 VPipeline::VPipeline(VDevice& device,
                      const RenderState &st, size_t stride, Topology tp, const VPipelineLay& ulay,
-                     const VShader* vert, const VShader* ctrl, const VShader* tess, const VShader* geom, const VShader* frag)
-  : device(device.device.impl), st(st), stride(stride), tp(tp) {
+                     const VShader* vert, const VShader* ctrl, const VShader* tess, const VShader* geom, const VShader* frag,
+                     const SpecializationConstants& sc)
+  : device(device.device.impl), cache(device.pipelineCache), st(st), stride(stride), tp(tp) {
   try {
     modules[0] = Detail::DSharedPtr<const VShader*>{vert};
     modules[1] = Detail::DSharedPtr<const VShader*>{ctrl};
@@ -36,8 +38,23 @@ VPipeline::VPipeline(VDevice& device,
       decl.reset(new Decl::ComponentType[declSize]);
       std::memcpy(decl.get(),vert->vdecl.data(),declSize*sizeof(Decl::ComponentType));
       }
+    if(!sc.isEmpty()) {
+      const std::vector<ShaderReflection::SpecConstant>* sp[5] = {};
+      for(size_t i=0; i<5; ++i)
+        if(modules[i].handler!=nullptr)
+          sp[i] = &modules[i].handler->spec;
+      ShaderReflection::specialize(spec,sp,5,sc);
+      }
     pipelineLayout = initLayout(device.device.impl,ulay,pushStageFlags);
     ssboBarriers   = ulay.hasSSBO;
+
+    // tesselation takes patches, not primitives: topology is baked, and blend alone is not worth sharing
+    if(ctrl==nullptr && tess==nullptr)
+      dynamicFlags = device.props.dynamicState;
+    if(dynamicFlags!=DynamicState::None) {
+      dynamic = DynamicState(st,tp);
+      shared  = device.sharedPipeline(*this,ulay);
+      }
     }
   catch(...) {
     cleanup();
@@ -45,36 +62,164 @@ VPipeline::VPipeline(VDevice& device,
     }
   }
 
-VPipeline::VPipeline(VPipeline &&other) {
-  std::swap(device,         other.device);
-  std::swap(inst,           other.inst);
-  std::swap(pipelineLayout, other.pipelineLayout);
-  std::swap(ssboBarriers,   other.ssboBarriers);
+VPipeline::VPipeline(VDevice& device, const VPipeline& src, const VPipelineLay& ulay)
+  : device(src.device), cache(src.cache),
+    st(DynamicState::baseState(src.st,src.dynamicFlags)), declSize(src.declSize), stride(src.stride),
+    tp(DynamicState::baseTopology(src.tp,src.dynamicFlags)), spec(src.spec), owner(&device) {
+  try {
+    for(size_t i=0; i<5; ++i)
+      modules[i] = src.modules[i];
+    if(declSize>0) {
+      decl.reset(new Decl::ComponentType[declSize]);
+      std::memcpy(decl.get(),src.decl.get(),declSize*sizeof(Decl::ComponentType));
+      }
+    // layouts of pipelines with same shaders are identically defined, so compatible with this one
+    pipelineLayout = initLayout(device.device.impl,ulay,pushStageFlags);
+    ssboBarriers   = src.ssboBarriers;
+    dynamicFlags   = src.dynamicFlags;
+    }
+  catch(...) {
+    cleanup();
+    throw;
+    }
   }
 
 VPipeline::~VPipeline() {
+  if(owner!=nullptr)
+    owner->removePipeline(*this);
   cleanup();
   }
 
 VPipeline::Inst &VPipeline::instance(VFramebufferLayout &lay) {
-  std::lock_guard<SpinLock> guard(sync);
-
-  for(auto& i:inst)
-    if(i.lay.handler->isCompatible(lay))
+  if(shared)
+    return shared.handler->instance(lay);
+  bool  added = false;
+  Inst& i     = findOrAdd(lay,added);
+  while(true) {
+    uint8_t s = i.state.load(std::memory_order_acquire);
+    if(s==Inst::Ready)
       return i;
-  VkPipeline val=VK_NULL_HANDLE;
+    if(s==Inst::Failed)
+      std::rethrow_exception(i.error);
+    if(s==Inst::Compiling) {
+      // compiled by worker: same pipeline is not compiled twice
+      std::unique_lock<std::mutex> guard(buildSync);
+      buildCv.wait(guard,[&i](){ return i.state.load(std::memory_order_acquire)!=Inst::Compiling; });
+      continue;
+      }
+    if(!i.state.compare_exchange_strong(s,Inst::Compiling))
+      continue;
+    build(i);
+    return i;
+    }
+  }
+
+VPipeline::Inst* VPipeline::tryInstance(VFramebufferLayout &lay, AsyncCompiler& compiler) {
+  if(shared)
+    return shared.handler->tryInstance(lay,compiler);
+  bool  added = false;
+  Inst& i     = findOrAdd(lay,added);
+  const uint8_t s = i.state.load(std::memory_order_acquire);
+  if(s==Inst::Ready)
+    return &i;
+  if(s==Inst::Failed)
+    std::rethrow_exception(i.error);
+  if(added)
+    compileAsync(i,compiler);
+  return nullptr;
+  }
+
+void VPipeline::prewarm(VFramebufferLayout &lay, AsyncCompiler& compiler) {
+  if(shared)
+    return shared.handler->prewarm(lay,compiler);
+  bool  added = false;
+  Inst& i     = findOrAdd(lay,added);
+  if(added)
+    compileAsync(i,compiler);
+  }
+
+VPipeline::Inst& VPipeline::findOrAdd(VFramebufferLayout &lay, bool& added) {
+  // wait-free for known layouts; instances are never moved, so references stay valid, while workers fill them
+  added = false;
+  return inst.get(&lay,[&lay,&added](const VFramebufferLayout*, Inst& i){
+    i.lay = DSharedPtr<VFramebufferLayout*>(&lay);
+    added = true;
+    });
+  }
+
+void VPipeline::build(Inst& i) {
   try {
-    val = initGraphicsPipeline(device,pipelineLayout,lay,st,
-                               decl.get(),declSize,stride,
-                               tp,modules);
-    inst.emplace_back(&lay,val);
+    i.val = initGraphicsPipeline(device,cache,pipelineLayout,*i.lay.handler,st,
+                                 decl.get(),declSize,stride,
+                                 tp,modules,spec,dynamicFlags);
     }
   catch(...) {
-    if(val!=VK_NULL_HANDLE)
-      vkDestroyPipeline(device,val,nullptr);
+    i.error = std::current_exception();
+    publish(i,Inst::Failed);
     throw;
     }
-  return inst.back();
+  publish(i,Inst::Ready);
+  }
+
+void VPipeline::publish(Inst& i, Inst::State s) {
+  // under lock: waiter in instance() can't miss notification between check and wait
+  std::lock_guard<std::mutex> guard(buildSync);
+  i.state.store(s,std::memory_order_release);
+  buildCv.notify_all();
+  }
+
+void VPipeline::compileAsync(Inst& i, AsyncCompiler& compiler) {
+  // task keeps pipeline alive; instances are never removed, so &i stays valid
+  DSharedPtr<VPipeline*> self(this);
+  Inst*                  pi = &i;
+  compiler.push([self,pi](){
+    uint8_t s = Inst::Pending;
+    // render thread may have taken it already
+    if(!pi->state.compare_exchange_strong(s,Inst::Compiling))
+      return;
+    try {
+      self.handler->build(*pi);
+      }
+    catch(...) {
+      // error is kept in instance, and rethrown by next tryInstance or instance
+      }
+    });
+  }
+
+size_t VPipeline::sharedHash() const {
+  size_t h = stride;
+  for(auto& i:modules)
+    h = h*31 + std::hash<const VShader*>()(i.handler);
+  return h;
+  }
+
+static bool isSame(const RenderState& a, const RenderState& b) {
+  return a.blendSource()==b.blendSource() &&
+         a.blendDest()==b.blendDest() &&
+         a.blendOperation()==b.blendOperation() &&
+         a.zTestMode()==b.zTestMode() &&
+         a.isZWriteEnabled()==b.isZWriteEnabled() &&
+         a.cullFaceMode()==b.cullFaceMode() &&
+         a.isRasterDiscardEnabled()==b.isRasterDiscardEnabled();
+  }
+
+bool VPipeline::isSharedFor(const VPipeline& src) const {
+  // shared pipeline holds modules: pointers are not reused, while it's alive
+  for(size_t i=0; i<5; ++i)
+    if(modules[i].handler!=src.modules[i].handler)
+      return false;
+  if(dynamicFlags!=src.dynamicFlags || stride!=src.stride)
+    return false;
+  if(tp!=DynamicState::baseTopology(src.tp,src.dynamicFlags))
+    return false;
+  if(!isSame(st,DynamicState::baseState(src.st,src.dynamicFlags)))
+    return false;
+  if(spec.size()!=src.spec.size())
+    return false;
+  for(size_t i=0; i<spec.size(); ++i)
+    if(spec[i].id!=src.spec[i].id || spec[i].bits!=src.spec[i].bits)
+      return false;
+  return true;
   }
 
 void VPipeline::cleanup() {
@@ -82,8 +227,10 @@ void VPipeline::cleanup() {
     return;
   if(pipelineLayout!=VK_NULL_HANDLE)
     vkDestroyPipelineLayout(device,pipelineLayout,nullptr);
-  for(auto& i:inst)
-    vkDestroyPipeline(device,i.val,nullptr);
+  inst.forEach([this](const VFramebufferLayout*, Inst& i){
+    if(i.val!=VK_NULL_HANDLE)
+      vkDestroyPipeline(device,i.val,nullptr);
+    });
   }
 
 VkPipelineLayout VPipeline::initLayout(VkDevice device, const VPipelineLay& uboLay, VkShaderStageFlags& pushStageFlags) {
@@ -121,11 +268,13 @@ VkPipelineLayout VPipeline::initLayout(VkDevice device, const VPipelineLay& uboL
   return ret;
   }
 
-VkPipeline VPipeline::initGraphicsPipeline(VkDevice device, VkPipelineLayout layout,
+VkPipeline VPipeline::initGraphicsPipeline(VkDevice device, VkPipelineCache cache, VkPipelineLayout layout,
                                            const VFramebufferLayout &lay, const RenderState &st,
                                            const Decl::ComponentType *decl, size_t declSize,
                                            size_t stride, Topology tp,
-                                           const DSharedPtr<const VShader*>* shaders) {
+                                           const DSharedPtr<const VShader*>* shaders,
+                                           const std::vector<ShaderReflection::SpecValue>& spec,
+                                           uint8_t dynamicFlags) {
   static const VkShaderStageFlagBits stageBits[] = {
     VK_SHADER_STAGE_VERTEX_BIT,
     VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT,
@@ -133,6 +282,19 @@ VkPipeline VPipeline::initGraphicsPipeline(VkDevice device, VkPipelineLayout lay
     VK_SHADER_STAGE_GEOMETRY_BIT,
     VK_SHADER_STAGE_FRAGMENT_BIT
     };
+  static const ShaderReflection::Stage stages[] = {
+    ShaderReflection::Vertex,
+    ShaderReflection::Control,
+    ShaderReflection::Evaluate,
+    ShaderReflection::Geometry,
+    ShaderReflection::Fragment
+    };
+  std::vector<uint32_t>                 specData(spec.size());
+  std::vector<VkSpecializationMapEntry> specEntry[5];
+  VkSpecializationInfo                  specInfo[5] = {};
+  for(size_t i=0; i<spec.size(); ++i)
+    specData[i] = spec[i].bits;
+
   VkPipelineShaderStageCreateInfo shaderStages[5] = {};
   size_t                          stagesCnt       = 0;
   for(size_t i=0; i<5; ++i) {
@@ -142,6 +304,7 @@ VkPipeline VPipeline::initGraphicsPipeline(VkDevice device, VkPipelineLayout lay
       sh.stage  = stageBits[i];
       sh.module = shaders[i].handler->impl;
       sh.pName  = "main";
+      sh.pSpecializationInfo = initSpecialization(specInfo[i],specEntry[i],spec,specData,stages[i]);
       stagesCnt++;
       }
     }
@@ -223,37 +386,14 @@ VkPipeline VPipeline::initGraphicsPipeline(VkDevice device, VkPipelineLayout lay
   multisampling.sampleShadingEnable  = VK_FALSE;
   multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
-  static const VkBlendFactor blend[] = {
-    VK_BLEND_FACTOR_ZERO,                 //GL_ZERO,
-    VK_BLEND_FACTOR_ONE,                  //GL_ONE,
-    VK_BLEND_FACTOR_SRC_COLOR,            //GL_SRC_COLOR,
-    VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR,  //GL_ONE_MINUS_SRC_COLOR,
-    VK_BLEND_FACTOR_SRC_ALPHA,            //GL_SRC_ALPHA,
-    VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,  //GL_ONE_MINUS_SRC_ALPHA,
-    VK_BLEND_FACTOR_DST_ALPHA,            //GL_DST_ALPHA,
-    VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA,  //GL_ONE_MINUS_DST_ALPHA,
-    VK_BLEND_FACTOR_DST_COLOR,            //GL_DST_COLOR,
-    VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR,  //GL_ONE_MINUS_DST_COLOR,
-    VK_BLEND_FACTOR_SRC_ALPHA_SATURATE,   //GL_SRC_ALPHA_SATURATE,
-    VK_BLEND_FACTOR_ZERO
-    };
-
-  static const VkBlendOp blendOp[] = {
-    VK_BLEND_OP_ADD,
-    VK_BLEND_OP_SUBTRACT,
-    VK_BLEND_OP_REVERSE_SUBTRACT,
-    VK_BLEND_OP_MIN,
-    VK_BLEND_OP_MAX,
-    };
-
   VkPipelineColorBlendAttachmentState blendAtt[256] = {};
   for(size_t i=0; i<lay.colorCount; ++i) {
     auto& a = blendAtt[i];
     a.colorWriteMask      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
     a.blendEnable         = st.hasBlend() ? VK_TRUE : VK_FALSE;
-    a.dstColorBlendFactor = blend[uint8_t(st.blendDest())];
-    a.srcColorBlendFactor = blend[uint8_t(st.blendSource())];
-    a.colorBlendOp        = blendOp[uint8_t(st.blendOperation())];
+    a.dstColorBlendFactor = nativeFormat(st.blendDest());
+    a.srcColorBlendFactor = nativeFormat(st.blendSource());
+    a.colorBlendOp        = nativeFormat(st.blendOperation());
     a.dstAlphaBlendFactor = a.dstColorBlendFactor;
     a.srcAlphaBlendFactor = a.srcColorBlendFactor;
     a.alphaBlendOp        = a.colorBlendOp;
@@ -302,9 +442,12 @@ VkPipeline VPipeline::initGraphicsPipeline(VkDevice device, VkPipelineLayout lay
 
   VkPipelineDynamicStateCreateInfo dynamic = {};
   dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-  const VkDynamicState dySt[2] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+  VkDynamicState dySt[6] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+  uint32_t       dyCnt   = 2;
+  if(dynamicFlags!=DynamicState::None)
+    dyCnt += VDevice::dynamicStates(dynamicFlags,dySt+dyCnt);
   dynamic.pDynamicStates    = dySt;
-  dynamic.dynamicStateCount = 2;
+  dynamic.dynamicStateCount = dyCnt;
 
   VkGraphicsPipelineCreateInfo pipelineInfo = {};
   pipelineInfo.sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -329,29 +472,62 @@ VkPipeline VPipeline::initGraphicsPipeline(VkDevice device, VkPipelineLayout lay
     }
 
   VkPipeline graphicsPipeline=VK_NULL_HANDLE;
-  vkAssert(vkCreateGraphicsPipelines(device,VK_NULL_HANDLE,1,&pipelineInfo,nullptr,&graphicsPipeline));
+  vkAssert(vkCreateGraphicsPipelines(device,cache,1,&pipelineInfo,nullptr,&graphicsPipeline));
   return graphicsPipeline;
   }
 
 
+const VkSpecializationInfo* VPipeline::initSpecialization(VkSpecializationInfo& info, std::vector<VkSpecializationMapEntry>& entry,
+                                                          const std::vector<ShaderReflection::SpecValue>& spec,
+                                                          const std::vector<uint32_t>& data, ShaderReflection::Stage stage) {
+  for(size_t i=0; i<spec.size(); ++i) {
+    if((spec[i].stage & stage)==0)
+      continue;
+    // bool constants are VkBool32: all supported types are 32 bit
+    VkSpecializationMapEntry e = {};
+    e.constantID = spec[i].id;
+    e.offset     = uint32_t(i*sizeof(uint32_t));
+    e.size       = sizeof(uint32_t);
+    entry.push_back(e);
+    }
+  if(entry.empty())
+    return nullptr;
+  info.mapEntryCount = uint32_t(entry.size());
+  info.pMapEntries   = entry.data();
+  info.dataSize      = data.size()*sizeof(uint32_t);
+  info.pData         = data.data();
+  return &info;
+  }
+
 VCompPipeline::VCompPipeline() {
   }
 
-VCompPipeline::VCompPipeline(VDevice& dev, const VPipelineLay& ulay, VShader& comp)
+VCompPipeline::VCompPipeline(VDevice& dev, const VPipelineLay& ulay, VShader& comp, const SpecializationConstants& sc)
   :device(dev.device.impl) {
   VkShaderStageFlags pushStageFlags = 0;
   pipelineLayout = VPipeline::initLayout(device,ulay,pushStageFlags);
   ssboBarriers   = ulay.hasSSBO;
 
   try {
+    const std::vector<ShaderReflection::SpecConstant>* sp[1] = {&comp.spec};
+    std::vector<ShaderReflection::SpecValue>           spec;
+    ShaderReflection::specialize(spec,sp,1,sc);
+
+    std::vector<uint32_t>                 specData(spec.size());
+    std::vector<VkSpecializationMapEntry> specEntry;
+    VkSpecializationInfo                  specInfo = {};
+    for(size_t i=0; i<spec.size(); ++i)
+      specData[i] = spec[i].bits;
+
     VkComputePipelineCreateInfo info = {};
     info.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
     info.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     info.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
     info.stage.module = comp.impl;
     info.stage.pName  = "main";
+    info.stage.pSpecializationInfo = VPipeline::initSpecialization(specInfo,specEntry,spec,specData,ShaderReflection::Compute);
     info.layout       = pipelineLayout;
-    vkAssert(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &impl));
+    vkAssert(vkCreateComputePipelines(device, dev.pipelineCache, 1, &info, nullptr, &impl));
     }
   catch(...) {
     vkDestroyPipelineLayout(device,pipelineLayout,nullptr);
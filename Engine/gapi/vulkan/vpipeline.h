@@ -2,11 +2,17 @@
 
 #include <Tempest/AbstractGraphicsApi>
 #include <Tempest/RenderState>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <vector>
 
 #include "../utility/dptr.h"
-#include "../utility/spinlock.h"
+#include "gapi/dynamicstate.h"
+#include "gapi/shaderreflection.h"
 #include "vulkan_sdk.h"
+#include "vrenderpass.h"
 
 namespace Tempest {
 namespace Detail {
@@ -16,55 +22,91 @@ class VDevice;
 class VFramebuffer;
 class VFramebufferLayout;
 class VPipelineLay;
+class AsyncCompiler;
 
 class VPipeline : public AbstractGraphicsApi::Pipeline {
   public:
     VPipeline();
     VPipeline(VDevice &device,
               const RenderState &st, size_t stride, Topology tp, const VPipelineLay& ulayImpl,
-              const VShader* vert, const VShader* ctrl, const VShader* tess, const VShader* geom,  const VShader* frag);
-    VPipeline(VPipeline&& other);
+              const VShader* vert, const VShader* ctrl, const VShader* tess, const VShader* geom,  const VShader* frag,
+              const SpecializationConstants& spec);
     ~VPipeline();
 
     struct Inst final {
-      Inst(VFramebufferLayout* lay,VkPipeline val):lay(lay),val(val){}
-      Inst(Inst&&)=default;
-      Inst& operator = (Inst&&)=default;
-
+      enum State : uint8_t {
+        Pending,
+        Compiling,
+        Ready,
+        Failed,
+        };
       Detail::DSharedPtr<VFramebufferLayout*> lay;
-      VkPipeline                              val;
+      VkPipeline                              val   = VK_NULL_HANDLE;
+      std::exception_ptr                      error; // set before Failed is published
+      std::atomic<uint8_t>                    state{Pending};
       };
 
     VkPipelineLayout   pipelineLayout = VK_NULL_HANDLE;
     VkShaderStageFlags pushStageFlags = 0;
     bool               ssboBarriers   = false;
+    // parts of state, that are set by VCommandBuffer, see VDevice::sharedPipeline
+    uint8_t            dynamicFlags   = DynamicState::None;
+    DynamicState       dynamic;
 
+    // compiles on calling thread, or waits for worker, if compilation is already in progress
     Inst&             instance(VFramebufferLayout &lay);
+    // never waits: returns nullptr and queues compilation, if pipeline is not ready yet
+    // both rethrow error of failed compilation, including one that failed on worker
+    Inst*             tryInstance(VFramebufferLayout &lay, AsyncCompiler& compiler);
+    void              prewarm(VFramebufferLayout &lay, AsyncCompiler& compiler);
+
+    size_t            sharedHash() const;
+    bool              isSharedFor(const VPipeline& src) const;
 
   private:
+    // shared part of pipelines with dynamic state: owns compiled instances
+    VPipeline(VDevice& device, const VPipeline& src, const VPipelineLay& ulay);
+
     VkDevice                               device=nullptr;
+    VkPipelineCache                        cache=VK_NULL_HANDLE;
     Tempest::RenderState                   st;
     size_t                                 declSize=0, stride=0;
     Topology                               tp=Topology::Triangles;
     DSharedPtr<const VShader*>             modules[5];
     std::unique_ptr<Decl::ComponentType[]> decl;
-    std::vector<Inst>                      inst;
-    SpinLock                               sync;
+    std::vector<ShaderReflection::SpecValue> spec;
+    ConcurrentCache<const VFramebufferLayout*,Inst,LayoutHash,LayoutEq> inst;
+    // signaled, once any instance leaves Compiling state
+    std::mutex                             buildSync;
+    std::condition_variable                buildCv;
+    DSharedPtr<VPipeline*>                 shared;
+    VDevice*                               owner=nullptr; // set for shared pipelines, registered in VDevice
 
     void cleanup();
+    Inst&                        findOrAdd(VFramebufferLayout &lay, bool& added);
+    void                         build(Inst& i);
+    void                         publish(Inst& i, Inst::State s);
+    void                         compileAsync(Inst& i, AsyncCompiler& compiler);
     static VkPipelineLayout      initLayout(VkDevice device, const VPipelineLay& uboLay, VkShaderStageFlags& pushFlg);
-    static VkPipeline            initGraphicsPipeline(VkDevice device, VkPipelineLayout layout,
+    static VkPipeline            initGraphicsPipeline(VkDevice device, VkPipelineCache cache, VkPipelineLayout layout,
                                                       const VFramebufferLayout &lay, const RenderState &st,
                                                       const Decl::ComponentType *decl, size_t declSize, size_t stride,
                                                       Topology tp,
-                                                      const DSharedPtr<const VShader*>* shaders);
+                                                      const DSharedPtr<const VShader*>* shaders,
+                                                      const std::vector<ShaderReflection::SpecValue>& spec,
+                                                      uint8_t dynamicFlags);
+    static const VkSpecializationInfo*
+                                 initSpecialization(VkSpecializationInfo& info, std::vector<VkSpecializationMapEntry>& entry,
+                                                    const std::vector<ShaderReflection::SpecValue>& spec,
+                                                    const std::vector<uint32_t>& data, ShaderReflection::Stage stage);
   friend class VCompPipeline;
+  friend class VDevice;
   };
 
 class VCompPipeline : public AbstractGraphicsApi::CompPipeline {
   public:
     VCompPipeline();
-    VCompPipeline(VDevice &device, const VPipelineLay& ulay, VShader &comp);
+    VCompPipeline(VDevice &device, const VPipelineLay& ulay, VShader &comp, const SpecializationConstants& spec);
     VCompPipeline(VCompPipeline&& other);
     ~VCompPipeline();
 
@@ -19,37 +19,18 @@ VRenderPass::VRenderPass(VDevice& device, const FboMode **attach, uint8_t attCou
     input[i] = *attach[i];
   }
 
-VRenderPass::VRenderPass(VRenderPass &&other) {
-  std::swap(attCount,other.attCount);
-  std::swap(device,other.device);
-  std::swap(impl,other.impl);
-  std::swap(input,other.input);
-  }
-
 VRenderPass::~VRenderPass(){
   if(device==nullptr)
     return;
-  for(auto& i:impl)
+  impl.forEach([this](const VFramebufferLayout*, Impl& i){
     if(i.impl!=VK_NULL_HANDLE)
       vkDestroyRenderPass(device,i.impl,nullptr);
-  }
-
-void VRenderPass::operator=(VRenderPass &&other) {
-  std::swap(attCount,other.attCount);
-  std::swap(device,other.device);
-  std::swap(impl,other.impl);
-  std::swap(input,other.input);
+    });
   }
 
 VRenderPass::Impl &VRenderPass::instance(VFramebufferLayout &lay) {
-  std::lock_guard<SpinLock> guard(sync);
-
-  for(auto& i:impl)
-    if(i.isCompatible(lay))
-      return i;
-
-  VkRenderPass val=VK_NULL_HANDLE;
-  try {
+  // lock-free, once render pass for compatible layout exists
+  return impl.get(&lay,[this,&lay](const VFramebufferLayout*, Impl& ret){
     std::unique_ptr<VkClearValue[]> clear(new VkClearValue[attCount]());
     for(size_t i=0;i<attCount;++i) {
       auto& cl = input[i].clear;
@@ -63,16 +44,10 @@ VRenderPass::Impl &VRenderPass::instance(VFramebufferLayout &lay) {
         clear[i].color.float32[3] = cl.a();
         }
       }
-
-    val = createInstance(device,lay.swapchain.get(),input.get(),lay.frm.get(),attCount);
-    impl.emplace_back(lay,val,std::move(clear));
-    }
-  catch(...) {
-    if(val!=VK_NULL_HANDLE)
-      vkDestroyRenderPass(device,val,nullptr);
-    throw;
-    }
-  return impl.back();
+    ret.lay   = DSharedPtr<VFramebufferLayout*>(&lay);
+    ret.clear = std::move(clear);
+    ret.impl  = createInstance(device,lay.swapchain.get(),input.get(),lay.frm.get(),attCount);
+    });
   }
 
 VkRenderPass VRenderPass::createInstance(VkDevice &device, VSwapchain** sw,
@@ -214,10 +189,4 @@ bool VRenderPass::isResultPreserved(size_t att) const {
   return (input[att].mode & FboMode::PreserveOut);
   }
 
-bool VRenderPass::Impl::isCompatible(VFramebufferLayout &l) const {
-  if(!lay.handler->isCompatible(l))
-    return false;
-  return true;
-  }
-
 #endif
@@ -2,10 +2,9 @@
 
 #include <Tempest/AbstractGraphicsApi>
 #include <Tempest/Color>
-#include <list>
 #include "vulkan_sdk.h"
 
-#include "utility/spinlock.h"
+#include "gapi/concurrentcache.h"
 
 namespace Tempest {
 
@@ -17,6 +16,14 @@ class VDevice;
 class VSwapchain;
 class VFramebufferLayout;
 
+// key functors for per-layout caches: layouts are equal, if they are compatible
+struct LayoutHash final {
+  size_t operator()(const VFramebufferLayout* l) const;
+  };
+struct LayoutEq final {
+  bool   operator()(const VFramebufferLayout* a, const VFramebufferLayout* b) const;
+  };
+
 class VRenderPass : public AbstractGraphicsApi::Pass {
   public:
     struct Att {
@@ -25,19 +32,12 @@ class VRenderPass : public AbstractGraphicsApi::Pass {
 
     VRenderPass()=default;
     VRenderPass(VDevice& device, const FboMode** attach, uint8_t attCount);
-    VRenderPass(VRenderPass&& other);
     ~VRenderPass();
 
-    void operator=(VRenderPass&& other);
-
     struct Impl {
-      Impl(VFramebufferLayout &lay,VkRenderPass impl,std::unique_ptr<VkClearValue[]>&& clr)
-        :lay(&lay),impl(impl),clear(std::move(clr)){}
       DSharedPtr<VFramebufferLayout*> lay;
       VkRenderPass                    impl=VK_NULL_HANDLE;
       std::unique_ptr<VkClearValue[]> clear;
-
-      bool                            isCompatible(VFramebufferLayout &lay) const;
       };
 
     Impl&                           instance(VFramebufferLayout &lay);
@@ -49,10 +49,11 @@ class VRenderPass : public AbstractGraphicsApi::Pass {
     bool                            isResultPreserved(size_t att) const;
 
   private:
+    using Cache = ConcurrentCache<const VFramebufferLayout*,Impl,LayoutHash,LayoutEq>;
+
     VkDevice                        device=nullptr;
-    std::list<Impl>                 impl;
+    Cache                           impl;
     std::unique_ptr<FboMode[]>      input;
-    SpinLock                        sync;
 
     static VkRenderPass             createInstance(VkDevice &device, VSwapchain** sw,
                                                    const FboMode* attach, const VkFormat *frm,
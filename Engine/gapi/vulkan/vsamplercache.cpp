@@ -13,8 +13,9 @@ VSamplerCache::VSamplerCache(){
 VSamplerCache::~VSamplerCache() {
   if(smpDefault!=VK_NULL_HANDLE)
     vkDestroySampler(device,smpDefault,nullptr);
-  for(auto& i:chunks)
-    vkDestroySampler(device,i.sampler,nullptr);
+  chunks.forEach([this](const Sampler2d&, VkSampler s){
+    vkDestroySampler(device,s,nullptr);
+    });
   }
 
 void VSamplerCache::setDevice(VDevice &dev) {
@@ -32,22 +33,9 @@ VkSampler VSamplerCache::get(Sampler2d s) {
   if(def==s)
     return smpDefault;
 
-  std::lock_guard<SpinLock> guard(sync);
-  for(auto& i:chunks) {
-    if(i.smp==s)
-      return i.sampler;
-    }
-
-  chunks.emplace_back();
-  auto& b = chunks.back();
-  b.smp = s;
-  try {
-    b.sampler = alloc(s);
-    }
-  catch(...) {
-    chunks.pop_back();
-    }
-  return b.sampler;
+  return chunks.get(s,[this](const Sampler2d& smp, VkSampler& ret){
+    ret = alloc(smp);
+    });
   }
 
 VkSampler VSamplerCache::alloc(const Sampler2d &s) {
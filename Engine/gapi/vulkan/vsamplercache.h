@@ -1,11 +1,8 @@
 #pragma once
 
 #include <Tempest/Texture2d>
-#include <mutex>
-#include <vector>
-
 #include "vulkan_sdk.h"
-#include "utility/spinlock.h"
+#include "gapi/concurrentcache.h"
 
 namespace Tempest {
 namespace Detail {
@@ -21,13 +18,15 @@ class VSamplerCache final {
     void      setDevice(VDevice &dev);
 
   private:
-    struct Entry {
-      Sampler2d smp;
-      VkSampler sampler=VK_NULL_HANDLE;
+    // consistent with Sampler2d::operator==: component mapping is not part of sampler
+    struct Hash final {
+      size_t operator()(const Sampler2d& s) const {
+        return size_t(s.minFilter)   | size_t(s.magFilter)<<4 | size_t(s.mipFilter)<<8 |
+               size_t(s.uClamp)<<12  | size_t(s.vClamp)<<16   | size_t(s.anisotropic)<<20;
+        }
       };
 
-    SpinLock           sync;
-    std::vector<Entry> chunks;
+    ConcurrentCache<Sampler2d,VkSampler,Hash> chunks;
 
     VkDevice           device        = nullptr;
     VkSampler          smpDefault    = VK_NULL_HANDLE;
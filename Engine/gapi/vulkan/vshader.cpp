@@ -5,12 +5,12 @@
 #include <Tempest/File>
 
 #include "vdevice.h"
-#include "gapi/shaderreflection.h"
+#include "gapi/spirvreflection.h"
 
 using namespace Tempest::Detail;
 
-VShader::VShader(VDevice& device, const void *source, size_t src_size)
-  :device(device.device.impl) {
+VShader::VShader(VDevice& device, const void *source, size_t src_size, const ShaderCache::Key& key)
+  :key(key), owner(device) {
   if(src_size%4!=0)
     throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
 
@@ -19,18 +19,25 @@ VShader::VShader(VDevice& device, const void *source, size_t src_size)
   createInfo.codeSize = src_size;
   createInfo.pCode    = reinterpret_cast<const uint32_t*>(source);
 
-  {
-  spirv_cross::Compiler comp(createInfo.pCode,uint32_t(src_size/4));
-  ShaderReflection::getVertexDecl(vdecl,comp);
-  ShaderReflection::getBindings(lay,comp);
-  }
+  ShaderCache::Reflection ref;
+  if(!device.shaderCache().find(key,ref)) {
+    SpirvReflection spv(createInfo.pCode,src_size/4);
+    spv.getVertexDecl(ref.vdecl);
+    spv.getBindings(ref.lay);
+    spv.getSpecConstants(ref.spec);
+    device.shaderCache().insert(key,ref);
+    }
+  vdecl = std::move(ref.vdecl);
+  lay   = std::move(ref.lay);
+  spec  = std::move(ref.spec);
 
   if(vkCreateShaderModule(device.device.impl,&createInfo,nullptr,&impl)!=VK_SUCCESS)
     throw std::system_error(Tempest::GraphicsErrc::InvalidShaderModule);
   }
 
 VShader::~VShader() {
-  vkDestroyShaderModule(device,impl,nullptr);
+  owner.removeShader(*this);
+  vkDestroyShaderModule(owner.device.impl,impl,nullptr);
   }
 
 #endif
@@ -4,6 +4,7 @@
 #include <Tempest/PipelineLayout>
 
 #include "gapi/shaderreflection.h"
+#include "gapi/shadercache.h"
 #include "vulkan_sdk.h"
 
 namespace Tempest {
@@ -13,17 +14,19 @@ class VDevice;
 
 class VShader:public AbstractGraphicsApi::Shader {
   public:
-    VShader(VDevice& device, const void* source, size_t src_size);
+    VShader(VDevice& device, const void* source, size_t src_size, const ShaderCache::Key& key);
     ~VShader();
 
     using Binding = ShaderReflection::Binding;
 
-    VkShaderModule                   impl;
-    std::vector<Decl::ComponentType> vdecl;
-    std::vector<Binding>             lay;
+    VkShaderModule                              impl;
+    std::vector<Decl::ComponentType>            vdecl;
+    std::vector<Binding>                        lay;
+    std::vector<ShaderReflection::SpecConstant> spec;
+    const ShaderCache::Key                      key;
 
   private:
-    VkDevice                         device;
+    VDevice&                         owner;
   };
 
 }}
@@ -15,12 +15,13 @@ VTexture::VTexture(VTexture &&other) {
   std::swap(mipCnt,   other.mipCnt);
   std::swap(alloc,    other.alloc);
   std::swap(page,     other.page);
-  std::swap(extViews, other.extViews);
+  extViews.store(other.extViews.exchange(nullptr));
   }
 
 VTexture::~VTexture() {
   if(alloc!=nullptr)
     alloc->free(*this);
+  delete extViews.load();
   }
 
 VkImageView VTexture::getView(VkDevice dev, const ComponentMapping& m, uint32_t mipLevel) {
@@ -32,23 +33,22 @@ VkImageView VTexture::getView(VkDevice dev, const ComponentMapping& m, uint32_t
     return view;
     }
 
-  std::lock_guard<Detail::SpinLock> guard(syncViews);
-  for(auto& i:extViews) {
-    if(i.m==m && i.mip==mipLevel)
-      return i.v;
+  ViewCache* views = extViews.load(std::memory_order_acquire);
+  if(views==nullptr) {
+    std::lock_guard<Detail::SpinLock> guard(syncViews);
+    views = extViews.load(std::memory_order_relaxed);
+    if(views==nullptr) {
+      views = new ViewCache();
+      extViews.store(views,std::memory_order_release);
+      }
     }
+
   View v;
-  createView(v.v,dev,format,&m,mipLevel);
   v.m   = m;
   v.mip = mipLevel;
-  try {
-    extViews.push_back(v);
-    }
-  catch (...) {
-    vkDestroyImageView(dev,v.v,nullptr);
-    throw;
-    }
-  return v.v;
+  return views->get(v,[this,dev,&m,mipLevel](const View&, VkImageView& ret){
+    createView(ret,dev,format,&m,mipLevel);
+    });
   }
 
 VkImageView VTexture::getFboView(VkDevice dev, uint32_t mip) {
@@ -59,12 +59,6 @@ void VTexture::createViews(VkDevice device) {
   createView(view, device, format, nullptr, uint32_t(-1));
   }
 
-void VTexture::destroyViews(VkDevice device) {
-  vkDestroyImageView(device,view,nullptr);
-  for(auto& i:extViews)
-    vkDestroyImageView(device,i.v,nullptr);
-  }
-
 void VTexture::createView(VkImageView& ret, VkDevice device, VkFormat format,
                           const ComponentMapping* cmap, uint32_t mipLevel) {
   VkImageViewCreateInfo viewInfo = {};
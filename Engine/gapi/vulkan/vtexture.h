@@ -5,6 +5,7 @@
 
 #include "vallocator.h"
 #include "../utility/spinlock.h"
+#include "gapi/concurrentcache.h"
 
 namespace Tempest {
 
@@ -37,17 +38,24 @@ class VTexture : public AbstractGraphicsApi::Texture {
 
   private:
     void createViews (VkDevice device);
-    void destroyViews(VkDevice device);
     void createView  (VkImageView& ret, VkDevice device, VkFormat format,
                       const ComponentMapping* cmap, uint32_t mipLevel);
 
     struct View {
       ComponentMapping m;
       uint32_t         mip = uint32_t(0);
-      VkImageView      v;
+      bool operator == (const View& v) const { return m==v.m && mip==v.mip; }
       };
-    Detail::SpinLock  syncViews;
-    std::vector<View> extViews;
+    struct ViewHash final {
+      size_t operator()(const View& v) const {
+        return size_t(v.m.r) | size_t(v.m.g)<<4 | size_t(v.m.b)<<8 | size_t(v.m.a)<<12 | size_t(v.mip)<<16;
+        }
+      };
+    using ViewCache = ConcurrentCache<View,VkImageView,ViewHash>;
+
+    // most of textures never have extra views: cache is created on demand
+    Detail::SpinLock        syncViews;
+    std::atomic<ViewCache*> extViews{nullptr};
 
     friend class VAllocator;
   };
@@ -0,0 +1,157 @@
+#if defined(TEMPEST_BUILD_VULKAN)
+
+#include "vtransfercmd.h"
+
+#include "vdevice.h"
+#include "vbuffer.h"
+#include "vtexture.h"
+
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+VTransferCmd::VTransferCmd(VDevice& device)
+  :VCommandBuffer(device,VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,device.transferQueue->family), device(device) {
+  if(!device.hasTransferQueue())
+    return;
+  acquire.reset(new VCommandBuffer(device));
+
+  VkSemaphoreCreateInfo info = {};
+  info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  vkAssert(vkCreateSemaphore(device.device.impl,&info,nullptr,&semaphore));
+  }
+
+VTransferCmd::~VTransferCmd() {
+  if(semaphore!=VK_NULL_HANDLE)
+    vkDestroySemaphore(device.device.impl,semaphore,nullptr);
+  }
+
+void VTransferCmd::reset() {
+  VCommandBuffer::reset();
+  if(acquire!=nullptr)
+    acquire->reset();
+  gfxWork = false;
+  }
+
+void VTransferCmd::begin() {
+  VCommandBuffer::begin();
+  if(acquire!=nullptr)
+    acquire->begin();
+  gfxWork = false;
+  }
+
+VCommandBuffer& VTransferCmd::graphics() {
+  if(acquire==nullptr)
+    return *this;
+  gfxWork = true;
+  return *acquire;
+  }
+
+void VTransferCmd::end() {
+  // uploads are visible to later submissions on graphics queue, in stages, that may read uploaded resources
+  VkMemoryBarrier barrier = {};
+  barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+  vkCmdPipelineBarrier(
+        graphicsImpl(),
+        VK_PIPELINE_STAGE_TRANSFER_BIT, device.uploadStages,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+
+  VCommandBuffer::end();
+  if(acquire!=nullptr)
+    acquire->end();
+  }
+
+void VTransferCmd::prepare(VTexture& tex) {
+  VkImageMemoryBarrier barrier = {};
+  barrier.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
+  barrier.newLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image                = tex.impl;
+  barrier.srcAccessMask        = 0;
+  barrier.dstAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+  barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel   = 0;
+  barrier.subresourceRange.levelCount     = tex.mipCnt;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount     = VK_REMAINING_ARRAY_LAYERS;
+
+  vkCmdPipelineBarrier(impl,
+                       VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0, 0,nullptr, 0,nullptr, 1,&barrier);
+  }
+
+void VTransferCmd::release(VBuffer& buf) {
+  if(acquire==nullptr)
+    return;
+
+  VkBufferMemoryBarrier barrier = {};
+  barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcQueueFamilyIndex = device.transferQueue->family;
+  barrier.dstQueueFamilyIndex = device.graphicsQueue->family;
+  barrier.buffer              = buf.impl;
+  barrier.offset              = 0;
+  barrier.size                = VK_WHOLE_SIZE;
+
+  // release
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = 0;
+  vkCmdPipelineBarrier(impl,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       0, 0,nullptr, 1,&barrier, 0,nullptr);
+
+  // acquire
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+  vkCmdPipelineBarrier(acquire->impl,
+                       device.uploadStages, device.uploadStages,
+                       0, 0,nullptr, 1,&barrier, 0,nullptr);
+  }
+
+void VTransferCmd::release(VTexture& tex, TextureLayout next) {
+  if(acquire==nullptr) {
+    if(next!=TextureLayout::TransferDest)
+      changeLayout(tex,TextureLayout::TransferDest,next,uint32_t(-1));
+    return;
+    }
+
+  // layout transition is part of ownership transfer: both halves must specify the same layouts
+  VkImageMemoryBarrier barrier = {};
+  barrier.sType                = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout            = nativeFormat(next);
+  barrier.srcQueueFamilyIndex  = device.transferQueue->family;
+  barrier.dstQueueFamilyIndex  = device.graphicsQueue->family;
+  barrier.image                = tex.impl;
+
+  barrier.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel   = 0;
+  barrier.subresourceRange.levelCount     = tex.mipCnt;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount     = VK_REMAINING_ARRAY_LAYERS;
+
+  // release
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = 0;
+  vkCmdPipelineBarrier(impl,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       0, 0,nullptr, 0,nullptr, 1,&barrier);
+
+  // acquire
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = (next==TextureLayout::TransferDest) ?
+                            (VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT) :
+                            VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(acquire->impl,
+                       device.uploadStages, device.uploadStages,
+                       0, 0,nullptr, 0,nullptr, 1,&barrier);
+  }
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include "vulkan_sdk.h"
+
+#include <memory>
+
+#include "vcommandbuffer.h"
+
+namespace Tempest {
+namespace Detail {
+
+class VDevice;
+class VBuffer;
+class VTexture;
+
+// Upload commands: copies are recorded on dedicated transfer queue, if device has one.
+// Everything, that needs graphics queue (queue ownership acquire, blits, updates of resources in use),
+// goes into graphics() part, which waits on semaphore. Part with acquire barriers only is postponed by VDevice,
+// until first graphics submission, that uses uploaded resources.
+class VTransferCmd : public VCommandBuffer {
+  public:
+    VTransferCmd(VDevice& device);
+    ~VTransferCmd();
+
+    using VCommandBuffer::begin;
+
+    void reset() override;
+    void begin() override;
+    void end()   override;
+
+    bool            isAsync() const { return acquire!=nullptr; }
+    // commands, recorded by caller into graphics(): such part can't be postponed
+    bool            hasGraphicsWork() const { return gfxWork; }
+    VCommandBuffer& graphics();
+    const VkCommandBuffer& graphicsImpl() const { return acquire!=nullptr ? acquire->impl : impl; }
+
+    // Undefined -> TransferDest; unlike changeLayout, valid on transfer-only queue
+    void prepare(VTexture& tex);
+    // hands over freshly uploaded resource to graphics queue
+    void release(VBuffer&  buf);
+    void release(VTexture& tex, TextureLayout next);
+
+    VkSemaphore     semaphore = VK_NULL_HANDLE;
+
+  private:
+    VDevice&                        device;
+    std::unique_ptr<VCommandBuffer> acquire;
+    bool                            gfxWork = false;
+  };
+
+}}
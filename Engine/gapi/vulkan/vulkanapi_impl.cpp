@@ -52,14 +52,18 @@ VulkanInstance::VulkanInstance(bool validation)
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
   createInfo.pApplicationInfo = &appInfo;
 
-  auto extensions = std::initializer_list<const char*>{
+  std::vector<const char*> extensions = {
     VK_EXT_DEBUG_REPORT_EXTENSION_NAME,
     VK_KHR_SURFACE_EXTENSION_NAME,
     SURFACE_EXTENSION_NAME,
     };
+  if(checkForExt(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+    hasDeviceProps2 = true;
+    extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    }
 
   createInfo.enabledExtensionCount   = static_cast<uint32_t>(extensions.size());
-  createInfo.ppEnabledExtensionNames = extensions.begin();
+  createInfo.ppEnabledExtensionNames = extensions.data();
 
   if(validation){
     createInfo.enabledLayerCount   = static_cast<uint32_t>(validationLayers.size());
@@ -116,6 +120,19 @@ const std::initializer_list<const char*>& VulkanInstance::checkValidationLayerSu
   return empty;
   }
 
+bool VulkanInstance::checkForExt(const char* name) {
+  uint32_t extCount=0;
+  vkEnumerateInstanceExtensionProperties(nullptr,&extCount,nullptr);
+
+  std::vector<VkExtensionProperties> ext(extCount);
+  vkEnumerateInstanceExtensionProperties(nullptr,&extCount,ext.data());
+
+  for(auto& i:ext)
+    if(std::strcmp(i.extensionName,name)==0)
+      return true;
+  return false;
+  }
+
 bool VulkanInstance::layerSupport(const std::vector<VkLayerProperties>& sup,
                                  const std::initializer_list<const char*> dest) {
   for(auto& i:dest) {
@@ -264,6 +281,11 @@ void VulkanInstance::getDevicePropsShort(VkPhysicalDevice physicalDevice, Tempes
   }
 
 void VulkanInstance::submit(VDevice* dev, VCommandBuffer** cmd, size_t count, VFence* doneCpu) {
+  // recorded VkBuffer of relocated buffer is released already
+  for(size_t i=0; i<count; ++i)
+    if(cmd[i]->isStale())
+      throw std::system_error(Tempest::GraphicsErrc::StaleCommandBuffer);
+
   size_t waitCnt = 0;
   for(size_t i=0; i<count; ++i) {
     for(auto& s:cmd[i]->swapchainSync) {
@@ -299,6 +321,7 @@ void VulkanInstance::submit(VDevice* dev, VCommandBuffer** cmd, size_t count, VF
   implSubmit(dev, cx, cmd, count,
              wx, flg, waitCnt,
              doneCpu);
+  dev->retireMgr().frame();
   }
 
 void VulkanInstance::implSubmit(VDevice* dx,
@@ -338,7 +361,14 @@ void VulkanInstance::implSubmit(VDevice* dx,
   if(fence!=nullptr)
     fence->reset();
 
-  dx->dataMgr().wait();
+  // uploads are ordered on GPU: by queue order and semaphore of transfer queue;
+  // postponed acquire of used uploads goes to queue first
+  dx->dataMgr().flush();
+  uint64_t upload = 0;
+  for(size_t i=0; i<count; ++i)
+    upload = std::max(upload,cmd[i]->uploadDependency());
+  if(upload!=0)
+    dx->submitAcquire(upload);
   dx->graphicsQueue->submit(1, &submitInfo, fence==nullptr ? VK_NULL_HANDLE : fence->impl);
   }
 
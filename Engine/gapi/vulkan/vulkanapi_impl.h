@@ -22,16 +22,20 @@ class VulkanInstance {
     std::vector<AbstractGraphicsApi::Props> devices() const;
 
     VkInstance       instance;
+    bool             hasDeviceProps2=false;
 
     struct VkProp:Tempest::AbstractGraphicsApi::Props {
       uint32_t graphicsFamily=uint32_t(-1);
       uint32_t presentFamily =uint32_t(-1);
+      uint32_t transferFamily=uint32_t(-1); // transfer-only family, if any
 
       size_t   nonCoherentAtomSize=0;
       size_t   bufferImageGranularity=0;
 
       bool     hasMemRq2        =false;
       bool     hasDedicatedAlloc=false;
+      bool     hasMemoryBudget  =false;
+      uint8_t  dynamicState     =0; // DynamicState::Flags, that can be set without pipeline rebind: None, or Blend with Topology
       };
 
     static void      getDeviceProps(VkPhysicalDevice physicalDevice, VkProp& c);
@@ -46,6 +50,7 @@ class VulkanInstance {
                     VkSemaphore* ws, VkPipelineStageFlags* wflg, size_t waitCnt,
                     VFence *fence);
 
+    bool checkForExt(const char* name);
     const std::initializer_list<const char*>& checkValidationLayerSupport();
     bool layerSupport(const std::vector<VkLayerProperties>& sup,const std::initializer_list<const char*> dest);
 
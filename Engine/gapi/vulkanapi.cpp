@@ -27,6 +27,8 @@
 #include <Tempest/PipelineLayout>
 #include <Tempest/Application>
 
+#include <cstring>
+
 using namespace Tempest;
 using namespace Tempest::Detail;
 
@@ -107,7 +109,8 @@ AbstractGraphicsApi::PPipeline VulkanApi::createPipeline(AbstractGraphicsApi::De
                                                          const RenderState &st, size_t stride, Topology tp,
                                                          const PipelineLay& ulayImpl,
                                                          const Shader* vs, const Shader* tc, const Shader* te,
-                                                         const Shader* gs, const Shader* fs) {
+                                                         const Shader* gs, const Shader* fs,
+                                                         const SpecializationConstants& spec) {
   auto* dx   = reinterpret_cast<Detail::VDevice*>(d);
   auto* vert = reinterpret_cast<const Detail::VShader*>(vs);
   auto* ctrl = reinterpret_cast<const Detail::VShader*>(tc);
@@ -116,21 +119,22 @@ AbstractGraphicsApi::PPipeline VulkanApi::createPipeline(AbstractGraphicsApi::De
   auto* frag = reinterpret_cast<const Detail::VShader*>(fs);
   auto& ul   = reinterpret_cast<const Detail::VPipelineLay&>(ulayImpl);
 
-  return PPipeline(new Detail::VPipeline(*dx,st,stride,tp,ul,vert,ctrl,tess,geom,frag));
+  return PPipeline(new Detail::VPipeline(*dx,st,stride,tp,ul,vert,ctrl,tess,geom,frag,spec));
   }
 
 AbstractGraphicsApi::PCompPipeline VulkanApi::createComputePipeline(AbstractGraphicsApi::Device* d,
                                                                 const AbstractGraphicsApi::PipelineLay& ulayImpl,
-                                                                AbstractGraphicsApi::Shader* shader) {
+                                                                AbstractGraphicsApi::Shader* shader,
+                                                                const SpecializationConstants& spec) {
   auto*   dx = reinterpret_cast<Detail::VDevice*>(d);
   auto&   ul = reinterpret_cast<const Detail::VPipelineLay&>(ulayImpl);
 
-  return PCompPipeline(new Detail::VCompPipeline(*dx,ul,*reinterpret_cast<Detail::VShader*>(shader)));
+  return PCompPipeline(new Detail::VCompPipeline(*dx,ul,*reinterpret_cast<Detail::VShader*>(shader),spec));
   }
 
 AbstractGraphicsApi::PShader VulkanApi::createShader(AbstractGraphicsApi::Device *d, const void* source, size_t src_size) {
   Detail::VDevice* dx=reinterpret_cast<Detail::VDevice*>(d);
-  return PShader(new Detail::VShader(*dx,source,src_size));
+  return dx->createShader(source,src_size);
   }
 
 AbstractGraphicsApi::Fence *VulkanApi::createFence(AbstractGraphicsApi::Device *d) {
@@ -143,6 +147,17 @@ AbstractGraphicsApi::PBuffer VulkanApi::createBuffer(AbstractGraphicsApi::Device
                                                      MemUsage usage, BufferHeap flg) {
   Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
 
+  const size_t bytes    = count*alignedSz;
+  const bool   geomOnly = (usage & (MemUsage::VertexBuffer|MemUsage::IndexBuffer))!=MemUsage(0) &&
+                          (usage & (MemUsage::UniformBuffer|MemUsage::StorageBuffer))==MemUsage(0);
+  if(geomOnly && bytes>0 && bytes<=VAllocator::ARENA_MAX_SIZE && flg!=BufferHeap::Readback) {
+    // small vbo/ibo: sub-range of shared buffer, to save on buffer objects and vkCmdBindVertexBuffers
+    DSharedPtr<Buffer*> pbuf(new VBuffer(dx.allocator.allocSlice(count,alignedSz,flg)));
+    if(mem!=nullptr)
+      pbuf.handler->update(mem,0,count,size,alignedSz);
+    return PBuffer(pbuf.handler);
+    }
+
   if(flg==BufferHeap::Upload) {
     VBuffer buf = dx.allocator.alloc(mem,count,size,alignedSz,usage|MemUsage::TransferSrc,BufferHeap::Upload);
     return PBuffer(new VBuffer(std::move(buf)));
@@ -153,12 +168,14 @@ AbstractGraphicsApi::PBuffer VulkanApi::createBuffer(AbstractGraphicsApi::Device
     return PBuffer(new VBuffer(std::move(buf)));
     }
 
-  VBuffer buf = dx.allocator.alloc(nullptr,count,size,alignedSz, usage|MemUsage::TransferDst|MemUsage::TransferSrc,BufferHeap::Device);
-  if(mem==nullptr)
-    return PBuffer(new VBuffer(std::move(buf)));
-
-  DSharedPtr<Buffer*> pbuf(new VBuffer(std::move(buf)));
-  pbuf.handler->update(mem,0,count,size,alignedSz);
+  VBuffer  buf  = dx.allocator.alloc(nullptr,count,size,alignedSz, usage|MemUsage::TransferDst|MemUsage::TransferSrc,BufferHeap::Device);
+  VBuffer* vbuf = new VBuffer(std::move(buf));
+  DSharedPtr<Buffer*> pbuf(vbuf);
+  // vbo/ibo handles are only taken at record time, so such buffers can be relocated by defragment
+  if((usage & (MemUsage::UniformBuffer|MemUsage::StorageBuffer))==MemUsage(0))
+    dx.allocator.setMovable(*vbuf);
+  if(mem!=nullptr)
+    vbuf->upload(mem,count,size,alignedSz);
   return PBuffer(pbuf.handler);
   }
 
@@ -166,41 +183,101 @@ AbstractGraphicsApi::PTexture VulkanApi::createTexture(AbstractGraphicsApi::Devi
   Detail::VDevice& dx     = *reinterpret_cast<Detail::VDevice*>(d);
   const uint32_t   size   = uint32_t(p.dataSize());
   VkFormat         format = Detail::nativeFormat(frm);
-  Detail::VBuffer  stage  = dx.allocator.alloc(p.data(),size,1,1,MemUsage::TransferSrc,BufferHeap::Upload);
-  Detail::VTexture buf    = dx.allocator.alloc(p,mipCnt,format);
+  Detail::VTexture buf    = dx.allocator.alloc(p.w(),p.h(),mipCnt,format);
 
-  Detail::DSharedPtr<Buffer*>  pstage(new Detail::VBuffer (std::move(stage)));
-  Detail::DSharedPtr<Texture*> pbuf  (new Detail::VTexture(std::move(buf)));
+  Detail::DSharedPtr<Buffer*>  pstage;
+  Detail::DSharedPtr<Texture*> pbuf(new Detail::VTexture(std::move(buf)));
 
-  auto cmd = dx.dataMgr().get();
-  cmd->begin();
-  cmd->hold(pstage);
-  cmd->hold(pbuf);
-
-  cmd->changeLayout(*pbuf.handler, TextureLayout::Undefined, TextureLayout::TransferDest, uint32_t(-1));
-  if(isCompressedFormat(frm)){
-    size_t blocksize  = (frm==TextureFormat::DXT1) ? 8 : 16;
-    size_t bufferSize = 0;
-
-    uint32_t w = uint32_t(p.w()), h = uint32_t(p.h());
-    for(uint32_t i=0; i<mipCnt; i++){
-      size_t blockcount = ((w+3)/4)*((h+3)/4);
-      cmd->copy(*pbuf.handler,w,h,i,*pstage.handler,bufferSize);
-
-      bufferSize += blockcount*blocksize;
-      w = std::max<uint32_t>(1,w/2);
-      h = std::max<uint32_t>(1,h/2);
+  // big images get own staging buffer, to not bloat transient ring of pooled command buffers
+  if(size>Detail::TransientHeap<Detail::VBuffer>::CHUNK_SIZE) {
+    Detail::VBuffer stage = dx.dataMgr().allocStagingMemory(p.data(),size,1,1,MemUsage::TransferSrc,BufferHeap::Upload);
+    pstage = Detail::DSharedPtr<Buffer*>(new Detail::VBuffer(std::move(stage)));
+    }
+
+  dx.dataMgr().record(nullptr,size,[&](Detail::VDevice::DataMgr::Commands& cmd) {
+    AbstractGraphicsApi::Buffer* src    = pstage.handler;
+    size_t                       offset = 0;
+    if(src==nullptr) {
+      AbstractGraphicsApi::Transient stage;
+      if(!cmd.allocTransient(size,16,stage))
+        throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
+      std::memcpy(stage.data,p.data(),size);
+      src    = stage.buf;
+      offset = stage.offset;
+      } else {
+      cmd.hold(pstage);
       }
+    cmd.hold(pbuf);
+
+    // copies go to transfer queue, mip generation needs graphics one
+    auto& tex = *reinterpret_cast<Detail::VTexture*>(pbuf.handler);
+    cmd.prepare(tex);
+    if(isCompressedFormat(frm)){
+      size_t blocksize  = (frm==TextureFormat::DXT1) ? 8 : 16;
+      size_t bufferSize = 0;
+
+      uint32_t w = uint32_t(p.w()), h = uint32_t(p.h());
+      for(uint32_t i=0; i<mipCnt; i++){
+        size_t blockcount = ((w+3)/4)*((h+3)/4);
+        cmd.copy(tex,w,h,i,*src,offset+bufferSize);
+
+        bufferSize += blockcount*blocksize;
+        w = std::max<uint32_t>(1,w/2);
+        h = std::max<uint32_t>(1,h/2);
+        }
+
+      cmd.release(tex,TextureLayout::Sampler);
+      } else {
+      cmd.copy(tex,p.w(),p.h(),0,*src,offset);
+      if(mipCnt>1) {
+        cmd.release(tex,TextureLayout::TransferDest);
+        cmd.graphics().generateMipmap(tex, TextureLayout::TransferDest, p.w(), p.h(), mipCnt);
+        } else {
+        cmd.release(tex,TextureLayout::Sampler);
+        }
+      }
+    });
 
-    cmd->changeLayout(*pbuf.handler, TextureLayout::TransferDest, TextureLayout::Sampler, uint32_t(-1));
-    } else {
-    cmd->copy(*pbuf.handler,p.w(),p.h(),0,*pstage.handler,0);
-    if(mipCnt>1)
-      cmd->generateMipmap(*pbuf.handler, TextureLayout::TransferDest, p.w(), p.h(), mipCnt); else
-      cmd->changeLayout(*pbuf.handler, TextureLayout::TransferDest, TextureLayout::Sampler, uint32_t(-1));
-    }
-  cmd->end();
-  dx.dataMgr().submit(std::move(cmd));
+  return PTexture(pbuf.handler);
+  }
+
+AbstractGraphicsApi::PBuffer VulkanApi::createStaging(AbstractGraphicsApi::Device* d,
+                                                     const uint32_t w, const uint32_t h, TextureFormat frm, size_t& stride) {
+  Detail::VDevice& dx  = *reinterpret_cast<Detail::VDevice*>(d);
+  const size_t     bpp = Pixmap::bppForFormat(Pixmap::toPixmapFormat(frm));
+  if(bpp==0 || isCompressedFormat(frm))
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
+
+  stride = w*bpp;
+  Detail::VBuffer stage = dx.dataMgr().allocStagingMemory(nullptr,h,stride,stride,MemUsage::TransferSrc,BufferHeap::Upload);
+  return PBuffer(new Detail::VBuffer(std::move(stage)));
+  }
+
+AbstractGraphicsApi::PTexture VulkanApi::createTexture(AbstractGraphicsApi::Device* d, const PBuffer& stage, size_t stride,
+                                                       const uint32_t w, const uint32_t h, uint32_t mipCnt,
+                                                       TextureFormat frm) {
+  Detail::VDevice& dx   = *reinterpret_cast<Detail::VDevice*>(d);
+  const size_t     bpp  = Pixmap::bppForFormat(Pixmap::toPixmapFormat(frm));
+  const size_t     size = stride*h;
+  Detail::VTexture buf  = dx.allocator.alloc(w,h,mipCnt,Detail::nativeFormat(frm));
+
+  Detail::DSharedPtr<Buffer*>  pstage = stage;
+  Detail::DSharedPtr<Texture*> pbuf(new Detail::VTexture(std::move(buf)));
+
+  dx.dataMgr().record(nullptr,size,[&](Detail::VDevice::DataMgr::Commands& cmd) {
+    cmd.hold(pstage);
+    cmd.hold(pbuf);
+
+    auto& tex = *reinterpret_cast<Detail::VTexture*>(pbuf.handler);
+    cmd.prepare(tex);
+    cmd.copy(tex,0,0,w,h,0,*pstage.handler,0,uint32_t(stride/bpp));
+    if(mipCnt>1) {
+      cmd.release(tex,TextureLayout::TransferDest);
+      cmd.graphics().generateMipmap(tex, TextureLayout::TransferDest, w, h, mipCnt);
+      } else {
+      cmd.release(tex,TextureLayout::Sampler);
+      }
+    });
 
   return PTexture(pbuf.handler);
   }
@@ -224,15 +301,55 @@ AbstractGraphicsApi::PTexture VulkanApi::createStorage(AbstractGraphicsApi::Devi
   Detail::VTexture buf=dx.allocator.alloc(w,h,mipCnt,frm,true);
   Detail::DSharedPtr<Texture*> pbuf(new Detail::VTexture(std::move(buf)));
 
-  auto cmd = dx.dataMgr().get();
-  cmd->begin();
-  cmd->changeLayout(*pbuf.handler,TextureLayout::Undefined,TextureLayout::Unordered,uint32_t(-1));
-  cmd->end();
-  dx.dataMgr().submit(std::move(cmd));
+  dx.dataMgr().record(nullptr,0,[&](Detail::VDevice::DataMgr::Commands& cmd) {
+    cmd.hold(pbuf);
+    cmd.graphics().changeLayout(*pbuf.handler,TextureLayout::Undefined,TextureLayout::Unordered,uint32_t(-1));
+    });
 
   return PTexture(pbuf.handler);
   }
 
+void VulkanApi::updateTexture(AbstractGraphicsApi::Device* d, const PTexture t, const Pixmap& p, TextureFormat /*frm*/,
+                              uint32_t x, uint32_t y, uint32_t mip) {
+  Detail::VDevice& dx   = *reinterpret_cast<Detail::VDevice*>(d);
+  const size_t     size = p.dataSize();
+  const size_t     bpp  = Pixmap::bppForFormat(p.format());
+
+  Detail::DSharedPtr<Buffer*>  pstage;
+  Detail::DSharedPtr<Texture*> ptex = t;
+
+  // only changed region is staged
+  if(size>Detail::TransientHeap<Detail::VBuffer>::CHUNK_SIZE) {
+    Detail::VBuffer stage = dx.dataMgr().allocStagingMemory(p.data(),size,1,1,MemUsage::TransferSrc,BufferHeap::Upload);
+    pstage = Detail::DSharedPtr<Buffer*>(new Detail::VBuffer(std::move(stage)));
+    }
+
+  dx.dataMgr().record(ptex.handler,size,[&](Detail::VDevice::DataMgr::Commands& cmd) {
+    AbstractGraphicsApi::Buffer* src    = pstage.handler;
+    size_t                       offset = 0;
+    if(src==nullptr) {
+      AbstractGraphicsApi::Transient stage;
+      // bufferOffset must be multiple of both texel size and 4
+      if(!cmd.allocTransient(size,4*bpp,stage))
+        throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
+      std::memcpy(stage.data,p.data(),size);
+      src    = stage.buf;
+      offset = stage.offset;
+      } else {
+      cmd.hold(pstage);
+      }
+    cmd.hold(ptex);
+
+    // texture is owned by graphics queue and can be sampled by frames in flight: copy goes there,
+    // with barriers around the updated mip only
+    auto& tex = *reinterpret_cast<Detail::VTexture*>(ptex.handler);
+    auto& gfx = cmd.graphics();
+    gfx.changeLayout(tex,TextureLayout::Sampler,TextureLayout::TransferDest,mip);
+    gfx.copy(tex,x,y,p.w(),p.h(),mip,*src,offset,0);
+    gfx.changeLayout(tex,TextureLayout::TransferDest,TextureLayout::Sampler,mip);
+    });
+  }
+
 void VulkanApi::readPixels(AbstractGraphicsApi::Device *d, Pixmap& out, const PTexture t,
                            TextureLayout lay, TextureFormat frm,
                            const uint32_t w, const uint32_t h, uint32_t mip) {
@@ -249,7 +366,7 @@ void VulkanApi::readPixels(AbstractGraphicsApi::Device *d, Pixmap& out, const PT
 
   auto cmd = dx.dataMgr().get();
   cmd->begin();
-  cmd->copy(stage,lay, w,h,mip,tx,0);
+  cmd->graphics().copy(stage,lay, w,h,mip,tx,0);
   cmd->end();
 
   dx.dataMgr().waitFor(&tx);
@@ -259,6 +376,29 @@ void VulkanApi::readPixels(AbstractGraphicsApi::Device *d, Pixmap& out, const PT
   stage.read(out.data(),0,size);
   }
 
+AbstractGraphicsApi::Readback* VulkanApi::readPixelsAsync(AbstractGraphicsApi::Device* d, const PTexture t,
+                                                         TextureLayout lay, TextureFormat frm,
+                                                         const uint32_t w, const uint32_t h, uint32_t mip) {
+  Detail::VDevice&  dx = *reinterpret_cast<Detail::VDevice*>(d);
+  Detail::VTexture& tx = *reinterpret_cast<Detail::VTexture*>(t.handler);
+
+  Pixmap::Format  pfrm = Pixmap::toPixmapFormat(frm);
+  size_t          bpp  = Pixmap::bppForFormat(pfrm);
+  if(bpp==0)
+    throw std::runtime_error("not implemented");
+
+  // bufferOffset must be multiple of 4 and of texel size
+  const size_t row = w*bpp;
+  std::unique_ptr<Detail::VDevice::Readback> ret(new Detail::VDevice::Readback(dx,row,row,h,4*bpp));
+
+  PTexture pt  = t;
+  auto&    cmd = ret->commands();
+  cmd.hold(pt);
+  cmd.graphics().copy(ret->staging(),lay,w,h,mip,tx,ret->offset());
+  ret->submit();
+  return ret.release();
+  }
+
 void VulkanApi::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buffer* buf, void* out, size_t size) {
   Detail::VBuffer&  bx = *reinterpret_cast<Detail::VBuffer*>(buf);
   bx.read(out,0,size);
@@ -267,7 +407,7 @@ void VulkanApi::readBytes(AbstractGraphicsApi::Device*, AbstractGraphicsApi::Buf
 AbstractGraphicsApi::Desc* VulkanApi::createDescriptors(AbstractGraphicsApi::Device* d, PipelineLay& ulayImpl) {
   auto* dx = reinterpret_cast<Detail::VDevice*>(d);
   auto& ul = reinterpret_cast<Detail::VPipelineLay&>(ulayImpl);
-  return new Detail::VDescriptorArray(dx->device.impl,ul);
+  return new Detail::VDescriptorArray(*dx,ul);
   }
 
 AbstractGraphicsApi::PPipelineLay VulkanApi::createPipelineLayout(Device *d,
@@ -315,6 +455,62 @@ void VulkanApi::submit(AbstractGraphicsApi::Device *d, AbstractGraphicsApi::Comm
   impl->submit(dx,reinterpret_cast<VCommandBuffer**>(cmd),count,rc);
   }
 
+size_t VulkanApi::defragment(AbstractGraphicsApi::Device* d, size_t byteBudget, size_t moveBudget) {
+  Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
+  return dx.allocator.defragment(byteBudget,moveBudget);
+  }
+
+void VulkanApi::memoryStats(AbstractGraphicsApi::Device* d, MemoryStats& out) {
+  Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
+  dx.allocator.stats(out);
+
+  auto rt = dx.retireMgr().stats();
+  out.pendingRelease = rt.bytes;
+  out.pendingObjects = rt.objects;
+  }
+
+void VulkanApi::setMemoryBudgetCallback(AbstractGraphicsApi::Device* d, float fraction, MemoryBudgetCallback fn) {
+  Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
+  dx.allocator.setBudgetCallback(fraction,std::move(fn));
+  }
+
+void VulkanApi::setPageCacheSize(AbstractGraphicsApi::Device* d, size_t bytes) {
+  Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
+  dx.allocator.setPageCacheSize(bytes);
+  }
+
+void VulkanApi::trimPageCache(AbstractGraphicsApi::Device* d, size_t keepBytes) {
+  Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
+  dx.allocator.trimPageCache(keepBytes);
+  }
+
+void VulkanApi::setPipelineCacheDir(AbstractGraphicsApi::Device* d, const char* dir) {
+  Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
+  dx.setPipelineCacheDir(dir);
+  }
+
+void VulkanApi::savePipelineCache(AbstractGraphicsApi::Device* d) {
+  Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
+  dx.savePipelineCache();
+  }
+
+void VulkanApi::pipelineCacheStats(AbstractGraphicsApi::Device* d, PipelineCacheStats& out) {
+  Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
+  dx.pipelineCacheStats(out);
+  }
+
+void VulkanApi::prewarm(AbstractGraphicsApi::Device* d, Pipeline* p, FboLayout** lay, size_t count) {
+  Detail::VDevice&   dx = *reinterpret_cast<Detail::VDevice*>(d);
+  Detail::VPipeline& px = *reinterpret_cast<Detail::VPipeline*>(p);
+  for(size_t i=0; i<count; ++i)
+    px.prewarm(*reinterpret_cast<Detail::VFramebufferLayout*>(lay[i]),dx.compiler());
+  }
+
+void VulkanApi::setAsyncPipelines(AbstractGraphicsApi::Device* d, bool async) {
+  Detail::VDevice& dx = *reinterpret_cast<Detail::VDevice*>(d);
+  dx.asyncPipelines = async;
+  }
+
 void VulkanApi::getCaps(Device *d, Props& props) {
   Detail::VDevice* dx=reinterpret_cast<Detail::VDevice*>(d);
   props=dx->props;
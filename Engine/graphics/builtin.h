@@ -16,6 +16,8 @@ class Builtin final {
     Builtin(Device& owner);
 
   public:
+    // variants differ only in blend mode and topology: with dynamic state support (Vulkan), backend compiles
+    // one native pipeline per texture/empty pair and switches blend and topology by commands, instead of rebinding
     struct Item {
       Tempest::RenderPipeline pen;
       Tempest::RenderPipeline brush;
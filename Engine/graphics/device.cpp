@@ -7,6 +7,8 @@
 #include <Tempest/Pixmap>
 #include <Tempest/Except>
 
+#include "formats/pixmapcodec.h"
+
 #include <mutex>
 
 using namespace Tempest;
@@ -177,6 +179,127 @@ Texture2d Device::loadTexture(const Pixmap &pm, bool mips) {
   return t;
   }
 
+Texture2d Device::loadTexture(IDevice& input, bool mips) {
+  StagedImage img;
+  decodeTexture(input,img);
+  return loadTexture(img,mips);
+  }
+
+void Device::decodeTexture(IDevice& input, StagedImage& out) {
+  struct Sink : PixmapCodec::Sink {
+    explicit Sink(Device& owner):owner(owner) {}
+
+    uint8_t* begin(uint32_t w, uint32_t h, Pixmap::Format& frm, size_t& stride) override {
+      auto& props = owner.devProps;
+      if(w>props.tex2d.maxSize || h>props.tex2d.maxSize)
+        throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
+
+      TextureFormat format = Pixmap::toTextureFormat(frm);
+      if(!props.hasSamplerFormat(format)) {
+        // same widening as in loadTexture(Pixmap), but done by codec while writing rows
+        if(format==TextureFormat::RGB8){
+          frm    = Pixmap::Format::RGBA;
+          format = TextureFormat::RGBA8;
+          }
+        else if(format==TextureFormat::RGB16){
+          frm    = Pixmap::Format::RGBA16;
+          format = TextureFormat::RGBA16;
+          }
+        else if(format==TextureFormat::RGB32F){
+          frm    = Pixmap::Format::RGBA32F;
+          format = TextureFormat::RGBA32F;
+          }
+        else {
+          throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
+          }
+        }
+
+      this->w      = w;
+      this->h      = h;
+      this->format = format;
+      stage = owner.api.createStaging(owner.dev,w,h,format,stride);
+      this->stride = stride;
+      auto* ret = reinterpret_cast<uint8_t*>(stage.handler->map());
+      if(ret==nullptr)
+        throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
+      return ret;
+      }
+
+    Device&                      owner;
+    AbstractGraphicsApi::PBuffer stage;
+    uint32_t                     w = 0, h = 0;
+    size_t                       stride = 0;
+    TextureFormat                format = TextureFormat::Undefined;
+    };
+
+  Sink sink(*this);
+  if(!PixmapCodec::decodeImg(input,sink)) {
+    // block-compressed images: keep baked mips, or decompress on cpu
+    out.pm = Pixmap(input);
+    return;
+    }
+  sink.stage.handler->unmap();
+
+  out.stage  = std::move(sink.stage);
+  out.w      = sink.w;
+  out.h      = sink.h;
+  out.stride = sink.stride;
+  out.format = sink.format;
+  }
+
+Texture2d Device::loadTexture(StagedImage& img, bool mips) {
+  if(img.stage.handler==nullptr)
+    return loadTexture(img.pm,mips);
+  uint32_t  mipCnt = mips ? mipCount(img.w,img.h) : 1;
+  Texture2d t(*this,api.createTexture(dev,img.stage,img.stride,img.w,img.h,mipCnt,img.format),img.w,img.h,img.format);
+  return t;
+  }
+
+Texture2d Device::loadTexture(const char* path, bool mips) {
+  Tempest::RFile file(path);
+  return loadTexture(file,mips);
+  }
+
+void Device::updateTexture(Texture2d& t, const Pixmap& pm, uint32_t x, uint32_t y, uint32_t mip) {
+  if(pm.isEmpty())
+    return;
+  TextureFormat format = Pixmap::toTextureFormat(pm.format());
+  const Pixmap* p=&pm;
+  Pixmap        alt;
+
+  uint32_t w = uint32_t(t.w()), h = uint32_t(t.h());
+  for(uint32_t i=0; i<mip; ++i) {
+    w = std::max<uint32_t>(1,w/2);
+    h = std::max<uint32_t>(1,h/2);
+    }
+  if(mip>=t.mipCount() || pm.w()>w || x>w-pm.w() || pm.h()>h || y>h-pm.h())
+    throw std::system_error(Tempest::GraphicsErrc::InvalidTexture);
+
+  if(isCompressedFormat(format) || isCompressedFormat(t.format()))
+    throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
+
+  if(format!=t.format()) {
+    // same widening as in loadTexture
+    if(format==TextureFormat::RGB8 && t.format()==TextureFormat::RGBA8){
+      alt = Pixmap(pm,Pixmap::Format::RGBA);
+      p   = &alt;
+      }
+    else if(format==TextureFormat::RGB16 && t.format()==TextureFormat::RGBA16){
+      alt = Pixmap(pm,Pixmap::Format::RGBA16);
+      p   = &alt;
+      }
+    else if(format==TextureFormat::RGB32F && t.format()==TextureFormat::RGBA32F){
+      alt = Pixmap(pm,Pixmap::Format::RGBA32F);
+      p   = &alt;
+      }
+    else {
+      throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
+      }
+    }
+
+  api.updateTexture(dev,t.impl,*p,t.format(),x,y,mip);
+  }
+
 StorageImage Device::image2d(TextureFormat frm, const uint32_t w, const uint32_t h, const bool mips) {
   if(!devProps.hasStorageFormat(frm))
     throw std::system_error(Tempest::GraphicsErrc::UnsupportedTextureFormat);
@@ -222,6 +345,97 @@ void Device::readBytes(const StorageBuffer& ssbo, void* out, size_t size) {
   api.readBytes(dev,ssbo.impl.impl.handler,out,size);
   }
 
+Readback Device::readPixelsAsync(const Texture2d& t, uint32_t mip) {
+  const uint32_t w = uint32_t(t.w());
+  const uint32_t h = uint32_t(t.h());
+  auto r = api.readPixelsAsync(dev,t.impl,TextureLayout::Sampler,t.format(),w,h,mip);
+  return Readback(r,w,h,Pixmap::toPixmapFormat(t.format()));
+  }
+
+Readback Device::readPixelsAsync(const Attachment& t, uint32_t mip) {
+  auto& tx = textureCast(t);
+  uint32_t w = t.w();
+  uint32_t h = t.h();
+  for(uint32_t i=0; i<mip; ++i) {
+    w = (w==1 ? 1 : w/2);
+    h = (h==1 ? 1 : h/2);
+    }
+  auto r = api.readPixelsAsync(dev,tx.impl,TextureLayout::Sampler,tx.format(),w,h,mip);
+  return Readback(r,w,h,Pixmap::toPixmapFormat(tx.format()));
+  }
+
+Readback Device::readPixelsAsync(const StorageImage& t, uint32_t mip) {
+  uint32_t w = t.w();
+  uint32_t h = t.h();
+  for(uint32_t i=0; i<mip; ++i) {
+    w = (w==1 ? 1 : w/2);
+    h = (h==1 ? 1 : h/2);
+    }
+  auto r = api.readPixelsAsync(dev,t.impl,TextureLayout::Unordered,t.format(),w,h,mip);
+  return Readback(r,w,h,Pixmap::toPixmapFormat(t.format()));
+  }
+
+size_t Device::defragment(size_t byteBudget, size_t moveBudget) {
+  return api.defragment(dev,byteBudget,moveBudget);
+  }
+
+Device::MemoryStats Device::memoryStats() const {
+  MemoryStats st;
+  api.memoryStats(dev,st);
+  return st;
+  }
+
+void Device::setMemoryBudgetCallback(float fraction, std::function<void(const MemoryStats&)> fn) {
+  api.setMemoryBudgetCallback(dev,fraction,std::move(fn));
+  }
+
+void Device::setPageCacheSize(size_t bytes) {
+  api.setPageCacheSize(dev,bytes);
+  }
+
+void Device::trimPageCache(size_t keepBytes) {
+  api.trimPageCache(dev,keepBytes);
+  }
+
+void Device::setPipelineCacheDir(const char* dir) {
+  api.setPipelineCacheDir(dev,dir);
+  }
+
+void Device::savePipelineCache() {
+  api.savePipelineCache(dev);
+  }
+
+Device::PipelineCacheStats Device::pipelineCacheStats() const {
+  PipelineCacheStats st;
+  api.pipelineCacheStats(dev,st);
+  return st;
+  }
+
+void Device::prewarm(const RenderPipeline& pso, const FrameBufferLayout* lay, size_t count) {
+  if(pso.isEmpty())
+    return;
+  std::vector<AbstractGraphicsApi::FboLayout*> fbo(count);
+  for(size_t i=0; i<count; ++i)
+    fbo[i] = lay[i].impl.handler;
+  api.prewarm(dev,pso.impl.handler,fbo.data(),count);
+  }
+
+void Device::prewarm(const Builtin& b, const FrameBufferLayout* lay, size_t count) {
+  const Builtin::Item* items[] = {&b.texture2d(), &b.empty()};
+  for(auto i:items) {
+    prewarm(i->pen,   lay,count);
+    prewarm(i->brush, lay,count);
+    prewarm(i->penB,  lay,count);
+    prewarm(i->brushB,lay,count);
+    prewarm(i->penA,  lay,count);
+    prewarm(i->brushA,lay,count);
+    }
+  }
+
+void Device::setAsyncPipelines(bool async) {
+  api.setAsyncPipelines(dev,async);
+  }
+
 TextureFormat Device::formatOf(const Attachment& a) {
   if(a.sImpl.swapchain!=nullptr)
     return TextureFormat::Undefined;
@@ -347,11 +561,15 @@ Fence Device::fence() {
   }
 
 ComputePipeline Device::pipeline(const Shader& comp) {
+  return pipeline(comp,SpecializationConstants());
+  }
+
+ComputePipeline Device::pipeline(const Shader& comp, const SpecializationConstants& spec) {
   if(!comp.impl)
     return ComputePipeline();
 
   auto ulay = api.createPipelineLayout(dev,nullptr,nullptr,nullptr,nullptr,nullptr,comp.impl.handler);
-  auto pipe = api.createComputePipeline(dev,*ulay.handler,comp.impl.handler);
+  auto pipe = api.createComputePipeline(dev,*ulay.handler,comp.impl.handler,spec);
   ComputePipeline f(std::move(pipe),std::move(ulay));
   return f;
   }
@@ -359,7 +577,8 @@ ComputePipeline Device::pipeline(const Shader& comp) {
 RenderPipeline Device::implPipeline(const RenderState &st,
                                     const Shader* sh[],
                                     size_t   stride,
-                                    Topology tp) {
+                                    Topology tp,
+                                    const SpecializationConstants& spec) {
   if(sh[0]==nullptr || sh[4]==nullptr)
     return RenderPipeline();
   if(!sh[0]->impl || !sh[4]->impl)
@@ -370,7 +589,7 @@ RenderPipeline Device::implPipeline(const RenderState &st,
     shv[i] = sh[i]!=nullptr ? sh[i]->impl.handler : nullptr;
 
   auto ulay = api.createPipelineLayout(dev,shv[0],shv[1],shv[2],shv[3],shv[4],nullptr);
-  auto pipe = api.createPipeline(dev,st,stride,tp,*ulay.handler,shv[0],shv[1],shv[2],shv[3],shv[4]);
+  auto pipe = api.createPipeline(dev,st,stride,tp,*ulay.handler,shv[0],shv[1],shv[2],shv[3],shv[4],spec);
   RenderPipeline f(std::move(pipe),std::move(ulay));
   return f;
   }
@@ -19,6 +19,7 @@
 #include <Tempest/Swapchain>
 #include <Tempest/UniformBuffer>
 #include <Tempest/Except>
+#include <Tempest/Readback>
 
 #include "videobuffer.h"
 
@@ -31,6 +32,7 @@ class Fence;
 
 class CommandPool;
 class RFile;
+class IDevice;
 
 class VideoBuffer;
 class Pixmap;
@@ -41,9 +43,15 @@ class PipelineLayout;
 class Color;
 class RenderState;
 
+// Thread-safety: vbo, ibo, ubo, ssbo, loadTexture, updateTexture, attachment, zbuffer, image2d, descriptors and updates of buffers
+// can be called from any thread; uploads of each thread are recorded into own transfer batch.
+// Writes into the same resource from different threads have to be ordered by caller.
+// submit, present, waitIdle and defragment are render thread calls: they must not run concurrently with each other.
 class Device {
   public:
     using Props=AbstractGraphicsApi::Props;
+    using MemoryStats=AbstractGraphicsApi::MemoryStats;
+    using PipelineCacheStats=AbstractGraphicsApi::PipelineCacheStats;
 
     Device(AbstractGraphicsApi& api);
     Device(AbstractGraphicsApi& api, const char* name);
@@ -131,6 +139,12 @@ class Device {
     Attachment           attachment (TextureFormat frm, const uint32_t w, const uint32_t h, const bool mips = false);
     ZBuffer              zbuffer    (TextureFormat frm, const uint32_t w, const uint32_t h);
     Texture2d            loadTexture(const Pixmap& pm,bool mips=true);
+    // decodes image straight into staging memory, without intermediate Pixmap
+    Texture2d            loadTexture(IDevice& input,bool mips=true);
+    Texture2d            loadTexture(const char* path,bool mips=true);
+
+    // Uploads pm into region at (x,y) of mip level; other texels are kept. Lower mips are not regenerated.
+    void                 updateTexture(Texture2d& t, const Pixmap& pm, uint32_t x=0, uint32_t y=0, uint32_t mip=0);
 
     StorageImage         image2d    (TextureFormat frm, const uint32_t w, const uint32_t h, const bool mips=false);
 
@@ -139,6 +153,42 @@ class Device {
     Pixmap               readPixels (const StorageImage& t, uint32_t mip=0);
     void                 readBytes  (const StorageBuffer& ssbo, void* out, size_t size);
 
+    // Records copy to persistent readback memory and returns at once; result can be taken few frames later
+    Readback             readPixelsAsync(const Texture2d&    t, uint32_t mip=0);
+    Readback             readPixelsAsync(const Attachment&   t, uint32_t mip=0);
+    Readback             readPixelsAsync(const StorageImage& t, uint32_t mip=0);
+
+    // Moves up to byteBudget bytes in up to moveBudget vertex/index buffers out of sparse memory pages, so that emptied pages
+    // are released. Copies are queued without CPU wait; old memory is released, once frames in flight are complete.
+    // Intended to be called once per frame. Command buffers, that use vertex/index buffers and were recorded before the call,
+    // must be submitted before it and not resubmitted after: record them again. Vulkan detects it, submit throws StaleCommandBuffer.
+    size_t               defragment (size_t byteBudget, size_t moveBudget = 64);
+
+    MemoryStats          memoryStats() const;
+    // fn is called, once usage of some heap crosses fraction of its budget
+    void                 setMemoryBudgetCallback(float fraction, std::function<void(const MemoryStats&)> fn);
+
+    // Freed memory pages are kept for reuse, up to given amount of bytes
+    void                 setPageCacheSize(size_t bytes);
+    // Releases cached pages back to driver; useful on level transitions
+    void                 trimPageCache(size_t keepBytes=0);
+
+    // Compiled pipelines and shader reflection are stored in dir and reused by next runs, if gpu and driver are the same.
+    // DirectX12 and Metal store HLSL/MSL translation of shaders: see Tools/shadertranslate to prepare it offline.
+    // Call before any shader or pipeline is created; damaged or outdated files are ignored
+    void                 setPipelineCacheDir(const char* dir);
+    // Writes pipeline cache now; same is done on Device destruction
+    void                 savePipelineCache();
+    // What was reused from files of setPipelineCacheDir
+    PipelineCacheStats   pipelineCacheStats() const;
+
+    // Compiles pso for given framebuffer layouts ahead of first draw; Vulkan does it on worker threads
+    void                 prewarm(const RenderPipeline& pso, const FrameBufferLayout* lay, size_t count);
+    // Same, for all 2d pipelines of builtin(), used by Painter
+    void                 prewarm(const Builtin& b, const FrameBufferLayout* lay, size_t count);
+    // Encoder::setPipeline doesn't wait for compilation: draws are skipped, until pipeline is ready
+    void                 setAsyncPipelines(bool async);
+
     FrameBuffer          frameBuffer(Attachment& out);
     FrameBuffer          frameBuffer(Attachment& out, ZBuffer& zbuf);
     FrameBuffer          frameBuffer(Attachment& out0, Attachment& out1, ZBuffer& zbuf);
@@ -161,6 +211,18 @@ class Device {
 
     ComputePipeline      pipeline(const Shader &comp);
 
+    // Variant of shaders with specialization constants: every constant set is a separate pipeline,
+    // with own compiled instances, while shader modules are shared
+    template<class Vertex>
+    RenderPipeline       pipeline(Topology tp,const RenderState& st, const Shader &vs, const Shader &fs,
+                                  const SpecializationConstants& spec);
+
+    template<class Vertex>
+    RenderPipeline       pipeline(Topology tp,const RenderState& st, const Shader &vs, const Shader &tc, const Shader &te, const Shader &fs,
+                                  const SpecializationConstants& spec);
+
+    ComputePipeline      pipeline(const Shader &comp, const SpecializationConstants& spec);
+
     Fence                fence();
     CommandBuffer        commandBuffer();
 
@@ -186,12 +248,23 @@ class Device {
 
     RenderPipeline
                 implPipeline(const RenderState &st, const Shader* shaders[],
-                             size_t stride, Topology tp);
+                             size_t stride, Topology tp, const SpecializationConstants& spec);
     void        implSubmit(const Tempest::CommandBuffer *cmd[], AbstractGraphicsApi::CommandBuffer* hcmd[],  size_t count,
                            AbstractGraphicsApi::Fence*  fdone);
 
     static TextureFormat formatOf(const Attachment& a);
 
+    // loadTexture(IDevice&) in two steps: TextureStreamer decodes on worker threads and records uploads within frame budget
+    struct StagedImage {
+      AbstractGraphicsApi::PBuffer stage;
+      uint32_t                     w = 0, h = 0;
+      size_t                       stride = 0;
+      TextureFormat                format = TextureFormat::Undefined;
+      Pixmap                       pm; // not decoded into staging: block-compressed images
+      };
+    void        decodeTexture(IDevice& input, StagedImage& out);
+    Texture2d   loadTexture(StagedImage& img, bool mips);
+
   friend class RenderPipeline;
   friend class RenderPass;
   friend class FrameBuffer;
@@ -203,6 +276,7 @@ class Device {
   friend class DescriptorSet;
 
   friend class Texture2d;
+  friend class TextureStreamer;
   };
 
 template<class T>
@@ -250,13 +324,27 @@ inline UniformBuffer<T> Device::ubo(BufferHeap ht, const T *mem, size_t size) {
 template<class Vertex>
 RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &fs) {
   const Shader* sh[] = {&vs,nullptr,nullptr,nullptr,&fs};
-  return implPipeline(st,sh,sizeof(Vertex),tp);
+  return implPipeline(st,sh,sizeof(Vertex),tp,SpecializationConstants());
   }
 
 template<class Vertex>
 RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &tc, const Shader &te, const Shader &fs) {
   const Shader* sh[] = {&vs,&tc,&te,nullptr,&fs};
-  return implPipeline(st,sh,sizeof(Vertex),tp);
+  return implPipeline(st,sh,sizeof(Vertex),tp,SpecializationConstants());
+  }
+
+template<class Vertex>
+RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &fs,
+                                const SpecializationConstants& spec) {
+  const Shader* sh[] = {&vs,nullptr,nullptr,nullptr,&fs};
+  return implPipeline(st,sh,sizeof(Vertex),tp,spec);
+  }
+
+template<class Vertex>
+RenderPipeline Device::pipeline(Topology tp, const RenderState &st, const Shader &vs, const Shader &tc, const Shader &te, const Shader &fs,
+                                const SpecializationConstants& spec) {
+  const Shader* sh[] = {&vs,&tc,&te,nullptr,&fs};
+  return implPipeline(st,sh,sizeof(Vertex),tp,spec);
   }
 
 }
@@ -5,6 +5,8 @@
 #include <Tempest/RenderPass>
 #include <Tempest/Texture2d>
 
+#include <cstring>
+
 using namespace Tempest;
 
 static uint32_t mipCount(uint32_t w, uint32_t h) {
@@ -123,6 +125,35 @@ void Encoder<Tempest::CommandBuffer>::implDraw(const VideoBuffer &vbo, const Vid
   impl->drawIndexed(*vbo.impl.handler,*ibo.impl.handler,index,offset,size,0,firstInstance,instanceCount);
   }
 
+void Encoder<Tempest::CommandBuffer>::implDraw(const void* vbo, size_t stride, size_t count) {
+  if(curPass.fbo==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
+  if(count==0)
+    return;
+  AbstractGraphicsApi::Transient v;
+  implTransient(vbo,stride*count,stride,v);
+  impl->draw(*v.buf,v.offset/stride,count,0,1);
+  }
+
+void Encoder<Tempest::CommandBuffer>::implDraw(const void* vbo, size_t stride, size_t vcount,
+                                               const void* ibo, Detail::IndexClass index, size_t isize, size_t icount) {
+  if(curPass.fbo==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::DrawCallWithoutFbo);
+  if(vcount==0 || icount==0)
+    return;
+  AbstractGraphicsApi::Transient v, i;
+  implTransient(vbo,stride*vcount,stride,v);
+  implTransient(ibo,isize*icount,isize,i);
+  impl->drawIndexed(*v.buf,*i.buf,index,i.offset/isize,icount,v.offset/stride,0,1);
+  }
+
+void Encoder<Tempest::CommandBuffer>::implTransient(const void* data, size_t size, size_t align,
+                                                    AbstractGraphicsApi::Transient& out) {
+  if(!impl->allocTransient(size,align,out))
+    throw std::system_error(Tempest::GraphicsErrc::OutOfHostMemory);
+  std::memcpy(out.data,data,size);
+  }
+
 void Encoder<CommandBuffer>::dispatch(size_t x, size_t y, size_t z) {
   if(curPass.fbo!=nullptr)
     throw std::system_error(Tempest::GraphicsErrc::ComputeCallInRenderPass);
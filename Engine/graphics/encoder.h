@@ -69,6 +69,14 @@ class Encoder<Tempest::CommandBuffer> {
     void draw(const VertexBuffer<T>& vbo,const IndexBuffer<I>& ibo,size_t offset,size_t count,size_t firstInstance,size_t instanceCount)
          { implDraw(vbo.impl,ibo.impl,Detail::indexCls<I>(),offset,count,firstInstance,instanceCount); }
 
+    // immediate-mode geometry: data is copied into per-frame transient memory of the command buffer
+    template<class T>
+    void draw(const T* vbo, size_t count) { implDraw(vbo,sizeof(T),count); }
+
+    template<class T,class I>
+    void draw(const T* vbo, size_t vcount, const I* ibo, size_t icount)
+         { implDraw(vbo,sizeof(T),vcount,ibo,Detail::indexCls<I>(),sizeof(I),icount); }
+
     void dispatch(size_t x, size_t y, size_t z);
 
     void copy(const Attachment& src, uint32_t mip, StorageBuffer& dest, size_t offset);
@@ -97,6 +105,10 @@ class Encoder<Tempest::CommandBuffer> {
     void         implDraw(const VideoBuffer& vbo, size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
     void         implDraw(const VideoBuffer &vbo, const VideoBuffer &ibo, Detail::IndexClass index,
                           size_t offset, size_t size, size_t firstInstance, size_t instanceCount);
+    void         implDraw(const void* vbo, size_t stride, size_t count);
+    void         implDraw(const void* vbo, size_t stride, size_t vcount,
+                          const void* ibo, Detail::IndexClass index, size_t isize, size_t icount);
+    void         implTransient(const void* data, size_t size, size_t align, AbstractGraphicsApi::Transient& out);
 
   friend class CommandBuffer;
   };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include "../utility/dptr.h"
+
+namespace Tempest {
+
+class VideoBuffer;
+
+// writable view of a persistently mapped host-visible buffer; unmaps (flushes) in destructor
+template<class T>
+class MappedSpan final {
+  public:
+    MappedSpan()=default;
+    MappedSpan(MappedSpan&& other):buf(std::move(other.buf)),ptr(other.ptr),count(other.count) {
+      other.ptr   = nullptr;
+      other.count = 0;
+      }
+    ~MappedSpan() {
+      if(buf)
+        buf.handler->unmap();
+      }
+
+    MappedSpan& operator=(MappedSpan&& other) {
+      std::swap(buf,  other.buf);
+      std::swap(ptr,  other.ptr);
+      std::swap(count,other.count);
+      return *this;
+      }
+
+    T*       data()        { return ptr;   }
+    const T* data()  const { return ptr;   }
+    size_t   size()  const { return count; }
+
+    T*       begin()       { return ptr;       }
+    T*       end()         { return ptr+count; }
+    const T* begin() const { return ptr;       }
+    const T* end()   const { return ptr+count; }
+
+    T&       operator[](size_t i)       { return ptr[i]; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+
+  private:
+    MappedSpan(const Detail::DSharedPtr<AbstractGraphicsApi::Buffer*>& buf, void* ptr, size_t count)
+      :buf(buf),ptr(reinterpret_cast<T*>(ptr)),count(count) {
+      }
+
+    Detail::DSharedPtr<AbstractGraphicsApi::Buffer*> buf;
+    T*                                               ptr  =nullptr;
+    size_t                                           count=0;
+
+  friend class Tempest::VideoBuffer;
+  };
+
+}
@@ -0,0 +1,58 @@
+#include "readback.h"
+
+#include <Tempest/Except>
+#include <utility>
+
+using namespace Tempest;
+
+Readback::Readback(AbstractGraphicsApi::Readback* impl, size_t size)
+  :impl(impl), sz(size) {
+  }
+
+Readback::Readback(AbstractGraphicsApi::Readback* impl, uint32_t w, uint32_t h, Pixmap::Format frm)
+  :impl(impl), sz(w*h*Pixmap::bppForFormat(frm)), w(w), h(h), frm(frm) {
+  }
+
+Readback::Readback(Readback&& other)
+  :impl(std::move(other.impl)), sz(other.sz), w(other.w), h(other.h), frm(other.frm) {
+  other.sz = 0;
+  other.w  = 0;
+  other.h  = 0;
+  }
+
+Readback::~Readback() {
+  delete impl.handler;
+  }
+
+Readback& Readback::operator =(Readback&& other) {
+  std::swap(impl,other.impl);
+  std::swap(sz,  other.sz);
+  std::swap(w,   other.w);
+  std::swap(h,   other.h);
+  std::swap(frm, other.frm);
+  return *this;
+  }
+
+bool Readback::isReady() const {
+  if(!impl)
+    return true;
+  return impl.handler->isReady();
+  }
+
+void Readback::wait() {
+  if(impl)
+    impl.handler->wait();
+  }
+
+void Readback::read(void* out) {
+  if(impl)
+    impl.handler->read(out);
+  }
+
+Pixmap Readback::pixmap() {
+  if(!impl || w==0 || h==0)
+    return Pixmap();
+  Pixmap pm(w,h,frm);
+  impl.handler->read(pm.data());
+  return pm;
+  }
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Tempest/AbstractGraphicsApi>
+#include <Tempest/Pixmap>
+#include "../utility/dptr.h"
+
+namespace Tempest {
+
+class Device;
+class VideoBuffer;
+
+//! result of asynchronous GPU to CPU copy; can be polled each frame and read, once ready, without stalling the GPU
+class Readback final {
+  public:
+    Readback()=default;
+    Readback(Readback&& other);
+    ~Readback();
+    Readback& operator = (Readback&& other);
+
+    bool   isEmpty() const { return !impl; }
+    size_t size()    const { return sz;     }
+
+    bool   isReady() const;
+    void   wait();
+
+    // copies size() bytes to out; blocks, if copy is not complete yet
+    void   read(void* out);
+    // image, requested by Device::readPixelsAsync; blocks, if copy is not complete yet
+    Pixmap pixmap();
+
+  private:
+    Readback(AbstractGraphicsApi::Readback* impl, size_t size);
+    Readback(AbstractGraphicsApi::Readback* impl, uint32_t w, uint32_t h, Pixmap::Format frm);
+
+    Detail::DPtr<AbstractGraphicsApi::Readback*> impl;
+    size_t                                       sz  = 0;
+    uint32_t                                     w   = 0;
+    uint32_t                                     h   = 0;
+    Pixmap::Format                               frm = Pixmap::Format::RGBA;
+
+  friend class Tempest::Device;
+  friend class Tempest::VideoBuffer;
+  };
+
+}
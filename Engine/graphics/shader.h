@@ -15,6 +15,9 @@ class Shader final {
     Shader& operator=(Shader&&)=default;
 
     bool isEmpty() const { return impl.handler==nullptr; }
+    // same module: identical SPIR-V, loaded by one device, is shared
+    bool operator == (const Shader& s) const { return impl.handler==s.impl.handler; }
+    bool operator != (const Shader& s) const { return impl.handler!=s.impl.handler; }
 
   private:
     Shader(Tempest::Device& dev,Detail::DSharedPtr<AbstractGraphicsApi::Shader*>&& impl);
@@ -16,6 +16,13 @@ class StorageBuffer final {
     void   update(const std::vector<T>& v)                      { return impl.update(v.data(),0,v.size()*sizeof(T),1,1); }
     void   update(const void* data, size_t offset, size_t size) { return impl.update(data,offset,size,1,1); }
 
+    // GPU copy of [offset, offset+size) is recorded right away; result can be read few frames later
+    Readback      readAsync(size_t offset, size_t size)         { return impl.readAsync(offset,size); }
+    Readback      readAsync()                                   { return impl.readAsync(0,impl.size()); }
+
+    template<class T=uint8_t>
+    MappedSpan<T> map()                                         { return impl.map<T>(impl.size()/sizeof(T)); }
+
   private:
     StorageBuffer(Tempest::VideoBuffer&& impl)
       :impl(std::move(impl)) {
@@ -7,6 +7,7 @@ namespace Tempest {
 
 class Device;
 class DescriptorSet;
+class TextureStreamer;
 template<class T>
 class Encoder;
 
@@ -37,6 +38,7 @@ class Texture2d final {
 
   friend class Tempest::Device;
   friend class Tempest::DescriptorSet;
+  friend class Tempest::TextureStreamer;
   friend class Encoder<Tempest::CommandBuffer>;
 
   template<class T>
@@ -0,0 +1,248 @@
+#include "texturestreamer.h"
+
+#include <Tempest/Device>
+#include <Tempest/File>
+#include <Tempest/Pixmap>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Tempest;
+
+static size_t textureBytes(uint32_t w, uint32_t h, size_t bpp, bool mips) {
+  size_t ret = size_t(w)*size_t(h)*bpp;
+  while(mips && (w>1 || h>1)) {
+    w    = std::max<uint32_t>(1,w/2);
+    h    = std::max<uint32_t>(1,h/2);
+    ret += size_t(w)*size_t(h)*bpp;
+    }
+  return ret;
+  }
+
+struct TextureStreamer::Request {
+  std::string              path;
+  std::u16string           path16;
+  std::unique_ptr<IDevice> input;
+  bool                     mips  = true;
+  uint64_t                 order = 0;
+
+  std::atomic<uint8_t>     priority{Normal};
+  std::atomic<uint8_t>     state{Queued};
+
+  // accessed by worker until Decoded, and by render thread afterwards
+  Device::StagedImage      staged;
+  size_t                   bytes = 0; // of all mips
+  // render thread only; published by release-store of Resident
+  Texture2d                tex;
+  };
+
+const Texture2d& TextureStreamer::Handle::texture() const {
+  static const Texture2d empty;
+  if(req==nullptr)
+    return empty;
+  return req->tex;
+  }
+
+TextureStreamer::State TextureStreamer::Handle::state() const {
+  if(req==nullptr)
+    return Cancelled;
+  return State(req->state.load(std::memory_order_acquire));
+  }
+
+void TextureStreamer::Handle::setPriority(Priority p) {
+  if(req!=nullptr)
+    req->priority.store(p);
+  }
+
+void TextureStreamer::Handle::cancel() {
+  if(req==nullptr)
+    return;
+  uint8_t st = req->state.load();
+  while(st==Queued || st==Decoding || st==Decoded) {
+    if(req->state.compare_exchange_weak(st,Cancelled))
+      return;
+    }
+  }
+
+TextureStreamer::TextureStreamer(Device& dev, uint32_t threads)
+  :device(dev) {
+  Pixmap white(1,1,Pixmap::Format::RGBA);
+  std::memset(white.data(),255,white.dataSize());
+  placeholder = device.loadTexture(white,false);
+
+  threads = std::max<uint32_t>(threads,1);
+  workers.reserve(threads);
+  for(uint32_t i=0; i<threads; ++i)
+    workers.emplace_back(&TextureStreamer::workerFunc,this);
+  }
+
+TextureStreamer::~TextureStreamer() {
+  {
+  std::lock_guard<std::mutex> guard(sync);
+  stop = true;
+  }
+  cv.notify_all();
+  for(auto& i:workers)
+    i.join();
+  }
+
+TextureStreamer::Handle TextureStreamer::load(const char* path, Priority p, bool mips) {
+  std::shared_ptr<Request> r = std::make_shared<Request>();
+  r->path = path;
+  return implLoad(std::move(r),p,mips);
+  }
+
+TextureStreamer::Handle TextureStreamer::load(const std::string& path, Priority p, bool mips) {
+  std::shared_ptr<Request> r = std::make_shared<Request>();
+  r->path = path;
+  return implLoad(std::move(r),p,mips);
+  }
+
+TextureStreamer::Handle TextureStreamer::load(const char16_t* path, Priority p, bool mips) {
+  std::shared_ptr<Request> r = std::make_shared<Request>();
+  r->path16 = path;
+  return implLoad(std::move(r),p,mips);
+  }
+
+TextureStreamer::Handle TextureStreamer::load(std::unique_ptr<IDevice>&& input, Priority p, bool mips) {
+  std::shared_ptr<Request> r = std::make_shared<Request>();
+  r->input = std::move(input);
+  return implLoad(std::move(r),p,mips);
+  }
+
+void TextureStreamer::setFrameBudget(size_t bytes) {
+  budget = bytes;
+  }
+
+TextureStreamer::Handle TextureStreamer::implLoad(std::shared_ptr<Request> r, Priority p, bool mips) {
+  r->mips     = mips;
+  r->priority = p;
+  r->tex      = Texture2d(device,AbstractGraphicsApi::PTexture(placeholder.impl),
+                          uint32_t(placeholder.w()),uint32_t(placeholder.h()),placeholder.format());
+  {
+  std::lock_guard<std::mutex> guard(sync);
+  r->order = order++;
+  queued.push_back(r);
+  }
+  cv.notify_one();
+  return Handle(std::move(r));
+  }
+
+std::shared_ptr<TextureStreamer::Request> TextureStreamer::pick(std::vector<std::shared_ptr<Request>>& list) {
+  // cancelled, or nobody holds a handle anymore
+  for(size_t i=0; i<list.size(); ) {
+    if(list[i]->state.load()==Cancelled || list[i].use_count()==1) {
+      list[i]->state.store(Cancelled);
+      list[i] = std::move(list.back());
+      list.pop_back();
+      } else {
+      ++i;
+      }
+    }
+  if(list.empty())
+    return nullptr;
+
+  size_t id = 0;
+  for(size_t i=1; i<list.size(); ++i) {
+    auto& r = *list[i];
+    auto& b = *list[id];
+    const uint8_t rp = r.priority.load(), bp = b.priority.load();
+    if(rp>bp || (rp==bp && r.order<b.order))
+      id = i;
+    }
+  auto ret = std::move(list[id]);
+  list[id] = std::move(list.back());
+  list.pop_back();
+  return ret;
+  }
+
+void TextureStreamer::workerFunc() {
+  while(true) {
+    std::shared_ptr<Request> r;
+    {
+    std::unique_lock<std::mutex> guard(sync);
+    cv.wait(guard,[this](){ return stop || !queued.empty(); });
+    if(stop)
+      return;
+    r = pick(queued);
+    }
+    if(r==nullptr)
+      continue;
+
+    uint8_t st = Queued;
+    if(!r->state.compare_exchange_strong(st,Decoding))
+      continue;
+
+    try {
+      // decoded straight into staging memory; upload is recorded by update(), within frame budget
+      auto& img = r->staged;
+      if(r->input!=nullptr) {
+        device.decodeTexture(*r->input,img);
+        } else
+      if(!r->path16.empty()) {
+        RFile f(r->path16);
+        device.decodeTexture(f,img);
+        } else {
+        RFile f(r->path);
+        device.decodeTexture(f,img);
+        }
+      r->input.reset();
+      if(img.stage.handler!=nullptr) {
+        r->bytes = textureBytes(img.w,img.h,Pixmap::bppForFormat(Pixmap::toPixmapFormat(img.format)),r->mips);
+        } else {
+        // block-compressed: baked mips are in pixmap already
+        r->bytes = std::max(img.pm.dataSize(),textureBytes(img.pm.w(),img.pm.h(),Pixmap::bppForFormat(img.pm.format()),r->mips));
+        }
+      }
+    catch(const std::exception&) {
+      r->state.store(Failed);
+      continue;
+      }
+
+    st = Decoding;
+    if(!r->state.compare_exchange_strong(st,Decoded)) {
+      r->staged = Device::StagedImage();
+      continue;
+      }
+
+    std::lock_guard<std::mutex> guard(sync);
+    decoded.push_back(std::move(r));
+    }
+  }
+
+size_t TextureStreamer::update() {
+  size_t published = 0;
+  while(true) {
+    std::shared_ptr<Request> r;
+    {
+    std::lock_guard<std::mutex> guard(sync);
+    r = pick(decoded);
+    if(r==nullptr)
+      break;
+    if(published>0 && published+r->bytes>budget) {
+      decoded.push_back(std::move(r));
+      break;
+      }
+    }
+
+    published += r->bytes;
+    Texture2d t;
+    try {
+      t = device.loadTexture(r->staged,r->mips);
+      }
+    catch(const std::exception&) {
+      r->staged = Device::StagedImage();
+      r->state.store(Failed);
+      continue;
+      }
+    r->staged = Device::StagedImage();
+
+    // texture goes first: Handle::texture() must see it, once state is Resident
+    Texture2d prev = std::move(r->tex);
+    r->tex = std::move(t);
+    uint8_t st = Decoded;
+    if(!r->state.compare_exchange_strong(st,Resident,std::memory_order_release,std::memory_order_relaxed))
+      r->tex = std::move(prev); // cancelled meanwhile
+    }
+  return published;
+  }
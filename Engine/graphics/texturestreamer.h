@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Tempest/Texture2d>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Tempest {
+
+class Device;
+class IDevice;
+
+//! Loads textures in background: worker threads decode images straight into staging memory,
+//! update() records uploads of decoded textures and publishes them, within per-frame byte budget.
+class TextureStreamer final {
+  private:
+    struct Request;
+
+  public:
+    enum Priority : uint8_t {
+      Low    = 0,
+      Normal = 1,
+      High   = 2,
+      };
+
+    enum State : uint8_t {
+      Queued,
+      Decoding,
+      Decoded,
+      Resident,
+      Failed,
+      Cancelled,
+      };
+
+    class Handle final {
+      public:
+        Handle()=default;
+
+        // placeholder texture, until state() is Resident;
+        // descriptors have to be updated, once real texture arrives
+        const Texture2d& texture()    const;
+        State            state()      const;
+        bool             isResident() const { return state()==Resident; }
+
+        void             setPriority(Priority p);
+        void             cancel();
+
+      private:
+        explicit Handle(std::shared_ptr<Request> r):req(std::move(r)){}
+        std::shared_ptr<Request> req;
+
+      friend class TextureStreamer;
+      };
+
+    enum {
+      DEFAULT_FRAME_BUDGET = 8*1024*1024,
+      };
+
+    TextureStreamer(Device& dev, uint32_t threads=2);
+    TextureStreamer(const TextureStreamer&)=delete;
+    ~TextureStreamer();
+
+    Handle  load(const char*        path,  Priority p=Normal, bool mips=true);
+    Handle  load(const std::string& path,  Priority p=Normal, bool mips=true);
+    Handle  load(const char16_t*    path,  Priority p=Normal, bool mips=true);
+    Handle  load(std::unique_ptr<IDevice>&& input, Priority p=Normal, bool mips=true);
+
+    void    setFrameBudget(size_t bytes);
+    size_t  frameBudget() const { return budget; }
+
+    // Uploads decoded textures in priority order, until frame budget (bytes of all mips) is spent; at least one texture per call.
+    // Intended to be called once per frame, from the thread that renders. Returns amount of uploaded bytes.
+    size_t  update();
+
+  private:
+    Handle  implLoad(std::shared_ptr<Request> r, Priority p, bool mips);
+    void    workerFunc();
+    static std::shared_ptr<Request> pick(std::vector<std::shared_ptr<Request>>& list);
+
+    Device&                               device;
+    Texture2d                             placeholder;
+    size_t                                budget = DEFAULT_FRAME_BUDGET;
+
+    std::mutex                            sync;
+    std::condition_variable               cv;
+    bool                                  stop = false;
+    uint64_t                              order = 0;
+    std::vector<std::shared_ptr<Request>> queued;
+    std::vector<std::shared_ptr<Request>> decoded;
+    std::vector<std::thread>              workers;
+  };
+
+}
@@ -26,6 +26,8 @@ class VertexBuffer final {
     void   update(const std::vector<T>& v)                 { return this->impl.update(v.data(),0,v.size(),sizeof(T),sizeof(T)); }
     void   update(const T* data,size_t offset,size_t size) { return this->impl.update(data,offset,size,sizeof(T),sizeof(T)); }
 
+    MappedSpan<T> map()                                    { return this->impl.template map<T>(sz); }
+
   private:
     VertexBuffer(Tempest::VideoBuffer&& impl,size_t size)
       :impl(std::move(impl)),sz(size) {
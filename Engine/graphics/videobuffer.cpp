@@ -31,3 +31,20 @@ void VideoBuffer::update(const void *data, size_t offset, size_t count, size_t s
     throw std::system_error(Tempest::GraphicsErrc::InvalidBufferUpdate);
   impl.handler->update(data,offset,count,size,alignedSz);
   }
+
+Readback VideoBuffer::readAsync(size_t offset, size_t size) {
+  if(size==0)
+    return Readback();
+  if(impl.handler==nullptr || offset+size>sz)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidBufferUpdate);
+  return Readback(impl.handler->readAsync(offset,size),size);
+  }
+
+void* VideoBuffer::implMap() {
+  if(impl.handler==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidBufferUpdate);
+  void* ret = impl.handler->map();
+  if(ret==nullptr)
+    throw std::system_error(Tempest::GraphicsErrc::InvalidBufferUpdate);
+  return ret;
+  }
@@ -2,6 +2,8 @@
 
 #include <Tempest/AbstractGraphicsApi>
 #include "../utility/dptr.h"
+#include "mappedspan.h"
+#include "readback.h"
 
 namespace Tempest {
 
@@ -19,11 +21,17 @@ class VideoBuffer {
     VideoBuffer& operator=(VideoBuffer&&);
 
     void   update(const void* data, size_t offset, size_t count, size_t size, size_t alignedSz);
+    Readback readAsync(size_t offset, size_t size);
     size_t size() const { return sz; }
 
+    template<class T>
+    MappedSpan<T> map(size_t count) { return MappedSpan<T>(impl,implMap(),count); }
+
   private:
     VideoBuffer(AbstractGraphicsApi::PBuffer &&impl, size_t size);
 
+    void*  implMap();
+
     Detail::DSharedPtr<AbstractGraphicsApi::Buffer*> impl;
     size_t                                           sz=0;
 
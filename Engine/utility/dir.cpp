@@ -8,6 +8,8 @@
 #else
 #include <errno.h>
 #include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 using namespace Tempest;
@@ -144,3 +146,21 @@ bool Dir::scan(const char16_t *path, std::function<void (const std::u16string &,
 #endif
   return true;
   }
+
+bool Dir::create(const char* path) {
+#if defined(__WINDOWS__) || defined(__WINDOWS_PHONE__)
+  const std::u16string p = TextCodec::toUtf16(path);
+  return CreateDirectoryW(reinterpret_cast<const WCHAR*>(p.c_str()),nullptr)!=FALSE;
+#else
+  return mkdir(path,0755)==0;
+#endif
+  }
+
+bool Dir::remove(const char* path) {
+#if defined(__WINDOWS__) || defined(__WINDOWS_PHONE__)
+  const std::u16string p = TextCodec::toUtf16(path);
+  return RemoveDirectoryW(reinterpret_cast<const WCHAR*>(p.c_str()))!=FALSE;
+#else
+  return rmdir(path)==0;
+#endif
+  }
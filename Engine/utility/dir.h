@@ -18,6 +18,11 @@ class Dir {
 
     static bool scan(const char16_t*       path,std::function<void(const std::u16string&,FileType)> cb);
     static bool scan(const std::u16string& path,std::function<void(const std::u16string&,FileType)> cb);
+
+    // false, if directory can't be created or already exists
+    static bool create(const char* path);
+    // directory must be empty
+    static bool remove(const char* path);
   };
 
 }
@@ -0,0 +1,142 @@
+#include "allocbench.h"
+
+#include "../gapi/deviceallocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Bench;
+using namespace Tempest::Detail;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum {
+  OPS_PER_THREAD = 200000,
+  LIVE           = 256,
+  };
+
+struct FakeDevice {
+  using DeviceMemory=uintptr_t;
+
+  DeviceMemory alloc(size_t /*size*/, uint32_t /*typeId*/, bool /*dedicated*/) {
+    ++pageAllocs;
+    return next.fetch_add(1);
+    }
+
+  void free(DeviceMemory /*m*/, size_t /*size*/, uint32_t /*typeId*/, bool /*dedicated*/) {
+    }
+
+  void* map(DeviceMemory m, size_t /*size*/) {
+    return reinterpret_cast<void*>(m);
+    }
+
+  void unmap(DeviceMemory /*m*/) {
+    }
+
+  std::atomic<uint64_t>  pageAllocs{0};
+  std::atomic<uintptr_t> next{1};
+  };
+
+using Allocator = DeviceAllocator<FakeDevice>;
+
+// every call is serialized, as it was with one shard per heap
+struct HeapLocked {
+  explicit HeapLocked(FakeDevice& dev):mem(dev){}
+
+  Allocator::Allocation alloc(size_t size, size_t align, uint32_t heapId) {
+    std::lock_guard<std::mutex> guard(sync);
+    return mem.alloc(size,align,heapId,heapId,false);
+    }
+  void free(const Allocator::Allocation& a) {
+    std::lock_guard<std::mutex> guard(sync);
+    mem.free(a);
+    }
+
+  Allocator  mem;
+  std::mutex sync;
+  };
+
+struct Sharded {
+  explicit Sharded(FakeDevice& dev):mem(dev){}
+
+  Allocator::Allocation alloc(size_t size, size_t align, uint32_t heapId) {
+    return mem.alloc(size,align,heapId,heapId,false);
+    }
+  void free(const Allocator::Allocation& a) {
+    mem.free(a);
+    }
+
+  Allocator mem;
+  };
+
+uint64_t elapsedNs(Clock::time_point a, Clock::time_point b) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(b-a).count());
+  }
+
+// returns ns per operation; every thread keeps LIVE allocations of random size in heap 0
+template<class Mem>
+double run(size_t threads, uint64_t& pages, size_t& failed) {
+  FakeDevice               dev;
+  Mem                      mem(dev);
+  std::vector<std::thread> th;
+  std::atomic<size_t>      fail{0};
+
+  auto t0 = Clock::now();
+  for(size_t t=0; t<threads; ++t) {
+    th.emplace_back([&,t](){
+      std::mt19937                       rnd(uint32_t(t+1));
+      std::vector<Allocator::Allocation> live(LIVE);
+      for(size_t i=0; i<OPS_PER_THREAD; ++i) {
+        auto& a = live[rnd()%LIVE];
+        if(a.page!=nullptr) {
+          mem.free(a);
+          a = Allocator::Allocation();
+          continue;
+          }
+        a = mem.alloc(256+rnd()%(64*1024),256,0);
+        if(a.page==nullptr)
+          ++fail;
+        }
+      for(auto& a:live)
+        if(a.page!=nullptr)
+          mem.free(a);
+      });
+    }
+  for(auto& i:th)
+    i.join();
+  auto t1 = Clock::now();
+
+  pages  = dev.pageAllocs.load();
+  failed = fail.load();
+  return double(elapsedNs(t0,t1))/double(OPS_PER_THREAD*threads);
+  }
+
+}
+
+void Bench::allocatorThreadsBenchmark(size_t threads) {
+  std::vector<size_t> threadCount = {1};
+  if(threads>1)
+    threadCount.push_back(threads);
+
+  std::printf("%-24s %8s %18s %18s %9s %12s %12s\n",
+              "allocator threads","threads","heap lock (ns/op)","sharded (ns/op)","speedup","pages before","pages after");
+  for(auto t:threadCount) {
+    uint64_t pLock = 0, pShard = 0;
+    size_t   fLock = 0, fShard = 0;
+    const double lck = run<HeapLocked>(t,pLock,fLock);
+    const double shd = run<Sharded>   (t,pShard,fShard);
+    std::printf("%-24s %8zu %18.1f %18.1f %8.1fx %12llu %12llu\n",
+                "same heap",t,lck,shd,(shd>0 ? lck/shd : 0.0),
+                (unsigned long long)pLock,(unsigned long long)pShard);
+    if(fLock+fShard>0)
+      std::printf("unexpected allocation failures: %zu\n",fLock+fShard);
+    }
+  }
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Bench {
+
+// DeviceAllocator alloc/free from several threads into the same heap, as worker threads creating buffers and textures do:
+// one lock per heap (previous implementation) against per-thread shards of the heap
+void allocatorThreadsBenchmark(size_t threads);
+
+}
@@ -0,0 +1,162 @@
+#include "bindbench.h"
+
+#include "../gapi/dynamicstate.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Bench;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum {
+  WIDGETS = 200,
+  };
+
+enum Blend : uint8_t {
+  NoBlend,
+  Alpha,
+  Add,
+  };
+
+// one RenderPipeline of Builtin, as VectorImage::pipelineOf selects it
+struct Block {
+  bool     hasImg = false;
+  Topology tp     = Triangles;
+  Blend    blend  = NoBlend;
+
+  uint32_t pipeline() const { return uint32_t(hasImg)*6 + uint32_t(tp==Triangles)*3 + uint32_t(blend); }
+  };
+
+// RenderState of Builtin: stNormal, stBlend, stAlpha
+RenderState stateOf(Blend b) {
+  RenderState st;
+  if(b==Alpha) {
+    st.setBlendSource  (RenderState::BlendMode::src_alpha);
+    st.setBlendDest    (RenderState::BlendMode::one_minus_src_alpha);
+    st.setZWriteEnabled(false);
+    }
+  if(b==Add) {
+    st.setBlendSource  (RenderState::BlendMode::one);
+    st.setBlendDest    (RenderState::BlendMode::one);
+    st.setZWriteEnabled(false);
+    }
+  return st;
+  }
+
+// widget: panel, border, optional icon, text, optional highlight
+void widget(std::vector<Block>& out, std::mt19937& rnd) {
+  out.push_back(Block{false,Triangles,Alpha});
+  out.push_back(Block{false,Lines,    NoBlend});
+  if(rnd()%2==0)
+    out.push_back(Block{true,Triangles,Alpha});
+  out.push_back(Block{true,Triangles,Alpha});
+  if(rnd()%10==0)
+    out.push_back(Block{false,Triangles,Add});
+  }
+
+struct Mode {
+  const char* name;
+  uint8_t     dynamic;
+  };
+
+struct Result {
+  uint64_t setPipeline = 0; // calls, that reach backend: Encoder skips repeated RenderPipeline
+  uint64_t binds       = 0;
+  uint64_t stateCmds   = 0;
+  uint64_t ns          = 0;
+  size_t   native      = 0;
+  };
+
+// native pipeline, that backend binds for given Builtin pipeline: pipelines with same base state share it
+uint64_t nativeOf(const Block& b, uint8_t dynamic) {
+  const RenderState st = DynamicState::baseState(stateOf(b.blend),dynamic);
+  const Topology    tp = DynamicState::baseTopology(b.tp,dynamic);
+  return 1 + uint64_t(b.hasImg)*64 + uint64_t(tp)*16 + uint64_t(st.blendSource())*2 + uint64_t(st.isZWriteEnabled());
+  }
+
+Result record(const std::vector<std::vector<Block>>& frames, const Mode& m) {
+  std::vector<uint64_t>     native(12);
+  std::vector<DynamicState> dyn(12);
+  for(uint32_t i=0; i<12; ++i) {
+    Block b;
+    b.hasImg  = (i/6)!=0;
+    b.tp      = ((i/3)%2)!=0 ? Triangles : Lines;
+    b.blend   = Blend(i%3);
+    native[i] = nativeOf(b,m.dynamic);
+    dyn[i]    = DynamicState(stateOf(b.blend),b.tp);
+    }
+
+  Result r;
+  std::vector<uint64_t> distinct;
+  for(auto i:native) {
+    bool known = false;
+    for(auto d:distinct)
+      known |= (d==i);
+    if(!known)
+      distinct.push_back(i);
+    }
+  r.native = distinct.size();
+
+  auto t0 = Clock::now();
+  for(auto& f:frames) {
+    DynamicStateTracker tracker;
+    uint32_t            cur = uint32_t(-1);
+    for(auto& b:f) {
+      const uint32_t p = b.pipeline();
+      if(p==cur)
+        continue;
+      cur = p;
+      ++r.setPipeline;
+      auto cmd = tracker.bind(native[p],m.dynamic,dyn[p]);
+      if(cmd.bindPipeline)
+        ++r.binds;
+      if(cmd.setState & DynamicState::Topology)
+        ++r.stateCmds;
+      if(cmd.setState & DynamicState::Blend)
+        r.stateCmds += 3; // depth write, blend enable, blend equation
+      }
+    }
+  auto t1 = Clock::now();
+  r.ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t1-t0).count());
+  return r;
+  }
+
+}
+
+void Bench::pipelineBindBenchmark(size_t frames) {
+  if(frames==0)
+    frames = 1;
+  std::mt19937 rnd(1);
+  std::vector<std::vector<Block>> fr(frames);
+  for(auto& f:fr)
+    for(size_t i=0; i<WIDGETS; ++i)
+      widget(f,rnd);
+
+  // Vulkan backend shares pipelines only when both blend and topology are dynamic: see VDevice::createLogicalDevice
+  static const Mode modes[] = {
+    {"baked",           DynamicState::None},
+    {"dynamic blend+tp",DynamicState::Blend | DynamicState::Topology},
+    };
+
+  std::printf("%-24s %8s %10s %14s %14s %14s %14s\n",
+              "pipeline binds","native","frames","setPipeline/f","binds/f","state cmds/f","ns/setPipeline");
+  uint64_t baked = 0;
+  for(auto& m:modes) {
+    Result r = record(fr,m);
+    const double n = double(frames);
+    std::printf("%-24s %8zu %10zu %14.1f %14.1f %14.1f %14.2f\n",
+                m.name,r.native,frames,double(r.setPipeline)/n,double(r.binds)/n,double(r.stateCmds)/n,
+                r.setPipeline==0 ? 0.0 : double(r.ns)/double(r.setPipeline));
+    if(m.dynamic==DynamicState::None)
+      baked = r.binds;
+    else if(r.binds>baked)
+      std::printf("unexpected: shared pipelines are bound more often, than baked ones\n");
+    }
+  }
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Bench {
+
+// Painter-like frames, drawn with Builtin pipelines (pen/brush x blend mode x texture/empty):
+// native pipeline binds and dynamic state commands per frame, with baked pipelines against shared ones
+void pipelineBindBenchmark(size_t frames);
+
+}
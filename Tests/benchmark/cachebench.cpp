@@ -0,0 +1,198 @@
+#include "cachebench.h"
+
+#include "../gapi/concurrentcache.h"
+#include "utility/spinlock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Bench;
+using namespace Tempest::Detail;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum {
+  PIPELINES = 32,
+  DRAWS     = 1000000,
+  };
+
+// framebuffer layout: attachment formats only, as VFramebufferLayout::isCompatible compares them
+struct FakeLayout {
+  uint8_t  attCount = 0;
+  uint32_t frm[4]   = {};
+
+  bool isCompatible(const FakeLayout& other) const {
+    if(this==&other)
+      return true;
+    if(attCount!=other.attCount)
+      return false;
+    for(size_t i=0; i<attCount; ++i)
+      if(frm[i]!=other.frm[i])
+        return false;
+    return true;
+    }
+
+  size_t hash() const {
+    size_t h = attCount;
+    for(size_t i=0; i<attCount; ++i)
+      h = h*31 + frm[i];
+    return h;
+    }
+  };
+
+struct LayoutHash {
+  size_t operator()(const FakeLayout* l) const { return l->hash(); }
+  };
+
+struct LayoutEq {
+  bool operator()(const FakeLayout* a, const FakeLayout* b) const { return a->isCompatible(*b); }
+  };
+
+struct Inst {
+  const FakeLayout* lay = nullptr;
+  uintptr_t         val = 0;
+  };
+
+// VPipeline::instance before: spinlock, then linear scan over std::list
+struct LinearPipeline {
+  Inst& instance(const FakeLayout& lay) {
+    std::lock_guard<SpinLock> guard(sync);
+    for(auto& i:inst)
+      if(i.lay->isCompatible(lay))
+        return i;
+    inst.emplace_back();
+    inst.back().lay = &lay;
+    inst.back().val = inst.size();
+    return inst.back();
+    }
+
+  std::list<Inst> inst;
+  SpinLock        sync;
+  };
+
+template<bool CountStats>
+struct HashedPipelineT {
+  Inst& instance(const FakeLayout& lay) {
+    // init runs under writer lock of cache
+    return inst.get(&lay,[this,&lay](const FakeLayout*, Inst& i){
+      i.lay = &lay;
+      i.val = ++count;
+      });
+    }
+
+  ConcurrentCache<const FakeLayout*,Inst,LayoutHash,LayoutEq,CountStats> inst;
+  uintptr_t                                                             count = 0;
+  };
+// timed without lookup counters, as in engine; counted variant runs as separate pass
+using HashedPipeline = HashedPipelineT<false>;
+
+struct Draw {
+  uint32_t pipeline = 0;
+  uint32_t layout   = 0;
+  };
+
+uint64_t elapsedNs(Clock::time_point a, Clock::time_point b) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(b-a).count());
+  }
+
+// records draws on every thread, each thread takes own slice of draw list
+template<class Pipeline>
+double record(std::vector<Pipeline>& pso, const std::vector<FakeLayout>& lay,
+              const std::vector<Draw>& draws, size_t threads, uintptr_t& checksum) {
+  std::vector<uintptr_t>   sum(threads);
+  std::vector<std::thread> th;
+  const size_t             slice = draws.size()/threads;
+
+  auto t0 = Clock::now();
+  for(size_t t=0; t<threads; ++t) {
+    th.emplace_back([&,t](){
+      uintptr_t s = 0;
+      for(size_t i=t*slice; i<(t+1)*slice; ++i) {
+        auto& d = draws[i];
+        s += pso[d.pipeline].instance(lay[d.layout]).val;
+        }
+      sum[t] = s;
+      });
+    }
+  for(auto& i:th)
+    i.join();
+  auto t1 = Clock::now();
+
+  checksum = 0;
+  for(auto i:sum)
+    checksum += i;
+  return double(elapsedNs(t0,t1))/double(slice*threads);
+  }
+
+}
+
+void Bench::drawCacheBenchmark(size_t layouts) {
+  if(layouts==0)
+    layouts = 1;
+  // every layout is present twice: framebuffers of swapchain images have distinct, but compatible layouts
+  std::vector<FakeLayout> lay(layouts*2);
+  for(size_t i=0; i<layouts; ++i) {
+    auto& l = lay[i];
+    l.attCount = uint8_t(1+i%4);
+    for(size_t r=0; r<l.attCount; ++r)
+      l.frm[r] = uint32_t(37+r);
+    l.frm[0] = uint32_t(i+1);
+    lay[i+layouts] = l;
+    }
+
+  std::mt19937      rnd(1);
+  std::vector<Draw> draws(DRAWS);
+  for(auto& i:draws) {
+    i.pipeline = uint32_t(rnd()%PIPELINES);
+    i.layout   = uint32_t(rnd()%lay.size());
+    }
+
+  std::vector<size_t> threadCount = {1};
+  const size_t        hw          = std::min<size_t>(std::thread::hardware_concurrency(),8);
+  if(hw>1)
+    threadCount.push_back(hw);
+
+  std::printf("%-24s %8s %8s %16s %16s %9s %9s %14s\n",
+              "draw cache","layouts","threads","linear (ns/op)","hashed (ns/op)","speedup","hit rate","probes/lookup");
+  for(auto threads:threadCount) {
+    std::vector<LinearPipeline> linear(PIPELINES);
+    std::vector<HashedPipeline> hashed(PIPELINES);
+
+    uintptr_t s0 = 0, s1 = 0;
+    const double lin = record(linear,lay,draws,threads,s0);
+    const double hsh = record(hashed,lay,draws,threads,s1);
+
+    std::vector<HashedPipelineT<true>> counted(PIPELINES);
+    uintptr_t s2 = 0;
+    record(counted,lay,draws,threads,s2);
+
+    ConcurrentCache<int,int>::Stats st;
+    for(auto& i:counted) {
+      auto s = i.inst.stats();
+      st.lookups += s.lookups;
+      st.hits    += s.hits;
+      st.probes  += s.probes;
+      }
+    const double hit    = st.lookups==0 ? 0 : double(st.hits)  /double(st.lookups);
+    const double probes = st.lookups==0 ? 0 : double(st.probes)/double(st.lookups);
+    std::printf("%-24s %8zu %8zu %16.1f %16.1f %8.1fx %9.4f %14.2f\n",
+                "pipeline instance",layouts,threads,lin,hsh,(hsh>0 ? lin/hsh : 0.0),hit,probes);
+
+    size_t variants = 0;
+    for(auto& i:hashed)
+      variants += i.inst.size();
+    if(variants>PIPELINES*layouts)
+      std::printf("unexpected variants: compatible layouts are not deduplicated\n");
+    if(threads==1 && s0!=s1)
+      std::printf("unexpected instance mismatch\n");
+    }
+  }
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Bench {
+
+// Per-layout pipeline lookup, as done for every draw while recording:
+// spinlock and linear scan over compatible layouts (previous implementation) against hashed wait-free cache
+void drawCacheBenchmark(size_t layouts);
+
+}
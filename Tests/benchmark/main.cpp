@@ -0,0 +1,455 @@
+#include "../gapi/deviceallocator.h"
+#include "../gapi/rectallocator.h"
+
+#include "allocbench.h"
+#include "bindbench.h"
+#include "cachebench.h"
+#include "trace.h"
+#include "uploadbench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace Bench;
+using namespace Tempest::Detail;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Fake memory providers: hand out opaque handles, no real memory is reserved
+struct FakeDevice {
+  using DeviceMemory=uintptr_t;
+
+  DeviceMemory alloc(size_t size, uint32_t /*typeId*/, bool /*dedicated*/) {
+    reserved += size;
+    peak      = std::max(peak,reserved);
+    ++pageAllocs;
+    return next++;
+    }
+
+  void free(DeviceMemory /*m*/, size_t size, uint32_t /*typeId*/, bool /*dedicated*/) {
+    reserved -= size;
+    }
+
+  void* map(DeviceMemory m, size_t /*size*/) {
+    return reinterpret_cast<void*>(m);
+    }
+
+  void unmap(DeviceMemory /*m*/) {
+    }
+
+  uint64_t  reserved  =0;
+  uint64_t  peak      =0;
+  uint64_t  pageAllocs=0;
+  uintptr_t next      =1;
+  };
+
+// RectAllocator moves pages around and frees moved-from ones: handle is move-only, as TextureAtlas::Memory
+struct FakeAtlas {
+  struct DeviceMemory {
+    DeviceMemory()=default;
+    explicit DeviceMemory(uintptr_t id):id(id){}
+    DeviceMemory(DeviceMemory&& other):id(other.id){ other.id=0; }
+    DeviceMemory& operator=(DeviceMemory&& other){ std::swap(id,other.id); return *this; }
+
+    uintptr_t id=0;
+    };
+
+  DeviceMemory alloc(uint32_t w, uint32_t h) {
+    const uint64_t sz = uint64_t(w)*h;
+    reserved += sz;
+    peak      = std::max(peak,reserved);
+    ++pageAllocs;
+    area[next] = sz;
+    return DeviceMemory(next++);
+    }
+
+  void free(DeviceMemory& m) {
+    if(m.id==0)
+      return;
+    reserved -= area[m.id];
+    area.erase(m.id);
+    m.id = 0;
+    }
+
+  std::unordered_map<uintptr_t,uint64_t> area;
+  uint64_t  reserved  =0;
+  uint64_t  peak      =0;
+  uint64_t  pageAllocs=0;
+  uintptr_t next      =1;
+  };
+
+struct Sample {
+  size_t   op      =0;
+  uint64_t reserved=0;
+  uint64_t used    =0;
+  double   frag    =0;
+  };
+
+struct Report {
+  std::string         trace;
+  const char*         allocator ="";
+  size_t              ops       =0;
+  size_t              failed    =0;
+  uint64_t            totalNs   =0;
+  uint64_t            worstNs   =0;
+  uint64_t            p99Ns     =0;
+  uint64_t            peak      =0;
+  uint64_t            pageAllocs=0;
+  std::vector<Sample> timeline;
+
+  double fragAvg() const {
+    double s = 0;
+    for(auto& i:timeline)
+      s += i.frag;
+    return timeline.empty() ? 0 : s/double(timeline.size());
+    }
+
+  double fragMax() const {
+    double s = 0;
+    for(auto& i:timeline)
+      s = std::max(s,i.frag);
+    return s;
+    }
+  };
+
+struct Options {
+  size_t                   ops         =200000;
+  uint32_t                 seed        =1;
+  size_t                   sampleEvery =0;
+  std::vector<std::string> synthetic;
+  std::vector<std::string> traces;
+  const char*              dumpDir     =nullptr;
+  const char*              csv         =nullptr;
+  size_t                   waitFor     =0;
+  size_t                   drawCache   =0;
+  size_t                   binds       =0;
+  size_t                   allocThreads=0;
+  };
+
+uint64_t elapsedNs(Clock::time_point a, Clock::time_point b) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(b-a).count());
+  }
+
+void finalize(Report& r, std::vector<uint32_t>& latency) {
+  r.ops = latency.size();
+  for(auto i:latency) {
+    r.totalNs += i;
+    r.worstNs  = std::max<uint64_t>(r.worstNs,i);
+    }
+  if(!latency.empty()) {
+    auto p99 = latency.begin()+ptrdiff_t((latency.size()*99)/100);
+    std::nth_element(latency.begin(),p99,latency.end());
+    r.p99Ns = *p99;
+    }
+  }
+
+Report replayDevice(const Trace& t, const Options& opt) {
+  using Allocator = DeviceAllocator<FakeDevice>;
+  enum { TYPE_COUNT=32 };
+
+  FakeDevice device;
+  Report     r;
+  r.trace     = t.name;
+  r.allocator = "DeviceAllocator";
+
+  std::vector<uint32_t> latency;
+  latency.reserve(t.ops.size());
+  {
+  Allocator                          mem(device);
+  std::vector<Allocator::Allocation> live(t.idCount);
+
+  auto sample = [&](size_t op) {
+    Allocator::Stats st[TYPE_COUNT] = {};
+    mem.stats(st,TYPE_COUNT);
+    // fragmentation: share of free bytes not reachable by the largest free block, over all memory types
+    Sample   s;
+    uint64_t free = 0, lost = 0;
+    s.op = op;
+    for(auto& i:st) {
+      s.reserved += i.reserved;
+      s.used     += i.used;
+      free       += i.reserved-i.used;
+      lost       += i.reserved-i.used-std::min(i.largestFree,i.reserved-i.used);
+      }
+    s.frag = free==0 ? 0 : double(lost)/double(free);
+    r.timeline.push_back(s);
+    };
+
+  for(size_t i=0; i<t.ops.size(); ++i) {
+    auto& op = t.ops[i];
+    if(op.kind==Op::Rect)
+      continue;
+
+    auto& a  = live[op.id];
+    auto  t0 = Clock::now();
+    switch(op.kind) {
+      case Op::Alloc:
+        a = mem.alloc(op.size,op.align,op.heapId,op.typeId,op.hostVisible);
+        break;
+      case Op::Dedicated:
+        a = mem.dedicatedAlloc(op.size,op.align,op.heapId,op.typeId,op.hostVisible);
+        break;
+      case Op::Free:
+        if(a.page!=nullptr)
+          mem.free(a);
+        break;
+      case Op::Rect:
+        break;
+      }
+    auto t1 = Clock::now();
+    latency.push_back(uint32_t(std::min<uint64_t>(elapsedNs(t0,t1),uint32_t(-1))));
+
+    if(op.kind==Op::Free)
+      a = Allocator::Allocation();
+    else if(a.page==nullptr)
+      ++r.failed;
+    if(i%opt.sampleEvery==0)
+      sample(i);
+    }
+  sample(t.ops.size());
+
+  for(auto& i:live)
+    if(i.page!=nullptr)
+      mem.free(i);
+  }
+
+  finalize(r,latency);
+  r.peak       = device.peak;
+  r.pageAllocs = device.pageAllocs;
+  return r;
+  }
+
+Report replayRect(const Trace& t, const Options& opt) {
+  using Allocator = Tempest::RectAllocator<FakeAtlas>;
+
+  FakeAtlas device;
+  Report    r;
+  r.trace     = t.name;
+  r.allocator = "RectAllocator";
+
+  std::vector<uint32_t> latency;
+  latency.reserve(t.ops.size());
+  {
+  Allocator                          mem(device);
+  std::vector<Allocator::Allocation> live(t.idCount);
+  std::vector<uint64_t>              area(t.idCount);
+  uint64_t                           used = 0;
+
+  auto sample = [&](size_t op) {
+    // fragmentation: share of reserved atlas area, not covered by live rectangles
+    Sample s;
+    s.op       = op;
+    s.reserved = device.reserved;
+    s.used     = used;
+    s.frag     = device.reserved==0 ? 0 : 1.0-double(used)/double(device.reserved);
+    r.timeline.push_back(s);
+    };
+
+  for(size_t i=0; i<t.ops.size(); ++i) {
+    auto& op = t.ops[i];
+    if(op.kind!=Op::Rect && op.kind!=Op::Free)
+      continue;
+
+    auto& a  = live[op.id];
+    auto  t0 = Clock::now();
+    if(op.kind==Op::Rect) {
+      try {
+        a = mem.alloc(op.size,op.align);
+        }
+      catch(const std::bad_alloc&) {
+        a = Allocator::Allocation();
+        }
+      } else {
+      a = Allocator::Allocation();
+      }
+    auto t1 = Clock::now();
+    latency.push_back(uint32_t(std::min<uint64_t>(elapsedNs(t0,t1),uint32_t(-1))));
+
+    if(op.kind==Op::Rect) {
+      if(a.owner==nullptr) {
+        ++r.failed;
+        } else {
+        area[op.id] = uint64_t(op.size)*op.align;
+        used       += area[op.id];
+        }
+      } else {
+      used       -= area[op.id];
+      area[op.id] = 0;
+      }
+    if(i%opt.sampleEvery==0)
+      sample(i);
+    }
+  sample(t.ops.size());
+  }
+
+  finalize(r,latency);
+  r.peak       = device.peak;
+  r.pageAllocs = device.pageAllocs;
+  return r;
+  }
+
+void printHeader() {
+  std::printf("%-24s %-16s %10s %12s %14s %11s %9s %9s %12s %10s %7s\n",
+              "trace","allocator","ops","ops/sec","peak reserved","page allocs","frag avg","frag max","worst (ns)","p99 (ns)","failed");
+  }
+
+void print(const Report& r) {
+  const double sec = double(r.totalNs)*1e-9;
+  std::printf("%-24s %-16s %10zu %12.0f %14llu %11llu %9.3f %9.3f %12llu %10llu %7zu\n",
+              r.trace.c_str(),r.allocator,r.ops,(sec>0 ? double(r.ops)/sec : 0.0),
+              (unsigned long long)r.peak,(unsigned long long)r.pageAllocs,
+              r.fragAvg(),r.fragMax(),
+              (unsigned long long)r.worstNs,(unsigned long long)r.p99Ns,r.failed);
+  }
+
+void writeCsv(FILE* f, const Report& r) {
+  for(auto& i:r.timeline)
+    std::fprintf(f,"%s,%s,%zu,%llu,%llu,%f\n",r.trace.c_str(),r.allocator,i.op,
+                 (unsigned long long)i.reserved,(unsigned long long)i.used,i.frag);
+  }
+
+void usage(const char* app) {
+  std::printf("usage: %s [options]\n"
+              "  --synthetic <name>  replay synthetic workload (repeatable), one of:",app);
+  for(auto& i:syntheticNames())
+    std::printf(" %s",i.c_str());
+  std::printf("\n"
+              "  --trace <file>      replay recorded trace (repeatable), format is described in trace.h\n"
+              "  --ops <n>           operations per synthetic trace (default 200000)\n"
+              "  --seed <n>          seed of synthetic traces (default 1)\n"
+              "  --sample <n>        fragmentation sampling period, in operations (default ops/256)\n"
+              "  --dump <dir>        save synthetic traces into directory\n"
+              "  --csv <file>        write fragmentation timeline as csv\n"
+              "  --waitfor <n>       measure UploadEngine::waitFor with n outstanding transfers\n"
+              "  --drawcache <n>     measure per-layout pipeline lookup, while recording draws against n layouts\n"
+              "  --binds <n>         count pipeline binds of n painter frames, with baked and dynamic-state pipelines\n"
+              "  --allocthreads <n>  measure DeviceAllocator alloc/free of n threads in the same heap\n"
+              "without --synthetic and --trace, all synthetic workloads are replayed\n");
+  }
+
+bool parse(int argc, const char** argv, Options& opt) {
+  for(int i=1; i<argc; ++i) {
+    const char* a    = argv[i];
+    const char* next = (i+1<argc) ? argv[i+1] : nullptr;
+    if(std::strcmp(a,"--help")==0 || std::strcmp(a,"-h")==0)
+      return false;
+    if(next==nullptr) {
+      std::fprintf(stderr,"missing value for %s\n",a);
+      return false;
+      }
+    if(std::strcmp(a,"--synthetic")==0)
+      opt.synthetic.push_back(next);
+    else if(std::strcmp(a,"--trace")==0)
+      opt.traces.push_back(next);
+    else if(std::strcmp(a,"--ops")==0)
+      opt.ops = size_t(std::strtoull(next,nullptr,10));
+    else if(std::strcmp(a,"--seed")==0)
+      opt.seed = uint32_t(std::strtoul(next,nullptr,10));
+    else if(std::strcmp(a,"--sample")==0)
+      opt.sampleEvery = size_t(std::strtoull(next,nullptr,10));
+    else if(std::strcmp(a,"--dump")==0)
+      opt.dumpDir = next;
+    else if(std::strcmp(a,"--csv")==0)
+      opt.csv = next;
+    else if(std::strcmp(a,"--waitfor")==0)
+      opt.waitFor = size_t(std::strtoull(next,nullptr,10));
+    else if(std::strcmp(a,"--drawcache")==0)
+      opt.drawCache = size_t(std::strtoull(next,nullptr,10));
+    else if(std::strcmp(a,"--binds")==0)
+      opt.binds = size_t(std::strtoull(next,nullptr,10));
+    else if(std::strcmp(a,"--allocthreads")==0)
+      opt.allocThreads = size_t(std::strtoull(next,nullptr,10));
+    else {
+      std::fprintf(stderr,"unknown option %s\n",a);
+      return false;
+      }
+    ++i;
+    }
+  if(opt.synthetic.empty() && opt.traces.empty() && opt.waitFor==0 && opt.drawCache==0 && opt.binds==0 && opt.allocThreads==0)
+    opt.synthetic = syntheticNames();
+  return true;
+  }
+
+}
+
+int main(int argc, const char** argv) {
+  Options opt;
+  if(!parse(argc,argv,opt)) {
+    usage(argv[0]);
+    return 1;
+    }
+
+  std::vector<Trace> traces;
+  for(auto& i:opt.synthetic) {
+    Trace t;
+    if(!syntheticTrace(i,opt.ops,opt.seed,t)) {
+      std::fprintf(stderr,"unknown synthetic workload: %s\n",i.c_str());
+      return 1;
+      }
+    if(opt.dumpDir!=nullptr) {
+      std::string path = std::string(opt.dumpDir)+"/"+i+".trace";
+      if(!saveTrace(path.c_str(),t))
+        std::fprintf(stderr,"unable to write %s\n",path.c_str());
+      }
+    traces.emplace_back(std::move(t));
+    }
+  for(auto& i:opt.traces) {
+    Trace t;
+    if(!loadTrace(i.c_str(),t)) {
+      std::fprintf(stderr,"unable to load trace: %s\n",i.c_str());
+      return 1;
+      }
+    traces.emplace_back(std::move(t));
+    }
+
+  FILE* csv = nullptr;
+  if(opt.csv!=nullptr) {
+    csv = std::fopen(opt.csv,"w");
+    if(csv==nullptr) {
+      std::fprintf(stderr,"unable to write %s\n",opt.csv);
+      return 1;
+      }
+    std::fprintf(csv,"trace,allocator,op,reserved,used,fragmentation\n");
+    }
+
+  if(opt.waitFor>0)
+    uploadWaitForBenchmark(opt.waitFor);
+  if(opt.drawCache>0)
+    drawCacheBenchmark(opt.drawCache);
+  if(opt.binds>0)
+    pipelineBindBenchmark(opt.binds);
+  if(opt.allocThreads>0)
+    allocatorThreadsBenchmark(opt.allocThreads);
+  if(traces.empty() && (opt.waitFor>0 || opt.drawCache>0 || opt.binds>0 || opt.allocThreads>0))
+    return 0;
+
+  printHeader();
+  for(auto& t:traces) {
+    Options o = opt;
+    if(o.sampleEvery==0)
+      o.sampleEvery = std::max<size_t>(1,t.ops.size()/256);
+
+    std::vector<Report> rep;
+    if(t.hasDevice())
+      rep.push_back(replayDevice(t,o));
+    if(t.hasRect())
+      rep.push_back(replayRect(t,o));
+    for(auto& r:rep) {
+      print(r);
+      if(csv!=nullptr)
+        writeCsv(csv,r);
+      }
+    }
+
+  if(csv!=nullptr)
+    std::fclose(csv);
+  return 0;
+  }
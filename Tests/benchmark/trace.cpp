@@ -0,0 +1,289 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+using namespace Bench;
+
+namespace {
+
+struct Rng {
+  uint32_t s;
+  explicit Rng(uint32_t seed):s(seed==0 ? 0x9E3779B9u : seed){}
+
+  uint32_t next() {
+    s ^= s<<13;
+    s ^= s>>17;
+    s ^= s<<5;
+    return s;
+    }
+
+  uint32_t range(uint32_t lo, uint32_t hi) {
+    return lo+next()%(hi-lo+1);
+    }
+
+  // roughly log-uniform in [lo,hi]: small allocations dominate, as in real scenes
+  uint32_t logRange(uint32_t lo, uint32_t hi) {
+    uint32_t l = 0, h = 0;
+    while((2u<<l)<=lo) ++l;
+    while((2u<<h)<=hi) ++h;
+    const uint32_t e = range(l,h);
+    const uint32_t v = (1u<<e) + next()%(1u<<e);
+    return v<lo ? lo : (v>hi ? hi : v);
+    }
+  };
+
+struct Gen {
+  explicit Gen(Trace& t):t(t){}
+
+  void alloc(Op op) {
+    op.id = t.idCount++;
+    live.push_back(op.id);
+    t.ops.push_back(op);
+    }
+
+  void freeAt(size_t i) {
+    Op f;
+    f.kind = Op::Free;
+    f.id   = live[i];
+    live[i] = live.back();
+    live.pop_back();
+    t.ops.push_back(f);
+    }
+
+  void freeFront(size_t count) {
+    for(size_t i=0; i<count && i<live.size(); ++i) {
+      Op f;
+      f.kind = Op::Free;
+      f.id   = live[i];
+      t.ops.push_back(f);
+      }
+    live.erase(live.begin(),live.begin()+std::min(count,live.size()));
+    }
+
+  void freeAll() {
+    freeFront(live.size());
+    }
+
+  Trace&                t;
+  std::vector<uint32_t> live;
+  };
+
+// heapId/typeId pairs as produced by VDevice::memoryTypeIndex: linear/optimal tiling on device-local type, plus host-visible type
+Op bufferOp(Rng& rng, uint32_t size) {
+  static const uint32_t align[] = {16,64,256,4096};
+  Op op;
+  op.kind  = Op::Alloc;
+  op.size  = size;
+  op.align = align[rng.next()%4];
+  switch(rng.next()%4) {
+    case 0:
+    case 1:
+      op.heapId = 0;
+      op.typeId = 0;
+      break;
+    case 2:
+      op.heapId = 1;
+      op.typeId = 0;
+      break;
+    case 3:
+      op.heapId      = 4;
+      op.typeId      = 2;
+      op.hostVisible = true;
+      break;
+    }
+  return op;
+  }
+
+void churn(Trace& t, size_t opCount, Rng& rng, bool withDedicated) {
+  Gen g(t);
+  const size_t liveTarget = 2000;
+  while(t.ops.size()<opCount) {
+    const bool grow = g.live.size()<liveTarget && (g.live.empty() || rng.next()%3!=0);
+    if(!grow) {
+      g.freeAt(rng.next()%g.live.size());
+      continue;
+      }
+    if(withDedicated && rng.next()%256==0) {
+      Op op = bufferOp(rng,rng.range(8u<<20,64u<<20));
+      op.kind = Op::Dedicated;
+      g.alloc(op);
+      continue;
+      }
+    g.alloc(bufferOp(rng,rng.logRange(256,1u<<20)));
+    }
+  g.freeAll();
+  }
+
+void stream(Trace& t, size_t opCount, Rng& rng) {
+  static const uint32_t classes[] = {64u<<10, 256u<<10, 1u<<20, 4u<<20};
+  const size_t framesInFlight = 3;
+
+  Gen g(t);
+  std::vector<size_t> frame;
+  while(t.ops.size()<opCount) {
+    const size_t n = rng.range(4,32);
+    for(size_t i=0; i<n; ++i) {
+      Op op = bufferOp(rng,classes[rng.next()%4]);
+      g.alloc(op);
+      }
+    frame.push_back(n);
+    if(frame.size()>framesInFlight) {
+      g.freeFront(frame.front());
+      frame.erase(frame.begin());
+      }
+    }
+  g.freeAll();
+  }
+
+void atlas(Trace& t, size_t opCount, Rng& rng) {
+  Gen g(t);
+  const size_t liveTarget = 4000;
+  while(t.ops.size()<opCount) {
+    const bool grow = g.live.size()<liveTarget && (g.live.empty() || rng.next()%3!=0);
+    if(!grow) {
+      g.freeAt(rng.next()%g.live.size());
+      continue;
+      }
+    Op op;
+    op.kind  = Op::Rect;
+    op.size  = rng.next()%64==0 ? rng.range(64,256) : rng.range(4,64);
+    op.align = rng.next()%64==0 ? rng.range(64,256) : rng.range(4,64);
+    g.alloc(op);
+    }
+  g.freeAll();
+  }
+
+}
+
+bool Trace::hasRect() const {
+  for(auto& i:ops)
+    if(i.kind==Op::Rect)
+      return true;
+  return false;
+  }
+
+bool Trace::hasDevice() const {
+  for(auto& i:ops)
+    if(i.kind==Op::Alloc || i.kind==Op::Dedicated)
+      return true;
+  return false;
+  }
+
+bool Bench::loadTrace(const char* path, Trace& out) {
+  FILE* f = std::fopen(path,"r");
+  if(f==nullptr)
+    return false;
+
+  std::unordered_map<uint64_t,uint32_t> ids;
+  auto remap = [&](uint64_t id, bool create, uint32_t& ret) {
+    auto it = ids.find(id);
+    if(it!=ids.end()) {
+      ret = it->second;
+      if(!create)
+        ids.erase(it);
+      return true;
+      }
+    if(!create)
+      return false;
+    ret = out.idCount++;
+    ids[id] = ret;
+    return true;
+    };
+
+  out.name = path;
+  char line[256] = {};
+  size_t lineNo = 0;
+  bool   ok     = true;
+  while(ok && std::fgets(line,sizeof(line),f)!=nullptr) {
+    ++lineNo;
+    char               kind = 0;
+    unsigned long long id   = 0;
+    unsigned           a=0, b=0, c=0, d=0, hv=0;
+    if(line[0]=='#' || line[0]=='\n' || line[0]=='\r' || line[0]=='\0')
+      continue;
+
+    Op op;
+    const int cnt = std::sscanf(line,"%c %llu %u %u %u %u %u",&kind,&id,&a,&b,&c,&d,&hv);
+    switch(kind) {
+      case 'a':
+      case 'd':
+        ok = (cnt==7);
+        op.kind        = (kind=='a' ? Op::Alloc : Op::Dedicated);
+        op.size        = a;
+        op.align       = b==0 ? 1 : b;
+        op.heapId      = c;
+        op.typeId      = d;
+        op.hostVisible = hv!=0;
+        break;
+      case 'r':
+        ok = (cnt>=4);
+        op.kind  = Op::Rect;
+        op.size  = a;
+        op.align = b;
+        break;
+      case 'f':
+        ok = (cnt>=2);
+        op.kind = Op::Free;
+        break;
+      default:
+        ok = false;
+      }
+    if(ok)
+      ok = remap(id,op.kind!=Op::Free,op.id);
+    if(ok)
+      out.ops.push_back(op);
+    }
+  if(!ok)
+    std::fprintf(stderr,"%s:%zu: malformed trace line\n",path,lineNo);
+  std::fclose(f);
+  return ok;
+  }
+
+bool Bench::saveTrace(const char* path, const Trace& t) {
+  FILE* f = std::fopen(path,"w");
+  if(f==nullptr)
+    return false;
+  std::fprintf(f,"# %s\n",t.name.c_str());
+  for(auto& i:t.ops) {
+    switch(i.kind) {
+      case Op::Alloc:
+      case Op::Dedicated:
+        std::fprintf(f,"%c %u %u %u %u %u %u\n",(i.kind==Op::Alloc ? 'a' : 'd'),
+                     i.id,i.size,i.align,i.heapId,i.typeId,i.hostVisible ? 1u : 0u);
+        break;
+      case Op::Rect:
+        std::fprintf(f,"r %u %u %u\n",i.id,i.size,i.align);
+        break;
+      case Op::Free:
+        std::fprintf(f,"f %u\n",i.id);
+        break;
+      }
+    }
+  std::fclose(f);
+  return true;
+  }
+
+const std::vector<std::string>& Bench::syntheticNames() {
+  static const std::vector<std::string> names = {"churn","stream","dedicated","atlas"};
+  return names;
+  }
+
+bool Bench::syntheticTrace(const std::string& name, size_t opCount, uint32_t seed, Trace& out) {
+  Rng rng(seed);
+  out = Trace();
+  out.name = name;
+  if(name=="churn")
+    churn(out,opCount,rng,false);
+  else if(name=="dedicated")
+    churn(out,opCount,rng,true);
+  else if(name=="stream")
+    stream(out,opCount,rng);
+  else if(name=="atlas")
+    atlas(out,opCount,rng);
+  else
+    return false;
+  return true;
+  }
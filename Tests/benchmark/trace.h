@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+// Allocation trace, as text file one operation per line:
+//   a <id> <size> <align> <heapId> <typeId> <hostVisible>   - DeviceAllocator::alloc
+//   d <id> <size> <align> <heapId> <typeId> <hostVisible>   - DeviceAllocator::dedicatedAlloc
+//   r <id> <w> <h>                                          - RectAllocator::alloc
+//   f <id>                                                  - free
+// '#' starts a comment; ids are arbitrary and remapped to dense indices on load.
+struct Op {
+  enum Kind : uint8_t {
+    Alloc,
+    Dedicated,
+    Rect,
+    Free
+    };
+  Kind     kind  =Alloc;
+  uint32_t id    =0;
+  uint32_t size  =0;  // width for Rect
+  uint32_t align =1;  // height for Rect
+  uint32_t heapId=0;
+  uint32_t typeId=0;
+  bool     hostVisible=false;
+  };
+
+struct Trace {
+  std::string     name;
+  std::vector<Op> ops;
+  uint32_t        idCount=0;
+
+  bool hasRect()   const;
+  bool hasDevice() const;
+  };
+
+bool  loadTrace(const char* path, Trace& out);
+bool  saveTrace(const char* path, const Trace& t);
+
+// deterministic synthetic workloads, independent from std random distributions
+const std::vector<std::string>& syntheticNames();
+bool  syntheticTrace(const std::string& name, size_t opCount, uint32_t seed, Trace& out);
+
+}
@@ -0,0 +1,124 @@
+#include "uploadbench.h"
+
+#include "../gapi/uploadengine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace Bench;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+using Clock  = std::chrono::steady_clock;
+using ResPtr = DSharedPtr<AbstractGraphicsApi::Shared*>;
+using BufPtr = DSharedPtr<AbstractGraphicsApi::Buffer*>;
+
+struct FakeDevice;
+
+struct FakeCmd {
+  explicit FakeCmd(FakeDevice&) {}
+  void begin() {}
+  void end()   {}
+  void reset() {}
+  };
+
+// gpu never finishes: all transfers stay outstanding
+struct FakeFence {
+  explicit FakeFence(FakeDevice&) {}
+  bool wait(uint64_t) { return false; }
+  void wait()         {}
+  };
+
+struct FakeBuffer : AbstractGraphicsApi::Buffer {
+  void  update(const void*,size_t,size_t,size_t,size_t) override {}
+  void  read  (void*,size_t,size_t) override {}
+  auto  readAsync(size_t,size_t) -> AbstractGraphicsApi::Readback* override { return nullptr; }
+  void* map   () override { return nullptr; }
+  void  unmap () override {}
+  };
+
+struct FakeDevice {
+  void submit(FakeCmd&, FakeFence&) {}
+  };
+
+// in-flight transfers, as UploadEngine tracked them before: every hazard check scans all of them
+struct LinearTracker {
+  struct Transfer {
+    std::vector<ResPtr> holdRes;
+    bool holds(AbstractGraphicsApi::Shared* s) const {
+      for(auto& i:holdRes)
+        if(i.handler==s)
+          return true;
+      return false;
+      }
+    };
+
+  bool waitFor(AbstractGraphicsApi::Shared* s) const {
+    bool found = false;
+    for(auto& i:cmd)
+      found |= i.holds(s);
+    return found;
+    }
+
+  std::vector<Transfer> cmd;
+  };
+
+uint64_t elapsedNs(Clock::time_point a, Clock::time_point b) {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(b-a).count());
+  }
+
+}
+
+void Bench::uploadWaitForBenchmark(size_t transfers) {
+  using Engine = UploadEngine<FakeDevice,FakeCmd,FakeFence,FakeBuffer>;
+
+  // every transfer writes one resource and holds one staging buffer
+  std::vector<BufPtr> dst, stage;
+  for(size_t i=0; i<transfers; ++i) {
+    dst.emplace_back(new FakeBuffer());
+    stage.emplace_back(new FakeBuffer());
+    }
+  // host-visible buffers, that are updated while transfers are in flight
+  std::vector<BufPtr> host;
+  for(size_t i=0; i<transfers; ++i)
+    host.emplace_back(new FakeBuffer());
+
+  LinearTracker linear;
+  for(size_t i=0; i<transfers; ++i) {
+    LinearTracker::Transfer t;
+    t.holdRes.emplace_back(ResPtr(dst[i].handler));
+    t.holdRes.emplace_back(ResPtr(stage[i].handler));
+    linear.cmd.emplace_back(std::move(t));
+    }
+
+  FakeDevice device;
+  std::unique_ptr<Engine> tagged(new Engine(device));
+  for(size_t i=0; i<transfers; ++i) {
+    auto cmd = tagged->get();
+    cmd->begin();
+    cmd->hold(dst[i]);
+    cmd->hold(stage[i]);
+    cmd->end();
+    tagged->submit(std::move(cmd));
+    }
+
+  size_t found = 0;
+  auto   t0    = Clock::now();
+  for(auto& i:host)
+    found += linear.waitFor(i.handler) ? 1 : 0;
+  auto   t1    = Clock::now();
+  for(auto& i:host)
+    tagged->waitFor(i.handler);
+  auto   t2    = Clock::now();
+
+  const double lin = double(elapsedNs(t0,t1))/double(transfers);
+  const double tag = double(elapsedNs(t1,t2))/double(transfers);
+  std::printf("%-24s %12s %16s %16s %9s\n","waitFor","transfers","linear (ns/op)","tagged (ns/op)","speedup");
+  std::printf("%-24s %12zu %16.1f %16.1f %8.1fx\n","host-visible update",transfers,lin,tag,(tag>0 ? lin/tag : 0.0));
+  if(found!=0)
+    std::printf("unexpected hazard in linear scan\n");
+  }
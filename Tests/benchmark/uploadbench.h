@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Bench {
+
+// UploadEngine::waitFor hazard check, with given amount of outstanding transfers:
+// linear scan over in-flight transfers (previous implementation) against per-resource last-transfer tag
+void uploadWaitForBenchmark(size_t transfers);
+
+}
@@ -0,0 +1,48 @@
+#version 450
+
+struct Inner {
+  float a;
+  vec3  b;
+  };
+
+layout(location = 0) in vec3  inPos;
+layout(location = 1) in ivec2 inId;
+layout(location = 2) in uint  inFlags;
+layout(location = 3) in mat2  inMat;
+
+layout(constant_id = 0) const uint  count = 2;
+layout(constant_id = 1) const bool  flag  = true;
+layout(constant_id = 2) const int   bias  = -1;
+layout(constant_id = 3) const float scale = 0.5;
+
+layout(std140, binding = 0) uniform Ubo {
+  mat4                     mvp;
+  vec4                     arr[3];
+  layout(row_major) mat3x4 rm;
+  Inner                    inner;
+  } ubo;
+
+layout(std430, binding = 1) readonly buffer Ro {
+  uint  n;
+  float data[];
+  } ro;
+
+layout(std430, binding = 2) buffer Rw {
+  vec4 v;
+  } rw;
+
+layout(binding = 3, rgba8) uniform image2D   img;
+layout(binding = 4)        uniform sampler2D tex[count];
+
+layout(push_constant) uniform Push {
+  vec2  p;
+  float q;
+  } push;
+
+void main() {
+  vec4 c = textureLod(tex[0],inPos.xy,0) + textureLod(tex[1],inPos.xy,0);
+  rw.v = vec4(ro.data[inFlags], float(ro.n), float(inId.x+bias), scale);
+  if(flag)
+    imageStore(img,inId,c);
+  gl_Position = ubo.mvp*vec4(inPos,1.0) + ubo.arr[2] + ubo.rm*vec3(inMat[0],ubo.inner.a) + vec4(push.p,push.q,ubo.inner.b.x);
+  }
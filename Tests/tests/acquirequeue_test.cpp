@@ -0,0 +1,90 @@
+#include "../gapi/acquirequeue.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+using namespace Tempest::Detail;
+
+namespace {
+
+struct TestCmd {
+  uint64_t serial = 0;
+  size_t   bytes  = 0;
+  };
+
+using Queue = AcquireQueue<TestCmd>;
+
+}
+
+TEST(main, AcquireQueue) {
+  Queue                 q;
+  std::vector<uint64_t> queue;
+  auto                  submit = [&](TestCmd& c){ queue.push_back(c.serial); };
+
+  TestCmd a{1}, b{2}, c{3};
+  EXPECT_TRUE(q.push(a,a.serial,a.bytes,true,submit));
+  EXPECT_TRUE(q.push(b,b.serial,b.bytes,true,submit));
+  EXPECT_TRUE(q.push(c,c.serial,c.bytes,true,submit));
+  EXPECT_EQ(q.size(),3u);
+  EXPECT_TRUE(queue.empty());
+
+  // graphics submission, that reads upload #2: only prefix goes to queue
+  q.submit(2,submit);
+  EXPECT_EQ(queue,(std::vector<uint64_t>{1u,2u}));
+  EXPECT_EQ(q.size(),1u);
+
+  // nothing depends on uploads
+  q.submit(0,submit);
+  EXPECT_EQ(q.size(),1u);
+
+  q.submit(uint64_t(-1),submit);
+  EXPECT_EQ(queue,(std::vector<uint64_t>{1u,2u,3u}));
+  EXPECT_EQ(q.size(),0u);
+  }
+
+TEST(main, AcquireQueueGraphicsWork) {
+  Queue                 q;
+  std::vector<uint64_t> queue;
+  auto                  submit = [&](TestCmd& c){ queue.push_back(c.serial); };
+
+  TestCmd a{1}, b{2}, gfx{3}, detached{0};
+  q.push(a,a.serial,a.bytes,true,submit);
+  q.push(b,b.serial,b.bytes,true,submit);
+
+  // batch with own graphics work may read earlier uploads: they are submitted before it
+  EXPECT_FALSE(q.push(gfx,gfx.serial,gfx.bytes,false,submit));
+  EXPECT_EQ(queue,(std::vector<uint64_t>{1u,2u,3u}));
+  EXPECT_EQ(q.size(),0u);
+
+  // detached batch (readback) has no serial, so it's never postponed
+  EXPECT_FALSE(q.push(detached,detached.serial,detached.bytes,true,submit));
+  EXPECT_EQ(queue,(std::vector<uint64_t>{1u,2u,3u,0u}));
+  }
+
+TEST(main, AcquireQueueLimit) {
+  Queue                 q;
+  std::vector<uint64_t> queue;
+  auto                  submit = [&](TestCmd& c){ queue.push_back(c.serial); };
+
+  const size_t chunk = Queue::MAX_BYTES/4;
+  TestCmd cmd[6] = {{1,chunk},{2,chunk},{3,chunk},{4,chunk},{5,chunk},{6,2*chunk}};
+  for(size_t i=0; i<4; ++i)
+    EXPECT_TRUE(q.push(cmd[i],cmd[i].serial,cmd[i].bytes,true,submit));
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(q.heldBytes(),Queue::MAX_BYTES);
+
+  // staging memory of postponed batches is bounded: oldest ones go to queue, so they can complete
+  EXPECT_TRUE(q.push(cmd[4],cmd[4].serial,cmd[4].bytes,true,submit));
+  EXPECT_EQ(queue,(std::vector<uint64_t>{1u}));
+  EXPECT_TRUE(q.push(cmd[5],cmd[5].serial,cmd[5].bytes,true,submit));
+  EXPECT_EQ(queue,(std::vector<uint64_t>{1u,2u,3u}));
+  EXPECT_EQ(q.size(),3u);
+  EXPECT_EQ(q.heldBytes(),Queue::MAX_BYTES);
+
+  // too big to be postponed at all
+  TestCmd big{7,Queue::MAX_BYTES+1};
+  EXPECT_FALSE(q.push(big,big.serial,big.bytes,true,submit));
+  EXPECT_EQ(queue,(std::vector<uint64_t>{1u,2u,3u,4u,5u,6u,7u}));
+  EXPECT_EQ(q.heldBytes(),0u);
+  }
@@ -1,5 +1,9 @@
 #include "../gapi/deviceallocator.h"
 
+#include <cstring>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
@@ -9,13 +13,25 @@ using namespace Tempest::Detail;
 struct TestDevice {
   using DeviceMemory=void*;
 
-  DeviceMemory alloc(size_t size, uint32_t /*typeId*/){
+  DeviceMemory alloc(size_t size, uint32_t /*typeId*/, bool dedicated){
+    lastSize      = size;
+    lastDedicated = dedicated;
     return std::malloc(size);
     }
 
-  void free(DeviceMemory m,size_t /*size*/,uint32_t /*typeId*/){
+  void free(DeviceMemory m,size_t /*size*/,uint32_t /*typeId*/, bool /*dedicated*/){
     std::free(m);
     }
+
+  void* map(DeviceMemory m,size_t /*size*/){
+    return m;
+    }
+
+  void unmap(DeviceMemory /*m*/){
+    }
+
+  size_t lastSize      = 0;
+  bool   lastDedicated = false;
   };
 
 TEST(main, DeviceAllocator) {
@@ -91,3 +107,302 @@ TEST(main, DeviceAllocatorAlign1) {
   memory.free(p1);
   memory.free(p3);
   }
+
+TEST(main, DeviceAllocatorReuse) {
+  TestDevice device;
+  DeviceAllocator<TestDevice> memory(device);
+
+  auto p1 = memory.alloc(64, 1,0,0, false);
+  auto p2 = memory.alloc(64, 1,0,0, false);
+  auto p3 = memory.alloc(64, 1,0,0, false);
+  memory.free(p2);
+
+  auto p4 = memory.alloc(64, 1,0,0, false);
+  EXPECT_EQ(p4.page,   p2.page);
+  EXPECT_EQ(p4.offset, p2.offset);
+
+  memory.free(p1);
+  memory.free(p3);
+  memory.free(p4);
+  }
+
+TEST(main, DeviceAllocatorRandom) {
+  TestDevice device;
+  DeviceAllocator<TestDevice> memory(device);
+  std::vector<DeviceAllocator<TestDevice>::Allocation> live;
+
+  uint32_t seed = 1;
+  auto rand = [&seed]() {
+    seed = seed*1103515245u + 12345u;
+    return (seed>>8);
+    };
+
+  for(int i=0; i<20000; ++i) {
+    if(live.size()>0 && rand()%3==0) {
+      size_t id = rand()%live.size();
+      memory.free(live[id]);
+      live[id] = live.back();
+      live.pop_back();
+      continue;
+      }
+    static const size_t align[] = {1,4,6,256,1024};
+    size_t a  = align[rand()%5];
+    size_t sz = 1+rand()%(64*1024);
+    auto   p  = memory.alloc(sz,a,0,0,false);
+    ASSERT_NE(p.page,nullptr);
+    EXPECT_EQ(p.offset%a,0u);
+    for(auto& r:live) {
+      if(r.page!=p.page)
+        continue;
+      EXPECT_TRUE(r.offset+r.size<=p.offset || p.offset+p.size<=r.offset);
+      }
+    live.push_back(p);
+    }
+
+  for(auto& i:live)
+    memory.free(i);
+  }
+
+TEST(main, DeviceAllocatorDefragment) {
+  using Allocator = DeviceAllocator<TestDevice>;
+  TestDevice device;
+  Allocator  memory(device);
+
+  const size_t page = Allocator::DEFAULT_PAGE_SIZE;
+  const size_t all  = size_t(-1);
+  auto filler = memory.alloc(page/2,   1,0,0, false);
+  auto s1     = memory.alloc(1024,     1,0,0, false);
+  auto s2     = memory.alloc(1024,     1,0,0, false);
+  auto big    = memory.alloc(page*3/4, 1,0,0, false);
+  memory.free(filler);
+  EXPECT_EQ(s1.page,s2.page);
+  EXPECT_NE(s1.page,big.page);
+
+  std::vector<Allocator::Movable> mv;
+  EXPECT_EQ(memory.defragment(page,all,mv),0u); // nothing is relocatable yet
+
+  memory.setOwner(s1,&s1);
+  memory.setOwner(s2,&s2);
+  EXPECT_EQ(memory.defragment(page,1,mv),1024u); // move budget
+  ASSERT_EQ(mv.size(),1u);
+  EXPECT_EQ(mv[0].owner,&s1);
+
+  EXPECT_EQ(memory.defragment(page,all,mv),1024u);
+  ASSERT_EQ(mv.size(),2u);
+  EXPECT_EQ(mv[1].owner,&s2);
+
+  for(auto& m:mv) {
+    auto& a   = *reinterpret_cast<Allocator::Allocation*>(m.owner);
+    auto  dst = memory.relocate(m.src,a.size,256);
+    ASSERT_EQ(dst.page,big.page);
+    EXPECT_EQ(dst.offset%256,0u);
+    memory.setOwner(dst,&a);
+    memory.free(a);
+    a = dst;
+    }
+
+  mv.clear();
+  EXPECT_EQ(memory.defragment(page,all,mv),0u); // last page is pinned by 'big'
+
+  memory.free(s1);
+  memory.free(s2);
+  memory.free(big);
+  }
+
+TEST(main, DeviceAllocatorDefragmentFreed) {
+  using Allocator = DeviceAllocator<TestDevice>;
+  TestDevice device;
+  Allocator  memory(device);
+
+  const size_t page = Allocator::DEFAULT_PAGE_SIZE;
+  const size_t all  = size_t(-1);
+  auto filler = memory.alloc(page/2,   1,0,0, false);
+  auto s1     = memory.alloc(1024,     1,0,0, false);
+  auto s2     = memory.alloc(1024,     1,0,0, false);
+  auto s3     = memory.alloc(1024,     1,0,0, false);
+  auto big    = memory.alloc(page*3/4, 1,0,0, false);
+  memory.free(filler);
+
+  memory.setOwner(s1,&s1);
+  memory.setOwner(s2,&s2);
+  memory.setOwner(s3,&s3);
+
+  // free of movable buffer: owner is cleared right away, memory itself is released later
+  memory.setOwner(s1,nullptr);
+  std::vector<Allocator::Movable> mv;
+  EXPECT_EQ(memory.defragment(page,all,mv),0u);
+  memory.free(s1);
+
+  EXPECT_EQ(memory.defragment(1,all,mv),1024u);
+  ASSERT_EQ(mv.size(),1u);
+  EXPECT_EQ(mv[0].owner,&s2);
+
+  // s3 freed between two defragment steps
+  memory.setOwner(s3,nullptr);
+  EXPECT_EQ(memory.defragment(page,all,mv),0u);
+  EXPECT_EQ(mv.size(),1u);
+
+  memory.setOwner(s2,&s2);
+  memory.free(s2);
+  memory.free(s3);
+  memory.free(big);
+  }
+
+TEST(main, DeviceAllocatorDedicated) {
+  using Allocator = DeviceAllocator<TestDevice>;
+  TestDevice device;
+  Allocator  memory(device);
+
+  auto d = memory.dedicatedAlloc(1000*1000+4,4,0,0,false);
+  ASSERT_NE(d.page,nullptr);
+  EXPECT_EQ(device.lastSize,1000*1000+4u);
+  EXPECT_TRUE(device.lastDedicated);
+  memory.free(d);
+
+  auto p = memory.alloc(64,1,0,0,false);
+  EXPECT_FALSE(device.lastDedicated);
+  memory.free(p);
+  }
+
+TEST(main, DeviceAllocatorStats) {
+  using Allocator = DeviceAllocator<TestDevice>;
+  TestDevice device;
+  Allocator  memory(device);
+
+  const size_t page = Allocator::DEFAULT_PAGE_SIZE;
+  auto p1 = memory.alloc(1024,1,0,0, false);
+  auto p2 = memory.alloc(4096,1,0,0, false);
+  auto p3 = memory.alloc(1024,1,0,0, false);
+  auto p4 = memory.alloc(512, 1,2,1, false);
+  memory.free(p2);
+
+  Allocator::Stats st[3] = {};
+  memory.stats(st,3);
+  EXPECT_EQ(st[0].pages,      1u);
+  EXPECT_EQ(st[0].reserved,   page);
+  EXPECT_EQ(st[0].used,       2048u);
+  EXPECT_EQ(st[0].largestFree,page-1024*2-4096);
+  EXPECT_EQ(st[1].pages,      1u);
+  EXPECT_EQ(st[1].used,       512u);
+  EXPECT_EQ(st[2].pages,      0u);
+
+  memory.free(p1);
+  memory.free(p3);
+  memory.free(p4);
+  }
+
+TEST(main, DeviceAllocatorMapped) {
+  TestDevice device;
+  DeviceAllocator<TestDevice> memory(device);
+
+  auto p1 = memory.alloc(64, 1,0,0, true);
+  auto p2 = memory.alloc(128,1,2,1, false);
+  EXPECT_EQ(p1.page->mapped,p1.page->memory);
+  EXPECT_EQ(p2.page->mapped,nullptr);
+  memory.free(p1);
+  memory.free(p2);
+  }
+
+TEST(main, DeviceAllocatorPageSize) {
+  TestDevice device;
+  DeviceAllocator<TestDevice> memory(device,4096);
+
+  // stride-aligned sub-ranges, as used by vertex buffer arena
+  std::vector<DeviceAllocator<TestDevice>::Allocation> a;
+  for(size_t i=0; i<64; ++i) {
+    a.push_back(memory.alloc(36,12,0,0,false));
+    ASSERT_NE(a.back().page,nullptr);
+    EXPECT_EQ(a.back().offset%12,0u);
+    EXPECT_EQ(a.back().page,a.front().page);
+    }
+
+  auto big = memory.alloc(8192,1,0,0,false);
+  ASSERT_NE(big.page,nullptr);
+  EXPECT_NE(big.page,a.front().page);
+
+  memory.free(big);
+  for(auto& i:a)
+    memory.free(i);
+  }
+
+TEST(main, DeviceAllocatorThreads) {
+  TestDevice device;
+  DeviceAllocator<TestDevice> memory(device,256*1024);
+
+  // two threads per heap: same shard contends, different shards don't; overlap is caught by fill pattern
+  auto worker = [&memory](uint32_t id) {
+    std::vector<DeviceAllocator<TestDevice>::Allocation> live;
+    uint32_t seed = id+1;
+    auto rand = [&seed]() {
+      seed = seed*1103515245u + 12345u;
+      return (seed>>8);
+      };
+    auto check = [id](const DeviceAllocator<TestDevice>::Allocation& a) {
+      auto* p = reinterpret_cast<const uint8_t*>(a.page->mapped)+a.offset;
+      for(size_t i=0; i<a.size; ++i)
+        if(p[i]!=uint8_t(id))
+          return false;
+      return true;
+      };
+
+    for(int i=0; i<4000; ++i) {
+      if(live.size()>0 && rand()%3==0) {
+        size_t id = rand()%live.size();
+        EXPECT_TRUE(check(live[id]));
+        memory.free(live[id]);
+        live[id] = live.back();
+        live.pop_back();
+        continue;
+        }
+      size_t sz = 1+rand()%(4*1024);
+      auto   p  = memory.alloc(sz,16,id%2,id%2,true);
+      ASSERT_NE(p.page,nullptr);
+      std::memset(reinterpret_cast<uint8_t*>(p.page->mapped)+p.offset,int(id),p.size);
+      live.push_back(p);
+      }
+    for(auto& i:live) {
+      EXPECT_TRUE(check(i));
+      memory.free(i);
+      }
+    };
+
+  std::vector<std::thread> th;
+  for(uint32_t i=0; i<4; ++i)
+    th.emplace_back(worker,i);
+  for(auto& i:th)
+    i.join();
+
+  DeviceAllocator<TestDevice>::Stats st[2] = {};
+  memory.stats(st,2);
+  EXPECT_EQ(st[0].pages,0u);
+  EXPECT_EQ(st[1].pages,0u);
+  }
+
+TEST(main, DeviceAllocatorThreadShards) {
+  using Allocator = DeviceAllocator<TestDevice>;
+  TestDevice device;
+  Allocator  memory(device,4096);
+
+  // page of other thread is reused, while its shard is not busy; free goes to shard of the page
+  auto a = memory.alloc(1024,1,0,0,true);
+  Allocator::Allocation b, c;
+  std::thread th([&](){
+    b = memory.alloc(1024,1,0,0,true);
+    c = memory.alloc(4096,1,0,0,true);
+    memory.free(a);
+    });
+  th.join();
+  EXPECT_EQ(b.page,a.page);
+  ASSERT_NE(c.page,nullptr);
+  EXPECT_NE(c.page,a.page);
+
+  Allocator::Stats st[1] = {};
+  memory.stats(st,1);
+  EXPECT_EQ(st[0].pages,2u);
+
+  memory.free(b);
+  memory.free(c);
+  st[0] = Allocator::Stats();
+  memory.stats(st,1);
+  EXPECT_EQ(st[0].pages,0u);
+  }
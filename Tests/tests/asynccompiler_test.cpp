@@ -0,0 +1,46 @@
+#include "../gapi/asynccompiler.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <atomic>
+
+using namespace testing;
+using namespace Tempest::Detail;
+
+TEST(main, AsyncCompiler) {
+  AsyncCompiler    c(2);
+  std::atomic<int> done{0};
+
+  for(int i=0; i<32; ++i)
+    c.push([&](){ ++done; });
+  c.wait();
+  EXPECT_EQ(done.load(),32);
+  EXPECT_EQ(c.pending(),0u);
+
+  // idle compiler can be reused
+  c.push([&](){ ++done; });
+  c.wait();
+  EXPECT_EQ(done.load(),33);
+  }
+
+TEST(main, AsyncCompilerShutdown) {
+  std::atomic<int>  done{0};
+  std::atomic<bool> started{false}, release{false};
+  {
+  AsyncCompiler c(1);
+  c.push([&](){
+    started = true;
+    while(!release)
+      std::this_thread::yield();
+    ++done;
+    });
+  // waits behind blocked task, and is dropped by destructor
+  c.push([&](){ ++done; });
+  while(!started)
+    std::this_thread::yield();
+  release = true;
+  }
+  // first task was running and is completed; second one may or may not have started
+  EXPECT_GE(done.load(),1);
+  }
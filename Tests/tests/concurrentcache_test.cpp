@@ -0,0 +1,82 @@
+#include "../gapi/concurrentcache.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <stdexcept>
+#include <thread>
+
+using namespace testing;
+using namespace Tempest::Detail;
+
+TEST(main, ConcurrentCache) {
+  ConcurrentCache<uint32_t,uint32_t,std::hash<uint32_t>,std::equal_to<uint32_t>,true> cache;
+  int created = 0;
+
+  EXPECT_EQ(cache.find(1),nullptr);
+  for(uint32_t i=0; i<100; ++i) {
+    auto& v = cache.get(i,[&](uint32_t k, uint32_t& v){ v = k*10; ++created; });
+    EXPECT_EQ(v,i*10);
+    }
+  EXPECT_EQ(created,100);
+  EXPECT_EQ(cache.size(),100u);
+
+  // table was grown several times: values keep their address
+  uint32_t* v5 = cache.find(5);
+  ASSERT_NE(v5,nullptr);
+  EXPECT_EQ(*v5,50u);
+  for(uint32_t i=100; i<1000; ++i)
+    cache.get(i,[&](uint32_t k, uint32_t& v){ v = k*10; ++created; });
+  EXPECT_EQ(cache.find(5),v5);
+
+  // existing value: init is not called
+  cache.get(5,[&](uint32_t, uint32_t&){ ++created; });
+  EXPECT_EQ(created,1000);
+
+  auto st = cache.stats();
+  EXPECT_EQ(st.size,1000u);
+  EXPECT_GT(st.lookups,0u);
+  EXPECT_GE(st.probes,st.lookups);
+  EXPECT_GT(st.hits,0u);
+
+  // no counters by default
+  ConcurrentCache<uint32_t,uint32_t> plain;
+  plain.get(1,[](uint32_t, uint32_t& v){ v = 1; });
+  EXPECT_NE(plain.find(1),nullptr);
+  EXPECT_EQ(plain.stats().lookups,0u);
+  EXPECT_EQ(plain.stats().size,1u);
+  }
+
+TEST(main, ConcurrentCacheInitThrows) {
+  ConcurrentCache<uint32_t,uint32_t> cache;
+  bool thrown = false;
+  try {
+    cache.get(1,[](uint32_t, uint32_t&){ throw std::runtime_error("fail"); });
+    }
+  catch(const std::runtime_error&) {
+    thrown = true;
+    }
+  EXPECT_TRUE(thrown);
+  EXPECT_EQ(cache.find(1),nullptr);
+  EXPECT_EQ(cache.size(),0u);
+  auto& v = cache.get(1,[](uint32_t, uint32_t& v){ v = 7; });
+  EXPECT_EQ(v,7u);
+  }
+
+TEST(main, ConcurrentCacheThreads) {
+  ConcurrentCache<uint32_t,uint32_t> cache;
+  std::atomic<int>                   created{0};
+
+  std::vector<std::thread> th;
+  for(int t=0; t<4; ++t)
+    th.emplace_back([&](){
+      for(uint32_t i=0; i<2000; ++i) {
+        auto& v = cache.get(i%500,[&](uint32_t k, uint32_t& v){ v = k+1; ++created; });
+        EXPECT_EQ(v,i%500+1);
+        }
+      });
+  for(auto& i:th)
+    i.join();
+  // every key is created exactly once
+  EXPECT_EQ(created.load(),500);
+  }
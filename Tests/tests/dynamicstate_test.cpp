@@ -0,0 +1,71 @@
+#include "../gapi/dynamicstate.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+TEST(main, DynamicStateBase) {
+  RenderState alpha;
+  alpha.setBlendSource  (RenderState::BlendMode::src_alpha);
+  alpha.setBlendDest    (RenderState::BlendMode::one_minus_src_alpha);
+  alpha.setZWriteEnabled(false);
+  alpha.setCullFaceMode (RenderState::CullMode::NoCull);
+
+  auto st = DynamicState::baseState(alpha,DynamicState::Blend);
+  EXPECT_FALSE(st.hasBlend());
+  EXPECT_TRUE (st.isZWriteEnabled());
+  EXPECT_EQ   (st.cullFaceMode(),RenderState::CullMode::NoCull);
+
+  st = DynamicState::baseState(alpha,DynamicState::Topology);
+  EXPECT_TRUE (st.hasBlend());
+  EXPECT_EQ   (DynamicState::baseTopology(Lines,DynamicState::Topology),Triangles);
+  EXPECT_EQ   (DynamicState::baseTopology(Lines,DynamicState::Blend),   Lines);
+
+  EXPECT_EQ(DynamicState(alpha,Lines).diff(DynamicState(alpha,Triangles)),DynamicState::Topology);
+  EXPECT_EQ(DynamicState(alpha,Lines).diff(DynamicState(RenderState(),Lines)),DynamicState::Blend);
+  }
+
+TEST(main, DynamicStateTracker) {
+  RenderState alpha;
+  alpha.setBlendSource(RenderState::BlendMode::src_alpha);
+  alpha.setBlendDest  (RenderState::BlendMode::one_minus_src_alpha);
+
+  const DynamicState  opaque(RenderState(),Triangles);
+  const DynamicState  blend (alpha,Triangles);
+  const uint8_t       dyn = DynamicState::Blend;
+  DynamicStateTracker t;
+
+  auto c = t.bind(1,dyn,opaque);
+  EXPECT_TRUE(c.bindPipeline);
+  EXPECT_EQ  (c.setState,DynamicState::Blend);
+
+  // same native pipeline: state change only
+  c = t.bind(1,dyn,blend);
+  EXPECT_FALSE(c.bindPipeline);
+  EXPECT_EQ   (c.setState,DynamicState::Blend);
+
+  c = t.bind(1,dyn,blend);
+  EXPECT_FALSE(c.bindPipeline);
+  EXPECT_EQ   (c.setState,DynamicState::None);
+
+  // other pipeline with dynamic blend keeps state
+  c = t.bind(2,dyn,blend);
+  EXPECT_TRUE(c.bindPipeline);
+  EXPECT_EQ  (c.setState,DynamicState::None);
+
+  // baked pipeline invalidates it
+  c = t.bind(3,DynamicState::None,blend);
+  EXPECT_TRUE(c.bindPipeline);
+  EXPECT_EQ  (c.setState,DynamicState::None);
+  c = t.bind(2,dyn,blend);
+  EXPECT_TRUE(c.bindPipeline);
+  EXPECT_EQ  (c.setState,DynamicState::Blend);
+
+  t.reset();
+  c = t.bind(2,dyn,blend);
+  EXPECT_TRUE(c.bindPipeline);
+  EXPECT_EQ  (c.setState,DynamicState::Blend);
+  }
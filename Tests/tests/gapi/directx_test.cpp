@@ -130,6 +130,42 @@ TEST(DirectX12Api,PushRemapping) {
 #endif
   }
 
+TEST(DirectX12Api,SpecializationConstants) {
+#if defined(_MSC_VER)
+  GapiTestCommon::specializationConstants<DirectX12Api>();
+#endif
+  }
+
+TEST(DirectX12Api,TextureStreaming) {
+#if defined(_MSC_VER)
+  GapiTestCommon::textureStreaming<DirectX12Api>();
+#endif
+  }
+
+TEST(DirectX12Api,ReadbackAsync) {
+#if defined(_MSC_VER)
+  GapiTestCommon::readbackAsync<DirectX12Api>();
+#endif
+  }
+
+TEST(DirectX12Api,ConcurrentResources) {
+#if defined(_MSC_VER)
+  GapiTestCommon::concurrentResources<DirectX12Api>();
+#endif
+  }
+
+TEST(DirectX12Api,TextureUpdate) {
+#if defined(_MSC_VER)
+  GapiTestCommon::textureUpdate<DirectX12Api>();
+#endif
+  }
+
+TEST(DirectX12Api,TextureLoadDirect) {
+#if defined(_MSC_VER)
+  GapiTestCommon::textureLoadDirect<DirectX12Api>();
+#endif
+  }
+
 TEST(DirectX12Api,SpirvDefect) {
 #if defined(_MSC_VER)
   using namespace Tempest;
@@ -168,3 +204,9 @@ TEST(DirectX12Api,SpirvDefect) {
     }
 #endif
   }
+
+TEST(DirectX12Api,PipelinePrewarm) {
+#if defined(_MSC_VER)
+  GapiTestCommon::pipelinePrewarm<DirectX12Api>();
+#endif
+  }
@@ -1,15 +1,26 @@
 #pragma once
 
 #include <Tempest/Device>
+#include <Tempest/Dir>
 #include <Tempest/Except>
 #include <Tempest/Fence>
 #include <Tempest/Pixmap>
 #include <Tempest/Log>
+#include <Tempest/MemReader>
+#include <Tempest/MemWriter>
+#include <Tempest/TextureStreamer>
 #include <Tempest/Vec>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
 namespace GapiTestCommon {
 
 struct Vertex {
@@ -19,6 +30,46 @@ struct Vertex {
 static const Vertex   vboData[3] = {{-1,-1},{1,-1},{1,1}};
 static const uint16_t iboData[3] = {0,1,2};
 
+// fresh directory in system temp dir, removed together with it's files: on-disk caches don't see earlier runs
+class TempDir {
+  public:
+    explicit TempDir(const char* name) {
+      const char* base = nullptr;
+      for(auto env:{"TMPDIR","TEMP","TMP"})
+        if((base = std::getenv(env))!=nullptr)
+          break;
+      path  = (base!=nullptr ? base : "/tmp");
+      path += "/";
+      path += name;
+      path += "-"+std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+      EXPECT_TRUE(Tempest::Dir::create(path.c_str()));
+      }
+
+    ~TempDir() {
+      Tempest::Dir::scan(path,[this](const std::string& f, Tempest::Dir::FileType t){
+        if(t==Tempest::Dir::FT_File)
+          std::remove((path+"/"+f).c_str());
+        });
+      Tempest::Dir::remove(path.c_str());
+      }
+
+    const char* c_str() const { return path.c_str(); }
+
+    // name of file, that starts with prefix and ends with suffix; empty string, if there is none
+    std::string find(const std::string& prefix, const std::string& suffix) const {
+      std::string ret;
+      Tempest::Dir::scan(path,[&](const std::string& f, Tempest::Dir::FileType t){
+        if(t==Tempest::Dir::FT_File && f.size()>=prefix.size()+suffix.size() &&
+           f.compare(0,prefix.size(),prefix)==0 && f.compare(f.size()-suffix.size(),suffix.size(),suffix)==0)
+          ret = f;
+        });
+      return ret;
+      }
+
+  private:
+    std::string path;
+  };
+
 template<class GraphicsApi>
 void init() {
   using namespace Tempest;
@@ -586,4 +637,470 @@ void pushConstant() {
       throw;
     }
   }
+
+template<class GraphicsApi>
+void specializationConstants() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto cs = device.loadShader("shader/spec_const.comp.sprv");
+
+    SpecializationConstants spec;
+    spec.set(0,int32_t(-3));
+    spec.set(1,int32_t(5)); // converted to float, as declared in shader
+    spec.set(2,true);
+    spec.set(7,1.f);        // not declared in shader: ignored
+
+    auto dispatch = [&](const ComputePipeline& pso) {
+      auto output = device.ssbo(nullptr,sizeof(Vec4));
+      auto ubo    = device.descriptors(pso.layout());
+      ubo.set(0,output);
+
+      auto cmd = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setUniforms(pso,ubo);
+        enc.dispatch(1,1,1);
+      }
+      auto sync = device.fence();
+      device.submit(cmd,sync);
+      sync.wait();
+
+      Vec4 ret = {};
+      device.readBytes(output,&ret,sizeof(ret));
+      return ret;
+      };
+
+    auto def = device.pipeline(cs);
+    auto sp  = device.pipeline(cs,spec);
+
+    const Vec4 a = dispatch(def);
+    const Vec4 b = dispatch(sp);
+    EXPECT_EQ(a,Vec4(1,2,0,4));
+    EXPECT_EQ(b,Vec4(-3,5,1,4));
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void textureStreaming() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    std::vector<uint8_t> png;
+    {
+      Pixmap    pm(32,16,Pixmap::Format::RGB);
+      MemWriter w(png);
+      pm.save(w,"png");
+    }
+
+    TextureStreamer stream(device);
+    auto tex  = stream.load(std::unique_ptr<IDevice>(new MemReader(png)),TextureStreamer::High);
+    auto lost = stream.load("missing_file.png",TextureStreamer::Low);
+    auto drop = stream.load(std::unique_ptr<IDevice>(new MemReader(png)),TextureStreamer::Low);
+    drop.cancel();
+
+    // placeholder is usable right away
+    EXPECT_FALSE(tex.texture().isEmpty());
+
+    for(int i=0; i<1000 && !tex.isResident(); ++i) {
+      stream.update();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    while(lost.state()==TextureStreamer::Queued || lost.state()==TextureStreamer::Decoding)
+      std::this_thread::yield();
+
+    EXPECT_TRUE(tex.isResident());
+    EXPECT_EQ(tex.texture().w(),32);
+    EXPECT_EQ(tex.texture().h(),16);
+    EXPECT_EQ(lost.state(),TextureStreamer::Failed);
+    EXPECT_EQ(drop.state(),TextureStreamer::Cancelled);
+    EXPECT_EQ(drop.texture().w(),1);
+
+    // uploads are recorded by update(), within budget: at least one texture per call
+    stream.setFrameBudget(1);
+    auto a = stream.load(std::unique_ptr<IDevice>(new MemReader(png)));
+    auto b = stream.load(std::unique_ptr<IDevice>(new MemReader(png)));
+    while(a.state()<TextureStreamer::Decoded || b.state()<TextureStreamer::Decoded)
+      std::this_thread::yield();
+    ASSERT_EQ(a.state(),TextureStreamer::Decoded);
+    ASSERT_EQ(b.state(),TextureStreamer::Decoded);
+    const size_t bytes = stream.update();
+    EXPECT_NE(a.isResident(),b.isResident());
+    // budget counts all mips: rgb or rgba, depending on device
+    EXPECT_TRUE(bytes==2049 || bytes==2732);
+    EXPECT_EQ(stream.update(),bytes);
+    EXPECT_TRUE(a.isResident() && b.isResident());
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void readbackAsync() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    const Vec4 inputCpu[2] = {Vec4(0,1,2,3),Vec4(4,5,6,7)};
+    auto ssbo = device.ssbo(inputCpu,sizeof(inputCpu));
+
+    Pixmap pm(4,4,Pixmap::Format::RGBA);
+    std::memset(pm.data(),127,pm.dataSize());
+    auto tex  = device.loadTexture(pm,false);
+
+    auto rbuf = ssbo.readAsync(sizeof(Vec4),sizeof(Vec4));
+    auto rtex = device.readPixelsAsync(tex);
+    EXPECT_EQ(rbuf.size(),sizeof(Vec4));
+
+    while(!rbuf.isReady())
+      std::this_thread::yield();
+
+    Vec4 outputCpu = {};
+    rbuf.read(&outputCpu);
+    EXPECT_EQ(outputCpu,inputCpu[1]);
+
+    auto px = rtex.pixmap();
+    ASSERT_EQ(px.w(),4u);
+    ASSERT_EQ(px.h(),4u);
+    EXPECT_EQ(reinterpret_cast<const uint8_t*>(px.data())[5],127);
+
+    // upload is submitted by frame, that doesn't read texture: acquire of it may be still postponed
+    std::memset(pm.data(),200,pm.dataSize());
+    auto tex2 = device.loadTexture(pm,false);
+    auto cmd  = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+    }
+    auto sync = device.fence();
+    device.submit(cmd,sync);
+    sync.wait();
+
+    auto px2 = device.readPixelsAsync(tex2).pixmap();
+    ASSERT_EQ(px2.w(),4u);
+    EXPECT_EQ(reinterpret_cast<const uint8_t*>(px2.data())[5],200);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void concurrentResources() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    const size_t threads   = 4;
+    const size_t perThread = 32;
+
+    std::vector<StorageBuffer>      ssbo(threads*perThread);
+    std::vector<Texture2d>          tex (threads*perThread);
+    std::vector<std::exception_ptr> err (threads);
+
+    std::vector<std::thread> th;
+    for(size_t t=0; t<threads; ++t) {
+      th.emplace_back([&,t]() {
+        try {
+          for(size_t i=0; i<perThread; ++i) {
+            const size_t id = t*perThread+i;
+            std::vector<uint32_t> data(64,uint32_t(id));
+            ssbo[id] = device.ssbo(data);
+
+            Pixmap pm(8,8,Pixmap::Format::RGBA);
+            std::memset(pm.data(),int(id%251),pm.dataSize());
+            tex[id] = device.loadTexture(pm,i%2==0);
+            }
+          }
+        catch(...) {
+          err[t] = std::current_exception();
+          }
+        });
+      }
+    for(auto& i:th)
+      i.join();
+    for(auto& i:err)
+      if(i!=nullptr)
+        std::rethrow_exception(i);
+
+    for(size_t id=0; id<ssbo.size(); ++id) {
+      uint32_t out[64] = {};
+      device.readBytes(ssbo[id],out,sizeof(out));
+      EXPECT_EQ(out[0], uint32_t(id));
+      EXPECT_EQ(out[63],uint32_t(id));
+
+      auto pm = device.readPixels(tex[id]);
+      EXPECT_EQ(reinterpret_cast<const uint8_t*>(pm.data())[0],uint8_t(id%251));
+      }
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void textureUpdate() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    Pixmap pm(16,16,Pixmap::Format::RGBA);
+    std::memset(pm.data(),0,pm.dataSize());
+    auto tex = device.loadTexture(pm,false);
+
+    Pixmap sub(4,2,Pixmap::Format::RGBA);
+    std::memset(sub.data(),255,sub.dataSize());
+    device.updateTexture(tex,sub,8,4);
+
+    auto out = device.readPixels(tex);
+    ASSERT_EQ(out.w(),16u);
+    auto px = [&](uint32_t x, uint32_t y) {
+      return reinterpret_cast<const uint8_t*>(out.data())[(y*out.w()+x)*4];
+      };
+    EXPECT_EQ(px(8, 4),255);
+    EXPECT_EQ(px(11,5),255);
+    EXPECT_EQ(px(7, 4),0);
+    EXPECT_EQ(px(12,4),0);
+    EXPECT_EQ(px(8, 6),0);
+
+    // region out of bounds
+    EXPECT_THROW(device.updateTexture(tex,sub,14,0),std::system_error);
+    EXPECT_THROW(device.updateTexture(tex,sub,uint32_t(-2),0),std::system_error);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void textureLoadDirect() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    Pixmap pm(16,8,Pixmap::Format::RGB);
+    auto*  px = reinterpret_cast<uint8_t*>(pm.data());
+    for(size_t i=0; i<pm.dataSize(); ++i)
+      px[i] = uint8_t(i);
+
+    std::vector<uint8_t> mem;
+    MemWriter wr(mem);
+    pm.save(wr,"png");
+
+    MemReader rd(mem);
+    auto tex = device.loadTexture(rd,false);
+    auto ref = device.loadTexture(pm,false);
+    ASSERT_EQ(tex.w(),16);
+    ASSERT_EQ(tex.h(),8);
+    EXPECT_EQ(tex.format(),ref.format());
+
+    auto out0 = device.readPixels(tex);
+    auto out1 = device.readPixels(ref);
+    ASSERT_EQ(out0.dataSize(),out1.dataSize());
+    EXPECT_EQ(std::memcmp(out0.data(),out1.data(),out0.dataSize()),0);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void pipelineCache() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    TempDir     dir("tempest-pipeline-cache");
+    for(int pass=0; pass<2; ++pass) {
+      // second pass is seeded from file, written by first one
+      Device device(api);
+      device.setPipelineCacheDir(dir.c_str());
+      EXPECT_EQ(device.pipelineCacheStats().pipelinesLoaded,pass==1);
+
+      Vec4 inputCpu[3] = {Vec4(0,1,2,3),Vec4(4,5,6,7),Vec4(8,9,10,11)};
+
+      auto input  = device.ssbo(inputCpu,sizeof(inputCpu));
+      auto output = device.ssbo(nullptr, sizeof(inputCpu));
+
+      auto cs     = device.loadShader("shader/simple_test.comp.sprv");
+      auto pso    = device.pipeline(cs);
+
+      auto ubo    = device.descriptors(pso.layout());
+      ubo.set(0,input);
+      ubo.set(1,output);
+
+      auto cmd = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setUniforms(pso,ubo);
+        enc.dispatch(3,1,1);
+      }
+
+      auto sync = device.fence();
+      device.submit(cmd,sync);
+      sync.wait();
+      device.savePipelineCache();
+      EXPECT_FALSE(dir.find("pipeline-cache-",".bin").empty());
+
+      Vec4 outputCpu[3] = {};
+      device.readBytes(output,outputCpu,sizeof(outputCpu));
+      for(size_t i=0; i<3; ++i)
+        EXPECT_EQ(outputCpu[i],inputCpu[i]);
+      }
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void pipelinePrewarm() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    Device      device(api);
+
+    auto vbo  = device.vbo(vboData,3);
+    auto ibo  = device.ibo(iboData,3);
+
+    auto vert = device.loadShader("shader/simple_test.vert.sprv");
+    auto frag = device.loadShader("shader/simple_test.frag.sprv");
+    auto pso  = device.pipeline<Vertex>(Topology::Triangles,RenderState(),vert,frag);
+
+    auto tex  = device.attachment(TextureFormat::RGBA8,128,128);
+    auto fbo  = device.frameBuffer(tex);
+    auto rp   = device.pass(FboMode(FboMode::PreserveOut,Color(0.f,0.f,1.f)));
+
+    device.prewarm(pso,&fbo.layout(),1);
+    device.prewarm(device.builtin(),&fbo.layout(),1);
+    device.setAsyncPipelines(true);
+
+    // draws are skipped, until pipeline is compiled in background
+    bool drawn = false;
+    for(int i=0; i<1000 && !drawn; ++i) {
+      auto cmd  = device.commandBuffer();
+      {
+        auto enc = cmd.startEncoding(device);
+        enc.setFramebuffer(fbo,rp);
+        enc.setUniforms(pso);
+        enc.draw(vbo,ibo);
+      }
+      auto sync = device.fence();
+      device.submit(cmd,sync);
+      sync.wait();
+
+      auto  pm = device.readPixels(tex);
+      auto* px = reinterpret_cast<const uint8_t*>(pm.data());
+      for(size_t r=0; r<pm.dataSize(); r+=4)
+        if(px[r+0]!=0 || px[r+1]!=0 || px[r+2]!=255) {
+          drawn = true;
+          break;
+          }
+      if(!drawn)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    EXPECT_TRUE(drawn);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
+
+template<class GraphicsApi>
+void shaderCache() {
+  using namespace Tempest;
+
+  try {
+    GraphicsApi api{ApiFlags::Validation};
+    TempDir     dir("tempest-shader-cache");
+    {
+      Device device(api);
+      device.setPipelineCacheDir(dir.c_str());
+      // same module twice: reflected once, second call doesn't even look into cache
+      const size_t hits = device.pipelineCacheStats().shaderHits;
+      auto cs0  = device.loadShader("shader/simple_test.comp.sprv");
+      auto cs1  = device.loadShader("shader/simple_test.comp.sprv");
+      EXPECT_TRUE(cs0==cs1);
+      EXPECT_EQ(device.pipelineCacheStats().shaderHits,hits);
+      auto pso0 = device.pipeline(cs0);
+      auto pso1 = device.pipeline(cs1);
+      EXPECT_FALSE(pso0.isEmpty());
+      EXPECT_FALSE(pso1.isEmpty());
+      device.savePipelineCache();
+    }
+
+    // reflection comes from disk now
+    Device device(api);
+    device.setPipelineCacheDir(dir.c_str());
+
+    Vec4 inputCpu[3] = {Vec4(0,1,2,3),Vec4(4,5,6,7),Vec4(8,9,10,11)};
+
+    auto input  = device.ssbo(inputCpu,sizeof(inputCpu));
+    auto output = device.ssbo(nullptr, sizeof(inputCpu));
+
+    const size_t hits = device.pipelineCacheStats().shaderHits;
+    auto cs     = device.loadShader("shader/simple_test.comp.sprv");
+    EXPECT_EQ(device.pipelineCacheStats().shaderHits,hits+1);
+    auto pso    = device.pipeline(cs);
+
+    auto ubo    = device.descriptors(pso.layout());
+    ubo.set(0,input);
+    ubo.set(1,output);
+
+    auto cmd = device.commandBuffer();
+    {
+      auto enc = cmd.startEncoding(device);
+      enc.setUniforms(pso,ubo);
+      enc.dispatch(3,1,1);
+    }
+
+    auto sync = device.fence();
+    device.submit(cmd,sync);
+    sync.wait();
+
+    Vec4 outputCpu[3] = {};
+    device.readBytes(output,outputCpu,sizeof(outputCpu));
+    for(size_t i=0; i<3; ++i)
+      EXPECT_EQ(outputCpu[i],inputCpu[i]);
+    }
+  catch(std::system_error& e) {
+    if(e.code()==Tempest::GraphicsErrc::NoDevice)
+      Log::d("Skipping graphics testcase: ", e.what()); else
+      throw;
+    }
+  }
 }
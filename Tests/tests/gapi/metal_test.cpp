@@ -135,3 +135,45 @@ TEST(MetalApi,PushRemapping) {
   GapiTestCommon::pushConstant<MetalApi>();
 #endif
   }
+
+TEST(MetalApi,SpecializationConstants) {
+#if defined(__OSX__)
+  GapiTestCommon::specializationConstants<MetalApi>();
+#endif
+  }
+
+TEST(MetalApi,TextureStreaming) {
+#if defined(__OSX__)
+  GapiTestCommon::textureStreaming<MetalApi>();
+#endif
+  }
+
+TEST(MetalApi,ReadbackAsync) {
+#if defined(__OSX__)
+  GapiTestCommon::readbackAsync<MetalApi>();
+#endif
+  }
+
+TEST(MetalApi,ConcurrentResources) {
+#if defined(__OSX__)
+  GapiTestCommon::concurrentResources<MetalApi>();
+#endif
+  }
+
+TEST(MetalApi,TextureUpdate) {
+#if defined(__OSX__)
+  GapiTestCommon::textureUpdate<MetalApi>();
+#endif
+  }
+
+TEST(MetalApi,TextureLoadDirect) {
+#if defined(__OSX__)
+  GapiTestCommon::textureLoadDirect<MetalApi>();
+#endif
+  }
+
+TEST(MetalApi,PipelinePrewarm) {
+#if defined(__OSX__)
+  GapiTestCommon::pipelinePrewarm<MetalApi>();
+#endif
+  }
@@ -112,3 +112,57 @@ TEST(VulkanApi,PushRemapping) {
   GapiTestCommon::pushConstant<VulkanApi>();
 #endif
   }
+
+TEST(VulkanApi,SpecializationConstants) {
+#if !defined(__OSX__)
+  GapiTestCommon::specializationConstants<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,TextureStreaming) {
+#if !defined(__OSX__)
+  GapiTestCommon::textureStreaming<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,ReadbackAsync) {
+#if !defined(__OSX__)
+  GapiTestCommon::readbackAsync<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,ConcurrentResources) {
+#if !defined(__OSX__)
+  GapiTestCommon::concurrentResources<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,TextureUpdate) {
+#if !defined(__OSX__)
+  GapiTestCommon::textureUpdate<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,TextureLoadDirect) {
+#if !defined(__OSX__)
+  GapiTestCommon::textureLoadDirect<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,PipelineCache) {
+#if !defined(__OSX__)
+  GapiTestCommon::pipelineCache<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,PipelinePrewarm) {
+#if !defined(__OSX__)
+  GapiTestCommon::pipelinePrewarm<VulkanApi>();
+#endif
+  }
+
+TEST(VulkanApi,ShaderCache) {
+#if !defined(__OSX__)
+  GapiTestCommon::shaderCache<VulkanApi>();
+#endif
+  }
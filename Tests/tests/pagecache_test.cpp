@@ -0,0 +1,81 @@
+#include "../gapi/pagecache.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+using namespace Tempest::Detail;
+
+namespace {
+
+struct Released {
+  std::vector<int> memory;
+  void operator()(int m, size_t, uint32_t) { memory.push_back(m); }
+  };
+
+}
+
+TEST(main, PageCacheSizeClass) {
+  using Cache = PageCache<int>;
+  EXPECT_EQ(Cache::sizeClass(128*1024*1024),size_t(128*1024*1024));
+  EXPECT_EQ(Cache::sizeClass(1000),size_t(1024));
+  EXPECT_EQ(Cache::sizeClass(1025),size_t(1152));
+  for(size_t i=1; i<100000; i+=37) {
+    const size_t c = Cache::sizeClass(i);
+    EXPECT_GE(c,i);
+    EXPECT_LE(c-i,i/8+1);
+    EXPECT_EQ(Cache::sizeClass(c),c);
+    }
+  }
+
+TEST(main, PageCacheReuse) {
+  PageCache<int> cache(1000);
+  Released       rel;
+
+  cache.put(1,100,0,rel);
+  cache.put(2,100,1,rel);
+  cache.put(3,200,0,rel);
+  EXPECT_EQ(cache.size(),400u);
+  EXPECT_EQ(cache.cachedBytes(0),300u);
+
+  int m = 0;
+  EXPECT_FALSE(cache.take(100,2,m));
+  EXPECT_FALSE(cache.take(300,0,m));
+  EXPECT_TRUE(cache.take(100,1,m));
+  EXPECT_EQ(m,2);
+  EXPECT_TRUE(cache.take(100,0,m));
+  EXPECT_EQ(m,1);
+  EXPECT_EQ(cache.size(),200u);
+  EXPECT_TRUE(rel.memory.empty());
+  }
+
+TEST(main, PageCacheEviction) {
+  PageCache<int> cache(300);
+  Released       rel;
+
+  cache.put(1,100,0,rel);
+  cache.put(2,100,0,rel);
+  cache.put(3,100,0,rel);
+
+  int m = 0;
+  // touch: most recent entry is taken first
+  EXPECT_TRUE(cache.take(100,0,m));
+  EXPECT_EQ(m,3);
+  cache.put(3,100,0,rel);
+
+  cache.put(4,200,0,rel);
+  EXPECT_EQ(rel.memory,std::vector<int>({1,2}));
+  EXPECT_EQ(cache.size(),300u);
+
+  // does not fit at all
+  cache.put(5,400,0,rel);
+  EXPECT_EQ(rel.memory,std::vector<int>({1,2,5}));
+
+  cache.trim(200,rel);
+  EXPECT_EQ(rel.memory,std::vector<int>({1,2,5,3}));
+  cache.setCapacity(0,rel);
+  EXPECT_EQ(rel.memory,std::vector<int>({1,2,5,3,4}));
+  EXPECT_EQ(cache.size(),0u);
+  }
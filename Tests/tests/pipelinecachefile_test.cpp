@@ -0,0 +1,71 @@
+#include "../gapi/pipelinecachefile.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+using namespace Tempest::Detail;
+
+namespace {
+
+PipelineCacheFile::Key testKey() {
+  PipelineCacheFile::Key k;
+  k.vendor = 0x10DE;
+  k.device = 0x1F08;
+  k.driver = 42;
+  for(uint8_t i=0; i<16; ++i)
+    k.uuid[i] = i;
+  return k;
+  }
+
+}
+
+TEST(main, PipelineCacheFile) {
+  const auto    k       = testKey();
+  const uint8_t blob[5] = {1,2,3,4,5};
+
+  auto   file = PipelineCacheFile::pack(k,blob,sizeof(blob));
+  size_t size = 0;
+  auto*  data = PipelineCacheFile::unpack(k,file,size);
+  ASSERT_NE(data,nullptr);
+  EXPECT_EQ(size,sizeof(blob));
+  EXPECT_EQ(std::memcmp(data,blob,sizeof(blob)),0);
+
+  EXPECT_EQ(PipelineCacheFile::fileName(k),"pipeline-cache-000010de-00001f08-000102030405060708090a0b0c0d0e0f.bin");
+  }
+
+TEST(main, PipelineCacheFileReject) {
+  const auto    k       = testKey();
+  const uint8_t blob[5] = {1,2,3,4,5};
+  const auto    file    = PipelineCacheFile::pack(k,blob,sizeof(blob));
+  size_t        size    = 0;
+
+  // other driver version
+  auto k2 = k;
+  k2.driver = 43;
+  EXPECT_EQ(PipelineCacheFile::unpack(k2,file,size),nullptr);
+
+  // other cache uuid
+  k2 = k;
+  k2.uuid[15] = 0;
+  EXPECT_EQ(PipelineCacheFile::unpack(k2,file,size),nullptr);
+
+  // truncated
+  auto f2 = file;
+  f2.pop_back();
+  EXPECT_EQ(PipelineCacheFile::unpack(k,f2,size),nullptr);
+  f2.resize(4);
+  EXPECT_EQ(PipelineCacheFile::unpack(k,f2,size),nullptr);
+  EXPECT_EQ(PipelineCacheFile::unpack(k,std::vector<uint8_t>(),size),nullptr);
+
+  // damaged payload
+  f2 = file;
+  f2.back() ^= 0xFF;
+  EXPECT_EQ(PipelineCacheFile::unpack(k,f2,size),nullptr);
+
+  // not a cache file
+  f2 = file;
+  f2[0] = 'X';
+  EXPECT_EQ(PipelineCacheFile::unpack(k,f2,size),nullptr);
+  EXPECT_EQ(size,0u);
+  }
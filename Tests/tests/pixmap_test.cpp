@@ -2,6 +2,8 @@
 #include <Tempest/MemWriter>
 #include <Tempest/MemReader>
 
+#include "../formats/pixmapcodec.h"
+
 #include <gtest/gtest.h>
 #include <gmock/gmock-matchers.h>
 
@@ -54,3 +56,74 @@ TEST(main,PixmapConv) {
   EXPECT_EQ(px1.format(),Pixmap::Format::RGBA16);
   px1.save("tst-dxt5.png");
   }
+
+namespace {
+struct RowSink : PixmapCodec::Sink {
+  uint8_t* begin(uint32_t w, uint32_t h, Pixmap::Format& frm, size_t& stride) override {
+    if(frm==Pixmap::Format::RGB)
+      frm = Pixmap::Format::RGBA;
+    format = frm;
+    stride = w*4+16; // padded rows
+    mem.assign(stride*h,0xCD);
+    this->stride = stride;
+    return mem.data();
+    }
+
+  std::vector<uint8_t> mem;
+  Pixmap::Format       format = Pixmap::Format::R;
+  size_t               stride = 0;
+  };
+}
+
+TEST(main,PixmapDecodeRows) {
+  Pixmap pm(5,3,Pixmap::Format::RGB);
+  auto*  px = reinterpret_cast<uint8_t*>(pm.data());
+  for(size_t i=0; i<pm.dataSize(); ++i)
+    px[i] = uint8_t(i);
+
+  // png is decoded by rows, other formats through codec memory
+  static const char* frm[]={"png","tga"};
+  for(auto f:frm) {
+    std::vector<uint8_t> mem;
+    MemWriter wr(mem);
+    pm.save(wr,f);
+
+    MemReader rd(mem);
+    RowSink   sink;
+    ASSERT_TRUE(PixmapCodec::decodeImg(rd,sink));
+    ASSERT_EQ(sink.format,Pixmap::Format::RGBA);
+
+    for(uint32_t y=0; y<pm.h(); ++y)
+      for(uint32_t x=0; x<pm.w(); ++x) {
+        const uint8_t* s = px+(y*pm.w()+x)*3;
+        const uint8_t* d = sink.mem.data()+y*sink.stride+x*4;
+        EXPECT_EQ(d[0],s[0]);
+        EXPECT_EQ(d[1],s[1]);
+        EXPECT_EQ(d[2],s[2]);
+        EXPECT_EQ(d[3],255);
+        }
+    // padding is not touched
+    EXPECT_EQ(sink.mem[pm.w()*4],0xCD);
+    }
+  }
+
+TEST(main,PixmapDecodeRowsUnsupported) {
+  struct WideSink : PixmapCodec::Sink {
+    uint8_t* begin(uint32_t w, uint32_t h, Pixmap::Format& frm, size_t& stride) override {
+      frm    = Pixmap::Format::RGBA16; // other channel size: no conversion
+      stride = w*8;
+      mem.resize(stride*h);
+      return mem.data();
+      }
+    std::vector<uint8_t> mem;
+    };
+
+  Pixmap pm(2,2,Pixmap::Format::RGB);
+  std::vector<uint8_t> mem;
+  MemWriter wr(mem);
+  pm.save(wr,"png");
+
+  MemReader rd(mem);
+  WideSink  sink;
+  EXPECT_THROW(PixmapCodec::decodeImg(rd,sink),std::system_error);
+  }
@@ -0,0 +1,153 @@
+#include "../gapi/uploadengine.h"
+#include "../gapi/readbackring.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <cstring>
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+struct TestDevice;
+
+struct TestCmd {
+  explicit TestCmd(TestDevice&) {}
+  void begin() {}
+  void end()   {}
+  void reset() {}
+  };
+
+struct TestFence {
+  explicit TestFence(TestDevice& dev):dev(dev) {}
+  bool wait(uint64_t);
+  void wait() {}
+  TestDevice& dev;
+  };
+
+struct TestBuffer : AbstractGraphicsApi::Buffer {
+  TestBuffer()=default;
+  TestBuffer(TestBuffer&& other):data(std::move(other.data)) {}
+
+  void update(const void*,size_t,size_t,size_t,size_t) override {}
+  void read  (void* out,size_t off,size_t size) override { std::memcpy(out,data.data()+off,size); }
+  AbstractGraphicsApi::Readback* readAsync(size_t,size_t) override { return nullptr; }
+  void* map  () override { return nullptr; }
+  void  unmap() override {}
+
+  std::vector<uint8_t> data;
+  };
+
+struct TestAllocator {
+  TestBuffer alloc(const void*, size_t count, size_t /*size*/, size_t alignedSz, MemUsage, BufferHeap) {
+    TestBuffer b;
+    b.data.resize(count*alignedSz);
+    ++allocs;
+    return b;
+    }
+  size_t allocs=0;
+  };
+
+struct TestDevice {
+  using DataMgr     = UploadEngine<TestDevice,TestCmd,TestFence,TestBuffer>;
+  using ReadbackMgr = ReadbackRing<TestDevice,TestBuffer>;
+  using Readback    = AsyncReadback<TestDevice,TestBuffer>;
+
+  TestDevice():data(*this), readback(*this) {}
+
+  DataMgr&     dataMgr()     { return data;     }
+  ReadbackMgr& readbackMgr() { return readback; }
+  void         submit(TestCmd&, TestFence&) { ++submits; }
+
+  TestAllocator allocator;
+  bool          gpuDone  = false;
+  size_t        submits  = 0;
+  DataMgr       data;
+  ReadbackMgr   readback;
+  };
+
+bool TestFence::wait(uint64_t) {
+  return dev.gpuDone;
+  }
+
+}
+
+TEST(main, RingAllocator) {
+  RingAllocator ring(1024);
+
+  size_t a = ring.alloc(400,16);
+  size_t b = ring.alloc(400,16);
+  EXPECT_EQ(a,0u);
+  EXPECT_EQ(b,400u);
+  // doesn't fit at the end, and front is still in use
+  EXPECT_EQ(ring.alloc(400,16),RingAllocator::npos);
+
+  // out of order free: space is not reclaimed, until front block is freed
+  ring.free(b);
+  EXPECT_EQ(ring.alloc(400,16),RingAllocator::npos);
+  ring.free(a);
+  EXPECT_TRUE(ring.isEmpty());
+
+  a = ring.alloc(600,16);
+  b = ring.alloc(300,16);
+  EXPECT_EQ(a,0u);
+  EXPECT_EQ(b,608u);
+  ring.free(a);
+  // wraps around
+  size_t c = ring.alloc(500,16);
+  EXPECT_EQ(c,0u);
+  EXPECT_EQ(ring.alloc(200,16),RingAllocator::npos);
+  EXPECT_EQ(ring.alloc(2000,16),RingAllocator::npos);
+  }
+
+TEST(main, AsyncReadback) {
+  TestDevice dev;
+
+  std::unique_ptr<TestDevice::Readback> rb(new TestDevice::Readback(dev,4,4,1,16));
+  // "gpu copy"
+  std::memcpy(rb->staging().data.data()+rb->offset(),"abcd",4);
+  rb->submit();
+  EXPECT_EQ(dev.submits,1u);
+  EXPECT_EQ(dev.allocator.allocs,1u);
+
+  EXPECT_FALSE(rb->isReady());
+  dev.gpuDone = true;
+  EXPECT_TRUE(rb->isReady());
+
+  char out[4] = {};
+  rb->read(out);
+  EXPECT_EQ(std::memcmp(out,"abcd",4),0);
+
+  // second readback shares persistent ring
+  std::unique_ptr<TestDevice::Readback> rb2(new TestDevice::Readback(dev,4,4,1,16));
+  EXPECT_EQ(&rb2->staging(),&rb->staging());
+  EXPECT_NE(rb2->offset(),rb->offset());
+  rb2->submit();
+  rb.reset();
+  rb2.reset();
+  EXPECT_EQ(dev.allocator.allocs,1u);
+
+  // too big for ring: dedicated staging buffer
+  std::unique_ptr<TestDevice::Readback> big(new TestDevice::Readback(dev,TestDevice::ReadbackMgr::RING_SIZE,TestDevice::ReadbackMgr::RING_SIZE,1,16));
+  EXPECT_EQ(dev.allocator.allocs,2u);
+  EXPECT_EQ(big->offset(),0u);
+  }
+
+TEST(main, AsyncReadbackPitch) {
+  TestDevice dev;
+  dev.gpuDone = true;
+
+  // 2 rows of 3 bytes, 8 bytes apart
+  TestDevice::Readback rb(dev,3,8,2,16);
+  auto* st = rb.staging().data.data()+rb.offset();
+  std::memcpy(st,  "abc",3);
+  std::memcpy(st+8,"def",3);
+  rb.submit();
+
+  char out[6] = {};
+  rb.read(out);
+  EXPECT_EQ(std::memcmp(out,"abcdef",6),0);
+  }
@@ -0,0 +1,98 @@
+#include "../gapi/shadercache.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+ShaderCache::Reflection testReflection() {
+  ShaderCache::Reflection r;
+  r.vdecl = {Decl::float2, Decl::float4};
+
+  ShaderReflection::Binding b;
+  b.layout = 0;
+  b.cls    = ShaderReflection::Ubo;
+  b.stage  = ShaderReflection::Vertex;
+  b.size   = 64;
+  r.lay.push_back(b);
+
+  b.layout = 1;
+  b.cls    = ShaderReflection::Texture;
+  b.stage  = ShaderReflection::Fragment;
+  b.size   = 0;
+  r.lay.push_back(b);
+
+  ShaderReflection::SpecConstant c;
+  c.id    = 3;
+  c.type  = SpecializationConstants::Float;
+  c.stage = ShaderReflection::Fragment;
+  r.spec.push_back(c);
+  return r;
+  }
+
+}
+
+TEST(main, ShaderCache) {
+  const uint32_t spirv[4] = {0x07230203,0x00010000,1,2};
+  const uint32_t other[4] = {0x07230203,0x00010000,1,3};
+
+  auto k0 = ShaderCache::key(spirv,sizeof(spirv));
+  auto k1 = ShaderCache::key(other,sizeof(other));
+  EXPECT_FALSE(k0==k1);
+  EXPECT_TRUE (k0==ShaderCache::key(spirv,sizeof(spirv)));
+
+  ShaderCache             cache;
+  ShaderCache::Reflection r;
+  EXPECT_FALSE(cache.find(k0,r));
+  cache.insert(k0,testReflection());
+  EXPECT_TRUE (cache.isDirty());
+  EXPECT_TRUE (cache.find(k0,r));
+  EXPECT_FALSE(cache.find(k1,r));
+  EXPECT_EQ(cache.hits(),1u);
+
+  auto file = cache.serialize();
+  EXPECT_FALSE(cache.isDirty());
+
+  ShaderCache ld;
+  ASSERT_TRUE(ld.deserialize(file));
+  EXPECT_FALSE(ld.isDirty());
+  EXPECT_EQ(ld.hits(),0u);
+  ASSERT_TRUE(ld.find(k0,r));
+  EXPECT_EQ(ld.hits(),1u);
+  ASSERT_EQ(r.vdecl.size(),2u);
+  EXPECT_EQ(r.vdecl[1],Decl::float4);
+  ASSERT_EQ(r.lay.size(),2u);
+  EXPECT_EQ(r.lay[0].size, 64u);
+  EXPECT_EQ(r.lay[0].stage,ShaderReflection::Vertex);
+  EXPECT_EQ(r.lay[1].cls,  ShaderReflection::Texture);
+  EXPECT_EQ(r.lay[1].layout,1u);
+  ASSERT_EQ(r.spec.size(),1u);
+  EXPECT_EQ(r.spec[0].id,  3u);
+  EXPECT_EQ(r.spec[0].type,SpecializationConstants::Float);
+  }
+
+TEST(main, ShaderCacheReject) {
+  const uint32_t spirv[4] = {0x07230203,0x00010000,1,2};
+  auto           k        = ShaderCache::key(spirv,sizeof(spirv));
+
+  ShaderCache src;
+  src.insert(k,testReflection());
+  const auto file = src.serialize();
+
+  ShaderCache             cache;
+  ShaderCache::Reflection r;
+  auto f = file;
+  f[f.size()/2] ^= 0xFF;
+  EXPECT_FALSE(cache.deserialize(f));
+
+  f = file;
+  f.resize(f.size()-1);
+  EXPECT_FALSE(cache.deserialize(f));
+  EXPECT_FALSE(cache.deserialize(std::vector<uint8_t>()));
+  EXPECT_FALSE(cache.find(k,r));
+  EXPECT_EQ(cache.size(),0u);
+  }
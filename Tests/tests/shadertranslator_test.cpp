@@ -0,0 +1,152 @@
+#include "../gapi/shadertranslator.h"
+#include "../gapi/translationcache.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+// layout(location = 0) out vec4 outColor;
+// layout(binding = 1) uniform Ubo { vec4 v; } ubo;
+// layout(constant_id = 0) const float sc = 0.5;
+// void main() { outColor = ubo.v*sc; }
+const uint32_t frag[] = {
+  0x07230203,0x00010000,0x00000000,0x00000013,0x00000000,0x00020011,0x00000001,0x0003000e,
+  0x00000000,0x00000001,0x0006000f,0x00000004,0x00000001,0x6e69616d,0x00000000,0x00000002,
+  0x00030010,0x00000001,0x00000007,0x00040047,0x00000002,0x0000001e,0x00000000,0x00040047,
+  0x00000003,0x00000001,0x00000000,0x00030047,0x00000004,0x00000002,0x00050048,0x00000004,
+  0x00000000,0x00000023,0x00000000,0x00040047,0x00000005,0x00000022,0x00000000,0x00040047,
+  0x00000005,0x00000021,0x00000001,0x00020013,0x00000006,0x00030021,0x00000007,0x00000006,
+  0x00030016,0x00000008,0x00000020,0x00040015,0x00000009,0x00000020,0x00000001,0x00040017,
+  0x0000000a,0x00000008,0x00000004,0x00040020,0x0000000b,0x00000003,0x0000000a,0x0003001e,
+  0x00000004,0x0000000a,0x00040020,0x0000000c,0x00000002,0x00000004,0x00040020,0x0000000d,
+  0x00000002,0x0000000a,0x0004003b,0x0000000b,0x00000002,0x00000003,0x0004003b,0x0000000c,
+  0x00000005,0x00000002,0x0004002b,0x00000009,0x0000000e,0x00000000,0x00040032,0x00000008,
+  0x00000003,0x3f000000,0x00050036,0x00000006,0x00000001,0x00000000,0x00000007,0x000200f8,
+  0x0000000f,0x00050041,0x0000000d,0x00000010,0x00000005,0x0000000e,0x0004003d,0x0000000a,
+  0x00000011,0x00000010,0x0005008e,0x0000000a,0x00000012,0x00000011,0x00000003,0x0003003e,
+  0x00000002,0x00000012,0x000100fd,0x00010038,
+  };
+
+ShaderTranslator::Profile mslMacOS() {
+  auto p = ShaderTranslator::msl();
+  p.target = ShaderTranslator::MslMacOS;
+  return p;
+  }
+
+}
+
+TEST(main, ShaderTranslatorHlsl) {
+  ShaderTranslator::Result r;
+  ShaderTranslator::translate(r,ShaderTranslator::hlsl(),frag,sizeof(frag)/4);
+
+  EXPECT_THAT(r.source,HasSubstr("main"));
+  EXPECT_EQ(r.stage,ShaderReflection::Fragment);
+  EXPECT_TRUE(r.vdecl.empty());
+  ASSERT_EQ(r.lay.size(),1u);
+  EXPECT_EQ(r.lay[0].layout,1u);
+  EXPECT_EQ(r.lay[0].cls,  ShaderReflection::Ubo);
+  EXPECT_EQ(r.lay[0].stage,ShaderReflection::Fragment);
+  EXPECT_EQ(r.lay[0].size, 16u);
+  ASSERT_EQ(r.spec.size(),1u);
+  EXPECT_EQ(r.spec[0].id,  0u);
+  EXPECT_EQ(r.spec[0].type,SpecializationConstants::Float);
+
+  // hlsl has no specialization: value is baked into source
+  ShaderReflection::SpecValue v;
+  v.id   = 0;
+  v.type = SpecializationConstants::Float;
+  v.bits = 0x40400000; // 3.0
+  const std::vector<ShaderReflection::SpecValue> values = {v};
+  ShaderTranslator::Result sp;
+  ShaderTranslator::translate(sp,ShaderTranslator::hlsl(),frag,sizeof(frag)/4,&values);
+  EXPECT_NE(sp.source,r.source);
+  EXPECT_THAT(sp.source,HasSubstr("3.0"));
+  EXPECT_TRUE(sp.lay.empty());
+  }
+
+TEST(main, ShaderTranslatorMsl) {
+  ShaderTranslator::Result r;
+  ShaderTranslator::translate(r,mslMacOS(),frag,sizeof(frag)/4);
+
+  EXPECT_THAT(r.source,HasSubstr("main0"));
+  EXPECT_THAT(r.source,HasSubstr("function_constant"));
+  ASSERT_EQ(r.lay.size(),1u);
+  EXPECT_EQ(r.lay[0].cls,ShaderReflection::Ubo);
+  EXPECT_NE(r.lay[0].mslBinding,uint32_t(-1));
+  EXPECT_EQ(r.lay[0].mslBinding2,uint32_t(-1));
+  }
+
+TEST(main, ShaderTranslatorInvalid) {
+  const uint32_t junk[] = {0x07230203,0x00010000,0,5,0,0xFFFFFFFF};
+  ShaderTranslator::Result r;
+  EXPECT_THROW(ShaderTranslator::translate(r,ShaderTranslator::hlsl(),junk,sizeof(junk)/4),std::system_error);
+
+  TranslationCache cache(ShaderTranslator::hlsl());
+  EXPECT_THROW(cache.translate(r,frag,sizeof(frag)-1),std::system_error);
+  EXPECT_EQ(cache.size(),0u);
+  }
+
+TEST(main, TranslationCache) {
+  TranslationCache cache(mslMacOS());
+  EXPECT_EQ(cache.fileName(),"shader-msl-macos10200.bin");
+
+  ShaderTranslator::Result r;
+  cache.translate(r,frag,sizeof(frag));
+  EXPECT_TRUE(cache.isDirty());
+  EXPECT_EQ(cache.size(),1u);
+
+  auto file = cache.serialize();
+  EXPECT_FALSE(cache.isDirty());
+
+  TranslationCache ld(mslMacOS());
+  ASSERT_TRUE(ld.deserialize(file));
+  ShaderTranslator::Result c;
+  ASSERT_TRUE(ld.find(ShaderCache::key(frag,sizeof(frag)),c));
+  EXPECT_EQ(c.source,r.source);
+  EXPECT_EQ(c.stage, r.stage);
+  ASSERT_EQ(c.lay.size(),r.lay.size());
+  EXPECT_EQ(c.lay[0].cls,        r.lay[0].cls);
+  EXPECT_EQ(c.lay[0].size,       r.lay[0].size);
+  EXPECT_EQ(c.lay[0].mslBinding, r.lay[0].mslBinding);
+  EXPECT_EQ(c.lay[0].mslBinding2,r.lay[0].mslBinding2);
+  ASSERT_EQ(c.spec.size(),1u);
+  EXPECT_EQ(c.spec[0].type,SpecializationConstants::Float);
+
+  // cache hit doesn't add entries
+  ld.translate(c,frag,sizeof(frag));
+  EXPECT_FALSE(ld.isDirty());
+  EXPECT_EQ(ld.size(),1u);
+  }
+
+TEST(main, TranslationCacheReject) {
+  TranslationCache src(ShaderTranslator::hlsl());
+  ShaderTranslator::Result r;
+  src.translate(r,frag,sizeof(frag));
+  const auto file = src.serialize();
+
+  // other profile
+  TranslationCache msl(mslMacOS());
+  EXPECT_FALSE(msl.deserialize(file));
+  auto sm51 = ShaderTranslator::hlsl();
+  sm51.version = 51;
+  TranslationCache hlsl51(sm51);
+  EXPECT_FALSE(hlsl51.deserialize(file));
+
+  TranslationCache cache(ShaderTranslator::hlsl());
+  auto f = file;
+  f[f.size()/2] ^= 0xFF;
+  EXPECT_FALSE(cache.deserialize(f));
+
+  f = file;
+  f.resize(f.size()-1);
+  EXPECT_FALSE(cache.deserialize(f));
+  EXPECT_FALSE(cache.deserialize(std::vector<uint8_t>()));
+  EXPECT_EQ(cache.size(),0u);
+  EXPECT_TRUE(cache.deserialize(file));
+  EXPECT_EQ(cache.size(),1u);
+  }
@@ -0,0 +1,175 @@
+#include "../gapi/shaderreflection.h"
+#include "../gapi/spirvreflection.h"
+
+#include <Tempest/File>
+
+#include <gtest/gtest.h>
+#include <cstring>
+
+#include "builtin_shader.h"
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+std::vector<uint32_t> words(const uint8_t* data, size_t size) {
+  std::vector<uint32_t> ret(size/4);
+  std::memcpy(ret.data(),data,ret.size()*4);
+  return ret;
+  }
+
+std::vector<uint32_t> load(const char* path) {
+  RFile                 f(path);
+  std::vector<uint32_t> ret(f.size()/4);
+  f.read(ret.data(),ret.size()*4);
+  return ret;
+  }
+
+// SpirvReflection must give exactly same results, as spirv_cross based ShaderReflection
+void expectSameReflection(const std::vector<uint32_t>& code) {
+  spirv_cross::Compiler comp(code.data(),code.size());
+  std::vector<Decl::ComponentType>            vdecl;
+  std::vector<ShaderReflection::Binding>      lay;
+  std::vector<ShaderReflection::SpecConstant> spec;
+  ShaderReflection::getVertexDecl(vdecl,comp);
+  ShaderReflection::getBindings(lay,comp);
+  ShaderReflection::getSpecConstants(spec,comp);
+
+  SpirvReflection spv(code.data(),code.size());
+  std::vector<Decl::ComponentType>            vdecl2;
+  std::vector<ShaderReflection::Binding>      lay2;
+  std::vector<ShaderReflection::SpecConstant> spec2;
+  spv.getVertexDecl(vdecl2);
+  spv.getBindings(lay2);
+  spv.getSpecConstants(spec2);
+
+  EXPECT_EQ(spv.stage(),ShaderReflection::stage(comp));
+  EXPECT_EQ(vdecl2,vdecl);
+  ASSERT_EQ(lay2.size(),lay.size());
+  for(size_t i=0; i<lay.size(); ++i) {
+    EXPECT_EQ(lay2[i].layout,         lay[i].layout);
+    EXPECT_EQ(lay2[i].cls,            lay[i].cls);
+    EXPECT_EQ(lay2[i].stage,          lay[i].stage);
+    EXPECT_EQ(lay2[i].size,           lay[i].size);
+    EXPECT_EQ(uint32_t(lay2[i].spvId),uint32_t(lay[i].spvId));
+    }
+  ASSERT_EQ(spec2.size(),spec.size());
+  for(size_t i=0; i<spec.size(); ++i) {
+    EXPECT_EQ(spec2[i].id,   spec[i].id);
+    EXPECT_EQ(spec2[i].type, spec[i].type);
+    EXPECT_EQ(spec2[i].stage,spec[i].stage);
+    }
+  }
+
+}
+
+TEST(main, SpirvReflectionBuiltin) {
+  expectSameReflection(words(blit_vert_sprv,     sizeof(blit_vert_sprv)));
+  expectSameReflection(words(blit_frag_sprv,     sizeof(blit_frag_sprv)));
+  expectSameReflection(words(empty_vert_sprv,    sizeof(empty_vert_sprv)));
+  expectSameReflection(words(empty_frag_sprv,    sizeof(empty_frag_sprv)));
+  expectSameReflection(words(tex_brush_vert_sprv,sizeof(tex_brush_vert_sprv)));
+  expectSameReflection(words(tex_brush_frag_sprv,sizeof(tex_brush_frag_sprv)));
+  }
+
+TEST(main, SpirvReflectionTestsuite) {
+  const char* shaders[] = {
+    "shader/simple_test.vert.sprv",
+    "shader/simple_test.frag.sprv",
+    "shader/simple_test.comp.sprv",
+    "shader/image_store_test.comp.sprv",
+    "shader/ubo_input.vert.sprv",
+    "shader/tess.vert.sprv",
+    "shader/tess.frag.sprv",
+    "shader/tess.tesc.sprv",
+    "shader/tess.tese.sprv",
+    "shader/ssbo_write_verify.comp.sprv",
+    "shader/ssbo_write.vert.sprv",
+    "shader/push_constant.comp.sprv",
+    "shader/spec_const.comp.sprv",
+    "shader/link_defect.vert.sprv",
+    "shader/link_defect.frag.sprv",
+    "shader/reflection.vert.sprv",
+    };
+  for(auto i:shaders) {
+    SCOPED_TRACE(i);
+    expectSameReflection(load(i));
+    }
+  }
+
+TEST(main, SpirvReflectionLayout) {
+  auto code = load("shader/reflection.vert.sprv");
+  SpirvReflection spv(code.data(),code.size());
+
+  std::vector<Decl::ComponentType> vdecl;
+  spv.getVertexDecl(vdecl);
+  ASSERT_EQ(vdecl.size(),4u);
+  EXPECT_EQ(vdecl[0],Decl::float3);
+  EXPECT_EQ(vdecl[1],Decl::int2);
+  EXPECT_EQ(vdecl[2],Decl::uint1);
+  EXPECT_EQ(vdecl[3],Decl::float2);
+
+  std::vector<ShaderReflection::Binding> lay;
+  spv.getBindings(lay);
+  ASSERT_EQ(lay.size(),6u);
+  EXPECT_EQ(lay[0].cls, ShaderReflection::Texture);
+  EXPECT_EQ(lay[1].cls, ShaderReflection::Ubo);
+  EXPECT_EQ(lay[1].size,204u);
+  EXPECT_EQ(lay[2].cls, ShaderReflection::SsboR);
+  EXPECT_EQ(lay[2].size,4u);
+  EXPECT_EQ(lay[3].cls, ShaderReflection::SsboRW);
+  EXPECT_EQ(lay[4].cls, ShaderReflection::ImgRW);
+  EXPECT_EQ(lay[5].cls, ShaderReflection::Push);
+  EXPECT_EQ(lay[5].size,12u);
+
+  std::vector<ShaderReflection::SpecConstant> spec;
+  spv.getSpecConstants(spec);
+  EXPECT_EQ(spec.size(),4u);
+  }
+
+TEST(main, SpirvReflectionInvalid) {
+  const uint32_t junk[]  = {0x07230203,0x00010000,0,5,0,0xFFFFFFFF};
+  const uint32_t magic[] = {0x03022307,0x00010000,0,5,0};
+  EXPECT_THROW(SpirvReflection(junk, sizeof(junk)/4), std::system_error);
+  EXPECT_THROW(SpirvReflection(magic,sizeof(magic)/4),std::system_error);
+  EXPECT_THROW(SpirvReflection(junk, 2),              std::system_error);
+  }
+
+TEST(main, SpirvReflectionMalformedTypes) {
+  // %2 = OpTypeArray %2 %3: array of itself
+  const uint32_t cyclicArray[] = {
+    0x07230203,0x00010000,0,8,0,
+    (5<<16)|15, 0,1,0x6E69616D,0,   // OpEntryPoint Vertex %1 "main"
+    (4<<16)|28, 2,2,3,              // OpTypeArray
+    (4<<16)|32, 4,2,2,              // OpTypePointer Uniform %2
+    (4<<16)|59, 4,5,2,              // OpVariable %4 Uniform
+    };
+  // %2 = OpTypeStruct %2, decorated as uniform block
+  const uint32_t cyclicStruct[] = {
+    0x07230203,0x00010000,0,8,0,
+    (5<<16)|15, 0,1,0x6E69616D,0,
+    (3<<16)|71, 2,2,                // OpDecorate %2 Block
+    (5<<16)|72, 2,0,35,0,           // OpMemberDecorate %2 0 Offset 0
+    (3<<16)|30, 2,2,                // OpTypeStruct
+    (4<<16)|32, 4,2,2,
+    (4<<16)|59, 4,5,2,
+    };
+  // OpTypeImage without dimension, depth, arrayed, ms and sampled operands
+  const uint32_t shortImage[] = {
+    0x07230203,0x00010000,0,8,0,
+    (5<<16)|15, 0,1,0x6E69616D,0,
+    (3<<16)|22, 6,32,               // OpTypeFloat 32
+    (3<<16)|25, 2,6,                // OpTypeImage
+    };
+
+  std::vector<ShaderReflection::Binding> lay;
+  SpirvReflection arr(cyclicArray,sizeof(cyclicArray)/4);
+  EXPECT_THROW(arr.getBindings(lay),std::system_error);
+
+  SpirvReflection str(cyclicStruct,sizeof(cyclicStruct)/4);
+  EXPECT_THROW(str.getBindings(lay),std::system_error);
+
+  EXPECT_THROW(SpirvReflection(shortImage,sizeof(shortImage)/4),std::system_error);
+  }
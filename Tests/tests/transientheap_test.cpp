@@ -0,0 +1,62 @@
+#include "../gapi/transientheap.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+struct TestBuffer : AbstractGraphicsApi::Buffer {
+  explicit TestBuffer(size_t sz):data(sz) {}
+  void update(const void*,size_t,size_t,size_t,size_t) override {}
+  void read  (void*,size_t,size_t) override {}
+  AbstractGraphicsApi::Readback* readAsync(size_t,size_t) override { return nullptr; }
+  void* map  () override { return data.data(); }
+  void  unmap() override {}
+  std::vector<uint8_t> data;
+  };
+
+struct MkChunk {
+  size_t count=0;
+  bool operator()(TransientHeap<TestBuffer>::Chunk& c) {
+    c.buf.reset(new TestBuffer(c.size));
+    c.mapped = c.buf->data.data();
+    ++count;
+    return true;
+    }
+  };
+
+}
+
+TEST(main, TransientHeap) {
+  TransientHeap<TestBuffer> heap;
+  MkChunk                   mk;
+
+  AbstractGraphicsApi::Transient a, b;
+  EXPECT_TRUE(heap.alloc(10,4,a,mk));
+  EXPECT_TRUE(heap.alloc(12,12,b,mk));
+  EXPECT_EQ(a.buf,b.buf);
+  EXPECT_EQ(a.offset,0u);
+  EXPECT_EQ(b.offset,12u);
+  EXPECT_EQ(reinterpret_cast<uint8_t*>(b.data)-reinterpret_cast<uint8_t*>(a.data),12);
+
+  // does not fit into first chunk
+  AbstractGraphicsApi::Transient big;
+  EXPECT_TRUE(heap.alloc(TransientHeap<TestBuffer>::CHUNK_SIZE,1,big,mk));
+  EXPECT_NE(big.buf,a.buf);
+  EXPECT_EQ(mk.count,2u);
+
+  // memory is recycled, without new chunks
+  heap.reset();
+  EXPECT_TRUE(heap.alloc(10,4,a,mk));
+  EXPECT_TRUE(heap.alloc(TransientHeap<TestBuffer>::CHUNK_SIZE,1,big,mk));
+  EXPECT_EQ(a.offset,0u);
+  EXPECT_EQ(mk.count,2u);
+
+  size_t cleared = 0;
+  heap.clear([&](TransientHeap<TestBuffer>::Chunk&){ ++cleared; });
+  EXPECT_EQ(cleared,2u);
+  }
@@ -0,0 +1,180 @@
+#include "../gapi/uploadengine.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock-matchers.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace testing;
+using namespace Tempest;
+using namespace Tempest::Detail;
+
+namespace {
+
+struct TestDevice;
+
+struct TestCmd {
+  explicit TestCmd(TestDevice&) {}
+  void begin() { ++begins;  }
+  void end()   {            }
+  void reset() {            }
+  size_t begins=0;
+  };
+
+struct TestFence {
+  explicit TestFence(TestDevice& dev):dev(dev) {}
+  bool wait(uint64_t);
+  void wait()         { ++waits;     }
+  TestDevice& dev;
+  size_t      waits=0;
+  };
+
+struct TestBuffer : AbstractGraphicsApi::Buffer {
+  void update(const void*,size_t,size_t,size_t,size_t) override {}
+  void read  (void*,size_t,size_t) override {}
+  AbstractGraphicsApi::Readback* readAsync(size_t,size_t) override { return nullptr; }
+  void* map  () override { return nullptr; }
+  void  unmap() override {}
+  };
+
+struct TestDevice {
+  void submit(TestCmd&, TestFence&) { ++submits; }
+  std::atomic<size_t> submits{0};
+  bool                gpuDone=true;
+  };
+
+bool TestFence::wait(uint64_t) {
+  return dev.gpuDone;
+  }
+
+using Engine = UploadEngine<TestDevice,TestCmd,TestFence,TestBuffer>;
+
+}
+
+TEST(main, UploadEngineBatch) {
+  TestDevice dev;
+  Engine     eng(dev);
+
+  DSharedPtr<AbstractGraphicsApi::Buffer*> buf(new TestBuffer());
+  size_t pending = 0;
+  for(int i=0; i<500; ++i) {
+    eng.record(buf.handler,64,[&](Engine::Commands& cmd) {
+      if(cmd.holds(buf.handler))
+        ++pending;
+      cmd.hold(buf);
+      });
+    }
+  // all copies go into one command buffer; repeated writes can see each other
+  EXPECT_EQ(dev.submits.load(),0u);
+  EXPECT_EQ(pending,499u);
+
+  eng.flush();
+  EXPECT_EQ(dev.submits.load(),1u);
+  eng.flush();
+  EXPECT_EQ(dev.submits.load(),1u);
+  }
+
+TEST(main, UploadEngineThreshold) {
+  TestDevice dev;
+  Engine     eng(dev);
+
+  eng.record(nullptr,Engine::FLUSH_THRESHOLD/2,[](Engine::Commands&){});
+  EXPECT_EQ(dev.submits.load(),0u);
+  eng.record(nullptr,Engine::FLUSH_THRESHOLD/2,[](Engine::Commands&){});
+  EXPECT_EQ(dev.submits.load(),1u);
+  }
+
+TEST(main, UploadEngineSyncPoint) {
+  TestDevice dev;
+  Engine     eng(dev);
+
+  DSharedPtr<AbstractGraphicsApi::Buffer*> a(new TestBuffer());
+  DSharedPtr<AbstractGraphicsApi::Buffer*> b(new TestBuffer());
+  eng.record(a.handler,16,[&](Engine::Commands& cmd) { cmd.hold(a); });
+
+  // unrelated resource doesn't break the batch
+  eng.waitFor(b.handler);
+  EXPECT_EQ(dev.submits.load(),0u);
+
+  eng.waitFor(a.handler);
+  EXPECT_EQ(dev.submits.load(),1u);
+  // submitted batch replaces it's open tag with serial
+  EXPECT_EQ(a.handler->lastTransfer.load() & Engine::Commands::OPEN_BATCH,0u);
+
+  eng.record(a.handler,16,[&](Engine::Commands& cmd) { cmd.hold(a); });
+  eng.wait();
+  EXPECT_EQ(dev.submits.load(),2u);
+  }
+
+TEST(main, UploadEngineLastWriter) {
+  TestDevice dev;
+  Engine     eng(dev);
+  dev.gpuDone = false;
+
+  std::vector<DSharedPtr<AbstractGraphicsApi::Buffer*>> buf;
+  for(int i=0; i<1000; ++i) {
+    buf.emplace_back(new TestBuffer());
+    auto cmd = eng.get();
+    cmd->begin();
+    cmd->hold(buf.back());
+    cmd->end();
+    eng.submit(std::move(cmd));
+    }
+  EXPECT_EQ(dev.submits.load(),1000u);
+
+  // waiting for 10th submission retires everything before it, but nothing after
+  eng.waitFor(buf[9].handler);
+  for(size_t i=0; i<buf.size(); ++i)
+    EXPECT_EQ(buf[i].handler->counter.load(),(i<10 ? 1u : 2u));
+
+  dev.gpuDone = true;
+  eng.wait();
+  for(auto& i:buf)
+    EXPECT_EQ(i.handler->counter.load(),1u);
+  }
+
+TEST(main, UploadEngineThreads) {
+  TestDevice dev;
+  Engine     eng(dev);
+
+  const size_t                             count = 8;
+  DSharedPtr<AbstractGraphicsApi::Buffer*> shared(new TestBuffer());
+  std::vector<Engine::Commands*>           first(count);
+  std::atomic<size_t>                      ready{0};
+
+  auto worker = [&](size_t id) {
+    DSharedPtr<AbstractGraphicsApi::Buffer*> own(new TestBuffer());
+    eng.record(own.handler,16,[&](Engine::Commands& cmd) {
+      first[id] = &cmd;
+      cmd.hold(own);
+      });
+    // all threads have open batches at the same time
+    ++ready;
+    while(ready.load()<count)
+      std::this_thread::yield();
+
+    for(int i=0; i<2000; ++i) {
+      auto& dst = (i%16==0) ? shared : own;
+      eng.record(dst.handler,16,[&](Engine::Commands& cmd) { cmd.hold(dst); });
+      if(i%128==0)
+        eng.waitFor(own.handler);
+      }
+    eng.waitFor(own.handler);
+    EXPECT_EQ(own.handler->counter.load(),1u);
+    };
+
+  std::vector<std::thread> th;
+  for(size_t i=0; i<count; ++i)
+    th.emplace_back(worker,i);
+  for(auto& i:th)
+    i.join();
+
+  // each thread recorded into own batch
+  for(size_t i=0; i<count; ++i)
+    for(size_t r=i+1; r<count; ++r)
+      EXPECT_NE(first[i],first[r]);
+
+  eng.wait();
+  EXPECT_EQ(shared.handler->counter.load(),1u);
+  }
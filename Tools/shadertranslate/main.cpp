@@ -0,0 +1,162 @@
+#include "gapi/cachefile.h"
+#include "gapi/shadertranslator.h"
+#include "gapi/translationcache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+using namespace Tempest::Detail;
+
+// Pre-translates directory of SPIR-V shaders into HLSL/MSL caches, that DirectX12 and Metal backends
+// load from Device::setPipelineCacheDir. Existing cache files in output directory are updated.
+
+namespace {
+
+struct Options {
+  const char*                            src = nullptr;
+  const char*                            dst = nullptr;
+  std::vector<ShaderTranslator::Profile> profiles;
+  };
+
+void usage(const char* app) {
+  std::printf("usage: %s [options] <spirv dir> <cache dir>\n"
+              "  --hlsl              translate to hlsl, shader model 5.0\n"
+              "  --msl-macos         translate to msl 1.2, macOS\n"
+              "  --msl-ios           translate to msl 1.2, iOS\n"
+              "all *.sprv and *.spv files of spirv dir are translated; without profile options, all profiles are produced\n",app);
+  }
+
+bool parse(int argc, const char** argv, Options& opt) {
+  for(int i=1; i<argc; ++i) {
+    const char* a = argv[i];
+    if(std::strcmp(a,"--help")==0 || std::strcmp(a,"-h")==0)
+      return false;
+    if(std::strcmp(a,"--hlsl")==0) {
+      opt.profiles.push_back(ShaderTranslator::hlsl());
+      }
+    else if(std::strcmp(a,"--msl-macos")==0 || std::strcmp(a,"--msl-ios")==0) {
+      auto p = ShaderTranslator::msl();
+      p.target = (std::strcmp(a,"--msl-macos")==0) ? ShaderTranslator::MslMacOS : ShaderTranslator::MslIOS;
+      opt.profiles.push_back(p);
+      }
+    else if(a[0]=='-') {
+      std::fprintf(stderr,"unknown option %s\n",a);
+      return false;
+      }
+    else if(opt.src==nullptr)
+      opt.src = a;
+    else if(opt.dst==nullptr)
+      opt.dst = a;
+    else {
+      std::fprintf(stderr,"unexpected argument %s\n",a);
+      return false;
+      }
+    }
+  if(opt.src==nullptr || opt.dst==nullptr)
+    return false;
+  if(opt.profiles.empty()) {
+    auto mac = ShaderTranslator::msl();
+    auto ios = ShaderTranslator::msl();
+    mac.target = ShaderTranslator::MslMacOS;
+    ios.target = ShaderTranslator::MslIOS;
+    opt.profiles = {ShaderTranslator::hlsl(), mac, ios};
+    }
+  return true;
+  }
+
+bool endsWith(const std::string& s, const char* ext) {
+  const size_t n = std::strlen(ext);
+  return s.size()>n && s.compare(s.size()-n,n,ext)==0;
+  }
+
+std::vector<std::string> listShaders(const std::string& dir) {
+  std::vector<std::string> ret;
+#if defined(_WIN32)
+  WIN32_FIND_DATAA fd = {};
+  HANDLE           h  = FindFirstFileA((dir+"*").c_str(),&fd);
+  if(h==INVALID_HANDLE_VALUE)
+    return ret;
+  do {
+    if((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)==0)
+      ret.push_back(fd.cFileName);
+    } while(FindNextFileA(h,&fd));
+  FindClose(h);
+#else
+  DIR* d = opendir(dir.c_str());
+  if(d==nullptr)
+    return ret;
+  while(auto* e = readdir(d))
+    ret.push_back(e->d_name);
+  closedir(d);
+#endif
+  std::vector<std::string> spv;
+  for(auto& i:ret)
+    if(endsWith(i,".sprv") || endsWith(i,".spv"))
+      spv.push_back(dir+i);
+  return spv;
+  }
+
+}
+
+int main(int argc, const char** argv) {
+  Options opt;
+  if(!parse(argc,argv,opt)) {
+    usage(argv[0]);
+    return 1;
+    }
+
+  const std::string src     = CacheFile::directory(opt.src);
+  const std::string dst     = CacheFile::directory(opt.dst);
+  const auto        shaders = listShaders(src);
+  if(shaders.empty()) {
+    std::fprintf(stderr,"no SPIR-V files in %s\n",opt.src);
+    return 1;
+    }
+
+  std::vector<std::vector<uint8_t>> spirv(shaders.size());
+  for(size_t i=0; i<shaders.size(); ++i)
+    if(!CacheFile::read(shaders[i],spirv[i])) {
+      std::fprintf(stderr,"unable to read %s\n",shaders[i].c_str());
+      return 1;
+      }
+
+  int ret = 0;
+  for(auto& p:opt.profiles) {
+    TranslationCache     cache(p);
+    const std::string    path = dst+cache.fileName();
+    std::vector<uint8_t> file;
+    if(CacheFile::read(path,file) && !cache.deserialize(file))
+      std::fprintf(stderr,"%s is outdated or damaged - rebuilt\n",path.c_str());
+
+    const size_t cached = cache.size();
+    size_t       failed = 0;
+    for(size_t i=0; i<shaders.size(); ++i) {
+      ShaderTranslator::Result r;
+      try {
+        cache.translate(r,spirv[i].data(),spirv[i].size());
+        }
+      catch(const std::system_error& e) {
+        std::fprintf(stderr,"%s: %s: %s\n",p.name().c_str(),shaders[i].c_str(),e.what());
+        ++failed;
+        }
+      }
+
+    if(cache.isDirty() && !CacheFile::write(path,cache.serialize())) {
+      std::fprintf(stderr,"unable to write %s\n",path.c_str());
+      return 1;
+      }
+    std::printf("%-16s %zu shaders, %zu translated, %zu failed -> %s\n",
+                p.name().c_str(),shaders.size(),cache.size()-cached,failed,path.c_str());
+    if(failed>0)
+      ret = 1;
+    }
+  return ret;
+  }